@@ -0,0 +1,129 @@
+#include <benchmark/benchmark.h>
+
+#include <rs_driver/driver/decoder/packet_builder.hpp>
+
+#include <rs_driver/utility/sync_queue.hpp>
+#include <rs_driver/utility/buffer.hpp>
+
+#include <thread>
+#include <atomic>
+
+using namespace robosense::lidar;
+
+static void BM_TrigonSinCos(benchmark::State& state)
+{
+  Trigon trigon;
+
+  int32_t angle = 0;
+  for (auto _ : state)
+  {
+    benchmark::DoNotOptimize(trigon.sin(angle) + trigon.cos(angle));
+    angle = (angle + 37) % 36000;
+  }
+
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_TrigonSinCos);
+
+static void BM_ChanAnglesAdjust(benchmark::State& state)
+{
+  const uint16_t chan_num = 128;
+  ChanAngles angles(chan_num);
+
+  uint16_t chan = 0;
+  int32_t azimuth = 0;
+  for (auto _ : state)
+  {
+    benchmark::DoNotOptimize(angles.horizAdjust(chan, azimuth) + angles.vertAdjust(chan));
+    benchmark::DoNotOptimize(angles.toUserChan(chan));
+
+    if (++chan == chan_num)
+    {
+      chan = 0;
+      azimuth = (azimuth + 20) % 36000;
+    }
+  }
+
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_ChanAnglesAdjust);
+
+//
+// Construct the block iterator of a packet, as the decoders do per packet.
+//
+template <typename T_Iterator, typename T_Pkt>
+static void BM_BlockIterator(benchmark::State& state, LidarType type)
+{
+  PacketBuilder builder(type);
+  const T_Pkt& pkt = *(const T_Pkt*)builder.msops()[0].data();
+  const uint16_t blocks = sizeof(pkt.blocks) / sizeof(pkt.blocks[0]);
+
+  for (auto _ : state)
+  {
+    T_Iterator iter(pkt, blocks, 55.52e-6, builder.azStep(), 55.52e-6);
+
+    int32_t az_diff;
+    double ts;
+    iter.get(blocks - 1, az_diff, ts);
+    benchmark::DoNotOptimize(az_diff);
+    benchmark::DoNotOptimize(ts);
+  }
+
+  state.SetItemsProcessed(state.iterations());
+}
+static int registerBlockIteratorBenchmarks()
+{
+  benchmark::RegisterBenchmark("BM_BlockIterator/Single/RS32", 
+      BM_BlockIterator<SingleReturnBlockIterator<RS32MsopPkt>, RS32MsopPkt>, LidarType::RS32);
+  benchmark::RegisterBenchmark("BM_BlockIterator/Dual/RS32", 
+      BM_BlockIterator<DualReturnBlockIterator<RS32MsopPkt>, RS32MsopPkt>, LidarType::RS32);
+  benchmark::RegisterBenchmark("BM_BlockIterator/ABDual/RSP128", 
+      BM_BlockIterator<ABDualReturnBlockIterator<RSP128MsopPkt>, RSP128MsopPkt>, LidarType::RSP128);
+  benchmark::RegisterBenchmark("BM_BlockIterator/Rs16Single/RS16", 
+      BM_BlockIterator<Rs16SingleReturnBlockIterator<RS16MsopPkt>, RS16MsopPkt>, LidarType::RS16);
+  benchmark::RegisterBenchmark("BM_BlockIterator/Rs16Dual/RS16", 
+      BM_BlockIterator<Rs16DualReturnBlockIterator<RS16MsopPkt>, RS16MsopPkt>, LidarType::RS16);
+  return 0;
+}
+
+static int block_iterator_benchmarks = registerBlockIteratorBenchmarks();
+
+//
+// Hand packets over from the benchmark thread to a consumer thread, as from the receiving thread
+// to the handling thread.
+//
+static void BM_SyncQueueHandoff(benchmark::State& state)
+{
+  SyncQueue<std::shared_ptr<Buffer>> queue;
+  std::shared_ptr<Buffer> pkt = std::make_shared<Buffer>(1500);
+  std::atomic<bool> to_exit(false);
+  std::atomic<uint64_t> popped(0);
+
+  std::thread consumer([&]() {
+    while (!to_exit)
+    {
+      if (queue.popWait(1000))
+      {
+        popped++;
+      }
+    }
+  });
+
+  uint64_t pushed = 0;
+  for (auto _ : state)
+  {
+    queue.push(pkt);
+    pushed++;
+  }
+
+  while (popped < pushed)
+  {
+    std::this_thread::yield();
+  }
+
+  to_exit = true;
+  consumer.join();
+
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_SyncQueueHandoff)->UseRealTime();
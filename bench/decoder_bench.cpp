@@ -0,0 +1,101 @@
+#include <benchmark/benchmark.h>
+
+#include <rs_driver/driver/decoder/packet_builder.hpp>
+
+using namespace robosense::lidar;
+
+typedef PointCloudT<PointXYZIRT> BenchCloud;
+
+static const LidarType BENCH_TYPES[] = 
+{
+  LidarType::RS16, LidarType::RS32, LidarType::RSBP, LidarType::RSBPV4, 
+  LidarType::RSHELIOS, LidarType::RSHELIOS_16P, LidarType::RS128, LidarType::RS80, LidarType::RS48, 
+  LidarType::RSP128, LidarType::RSP80, LidarType::RSP48, 
+  LidarType::RSM1, LidarType::RSM2, LidarType::RSEOS, LidarType::RSM1_JUMBO
+};
+
+static std::shared_ptr<Decoder<BenchCloud>> createDecoder(LidarType type)
+{
+  RSDecoderParam param;
+  param.wait_for_difop = false;
+  param.dense_points = false; // a point per channel, so the points are countable.
+
+  std::shared_ptr<Decoder<BenchCloud>> decoder = DecoderFactory<BenchCloud>::createDecoder(type, param);
+  decoder->point_cloud_ = std::make_shared<BenchCloud>();
+
+  // reuse the point cloud, as the driver does.
+  Decoder<BenchCloud>* d = decoder.get();
+  decoder->regCallback(
+      [](const Error&) {}, 
+      [d](uint16_t, double) { d->point_cloud_->points.resize(0); });
+
+  return decoder;
+}
+
+static void setPointCounters(benchmark::State& state, double points)
+{
+  state.counters["points/s"] = benchmark::Counter(points, benchmark::Counter::kIsRate);
+  state.counters["time/point"] = 
+    benchmark::Counter(points, benchmark::Counter::kIsRate | benchmark::Counter::kInvert);
+}
+
+//
+// processMsopPkt() per packet, over a round (mechanical) or a frame (MEMS) of packets.
+//
+static void BM_DecodeMsop(benchmark::State& state, LidarType type)
+{
+  PacketBuilder builder(type);
+  const auto& msops = builder.msops();
+
+  std::shared_ptr<Decoder<BenchCloud>> decoder = createDecoder(type);
+  decoder->processMsopPkt(msops[1].data(), msops[1].size());
+  if (decoder->point_cloud_->points.empty())
+  {
+    state.SkipWithError("Packets are not decoded.");
+    return;
+  }
+
+  size_t i = 0;
+  for (auto _ : state)
+  {
+    const std::vector<uint8_t>& pkt = msops[i];
+    benchmark::DoNotOptimize(decoder->processMsopPkt(pkt.data(), pkt.size()));
+
+    if (++i == msops.size())
+    {
+      i = 0;
+    }
+  }
+
+  state.SetItemsProcessed(state.iterations());
+  setPointCounters(state, (double)state.iterations() * builder.pointNum() / msops.size());
+}
+
+static void BM_DecodeDifop(benchmark::State& state, LidarType type)
+{
+  PacketBuilder builder(type);
+  const std::vector<uint8_t>& difop = builder.difop();
+
+  std::shared_ptr<Decoder<BenchCloud>> decoder = createDecoder(type);
+
+  for (auto _ : state)
+  {
+    decoder->processDifopPkt(difop.data(), difop.size());
+  }
+
+  state.SetItemsProcessed(state.iterations());
+}
+
+static int registerDecoderBenchmarks()
+{
+  for (auto type : BENCH_TYPES)
+  {
+    std::string name = lidarTypeToStr(type);
+    benchmark::RegisterBenchmark(("BM_DecodeMsop/" + name).c_str(), BM_DecodeMsop, type);
+    benchmark::RegisterBenchmark(("BM_DecodeDifop/" + name).c_str(), BM_DecodeDifop, type);
+  }
+
+  return 0;
+}
+
+static int decoder_benchmarks = registerDecoderBenchmarks();
@@ -0,0 +1,92 @@
+#include <benchmark/benchmark.h>
+
+#include <rs_driver/driver/decoder/packet_builder.hpp>
+
+#include <rs_driver/api/lidar_driver.hpp>
+#include <rs_driver/utility/sync_queue.hpp>
+
+#include <atomic>
+#include <thread>
+
+using namespace robosense::lidar;
+
+typedef PointCloudT<PointXYZIRT> BenchCloud;
+
+//
+// End to end, from LidarDriver::decodePacket() to the point cloud callback.
+// An iteration is a round (a frame) of packets. The frame is delivered when the first packet of 
+// the next round is decoded, so at most a round of packets is in the queue of the driver.
+//
+static void BM_DriverPipeline(benchmark::State& state, LidarType type)
+{
+  PacketBuilder builder(type);
+
+  std::vector<Packet> pkts;
+  for (const auto& msop : builder.msops())
+  {
+    Packet pkt(msop.size());
+    memcpy(pkt.buf_.data(), msop.data(), msop.size());
+    pkts.push_back(pkt);
+  }
+
+  SyncQueue<std::shared_ptr<BenchCloud>> free_cloud_queue;
+  std::atomic<uint64_t> frames(0);
+  std::atomic<uint64_t> points(0);
+
+  RSDriverParam param;
+  param.lidar_type = type;
+  param.input_type = InputType::RAW_PACKET;
+  param.decoder_param.wait_for_difop = false;
+  param.decoder_param.dense_points = false;
+
+  LidarDriver<BenchCloud> driver;
+  driver.regPointCloudCallback(
+      [&free_cloud_queue]() 
+      {
+        std::shared_ptr<BenchCloud> cloud = free_cloud_queue.pop();
+        return cloud ? cloud : std::make_shared<BenchCloud>();
+      },
+      [&](std::shared_ptr<BenchCloud> cloud)
+      {
+        points += cloud->points.size();
+        frames++;
+        free_cloud_queue.push(cloud);
+      });
+  driver.regExceptionCallback([](const Error&) {});
+
+  if (!driver.init(param) || !driver.start())
+  {
+    state.SkipWithError("Failed to start driver.");
+    return;
+  }
+
+  driver.decodePacket(pkts[0]);
+  uint64_t wait_frames = frames;
+
+  for (auto _ : state)
+  {
+    for (size_t i = 1; i < pkts.size(); i++)
+    {
+      driver.decodePacket(pkts[i]);
+    }
+    driver.decodePacket(pkts[0]);
+
+    wait_frames++;
+    while (frames < wait_frames)
+    {
+      std::this_thread::yield();
+    }
+  }
+
+  driver.stop();
+
+  state.SetItemsProcessed(state.iterations() * pkts.size());
+  state.counters["points/s"] = benchmark::Counter((double)points, benchmark::Counter::kIsRate);
+  state.counters["time/point"] = 
+    benchmark::Counter((double)points, benchmark::Counter::kIsRate | benchmark::Counter::kInvert);
+}
+
+BENCHMARK_CAPTURE(BM_DriverPipeline, RS16, LidarType::RS16)->UseRealTime();
+BENCHMARK_CAPTURE(BM_DriverPipeline, RSHELIOS, LidarType::RSHELIOS)->UseRealTime();
+BENCHMARK_CAPTURE(BM_DriverPipeline, RS128, LidarType::RS128)->UseRealTime();
+BENCHMARK_CAPTURE(BM_DriverPipeline, RSM1, LidarType::RSM1)->UseRealTime();
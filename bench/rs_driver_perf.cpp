@@ -0,0 +1,590 @@
+#include <rs_driver/api/lidar_driver.hpp>
+#include <rs_driver/driver/decoder/packet_builder.hpp>
+#include <rs_driver/driver/recorder/recorder.hpp>
+#include <rs_driver/utility/sync_queue.hpp>
+
+#include <glob.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/resource.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <map>
+#include <new>
+#include <sstream>
+#include <thread>
+
+using namespace robosense::lidar;
+
+typedef PointCloudT<PointXYZIRT> PerfCloud;
+
+//
+// Perf-regression harness.
+//
+// For each Lidar type, a reference capture is generated with PacketBuilder and Recorder (or given with -path),
+// and replayed through LidarDriver (PCAP_FILE or LOG_FILE input) as fast as possible (pcap_rate = 0).
+// Every capture is replayed in a fresh child process, so its peak RSS is not polluted by the other ones.
+// The results are written into a flat JSON file, and compared with a baseline.
+//
+
+//
+// Count heap allocations of all threads. With ENABLE_ALLOC_TRACKING, rs_driver hooks operator new itself.
+//
+#ifdef ENABLE_ALLOC_TRACKING
+static uint64_t allocNum()
+{
+  return AllocTracker::totalCount().load(std::memory_order_relaxed);
+}
+#else
+static std::atomic<uint64_t> g_allocs(0);
+
+static uint64_t allocNum()
+{
+  return g_allocs.load(std::memory_order_relaxed);
+}
+
+void* operator new(size_t size)
+{
+  g_allocs.fetch_add(1, std::memory_order_relaxed);
+  void* p = malloc(size ? size : 1);
+  if (p == NULL)
+  {
+    throw std::bad_alloc();
+  }
+  return p;
+}
+
+void* operator new[](size_t size)
+{
+  return operator new(size);
+}
+
+// not inlined, or GCC pairs free() with operator new, and warns of -Wmismatched-new-delete.
+__attribute__((noinline)) void operator delete(void* p) noexcept
+{
+  free(p);
+}
+
+__attribute__((noinline)) void operator delete[](void* p) noexcept
+{
+  free(p);
+}
+
+void operator delete(void* p, size_t) noexcept
+{
+  operator delete(p);
+}
+
+void operator delete[](void* p, size_t) noexcept
+{
+  operator delete[](p);
+}
+#endif
+
+struct PerfResult
+{
+  double frames_per_sec = 0.0;
+  double points_per_sec = 0.0;
+  double peak_rss_kb = 0.0;
+  double allocs_per_frame = 0.0;
+};
+
+bool checkKeywordExist(int argc, const char* const* argv, const char* str)
+{
+  for (int i = 1; i < argc; i++)
+  {
+    if (strcmp(argv[i], str) == 0)
+    {
+      return true;
+    }
+  }
+  return false;
+}
+
+bool parseArgument(int argc, const char* const* argv, const char* str, std::string& val)
+{
+  int index = -1;
+
+  for (int i = 1; i < argc; i++)
+  {
+    if (strcmp(argv[i], str) == 0)
+    {
+      index = i + 1;
+    }
+  }
+
+  if (index > 0 && index < argc)
+  {
+    val = argv[index];
+    return true;
+  }
+
+  return false;
+}
+
+void printHelpMenu()
+{
+  RS_MSG << "Arguments: " << RS_REND;
+  RS_MSG << "  -type      = LiDAR types, separated by ',', the default value is RS16,RSHELIOS,RS128,RSM1" << RS_REND;
+  RS_MSG << "  -path      = Reference capture (PCAP/log file) of a single -type, instead of the generated one" << RS_REND;
+  RS_MSG << "  -format    = Format of the reference captures, pcap or log, the default value is pcap (log if DISABLE_PCAP_PARSE)" << RS_REND;
+  RS_MSG << "  -frames    = Frames in a generated capture, the default value is 30" << RS_REND;
+  RS_MSG << "  -warmup    = Frames to skip before measuring, the default value is 5" << RS_REND;
+  RS_MSG << "  -dir       = Directory of the generated captures, the default value is /tmp/rs_driver_perf" << RS_REND;
+  RS_MSG << "  -output    = Result file (JSON), the default value is perf_result.json" << RS_REND;
+  RS_MSG << "  -baseline  = Baseline file (JSON) to compare with. Fail if it can't be read. The default value is empty (no comparison)" << RS_REND;
+  RS_MSG << "  -tolerance = Ratio of regression to tolerate, the default value is 0.15" << RS_REND;
+  RS_MSG << "  -update    = Write the result into the baseline file, instead of comparing with it" << RS_REND;
+}
+
+static double nowSec()
+{
+  return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static void removeFiles(const std::string& pattern)
+{
+  glob_t g;
+  if (glob(pattern.c_str(), 0, NULL, &g) == 0)
+  {
+    for (size_t i = 0; i < g.gl_pathc; i++)
+    {
+      unlink(g.gl_pathv[i]);
+    }
+  }
+  globfree(&g);
+}
+
+//
+// Generate a capture of a Lidar type, with a DIFOP packet every second (10 frames).
+// Return the glob pattern of the record files, or an empty string on failure.
+//
+static std::string generateCapture(LidarType type, const std::string& dir, int frames, RecordFormat format)
+{
+  PacketBuilder builder(type);
+
+  RSRecordParam record_param;
+  record_param.record_path = dir + "/" + lidarTypeToStr(type);
+  record_param.record_format = format;
+
+  std::string pattern = record_param.record_path + "_*" + ((format == RECORD_LOG) ? ".rslog" : ".pcap");
+  removeFiles(pattern);
+
+  Recorder recorder(record_param, RSInputParam());
+  recorder.regCallback([](const Error&) {});
+  if (!recorder.init() || !recorder.start())
+  {
+    RS_ERROR << "Fail to record " << record_param.record_path << RS_REND;
+    return "";
+  }
+
+  // the recorder drops packets if all its buffers are full. keep half of them free.
+  const uint64_t buf_bytes = (uint64_t)record_param.buf_size * record_param.buf_num / 2;
+  uint64_t appended = 0;
+
+  for (int f = 0; f < frames; f++)
+  {
+    if (f % 10 == 0)
+    {
+      recorder.record(builder.difop().data(), builder.difop().size(), true);
+      appended += builder.difop().size();
+    }
+
+    for (const auto& msop : builder.msops())
+    {
+      recorder.record(msop.data(), msop.size(), false);
+      appended += msop.size();
+    }
+
+    while (appended > recorder.getStats().bytes + buf_bytes)
+    {
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+  }
+
+  recorder.stop();
+
+  if (recorder.getStats().dropped > 0)
+  {
+    RS_ERROR << "Packets dropped in recording " << record_param.record_path << RS_REND;
+    return "";
+  }
+
+  return pattern;
+}
+
+//
+// Replay a capture as fast as possible, and measure the frames after warmup.
+//
+static bool replayCapture(LidarType type, InputType input_type, const std::string& path, int warmup, PerfResult& result)
+{
+  SyncQueue<std::shared_ptr<PerfCloud>> free_cloud_queue;
+  std::atomic<bool> to_exit(false);
+
+  int frames = 0;
+  uint64_t points = 0;
+  double begin_sec = 0.0, end_sec = 0.0;
+  uint64_t begin_allocs = 0, end_allocs = 0;
+  uint64_t begin_points = 0;
+
+  RSDriverParam param;
+  param.lidar_type = type;
+  param.input_type = input_type;
+  param.input_param.pcap_path = path;
+  param.input_param.pcap_repeat = false;
+  param.input_param.pcap_rate = 0;
+
+  LidarDriver<PerfCloud> driver;
+  driver.regPointCloudCallback(
+      [&free_cloud_queue]()
+      {
+        std::shared_ptr<PerfCloud> cloud = free_cloud_queue.pop();
+        return cloud ? cloud : std::make_shared<PerfCloud>();
+      },
+      [&](std::shared_ptr<PerfCloud> cloud)
+      {
+        frames++;
+        points += cloud->points.size();
+
+        if (frames == warmup)
+        {
+          begin_sec = nowSec();
+          begin_allocs = allocNum();
+          begin_points = points;
+        }
+
+        end_sec = nowSec();
+        end_allocs = allocNum();
+
+        free_cloud_queue.push(cloud);
+      });
+  driver.regExceptionCallback(
+      [&to_exit](const Error& code)
+      {
+        if (code.error_code == ERRCODE_PCAPEXIT)
+        {
+          to_exit = true;
+        }
+        else if (code.error_code_type != ErrCodeType::INFO_CODE)
+        {
+          RS_WARNING << code.toString() << RS_REND;
+        }
+      });
+
+  if (!driver.init(param) || !driver.start())
+  {
+    RS_ERROR << "Fail to replay " << path << RS_REND;
+    return false;
+  }
+
+  while (!to_exit)
+  {
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+
+  // wait for the packets in the queue.
+  DriverStats stats;
+  for (int i = 0; i < 500; i++)
+  {
+    if (driver.getStats(stats) && (stats.msop_pkts + stats.difop_pkts >= stats.pkts))
+    {
+      break;
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+
+  driver.stop();
+
+  if (stats.queue_dropped_pkts > 0)
+  {
+    RS_ERROR << "Packets dropped in replaying " << path << ": " << stats.queue_dropped_pkts << RS_REND;
+    return false;
+  }
+
+  int steady_frames = frames - warmup;
+  if ((steady_frames <= 0) || (end_sec <= begin_sec))
+  {
+    RS_ERROR << "Too few frames in " << path << ": " << frames << RS_REND;
+    return false;
+  }
+
+  struct rusage usage;
+  getrusage(RUSAGE_SELF, &usage);
+
+  result.frames_per_sec = steady_frames / (end_sec - begin_sec);
+  result.points_per_sec = (points - begin_points) / (end_sec - begin_sec);
+  result.peak_rss_kb = (double)usage.ru_maxrss;
+  result.allocs_per_frame = (double)(end_allocs - begin_allocs) / steady_frames;
+  return true;
+}
+
+//
+// Run replayCapture() in a child process, i.e. this program with the option -replay.
+//
+static bool runReplay(const std::string& exe, LidarType type, InputType input_type,
+    const std::string& path, int warmup, PerfResult& result)
+{
+  std::stringstream cmd;
+  cmd << "'" << exe << "' -replay -type " << lidarTypeToStr(type)
+    << " -format " << ((input_type == InputType::LOG_FILE) ? "log" : "pcap")
+    << " -path '" << path << "' -warmup " << warmup;
+
+  FILE* fp = popen(cmd.str().c_str(), "r");
+  if (fp == NULL)
+  {
+    RS_ERROR << "Fail to run " << cmd.str() << RS_REND;
+    return false;
+  }
+
+  bool found = false;
+  char line[1024];
+  while (fgets(line, sizeof(line), fp) != NULL)
+  {
+    if (sscanf(line, "RESULT %lf %lf %lf %lf", &result.frames_per_sec, &result.points_per_sec,
+          &result.peak_rss_kb, &result.allocs_per_frame) == 4)
+    {
+      found = true;
+    }
+    else
+    {
+      fputs(line, stdout);
+    }
+  }
+
+  return (pclose(fp) == 0) && found;
+}
+
+static bool writeResults(const std::string& file, const std::map<std::string, double>& results)
+{
+  std::ofstream ofs(file);
+  if (!ofs)
+  {
+    RS_ERROR << "Fail to write " << file << RS_REND;
+    return false;
+  }
+
+  ofs << "{" << std::endl;
+  size_t i = 0;
+  for (const auto& r : results)
+  {
+    ofs << "  \"" << r.first << "\": " << std::fixed << std::setprecision(2) << r.second
+      << ((++i < results.size()) ? "," : "") << std::endl;
+  }
+  ofs << "}" << std::endl;
+  return true;
+}
+
+static bool readResults(const std::string& file, std::map<std::string, double>& results)
+{
+  std::ifstream ifs(file);
+  if (!ifs)
+  {
+    return false;
+  }
+
+  std::string line;
+  while (std::getline(ifs, line))
+  {
+    char key[256];
+    double val;
+    if (sscanf(line.c_str(), " \"%255[^\"]\" : %lf", key, &val) == 2)
+    {
+      results[key] = val;
+    }
+  }
+
+  return true;
+}
+
+//
+// frames_per_sec and points_per_sec are higher-better. peak_rss_kb and allocs_per_frame are lower-better,
+// with a slack of 1, so a baseline of 0 allocation still tolerates noise.
+//
+static bool compareResults(const std::map<std::string, double>& base,
+    const std::map<std::string, double>& results, double tolerance)
+{
+  bool ok = true;
+
+  for (const auto& r : results)
+  {
+    auto it = base.find(r.first);
+    if (it == base.end())
+    {
+      RS_MSG << std::left << std::setw(32) << r.first << std::fixed << std::setprecision(2) 
+        << r.second << " (no baseline)" << RS_REND;
+      continue;
+    }
+
+    bool higher_better = (r.first.find("_per_sec") != std::string::npos);
+    bool regressed = higher_better ? (r.second < it->second * (1 - tolerance)) :
+      (r.second > it->second * (1 + tolerance) + 1);
+    double change = (it->second != 0) ? (r.second / it->second - 1) * 100 : 0.0;
+
+    std::stringstream ss;
+    ss << std::left << std::setw(32) << r.first << std::fixed << std::setprecision(2)
+      << it->second << " -> " << r.second << " (" << std::showpos << change << std::noshowpos << "%)";
+    if (regressed)
+    {
+      RS_ERROR << ss.str() << " REGRESSION" << RS_REND;
+      ok = false;
+    }
+    else
+    {
+      RS_MSG << ss.str() << RS_REND;
+    }
+  }
+
+  return ok;
+}
+
+static std::string selfPath(const char* argv0)
+{
+  char buf[4096];
+  ssize_t len = readlink("/proc/self/exe", buf, sizeof(buf) - 1);
+  if (len <= 0)
+  {
+    return argv0;
+  }
+
+  buf[len] = '\0';
+  return buf;
+}
+
+int main(int argc, char* argv[])
+{
+  if (checkKeywordExist(argc, argv, "-h") || checkKeywordExist(argc, argv, "--help"))
+  {
+    printHelpMenu();
+    return 0;
+  }
+
+  std::string result_str;
+  std::vector<LidarType> types = {LidarType::RS16, LidarType::RSHELIOS, LidarType::RS128, LidarType::RSM1};
+  std::string path;
+#ifdef DISABLE_PCAP_PARSE
+  RecordFormat format = RECORD_LOG;
+#else
+  RecordFormat format = RECORD_PCAP;
+#endif
+  int frames = 30;
+  int warmup = 5;
+  std::string dir = "/tmp/rs_driver_perf";
+  std::string output = "perf_result.json";
+  std::string baseline;
+  double tolerance = 0.15;
+  bool update = checkKeywordExist(argc, argv, "-update");
+
+  if (parseArgument(argc, argv, "-type", result_str))
+  {
+    types.clear();
+
+    std::stringstream ss(result_str);
+    std::string item;
+    while (std::getline(ss, item, ','))
+    {
+      types.push_back(strToLidarType(item));
+    }
+  }
+
+  parseArgument(argc, argv, "-path", path);
+
+  if (parseArgument(argc, argv, "-format", result_str))
+  {
+    format = (result_str == "log") ? RECORD_LOG : RECORD_PCAP;
+  }
+
+  if (parseArgument(argc, argv, "-frames", result_str))
+  {
+    frames = std::stoi(result_str);
+  }
+
+  if (parseArgument(argc, argv, "-warmup", result_str))
+  {
+    warmup = std::max(std::stoi(result_str), 1);
+  }
+
+  parseArgument(argc, argv, "-dir", dir);
+  parseArgument(argc, argv, "-output", output);
+  parseArgument(argc, argv, "-baseline", baseline);
+
+  if (parseArgument(argc, argv, "-tolerance", result_str))
+  {
+    tolerance = std::stod(result_str);
+  }
+
+  InputType input_type = (format == RECORD_LOG) ? InputType::LOG_FILE : InputType::PCAP_FILE;
+
+  if (checkKeywordExist(argc, argv, "-replay"))
+  {
+    PerfResult result;
+    if (types.empty() || !replayCapture(types[0], input_type, path, warmup, result))
+    {
+      return 1;
+    }
+
+    printf("RESULT %f %f %f %f\n",
+        result.frames_per_sec, result.points_per_sec, result.peak_rss_kb, result.allocs_per_frame);
+    return 0;
+  }
+
+  if (!path.empty() && (types.size() != 1))
+  {
+    RS_ERROR << "-path is for a single -type." << RS_REND;
+    return 1;
+  }
+
+  mkdir(dir.c_str(), 0755);
+
+  std::string exe = selfPath(argv[0]);
+  std::map<std::string, double> results;
+
+  for (auto type : types)
+  {
+    std::string name = lidarTypeToStr(type);
+
+    std::string capture = path.empty() ? generateCapture(type, dir, frames, format) : path;
+    PerfResult result;
+    if (capture.empty() || !runReplay(exe, type, input_type, capture, warmup, result))
+    {
+      RS_ERROR << "Fail to measure " << name << RS_REND;
+      return 1;
+    }
+
+    results[name + ".frames_per_sec"] = result.frames_per_sec;
+    results[name + ".points_per_sec"] = result.points_per_sec;
+    results[name + ".peak_rss_kb"] = result.peak_rss_kb;
+    results[name + ".allocs_per_frame"] = result.allocs_per_frame;
+  }
+
+  if (!writeResults(output, results))
+  {
+    return 1;
+  }
+
+  if (baseline.empty())
+  {
+    return compareResults(std::map<std::string, double>(), results, tolerance) ? 0 : 1;
+  }
+
+  if (update)
+  {
+    RS_MSG << "Update baseline " << baseline << RS_REND;
+    return writeResults(baseline, results) ? 0 : 1;
+  }
+
+  std::map<std::string, double> base;
+  if (!readResults(baseline, base))
+  {
+    // never pass without a baseline.
+    compareResults(base, results, tolerance);
+    RS_ERROR << "No baseline " << baseline << ". Run with -update to create it." << RS_REND;
+    return 1;
+  }
+
+  return compareResults(base, results, tolerance) ? 0 : 1;
+}
@@ -39,6 +39,7 @@ THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #endif
 
 //#define ORDERLY_EXIT
+//#define SHARE_THREADS  ///< Receive and decode in the threads of LidarDriverManager, instead of each driver's own
 
 typedef PointXYZI PointT;
 typedef PointCloudT<PointT> PointCloudMsg;
@@ -54,7 +55,7 @@ public:
   {
   }
 
-  bool init(const RSDriverParam& param)
+  bool init(const RSDriverParam& param, LidarDriverManager* manager = NULL)
   {
     RS_INFO << "------------------------------------------------------" << RS_REND;
     RS_INFO << "                      " << name_ << RS_REND;
@@ -65,7 +66,8 @@ public:
                                   std::bind(&DriverClient::driverReturnPointCloudToCallerCallback, this, std::placeholders::_1));
     driver_.regExceptionCallback (std::bind(&DriverClient::exceptionCallback, this, std::placeholders::_1));
 
-    if (!driver_.init(param))
+    bool ret = (manager != NULL) ? driver_.init(param, *manager) : driver_.init(param);
+    if (!ret)
     {
       RS_ERROR << name_ << ": Failed to initialize driver." << RS_REND;
       return false;
@@ -146,6 +148,22 @@ int main(int argc, char* argv[])
   RS_TITLE << "            RS_Driver Core Version: v" << getDriverVersion() << RS_REND;
   RS_TITLE << "------------------------------------------------------" << RS_REND;
 
+#ifdef SHARE_THREADS
+  RSManagerParam manager_param;
+  manager_param.recv_thread_num = 1;    ///< Set the number of receiving threads, shared by all lidars
+  manager_param.worker_thread_num = 2;  ///< Set the number of decoding threads, shared by all lidars
+
+  LidarDriverManager manager;
+  if (!manager.init(manager_param))
+  {
+    return -1;
+  }
+
+  LidarDriverManager* mgr = &manager;
+#else
+  LidarDriverManager* mgr = NULL;
+#endif
+
   RSDriverParam param_left;                  ///< Create a parameter object
   param_left.input_type = InputType::ONLINE_LIDAR;
   param_left.input_param.msop_port = 6004;   ///< Set the lidar msop port number, the default is 6699
@@ -153,7 +171,7 @@ int main(int argc, char* argv[])
   param_left.lidar_type = LidarType::RSM1;   ///< Set the lidar type. Make sure this type is correct
 
   DriverClient client_left("LEFT ");
-  if (!client_left.init(param_left))                         ///< Call the init function
+  if (!client_left.init(param_left, mgr))                         ///< Call the init function
   {
     return -1;
   }
@@ -165,11 +183,15 @@ int main(int argc, char* argv[])
   param_right.lidar_type = LidarType::RSM1;   ///< Set the lidar type. Make sure this type is correct
 
   DriverClient client_right("RIGHT");
-  if (!client_right.init(param_right))                         ///< Call the init function
+  if (!client_right.init(param_right, mgr))                         ///< Call the init function
   {
     return -1;
   }
 
+#ifdef SHARE_THREADS
+  manager.start();
+#endif
+
   client_left.start();
   client_right.start();
 
@@ -178,6 +200,10 @@ int main(int argc, char* argv[])
 
   client_left.stop();
   client_right.stop();
+
+#ifdef SHARE_THREADS
+  manager.stop();
+#endif
 #else
   while (true)
   {
@@ -0,0 +1,132 @@
+/*********************************************************************************************************************
+Copyright (c) 2020 RoboSense
+All rights reserved
+
+By downloading, copying, installing or using the software you agree to this license. If you do not agree to this
+license, do not download, install, copy or use the software.
+
+License Agreement
+For RoboSense LiDAR SDK Library
+(3-clause BSD License)
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that the
+following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following
+disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following
+disclaimer in the documentation and/or other materials provided with the distribution.
+
+3. Neither the names of the RoboSense, nor Suteng Innovation Technology, nor the names of other contributors may be used
+to endorse or promote products derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*********************************************************************************************************************/
+
+
+#pragma once
+
+#include <rs_driver/driver/fusion_driver_impl.hpp>
+
+namespace robosense
+{
+namespace lidar
+{
+
+/**
+ * @brief Driver of multiple Lidars. Their point clouds are merged into one point cloud per split_period,
+ *        on a common time grid, and each point is tagged with the lidar_id of its Lidar.
+ */
+template <typename T_PointCloud>
+class FusionDriver
+{
+public:
+
+  /**
+   * @brief Constructor, instanciate the driver pointer
+   */
+  FusionDriver() 
+    : driver_ptr_(std::make_shared<FusionDriverImpl<T_PointCloud>>())
+  {
+  }
+
+  /**
+   * @brief Register the merged point cloud callback functions
+   * @param cb_get_cloud Callback function to get an free point cloud instance
+   * @param cb_put_cloud Callback function to return the merged point cloud
+   */
+  inline void regPointCloudCallback(const std::function<std::shared_ptr<T_PointCloud>(void)>& cb_get_cloud,
+      const std::function<void(std::shared_ptr<T_PointCloud>)>& cb_put_cloud)
+  {
+    driver_ptr_->regPointCloudCallback(cb_get_cloud, cb_put_cloud);
+  }
+
+  /**
+   * @brief Register the exception message callback function. When error occurs, this function will be called
+   * @param callback The callback function
+   */
+  inline void regExceptionCallback(const std::function<void(const Error&)>& cb_excep)
+  {
+    driver_ptr_->regExceptionCallback(cb_excep);
+  }
+
+  /**
+   * @brief Initialize the driver
+   * @param param The custom struct RSFusionParam. Each Lidar should use lidar clock (use_lidar_clock = true), 
+   *        and the clocks should be synchronized, e.g. by PTP.
+   * @return If successful, return true; else return false
+   */
+  inline bool init(const RSFusionParam& param)
+  {
+    return driver_ptr_->init(param);
+  }
+
+  /**
+   * @brief Start the driver
+   * @return If successful, return true; else return false
+   */
+  inline bool start()
+  {
+    return driver_ptr_->start();
+  }
+
+  /**
+   * @brief Decode a packet of a Lidar. Only when its input_type = RAW_PACKET
+   * @param lidar_id Index of the Lidar in RSFusionParam::lidars
+   * @param pkt The packet
+   */
+  inline void decodePacket(size_t lidar_id, const Packet& pkt)
+  {
+    driver_ptr_->decodePacket(lidar_id, pkt);
+  }
+
+  /**
+   * @brief Get the number of packets dropped, because their frames had been emitted
+   * @return The number of packets
+   */
+  inline uint64_t latePktNum() const
+  {
+    return driver_ptr_->latePktNum();
+  }
+
+  /**
+   * @brief Stop the driver
+   */
+  inline void stop()
+  {
+    driver_ptr_->stop();
+  }
+
+private:
+  std::shared_ptr<FusionDriverImpl<T_PointCloud>> driver_ptr_;  ///< The driver pointer
+};
+
+}  // namespace lidar
+}  // namespace robosense
@@ -33,6 +33,7 @@ THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #pragma once
 
 #include <rs_driver/driver/lidar_driver_impl.hpp>
+#include <rs_driver/api/lidar_driver_manager.hpp>
 #include <rs_driver/msg/packet.hpp>
 
 namespace robosense
@@ -69,6 +70,19 @@ public:
     driver_ptr_->regPointCloudCallback(cb_get_cloud, cb_put_cloud);
   }
 
+  /**
+   * @brief Register the sector callback function. A sector of the frame being decoded is emitted every 
+   *        sector_angle degrees (or sector_blks blocks), before the whole frame. Call it before init().
+   *        The sector refers to the points of the frame's point cloud without copy. More points are appended 
+   *        to the cloud after the callback, so either read the points in the callback, or reserve 
+   *        enough capacity in cb_get_cloud of regPointCloudCallback(), to avoid reallocation.
+   * @param callback The callback function
+   */
+  inline void regSectorCallback(const std::function<void(const PointCloudSector<T_PointCloud>&)>& cb_put_sector)
+  {
+    driver_ptr_->regSectorCallback(cb_put_sector);
+  }
+
   /**
    * @brief Register the lidar difop packet message callback function to driver. When lidar difop packet message is
    * ready, this function will be called
@@ -99,6 +113,18 @@ public:
     return driver_ptr_->init(param);
   }
 
+  /**
+   * @brief The initialization function, like init(param), but receive and decode 
+   *        in the threads of the manager, instead of own threads
+   * @param param The custom struct RSDriverParam
+   * @param manager The LidarDriverManager, already initialized
+   * @return If successful, return true; else return false
+   */
+  inline bool init(const RSDriverParam& param, const LidarDriverManager& manager)
+  {
+    return driver_ptr_->init(param, manager.recvEngine(), manager.workerPool());
+  }
+
   /**
    * @brief Start the thread to receive and decode packets
    * @return If successful, return true; else return false
@@ -127,6 +153,91 @@ public:
     return driver_ptr_->getTemperature(temp);
   }
 
+  /**
+   * @brief Get the statistics of the packet recorder
+   * @param stats The variable to store the statistics
+   * @return if the recorder is enabled, return true; else return false
+   */
+  inline bool getRecordStats(RecordStats& stats)
+  {
+    return driver_ptr_->getRecordStats(stats);
+  }
+
+  /**
+   * @brief Get the counters of packets, frames and decoding of this driver instance. They are updated 
+   *        without lock, so it is cheap to poll them, e.g. once a second.
+   * @param stats The variable to store the counters
+   * @return if the driver is initialized, return true; else return false
+   */
+  inline bool getStats(DriverStats& stats)
+  {
+    return driver_ptr_->getStats(stats);
+  }
+
+  /**
+   * @brief Get the latest rolling 360 degree window. Only if window_resolution > 0.
+   *        The points of each column are overwritten in place by new packets, and no point cloud is 
+   *        delivered per frame. The window is not copied for the caller. Pass the previous window back, 
+   *        so its memory can be reused. Keep it as long as you need, but don't modify it.
+   * @param window The variable to store the window. 
+   * @return if a whole round has been received, return true; else return false
+   */
+  inline bool getWindow(std::shared_ptr<const T_PointCloud>& window)
+  {
+    return driver_ptr_->getWindow(window);
+  }
+
+  /**
+   * @brief Wait for a frame. Only if frame_queue_len > 0. 
+   *        The frames are handed over without a thread of the caller or a queue of its own. 
+   *        Release the frame after use, so its memory can be reused.
+   * @param cloud The variable to store the frame
+   * @param timeout_ms Milliseconds to wait
+   * @return if a frame is got, return true; else (timeout) return false
+   */
+  inline bool waitForFrame(std::shared_ptr<T_PointCloud>& cloud, uint32_t timeout_ms)
+  {
+    return driver_ptr_->waitForFrame(cloud, timeout_ms);
+  }
+
+  /**
+   * @brief Get a frame if there is one, without waiting. Only if frame_queue_len > 0.
+   * @param cloud The variable to store the frame
+   * @return if a frame is got, return true; else return false
+   */
+  inline bool tryGetFrame(std::shared_ptr<T_PointCloud>& cloud)
+  {
+    return driver_ptr_->tryGetFrame(cloud);
+  }
+
+  /**
+   * @brief Get the number of frames dropped, since the caller didn't get them in time.
+   * @return the number of dropped frames
+   */
+  inline uint64_t droppedFrameNum()
+  {
+    return driver_ptr_->droppedFrameNum();
+  }
+
+  /**
+   * @brief Get the latency histograms of the stages from receiving a packet to the point cloud callback.
+   *        Only if rs_driver is compiled with ENABLE_LATENCY_STATS.
+   * @param report The variable to store the count, min, mean, percentiles and max (in microseconds) of each stage
+   * @return if ENABLE_LATENCY_STATS is defined, return true; else return false
+   */
+  inline bool getLatencyReport(LatencyReport& report)
+  {
+    return driver_ptr_->getLatencyReport(report);
+  }
+
+  /**
+   * @brief Clear the latency histograms, e.g. after the warming up.
+   */
+  inline void resetLatencyStats()
+  {
+    driver_ptr_->resetLatencyStats();
+  }
+
   /**
    * @brief Stop all threads
    */
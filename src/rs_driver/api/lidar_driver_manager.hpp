@@ -0,0 +1,183 @@
+/*********************************************************************************************************************
+Copyright (c) 2020 RoboSense
+All rights reserved
+
+By downloading, copying, installing or using the software you agree to this license. If you do not agree to this
+license, do not download, install, copy or use the software.
+
+License Agreement
+For RoboSense LiDAR SDK Library
+(3-clause BSD License)
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that the
+following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following
+disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following
+disclaimer in the documentation and/or other materials provided with the distribution.
+
+3. Neither the names of the RoboSense, nor Suteng Innovation Technology, nor the names of other contributors may be used
+to endorse or promote products derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*********************************************************************************************************************/
+
+
+#pragma once
+
+#include <rs_driver/driver/driver_param.hpp>
+#include <rs_driver/driver/thread_setting.hpp>
+#include <rs_driver/utility/worker_pool.hpp>
+
+#ifndef _WIN32
+#include <rs_driver/driver/input/unix/recv_engine.hpp>
+#endif
+
+#include <memory>
+
+namespace robosense
+{
+namespace lidar
+{
+
+#ifdef _WIN32
+class RecvEngine;
+#endif
+
+/**
+ * @brief The threads shared by many LidarDrivers. 
+ *        Instead of a receiving thread and a handling thread for each Lidar, 
+ *        the sockets of all Lidars are watched by a few receiving threads (epoll loops),
+ *        and their packets are decoded by a pool of worker threads. 
+ *        Each Lidar still has its own callbacks. The packets of a Lidar are decoded in order.
+ *        On Windows, each Lidar receives in its own thread, and only the worker threads are shared.
+ */
+class LidarDriverManager
+{
+public:
+
+  LidarDriverManager()
+    : init_flag_(false), start_flag_(false)
+  {
+  }
+
+  ~LidarDriverManager()
+  {
+    stop();
+  }
+
+  /**
+   * @brief Create the threads, before LidarDriver::init(param, manager) is called 
+   * @param param The custom struct RSManagerParam
+   * @return If successful, return true; else return false
+   */
+  inline bool init(const RSManagerParam& param = RSManagerParam());
+
+  /**
+   * @brief Start the threads
+   * @return If successful, return true; else return false
+   */
+  inline bool start();
+
+  /**
+   * @brief Stop the threads. Stop the LidarDrivers before it
+   */
+  inline void stop();
+
+  std::shared_ptr<RecvEngine> recvEngine() const
+  {
+    return recv_engine_;
+  }
+
+  std::shared_ptr<WorkerPool> workerPool() const
+  {
+    return worker_pool_;
+  }
+
+private:
+
+  RSManagerParam param_;
+  std::shared_ptr<RecvEngine> recv_engine_;
+  std::shared_ptr<WorkerPool> worker_pool_;
+  bool init_flag_;
+  bool start_flag_;
+};
+
+inline bool LidarDriverManager::init(const RSManagerParam& param)
+{
+  if (init_flag_)
+  {
+    return true;
+  }
+
+#ifndef _WIN32
+  recv_engine_ = std::make_shared<RecvEngine>();
+  if (!recv_engine_->init(param.recv_thread_num))
+  {
+    recv_engine_.reset();
+    return false;
+  }
+#endif
+
+  worker_pool_ = std::make_shared<WorkerPool>();
+
+  param_ = param;
+  init_flag_ = true;
+  return true;
+}
+
+inline bool LidarDriverManager::start()
+{
+  if (start_flag_)
+  {
+    return true;
+  }
+
+  if (!init_flag_)
+  {
+    return false;
+  }
+
+  // the threads place themselves first, so they never run anywhere else.
+  RSThreadParam worker_param = param_.worker_thread_param;
+  worker_pool_->start(param_.worker_thread_num, [worker_param](size_t idx) {
+    applyThreadParam(indexThreadParam(worker_param, idx), "rs_worker" + std::to_string(idx));
+  });
+
+#ifndef _WIN32
+  RSThreadParam recv_param = param_.recv_thread_param;
+  recv_engine_->start([recv_param](size_t idx) {
+    applyThreadParam(indexThreadParam(recv_param, idx), "rs_recv" + std::to_string(idx));
+  });
+#endif
+
+  start_flag_ = true;
+  return true;
+}
+
+inline void LidarDriverManager::stop()
+{
+  if (!start_flag_)
+  {
+    return;
+  }
+
+#ifndef _WIN32
+  recv_engine_->stop();
+#endif
+
+  worker_pool_->stop();
+
+  start_flag_ = false;
+}
+
+}  // namespace lidar
+}  // namespace robosense
@@ -0,0 +1,363 @@
+/*********************************************************************************************************************
+Copyright (c) 2020 RoboSense
+All rights reserved
+
+By downloading, copying, installing or using the software you agree to this license. If you do not agree to this
+license, do not download, install, copy or use the software.
+
+License Agreement
+For RoboSense LiDAR SDK Library
+(3-clause BSD License)
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that the
+following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following
+disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following
+disclaimer in the documentation and/or other materials provided with the distribution.
+
+3. Neither the names of the RoboSense, nor Suteng Innovation Technology, nor the names of other contributors may be used
+to endorse or promote products derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*********************************************************************************************************************/
+
+
+#pragma once
+
+#include <rs_driver/api/lidar_driver.hpp>
+
+#ifndef _WIN32
+#include <rs_driver/utility/metrics_server.hpp>
+#endif
+
+#include <iomanip>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace robosense
+{
+namespace lidar
+{
+
+/**
+ * @brief Serve the metrics of LidarDrivers in Prometheus text format, e.g. for `curl http://127.0.0.1:port/metrics`.
+ *        The metrics are read from the lock-free counters of the drivers at each scrape, 
+ *        in the exporter's own thread, so the data path of the drivers is not touched.
+ *        Each driver is labeled with its name, as `lidar="name"`. Linux/Unix only.
+ */
+class MetricsExporter
+{
+public:
+
+  MetricsExporter()
+    : start_flag_(false)
+  {
+  }
+
+  ~MetricsExporter()
+  {
+    stop();
+  }
+
+  /**
+   * @brief Add a driver to export. The driver should live until the exporter is stopped.
+   * @param name The name of the driver, as the value of the label `lidar`
+   * @param driver The driver
+   */
+  template <typename T_PointCloud>
+  inline void addDriver(const std::string& name, LidarDriver<T_PointCloud>& driver);
+
+  /**
+   * @brief Listen on the TCP port or the Unix socket, and start the exporter thread
+   * @param param The custom struct RSMetricsParam
+   * @return If successful, return true; else return false
+   */
+  inline bool start(const RSMetricsParam& param = RSMetricsParam());
+
+  /**
+   * @brief Stop the exporter thread
+   */
+  inline void stop();
+
+  /**
+   * @brief The TCP port listened on. It is the port chosen by the system, if RSMetricsParam::port is 0.
+   */
+  inline uint16_t port() const;
+
+  /**
+   * @brief Render the metrics of all drivers in Prometheus text format, as a scrape gets
+   */
+  inline std::string render();
+
+#ifndef UNIT_TEST
+private:
+#endif
+
+  struct Source
+  {
+    std::string name;
+    std::function<bool(DriverStats&)> get_stats;
+    std::function<bool(float&)> get_temperature;
+    std::function<bool(RecordStats&)> get_record_stats;
+    std::function<bool(LatencyReport&)> get_latency_report;
+  };
+
+  static std::string label(const std::string& name);
+
+  std::mutex mtx_;
+  std::vector<Source> sources_;
+#ifndef _WIN32
+  std::shared_ptr<MetricsServer> server_;
+#endif
+  bool start_flag_;
+};
+
+template <typename T_PointCloud>
+inline void MetricsExporter::addDriver(const std::string& name, LidarDriver<T_PointCloud>& driver)
+{
+  LidarDriver<T_PointCloud>* d = &driver;
+
+  Source src;
+  src.name = name;
+  src.get_stats = [d](DriverStats& stats) { return d->getStats(stats); };
+  src.get_temperature = [d](float& temp) { return d->getTemperature(temp); };
+  src.get_record_stats = [d](RecordStats& stats) { return d->getRecordStats(stats); };
+  src.get_latency_report = [d](LatencyReport& report) { return d->getLatencyReport(report); };
+
+  std::lock_guard<std::mutex> lg(mtx_);
+  sources_.push_back(src);
+}
+
+inline bool MetricsExporter::start(const RSMetricsParam& param)
+{
+  if (start_flag_)
+  {
+    return true;
+  }
+
+#ifndef _WIN32
+  server_ = std::make_shared<MetricsServer>();
+  if (!server_->init(param, std::bind(&MetricsExporter::render, this)) || !server_->start())
+  {
+    server_.reset();
+    return false;
+  }
+
+  start_flag_ = true;
+  return true;
+#else
+  RS_ERROR << "MetricsExporter is not supported on Windows." << RS_REND;
+  return false;
+#endif
+}
+
+inline void MetricsExporter::stop()
+{
+  if (!start_flag_)
+  {
+    return;
+  }
+
+#ifndef _WIN32
+  server_.reset();
+#endif
+
+  start_flag_ = false;
+}
+
+inline uint16_t MetricsExporter::port() const
+{
+#ifndef _WIN32
+  return (server_ ? server_->port() : 0);
+#else
+  return 0;
+#endif
+}
+
+inline std::string MetricsExporter::label(const std::string& name)
+{
+  std::string str = "{lidar=\"";
+  for (char c : name)
+  {
+    switch (c)
+    {
+      case '\\': str += "\\\\"; break;
+      case '"':  str += "\\\""; break;
+      case '\n': str += "\\n"; break;
+      default:   str += c; break;
+    }
+  }
+
+  return str + "\"";
+}
+
+inline std::string MetricsExporter::render()
+{
+  struct Metric
+  {
+    const char* name;
+    const char* type;
+    const char* help;
+    uint64_t DriverStats::* member;
+    double scale;
+  };
+
+  static const Metric metrics[] = 
+  {
+    {"rs_driver_pkts_total", "counter", "Packets received", &DriverStats::pkts, 1},
+    {"rs_driver_msop_pkts_total", "counter", "MSOP packets handled", &DriverStats::msop_pkts, 1},
+    {"rs_driver_difop_pkts_total", "counter", "DIFOP packets handled", &DriverStats::difop_pkts, 1},
+    {"rs_driver_wrong_len_pkts_total", "counter", "Packets with wrong length", &DriverStats::wrong_len_pkts, 1},
+    {"rs_driver_wrong_id_pkts_total", "counter", "Packets with wrong id", &DriverStats::wrong_id_pkts, 1},
+    {"rs_driver_no_difop_pkts_total", "counter", "MSOP packets ignored before DIFOP packet", 
+      &DriverStats::no_difop_pkts, 1},
+    {"rs_driver_queue_dropped_pkts_total", "counter", "Packets dropped since the packet queue overflows", 
+      &DriverStats::queue_dropped_pkts, 1},
+    {"rs_driver_out_of_order_pkts_total", "counter", "MSOP packets late or duplicated", 
+      &DriverStats::out_of_order_pkts, 1},
+    {"rs_driver_cloud_overflows_total", "counter", "Point clouds of too many points", 
+      &DriverStats::cloud_overflows, 1},
+    {"rs_driver_frames_total", "counter", "Point clouds delivered", &DriverStats::frames, 1},
+    {"rs_driver_empty_frames_total", "counter", "Frames without any point", &DriverStats::empty_frames, 1},
+    {"rs_driver_lossy_frames_total", "counter", "Frames with lost packets", &DriverStats::lossy_frames, 1},
+    {"rs_driver_points_total", "counter", "Points of delivered point clouds", &DriverStats::points, 1},
+    {"rs_driver_decode_seconds_total", "counter", "Time spent in decoding MSOP packets", 
+      &DriverStats::decode_ns, 1e-9},
+    {"rs_driver_degrade_changes_total", "counter", "Times the degrade modes changed", 
+      &DriverStats::degrade_changes, 1},
+    {"rs_driver_last_frame_points", "gauge", "Points of the last point cloud", &DriverStats::last_frame_points, 1},
+    {"rs_driver_queue_depth", "gauge", "Packets in the packet queue", &DriverStats::queue_depth, 1},
+    {"rs_driver_lost_pkts", "gauge", "Estimated lost MSOP packets. It goes down if a packet counted lost arrives late", 
+      &DriverStats::lost_pkts, 1},
+    {"rs_driver_degrade_modes", "gauge", "Degrade modes enabled, bits of DegradeMode", 
+      &DriverStats::degrade_modes, 1},
+    {"rs_driver_rpm", "gauge", "RPM in the last DIFOP packet", &DriverStats::rpm, 1},
+  };
+
+  //
+  // sample all drivers first, and then print them metric by metric.
+  //
+  struct Sample
+  {
+    std::string label;
+    bool stats_ok;
+    DriverStats stats;
+    bool temp_ok;
+    float temp;
+    bool record_ok;
+    RecordStats record;
+    bool latency_ok;
+    LatencyReport latency;
+  };
+
+  std::vector<Sample> samples;
+  {
+    std::lock_guard<std::mutex> lg(mtx_);
+    samples.resize(sources_.size());
+    for (size_t i = 0; i < sources_.size(); i++)
+    {
+      // nothing of a driver not initialized.
+      Sample& s = samples[i];
+      s.label = label(sources_[i].name);
+      s.stats_ok = sources_[i].get_stats(s.stats);
+      s.temp_ok = s.stats_ok && sources_[i].get_temperature(s.temp);
+      s.record_ok = s.stats_ok && sources_[i].get_record_stats(s.record);
+      s.latency_ok = s.stats_ok && sources_[i].get_latency_report(s.latency);
+    }
+  }
+
+  std::stringstream ss;
+  ss << std::setprecision(10);
+
+  for (const Metric& m : metrics)
+  {
+    ss << "# HELP " << m.name << " " << m.help << "\n" << "# TYPE " << m.name << " " << m.type << "\n";
+    for (const Sample& s : samples)
+    {
+      if (s.stats_ok)
+      {
+        // counters as integers, so that they keep all their digits.
+        ss << m.name << s.label << "} ";
+        if (m.scale == 1)
+        {
+          ss << s.stats.*(m.member) << "\n";
+        }
+        else
+        {
+          ss << (double)(s.stats.*(m.member)) * m.scale << "\n";
+        }
+      }
+    }
+  }
+
+  ss << "# HELP rs_driver_temperature_celsius Lidar temperature\n" 
+    << "# TYPE rs_driver_temperature_celsius gauge\n";
+  for (const Sample& s : samples)
+  {
+    if (s.temp_ok)
+    {
+      ss << "rs_driver_temperature_celsius" << s.label << "} " << s.temp << "\n";
+    }
+  }
+
+  ss << "# HELP rs_driver_record_pkts_total Packets recorded\n" 
+    << "# TYPE rs_driver_record_pkts_total counter\n";
+  for (const Sample& s : samples)
+  {
+    if (s.record_ok)
+    {
+      ss << "rs_driver_record_pkts_total" << s.label << "} " << s.record.packets << "\n";
+    }
+  }
+
+  ss << "# HELP rs_driver_record_dropped_pkts_total Packets not recorded since the write buffers are full\n" 
+    << "# TYPE rs_driver_record_dropped_pkts_total counter\n";
+  for (const Sample& s : samples)
+  {
+    if (s.record_ok)
+    {
+      ss << "rs_driver_record_dropped_pkts_total" << s.label << "} " << s.record.dropped << "\n";
+    }
+  }
+
+  // only with ENABLE_LATENCY_STATS.
+  ss << "# HELP rs_driver_latency_seconds Latency of the stages from packet receiving to the point cloud callback\n" 
+    << "# TYPE rs_driver_latency_seconds summary\n";
+  for (const Sample& s : samples)
+  {
+    if (!s.latency_ok)
+    {
+      continue;
+    }
+
+    for (int i = 0; i < LAT_STAGE_NUM; i++)
+    {
+      const LatencySummary& l = s.latency.stages[i];
+      std::string lbl = s.label + ",stage=\"" + latencyStageToStr(i) + "\"";
+
+      ss << "rs_driver_latency_seconds" << lbl << ",quantile=\"0.5\"} " << l.p50 * 1e-6 << "\n"
+        << "rs_driver_latency_seconds" << lbl << ",quantile=\"0.9\"} " << l.p90 * 1e-6 << "\n"
+        << "rs_driver_latency_seconds" << lbl << ",quantile=\"0.99\"} " << l.p99 * 1e-6 << "\n"
+        << "rs_driver_latency_seconds" << lbl << ",quantile=\"0.999\"} " << l.p999 * 1e-6 << "\n"
+        << "rs_driver_latency_seconds_sum" << lbl << "} " << l.mean * l.count * 1e-6 << "\n"
+        << "rs_driver_latency_seconds_count" << lbl << "} " << l.count << "\n";
+    }
+  }
+
+  return ss.str();
+}
+
+}  // namespace lidar
+}  // namespace robosense
@@ -0,0 +1,115 @@
+/*********************************************************************************************************************
+Copyright (c) 2020 RoboSense
+All rights reserved
+
+By downloading, copying, installing or using the software you agree to this license. If you do not agree to this
+license, do not download, install, copy or use the software.
+
+License Agreement
+For RoboSense LiDAR SDK Library
+(3-clause BSD License)
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that the
+following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following
+disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following
+disclaimer in the documentation and/or other materials provided with the distribution.
+
+3. Neither the names of the RoboSense, nor Suteng Innovation Technology, nor the names of other contributors may be used
+to endorse or promote products derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*********************************************************************************************************************/
+
+
+#pragma once
+
+#include <rs_driver/driver/offline_decoder_impl.hpp>
+
+namespace robosense
+{
+namespace lidar
+{
+
+/**
+ * @brief Pull-style decoder of PCAP files or log files. It runs entirely in the caller's thread,
+ *        and the result is reproducible, so it fits unit tests, regression tests and batch jobs.
+ */
+template <typename T_PointCloud>
+class OfflineDecoder
+{
+public:
+
+  /**
+   * @brief Constructor, instanciate the decoder pointer
+   */
+  OfflineDecoder() 
+    : decoder_ptr_(std::make_shared<OfflineDecoderImpl<T_PointCloud>>())
+  {
+  }
+
+  /**
+   * @brief Register the exception message callback function. When error occurs, this function will be called
+   * @param callback The callback function
+   */
+  inline void regExceptionCallback(const std::function<void(const Error&)>& cb_excep)
+  {
+    decoder_ptr_->regExceptionCallback(cb_excep);
+  }
+
+  /**
+   * @brief Open the PCAP files or log files
+   * @param param The custom struct RSDriverParam. input_type should be PCAP_FILE or LOG_FILE.
+   *        pcap_repeat and pcap_rate are ignored. Point cloud is always stamped with lidar clock.
+   * @return If successful, return true; else return false
+   */
+  inline bool open(const RSDriverParam& param)
+  {
+    return decoder_ptr_->open(param);
+  }
+
+  /**
+   * @brief Decode packets until the next frame is ready
+   * @param cloud The variable to store the frame. If it holds a point cloud, and no other copy of it is kept,
+   *        the cloud is reused for decoding.
+   * @return If a frame is ready, return true; at the end of the files, return false. 
+   *         The last incomplete frame is dropped.
+   */
+  inline bool nextFrame(std::shared_ptr<T_PointCloud>& cloud)
+  {
+    return decoder_ptr_->nextFrame(cloud);
+  }
+
+  /**
+   * @brief Get the current lidar temperature
+   * @param temp The variable to store lidar temperature
+   * @return if get temperature successfully, return true; else return false
+   */
+  inline bool getTemperature(float& temp)
+  {
+    return decoder_ptr_->getTemperature(temp);
+  }
+
+  /**
+   * @brief Close the files
+   */
+  inline void close()
+  {
+    decoder_ptr_->close();
+  }
+
+private:
+  std::shared_ptr<OfflineDecoderImpl<T_PointCloud>> decoder_ptr_;  ///< The decoder pointer
+};
+
+}  // namespace lidar
+}  // namespace robosense
@@ -34,6 +34,8 @@ THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 #include <string>
 #include <ctime>
+#include <atomic>
+#include <functional>
 
 namespace robosense
 {
@@ -59,6 +61,7 @@ enum ErrCode
   ERRCODE_SUCCESS         = 0x00,  ///< Normal
   ERRCODE_PCAPREPEAT      = 0x01,  ///< Pcap file will play repeatedly
   ERRCODE_PCAPEXIT        = 0x02,  ///< Pcap thread will exit
+  ERRCODE_DECODERECOVER   = 0x03,  ///< Decoding recovers from overload, and disables a degrade mode
 
   // warning
   ERRCODE_MSOPTIMEOUT     = 0x40,  ///< Msop packets receive overtime (1 sec)
@@ -72,6 +75,11 @@ enum ErrCode
   ERRCODE_ZEROPOINTS      = 0x48,  ///< Size of the point cloud is zero
   ERRCODE_PKTBUFOVERFLOW  = 0x49,  ///< Packet buffer is overflow
   ERRCODE_CLOUDOVERFLOW   = 0x4a,  ///< Point cloud buffer is overflow
+  ERRCODE_RECORDOVERFLOW  = 0x4b,  ///< Record buffer is overflow, and packets are dropped
+  ERRCODE_FUSIONLATEPKT   = 0x4c,  ///< Packet is too late for its fused frame, and dropped
+  ERRCODE_DECODEDEGRADE   = 0x4d,  ///< Decoding is overloaded, and enables a degrade mode
+  ERRCODE_ALLOCEXCEEDED   = 0x4e,  ///< Heap allocations of a packet or a frame exceed the steady state (RSAllocParam)
+  ERRCODE_PKTOVERSIZE     = 0x4f,  ///< Packet is larger than the packet buffer, and dropped
 
   // error
   ERRCODE_STARTBEFOREINIT = 0x80,  ///< start() function is called before initializing successfully
@@ -116,6 +124,8 @@ struct Error
         return "Info_PcapRepeat";
       case ERRCODE_PCAPEXIT:
         return "Info_PcapExit";
+      case ERRCODE_DECODERECOVER:
+        return "Info_DecodeRecover";
 
       // warning
       case ERRCODE_MSOPTIMEOUT:
@@ -152,6 +162,16 @@ struct Error
         return "ERRCODE_PKTBUFOVERFLOW";
       case ERRCODE_CLOUDOVERFLOW:
         return "ERRCODE_CLOUDOVERFLOW";
+      case ERRCODE_RECORDOVERFLOW:
+        return "ERRCODE_RECORDOVERFLOW";
+      case ERRCODE_FUSIONLATEPKT:
+        return "ERRCODE_FUSIONLATEPKT";
+      case ERRCODE_DECODEDEGRADE:
+        return "ERRCODE_DECODEDEGRADE";
+      case ERRCODE_ALLOCEXCEEDED:
+        return "ERRCODE_ALLOCEXCEEDED";
+      case ERRCODE_PKTOVERSIZE:
+        return "ERRCODE_PKTOVERSIZE";
 
       //default
       default:
@@ -182,5 +202,60 @@ struct Error
   }                             \
 }
 
+//
+// Rate limit of the exception callback per error code, within an object (e.g. a driver instance). 
+// Unlike LIMIT_CALL, whose limit is per call site and shared by all instances, the errors of 
+// different Lidars don't suppress each other.
+//
+class ErrorLimiter
+{
+public:
+
+  ErrorLimiter()
+  {
+    for (auto& tm : prev_tm_)
+    {
+      tm.store(0, std::memory_order_relaxed);
+    }
+  }
+
+  //
+  // Is the error allowed now? At most once per sec+1 seconds.
+  // With delay, the first one is suppressed too, as DELAY_LIMIT_CALL.
+  //
+  bool allow(ErrCode code, time_t sec, bool delay = false)
+  {
+    std::atomic<int64_t>& prev = prev_tm_[code & 0xFF];
+    int64_t cur_tm = (int64_t)time(NULL);
+    int64_t prev_tm = prev.load(std::memory_order_relaxed);
+
+    if (prev_tm == 0 && delay)
+    {
+      prev.store(cur_tm, std::memory_order_relaxed);
+      return false;
+    }
+
+    if ((cur_tm - prev_tm) > sec)
+    {
+      prev.store(cur_tm, std::memory_order_relaxed);
+      return true;
+    }
+
+    return false;
+  }
+
+  void call(const std::function<void(const Error&)>& cb, ErrCode code, time_t sec, bool delay = false)
+  {
+    if (cb && allow(code, sec, delay))
+    {
+      cb(Error(code));
+    }
+  }
+
+private:
+
+  std::atomic<int64_t> prev_tm_[256];
+};
+
 }  // namespace lidar
 }  // namespace robosense
@@ -40,6 +40,7 @@ THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include <functional>
 #include <chrono>
 #include <mutex>
+#include <cstring>
 
 namespace robosense
 {
@@ -34,7 +34,9 @@ THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 #include <rs_driver/common/error_code.hpp>
 #include <rs_driver/driver/driver_param.hpp>
+#include <rs_driver/driver/driver_stats.hpp>
 #include <rs_driver/driver/decoder/member_checker.hpp>
+#include <rs_driver/driver/decoder/loss_estimator.hpp>
 #include <rs_driver/driver/decoder/trigon.hpp>
 #include <rs_driver/driver/decoder/section.hpp>
 #include <rs_driver/driver/decoder/basic_attr.hpp>
@@ -259,17 +261,67 @@ public:
   void processDifopPkt(const uint8_t* pkt, size_t size);
   bool processMsopPkt(const uint8_t* pkt, size_t size);
 
+  // max points of a point cloud of a Lidar
+  constexpr static size_t CLOUD_POINT_MAX = 1000000;
+
+  //
+  // Max points of point_cloud_, before ERRCODE_CLOUDOVERFLOW. 
+  // It's larger if point_cloud_ is shared by several Lidars, e.g. in FusionDriver.
+  //
+  void setCloudPointMax(size_t num)
+  {
+    cloud_point_max_ = num;
+  }
+
+  //
+  // Don't grow point_cloud_ any more, since its points are referred to by others, e.g. sectors.
+  // A packet not fitting in its capacity finishes the frame early, as a cloud overflow.
+  //
+  void fixCloudCapacity(bool fixed)
+  {
+    cloud_fixed_ = fixed;
+  }
+
+  bool cloudFixed() const
+  {
+    return cloud_fixed_;
+  }
+
+  size_t pointsPerPkt() const
+  {
+    return (size_t)const_param_.BLOCKS_PER_PKT * const_param_.CHANNELS_PER_BLOCK;
+  }
+
+  //
+  // Points of a frame at most, by the split mode, the rpm and the echo mode.
+  // It's the capacity reserved for a frame, if its points are referred to by sectors.
+  //
+  virtual size_t framePoints();
+
   explicit Decoder(const RSDecoderConstParam& const_param, const RSDecoderParam& param);
 
   float getTemperature();
   double getPacketDuration();
+  const RSDecoderConstParam& constParam() const
+  {
+    return const_param_;
+  }
   void enableWritePktTs(bool value);
   double prevPktTs();
+  void getStats(DriverStats& stats) const;
+  void endFrame(FrameQuality& quality);
+  void setDegrade(uint8_t modes);
+  bool densePoints() const
+  {
+    return param_.dense_points;
+  }
   void transformPoint(float& x, float& y, float& z);
 
   void regCallback(
       const std::function<void(const Error&)>& cb_excep,
       const std::function<void(uint16_t, double)>& cb_split_frame);
+  void regSectorCallback(const std::function<void(void)>& cb_split_sector);
+  void regBlockCallback(const std::function<void(int32_t)>& cb_new_block);
 
   std::shared_ptr<T_PointCloud> point_cloud_; // accumulated point cloud currently
 
@@ -278,10 +330,19 @@ protected:
 #endif
 
   double cloudTs();
+  void countLoss(int32_t lost);
+  void countSeq(SeqLossEstimator& estimator, uint16_t seq);
+  bool skipPoint(uint16_t ring) const
+  {
+    return (degrade_ != 0) && 
+      (((degrade_ & DEGRADE_DROP_SECOND_ECHO) && second_echo_) || ((degrade_ & DEGRADE_DECIMATE_RINGS) && (ring & 1)));
+  }
 
   RSDecoderConstParam const_param_; // const param
   RSDecoderParam param_; // user param
   std::function<void(uint16_t, double)> cb_split_frame_;
+  std::function<void(void)> cb_split_sector_;
+  std::function<void(int32_t)> cb_new_block_;
   std::function<void(const Error&)> cb_excep_;
   bool write_pkt_ts_;
 
@@ -303,6 +364,21 @@ protected:
   double prev_pkt_ts_; // timestamp of prevous packet
   double prev_point_ts_; // timestamp of previous point
   double first_point_ts_; // timestamp of first point
+  bool dense_points_; // dense_points of the user param
+  uint8_t degrade_; // degrade modes enabled now
+  size_t cloud_point_max_; // max points of point_cloud_
+  bool cloud_fixed_; // is the capacity of point_cloud_ fixed?
+  bool second_echo_; // is the block being decoded the second echo?
+
+  ErrorLimiter err_limiter_; // rate limit of errors, per decoder
+  StatCounter wrong_len_pkts_;
+  StatCounter wrong_id_pkts_;
+  StatCounter no_difop_pkts_;
+  StatCounter cloud_overflows_;
+  StatCounter lost_pkts_;
+  StatCounter out_of_order_pkts_;
+  StatCounter rpm_;
+  FrameLossTracker frame_loss_; // packets of the frame being decoded
 };
 
 template <typename T_PointCloud>
@@ -314,6 +390,18 @@ inline void Decoder<T_PointCloud>::regCallback(
   cb_split_frame_ = cb_split_frame;
 }
 
+template <typename T_PointCloud>
+inline void Decoder<T_PointCloud>::regSectorCallback(const std::function<void(void)>& cb_split_sector)
+{
+  cb_split_sector_ = cb_split_sector;
+}
+
+template <typename T_PointCloud>
+inline void Decoder<T_PointCloud>::regBlockCallback(const std::function<void(int32_t)>& cb_new_block)
+{
+  cb_new_block_ = cb_new_block;
+}
+
 template <typename T_PointCloud>
 inline Decoder<T_PointCloud>::Decoder(const RSDecoderConstParam& const_param, const RSDecoderParam& param)
   : const_param_(const_param)
@@ -327,6 +415,11 @@ inline Decoder<T_PointCloud>::Decoder(const RSDecoderConstParam& const_param, co
   , prev_pkt_ts_(0.0)
   , prev_point_ts_(0.0)
   , first_point_ts_(0.0)
+  , dense_points_(param.dense_points)
+  , degrade_(0)
+  , cloud_point_max_(CLOUD_POINT_MAX)
+  , cloud_fixed_(false)
+  , second_echo_(false)
 {
 #ifdef ENABLE_TRANSFORM
   Eigen::AngleAxisd current_rotation_x(param_.transform_param.roll, Eigen::Vector3d::UnitX());
@@ -356,12 +449,70 @@ inline double Decoder<T_PointCloud>::getPacketDuration()
   return packet_duration_;
 }
 
+template <typename T_PointCloud>
+inline size_t Decoder<T_PointCloud>::framePoints()
+{
+  // packets of 0.2 second (300 rpm).
+  size_t pkt_num = (packet_duration_ > 0) ? (size_t)(0.2 / packet_duration_) + 1 : 1000;
+  return pkt_num * pointsPerPkt();
+}
+
 template <typename T_PointCloud>
 inline double Decoder<T_PointCloud>::prevPktTs()
 {
   return prev_pkt_ts_;
 }
 
+template <typename T_PointCloud>
+inline void Decoder<T_PointCloud>::getStats(DriverStats& stats) const
+{
+  stats.wrong_len_pkts = wrong_len_pkts_.get();
+  stats.wrong_id_pkts = wrong_id_pkts_.get();
+  stats.no_difop_pkts = no_difop_pkts_.get();
+  stats.cloud_overflows = cloud_overflows_.get();
+  stats.lost_pkts = lost_pkts_.get();
+  stats.out_of_order_pkts = out_of_order_pkts_.get();
+  stats.rpm = rpm_.get();
+}
+
+template <typename T_PointCloud>
+inline void Decoder<T_PointCloud>::countLoss(int32_t lost)
+{
+  if (lost > 0)
+  {
+    lost_pkts_.add(lost);
+  }
+  else if (lost < 0)
+  {
+    // it was counted lost.
+    out_of_order_pkts_.add(1);
+    lost_pkts_.sub(1);
+  }
+}
+
+template <typename T_PointCloud>
+inline void Decoder<T_PointCloud>::countSeq(SeqLossEstimator& estimator, uint16_t seq)
+{
+  int32_t lost = estimator.newPacket(seq);
+  countLoss(lost);
+
+  frame_loss_.newSeq(seq, estimator.seqMax(), (lost < 0), 
+      (param_.split_frame_mode != SplitFrameMode::SPLIT_BY_TIME));
+}
+
+template <typename T_PointCloud>
+inline void Decoder<T_PointCloud>::endFrame(FrameQuality& quality)
+{
+  frame_loss_.endFrame(quality);
+}
+
+template <typename T_PointCloud>
+inline void Decoder<T_PointCloud>::setDegrade(uint8_t modes)
+{
+  degrade_ = modes;
+  param_.dense_points = dense_points_ || (modes & DEGRADE_SKIP_NAN);
+}
+
 template <typename T_PointCloud>
 inline double Decoder<T_PointCloud>::cloudTs()
 {
@@ -372,6 +523,11 @@ template <typename T_PointCloud>
 inline void Decoder<T_PointCloud>::transformPoint(float& x, float& y, float& z)
 {
 #ifdef ENABLE_TRANSFORM
+  if (degrade_ & DEGRADE_NO_TRANSFORM)
+  {
+    return;
+  }
+
   Eigen::Vector4d target_ori(x, y, z, 1);
   Eigen::Vector4d target_rotate = trans_ * target_ori;
   x = target_rotate(0);
@@ -385,13 +541,15 @@ inline void Decoder<T_PointCloud>::processDifopPkt(const uint8_t* pkt, size_t si
 {
   if (size != this->const_param_.DIFOP_LEN)
   {
-     LIMIT_CALL(this->cb_excep_(Error(ERRCODE_WRONGDIFOPLEN)), 1);
-     return;
+    wrong_len_pkts_.add(1);
+    err_limiter_.call(cb_excep_, ERRCODE_WRONGDIFOPLEN, 1);
+    return;
   }
 
   if (memcmp(pkt, this->const_param_.DIFOP_ID, const_param_.DIFOP_ID_LEN) != 0)
   {
-    LIMIT_CALL(this->cb_excep_(Error(ERRCODE_WRONGDIFOPID)), 1);
+    wrong_id_pkts_.add(1);
+    err_limiter_.call(cb_excep_, ERRCODE_WRONGDIFOPID, 1);
     return;
   }
 
@@ -401,32 +559,50 @@ inline void Decoder<T_PointCloud>::processDifopPkt(const uint8_t* pkt, size_t si
 template <typename T_PointCloud>
 inline bool Decoder<T_PointCloud>::processMsopPkt(const uint8_t* pkt, size_t size)
 {
-  constexpr static int CLOUD_POINT_MAX = 1000000;
-
-  if (this->point_cloud_ && (this->point_cloud_->points.size() > CLOUD_POINT_MAX))
+  if (this->point_cloud_ && (this->point_cloud_->points.size() > cloud_point_max_))
   {
-     LIMIT_CALL(this->cb_excep_(Error(ERRCODE_CLOUDOVERFLOW)), 1);
+    cloud_overflows_.add(1);
+    err_limiter_.call(cb_excep_, ERRCODE_CLOUDOVERFLOW, 1);
   }
 
   if (param_.wait_for_difop && !angles_ready_)
   {
-     DELAY_LIMIT_CALL(cb_excep_(Error(ERRCODE_NODIFOPRECV)), 1);
-     return false;
+    no_difop_pkts_.add(1);
+    err_limiter_.call(cb_excep_, ERRCODE_NODIFOPRECV, 1, true);
+    return false;
   }
 
   if (size != this->const_param_.MSOP_LEN)
   {
-     LIMIT_CALL(this->cb_excep_(Error(ERRCODE_WRONGMSOPLEN)), 1);
-     return false;
+    wrong_len_pkts_.add(1);
+    err_limiter_.call(cb_excep_, ERRCODE_WRONGMSOPLEN, 1);
+    return false;
   }
 
   if (memcmp(pkt, this->const_param_.MSOP_ID, this->const_param_.MSOP_ID_LEN) != 0)
   {
-    LIMIT_CALL(this->cb_excep_(Error(ERRCODE_WRONGMSOPID)), 1);
+    wrong_id_pkts_.add(1);
+    err_limiter_.call(cb_excep_, ERRCODE_WRONGMSOPID, 1);
     return false;
   }
 
-  return decodeMsopPkt(pkt, size);
+  bool split = false;
+  if (cloud_fixed_ && 
+      (this->point_cloud_->points.capacity() - this->point_cloud_->points.size() < pointsPerPkt()))
+  {
+    // the frame is larger than its reserved capacity. Finish it here, 
+    // so that the next one is reserved larger, instead of dropping all packets from now on.
+    cloud_overflows_.add(1);
+    err_limiter_.call(cb_excep_, ERRCODE_CLOUDOVERFLOW, 1);
+
+    cb_split_frame_(const_param_.LASER_NUM, cloudTs());
+    first_point_ts_ = prev_point_ts_;
+    split = true;
+  }
+
+  bool ret = decodeMsopPkt(pkt, size);
+  frame_loss_.newPacket();
+  return (ret || split);
 }
 
 }  // namespace lidar
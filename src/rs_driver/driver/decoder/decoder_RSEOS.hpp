@@ -99,6 +99,8 @@ private:
   RSEchoMode getEchoMode(uint8_t mode);
 
   SplitStrategyBySeq split_strategy_;
+  SplitStrategyByTime time_split_strategy_;
+  SeqLossEstimator loss_estimator_;
 };
 
 template <typename T_PointCloud>
@@ -128,6 +130,8 @@ inline RSDecoderConstParam& DecoderRSEOS<T_PointCloud>::getConstParam()
 template <typename T_PointCloud>
 inline DecoderRSEOS<T_PointCloud>::DecoderRSEOS(const RSDecoderParam& param)
   : Decoder<T_PointCloud>(getConstParam(), param)
+  , time_split_strategy_(param.split_period, param.split_phase)
+  , loss_estimator_(SINGLE_PKT_NUM)
 {
   this->packet_duration_ = FRAME_DURATION / SINGLE_PKT_NUM;
   this->angles_ready_ = true;
@@ -180,13 +184,17 @@ inline bool DecoderRSEOS<T_PointCloud>::decodeMsopPkt(const uint8_t* packet, siz
   }
 
   uint16_t pkt_seq = ntohs(pkt.header.pkt_seq);
-  if (split_strategy_.newPacket(pkt_seq))
+  bool split = (this->param_.split_frame_mode == SplitFrameMode::SPLIT_BY_TIME) ? 
+    time_split_strategy_.newTs(pkt_ts) : split_strategy_.newPacket(pkt_seq);
+  if (split)
   {
     this->cb_split_frame_(this->const_param_.LASER_NUM, this->cloudTs());
     this->first_point_ts_ = pkt_ts;
     ret = true;
   }
 
+  this->countSeq(loss_estimator_, pkt_seq); // in the frame it starts, if split
+
   for (uint16_t blk = 0; blk < this->const_param_.BLOCKS_PER_PKT; blk++)
   {
     const RSEOSBlock& block = pkt.blocks[blk];
@@ -199,7 +207,7 @@ inline bool DecoderRSEOS<T_PointCloud>::decodeMsopPkt(const uint8_t* packet, siz
 
       float distance = ntohs(channel.distance) * this->const_param_.DISTANCE_RES;
 
-      if (this->distance_section_.in(distance))
+      if (this->distance_section_.in(distance) && !this->skipPoint(chan))
       {
         int16_t vector_x = RS_SWAP_INT16(channel.x);
         int16_t vector_y = RS_SWAP_INT16(channel.y);
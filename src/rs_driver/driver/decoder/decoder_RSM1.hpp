@@ -154,6 +154,8 @@ private:
   RSEchoMode getEchoMode(uint8_t mode);
 
   SplitStrategyBySeq split_strategy_;
+  SplitStrategyByTime time_split_strategy_;
+  SeqLossEstimator loss_estimator_;
 };
 
 template <typename T_PointCloud>
@@ -183,6 +185,8 @@ inline RSDecoderConstParam& DecoderRSM1<T_PointCloud>::getConstParam()
 template <typename T_PointCloud>
 inline DecoderRSM1<T_PointCloud>::DecoderRSM1(const RSDecoderParam& param)
   : Decoder<T_PointCloud>(getConstParam(), param)
+  , time_split_strategy_(param.split_period, param.split_phase)
+  , loss_estimator_(SINGLE_PKT_NUM)
 {
   this->packet_duration_ = FRAME_DURATION / SINGLE_PKT_NUM;
   this->angles_ready_ = true;
@@ -237,13 +241,17 @@ inline bool DecoderRSM1<T_PointCloud>::decodeMsopPkt(const uint8_t* packet, size
   }
 
   uint16_t pkt_seq = ntohs(pkt.header.pkt_seq);
-  if (split_strategy_.newPacket(pkt_seq))
+  bool split = (this->param_.split_frame_mode == SplitFrameMode::SPLIT_BY_TIME) ? 
+    time_split_strategy_.newTs(pkt_ts) : split_strategy_.newPacket(pkt_seq);
+  if (split)
   {
     this->cb_split_frame_(this->const_param_.LASER_NUM, this->cloudTs());
     this->first_point_ts_ = pkt_ts;
     ret = true;
   }
 
+  this->countSeq(loss_estimator_, pkt_seq); // in the frame it starts, if split
+
   for (uint16_t blk = 0; blk < this->const_param_.BLOCKS_PER_PKT; blk++)
   {
     const RSM1Block& block = pkt.blocks[blk];
@@ -256,7 +264,7 @@ inline bool DecoderRSM1<T_PointCloud>::decodeMsopPkt(const uint8_t* packet, size
 
       float distance = ntohs(channel.distance) * this->const_param_.DISTANCE_RES;
 
-      if (this->distance_section_.in(distance))
+      if (this->distance_section_.in(distance) && !this->skipPoint(chan))
       {
         int pitch = ntohs(channel.pitch) - ANGLE_OFFSET;
         int yaw = ntohs(channel.yaw) - ANGLE_OFFSET;
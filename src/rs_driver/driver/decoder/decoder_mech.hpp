@@ -77,6 +77,7 @@ public:
   explicit DecoderMech(const RSDecoderMechConstParam& const_param, const RSDecoderParam& param);
 
   void print();
+  virtual size_t framePoints();
 
 #ifndef UNIT_TEST
 protected:
@@ -85,16 +86,23 @@ protected:
   template <typename T_Difop>
   void decodeDifopCommon(const T_Difop& pkt);
 
+  bool splitBlock(int32_t angle, double ts);
+
   RSDecoderMechConstParam mech_const_param_; // const param 
   ChanAngles chan_angles_; // vert_angles/horiz_angles adjustment
   AzimuthSection scan_section_; // valid azimuth section
   std::shared_ptr<SplitStrategy> split_strategy_; // split strategy
+  std::shared_ptr<SplitStrategy> sector_strategy_; // split strategy of sectors
 
   uint16_t rps_; // rounds per second
   uint16_t blks_per_frame_; // blocks per frame/round
   uint16_t split_blks_per_frame_; // blocks in msop pkt per frame/round. 
   uint16_t block_az_diff_; // azimuth difference between adjacent blocks.
   double fov_blind_ts_diff_; // timestamp difference across blind section(defined by fov)
+  AzimuthLossEstimator loss_estimator_; // lost packets by azimuth gaps
+  uint64_t lost_blks_; // blocks counted lost
+  uint64_t late_blks_; // blocks arriving late
+  int32_t prev_blk_angle_; // azimuth of the previous block
 };
 
 template <typename T_PointCloud>
@@ -109,6 +117,9 @@ inline DecoderMech<T_PointCloud>::DecoderMech(const RSDecoderMechConstParam& con
   , split_blks_per_frame_(blks_per_frame_)
   , block_az_diff_(20)
   , fov_blind_ts_diff_(0.0)
+  , lost_blks_(0)
+  , late_blks_(0)
+  , prev_blk_angle_(-1)
 {
   this->packet_duration_ = 
     this->mech_const_param_.BLOCK_DURATION * this->const_param_.BLOCKS_PER_PKT;
@@ -123,13 +134,27 @@ inline DecoderMech<T_PointCloud>::DecoderMech(const RSDecoderMechConstParam& con
       split_strategy_ = std::make_shared<SplitStrategyByNum>(&this->param_.num_blks_split);
       break;
 
+    case SplitFrameMode::SPLIT_BY_TIME:
+      split_strategy_ = std::make_shared<SplitStrategyByTime>(this->param_.split_period, this->param_.split_phase);
+      break;
+
     case SplitFrameMode::SPLIT_BY_ANGLE:
     default:
       uint16_t angle = (uint16_t)(this->param_.split_angle * 100);
-      split_strategy_ = std::make_shared<SplitStrategyByAngle>(angle);
+      split_strategy_ = std::make_shared<SplitStrategyByAngle>(angle, &this->block_az_diff_);
       break;
   }
 
+  if (this->param_.sector_angle > 0)
+  {
+    sector_strategy_ = std::make_shared<SplitStrategyBySector>(
+        (int32_t)(this->param_.split_angle * 100), (int32_t)(this->param_.sector_angle * 100));
+  }
+  else if (this->param_.sector_blks > 0)
+  {
+    sector_strategy_ = std::make_shared<SplitStrategyByBlks>(this->param_.sector_blks);
+  }
+
   if (this->param_.config_from_file)
   {
     int ret = chan_angles_.loadFromFile(this->param_.angle_path);
@@ -161,11 +186,43 @@ inline void DecoderMech<T_PointCloud>::print()
   this->chan_angles_.print();
 }
 
+template <typename T_PointCloud>
+inline size_t DecoderMech<T_PointCloud>::framePoints()
+{
+  // before the difop packet, the slowest rpm (300) and dual return.
+  bool difop_ready = (this->rpm_.get() > 0);
+  double rps = difop_ready ? this->rps_ : 5;
+  bool dual = !difop_ready || (this->echo_mode_ == RSEchoMode::ECHO_DUAL);
+
+  // packets come twice as often with dual return.
+  double pkt_duration = this->packet_duration_ / (dual ? 2 : 1);
+
+  double pkt_num;
+  switch (this->param_.split_frame_mode)
+  {
+    case SplitFrameMode::SPLIT_BY_CUSTOM_BLKS:
+      pkt_num = (double)this->param_.num_blks_split / this->const_param_.BLOCKS_PER_PKT;
+      break;
+
+    case SplitFrameMode::SPLIT_BY_TIME:
+      pkt_num = std::max(this->param_.split_period, 0.1) / pkt_duration;
+      break;
+
+    default:
+      pkt_num = 1 / (rps * pkt_duration);
+      break;
+  }
+
+  return ((size_t)pkt_num + 2) * this->pointsPerPkt();
+}
+
 template <typename T_PointCloud>
 template <typename T_Difop>
 inline void DecoderMech<T_PointCloud>::decodeDifopCommon(const T_Difop& pkt)
 {
   // rounds per second
+  uint16_t prev_rps = this->rps_;
+  this->rpm_.set(ntohs(pkt.rpm));
   this->rps_ = ntohs(pkt.rpm) / 60;
   if (this->rps_ == 0)
   {
@@ -173,6 +230,11 @@ inline void DecoderMech<T_PointCloud>::decodeDifopCommon(const T_Difop& pkt)
     this->rps_ = 10;
   }
 
+  if (this->rps_ != prev_rps)
+  {
+    this->loss_estimator_.reset();
+  }
+
   // blocks per frame
   this->blks_per_frame_ = (uint16_t)(1 / (this->rps_ * this->mech_const_param_.BLOCK_DURATION));
 
@@ -190,6 +252,7 @@ inline void DecoderMech<T_PointCloud>::decodeDifopCommon(const T_Difop& pkt)
   // fov blind diff of timestamp
   this->fov_blind_ts_diff_ = 
     (double)fov_blind_range / ((double)RS_ONE_ROUND * (double)this->rps_);
+  this->loss_estimator_.setBlind(fov_end_angle, fov_blind_range);
 
   // load angles
   if (!this->param_.config_from_file && !this->angles_ready_)
@@ -199,5 +262,64 @@ inline void DecoderMech<T_PointCloud>::decodeDifopCommon(const T_Difop& pkt)
   }
 }
 
+template <typename T_PointCloud>
+inline bool DecoderMech<T_PointCloud>::splitBlock(int32_t angle, double ts)
+{
+  if (this->cb_new_block_)
+  {
+    this->cb_new_block_(angle);
+  }
+
+  // the second echo shares the azimuth with the first one.
+  this->second_echo_ = (this->echo_mode_ == RSEchoMode::ECHO_DUAL) && (angle == prev_blk_angle_);
+  prev_blk_angle_ = angle;
+
+  int32_t lost = loss_estimator_.newBlock(angle);
+  if (lost != 0)
+  {
+    // blocks of different azimuths in a packet.
+    uint16_t az_blks = this->const_param_.BLOCKS_PER_PKT;
+    if (this->echo_mode_ == RSEchoMode::ECHO_DUAL && az_blks > 1)
+    {
+      az_blks /= 2;
+    }
+
+    if (lost > 0)
+    {
+      lost_blks_ += lost;
+      this->frame_loss_.newLostBlocks(lost, loss_estimator_.gapBegin(), angle, az_blks);
+    }
+    else
+    {
+      // it was counted lost.
+      late_blks_++;
+      lost_blks_ -= (lost_blks_ > 0) ? 1 : 0;
+      this->frame_loss_.newLateBlock(angle);
+    }
+
+    this->lost_pkts_.set((lost_blks_ + az_blks / 2) / az_blks);
+    this->out_of_order_pkts_.set((late_blks_ + az_blks / 2) / az_blks);
+  }
+
+  bool split = split_strategy_->newBlock(angle, ts);
+
+  if (sector_strategy_)
+  {
+    // sectors start from the beginning of the frame. 
+    if (split)
+    {
+      sector_strategy_->reset();
+    }
+
+    // The last sector of a frame goes with the frame itself.
+    if (sector_strategy_->newBlock(angle, ts) && !split && this->cb_split_sector_)
+    {
+      this->cb_split_sector_();
+    }
+  }
+
+  return split;
+}
+
 }  // namespace lidar
 }  // namespace robosense
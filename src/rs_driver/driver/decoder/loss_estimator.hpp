@@ -0,0 +1,446 @@
+/*********************************************************************************************************************
+Copyright (c) 2020 RoboSense
+All rights reserved
+
+By downloading, copying, installing or using the software you agree to this license. If you do not agree to this
+license, do not download, install, copy or use the software.
+
+License Agreement
+For RoboSense LiDAR SDK Library
+(3-clause BSD License)
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that the
+following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following
+disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following
+disclaimer in the documentation and/or other materials provided with the distribution.
+
+3. Neither the names of the RoboSense, nor Suteng Innovation Technology, nor the names of other contributors may be used
+to endorse or promote products derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*********************************************************************************************************************/
+
+
+#pragma once
+
+#include <rs_driver/msg/frame_quality.hpp>
+
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+namespace robosense
+{
+namespace lidar
+{
+
+//
+// Estimate lost packets by pkt_seq of MEMS Lidars, which goes from 1 to seq_max in a frame.
+// seq_max is the initial guess, and grows with the largest seq seen.
+// newPacket() returns the number of packets found lost before this one, 
+// or -1 if this packet is late (reordered) or duplicated. A late packet was counted lost before.
+//
+class SeqLossEstimator
+{
+public:
+
+  SeqLossEstimator(uint16_t seq_max)
+    : seq_max_(seq_max), prev_seq_(0)
+  {
+  }
+
+  uint16_t seqMax() const
+  {
+    return seq_max_;
+  }
+
+  int32_t newPacket(uint16_t seq)
+  {
+    if (prev_seq_ == 0)
+    {
+      prev_seq_ = seq;
+      return 0;
+    }
+
+    if (seq > seq_max_)
+    {
+      seq_max_ = seq;
+    }
+
+    int32_t diff = (int32_t)seq - (int32_t)prev_seq_;
+    int32_t half = seq_max_ / 2;
+    int32_t lost = 0;
+
+    if (diff > half) // late from the previous frame
+    {
+      return -1;
+    }
+    else if (diff > 0)
+    {
+      lost = diff - 1;
+    }
+    else if (diff < -half) // next frame
+    {
+      lost = (seq_max_ - prev_seq_) + (seq - 1);
+    }
+    else // late or duplicated
+    {
+      return -1;
+    }
+
+    prev_seq_ = seq;
+    return lost;
+  }
+
+#ifndef UNIT_TEST
+private:
+#endif
+
+  uint16_t seq_max_;
+  uint16_t prev_seq_;
+};
+
+//
+// Estimate lost blocks by the azimuth gaps of mechanical Lidars.
+// The azimuth step between blocks is learned. Call reset() to learn it again if the rpm changes. 
+// Blocks of the same azimuth (dual return) are ignored. The blind section of FOV is not taken as a gap.
+// newBlock() returns the number of blocks found lost before this one, or -1 if this block is late.
+// A late block goes back by at most LATE_BLKS_MAX steps. Going back further, it's a gap forward.
+//
+class AzimuthLossEstimator
+{
+public:
+
+  constexpr static int32_t RS_ONE_ROUND = 36000;
+  constexpr static int32_t LATE_BLKS_MAX = 60;
+
+  AzimuthLossEstimator()
+    : prev_az_(-1), gap_begin_(0), step_(0), blind_start_(0), blind_range_(0)
+  {
+  }
+
+  int32_t gapBegin() const // azimuth of the block before the latest gap
+  {
+    return gap_begin_;
+  }
+
+  void reset()
+  {
+    prev_az_ = -1;
+    step_ = 0;
+  }
+
+  void setBlind(int32_t start, int32_t range)
+  {
+    blind_start_ = start;
+    blind_range_ = (range > 0 && range < RS_ONE_ROUND) ? range : 0;
+  }
+
+  int32_t newBlock(int32_t az)
+  {
+    if (prev_az_ < 0)
+    {
+      prev_az_ = az;
+      return 0;
+    }
+
+    int32_t diff = ((az - prev_az_) % RS_ONE_ROUND + RS_ONE_ROUND) % RS_ONE_ROUND;
+    if (diff == 0)
+    {
+      return 0;
+    }
+    else if ((step_ > 0) && (RS_ONE_ROUND - diff <= step_ * LATE_BLKS_MAX))
+    {
+      return -1;
+    }
+
+    if (blind_range_ > 0)
+    {
+      int32_t blind_off = ((blind_start_ - prev_az_) % RS_ONE_ROUND + RS_ONE_ROUND) % RS_ONE_ROUND;
+      if (blind_off < diff && diff >= blind_range_)
+      {
+        diff -= blind_range_;
+      }
+    }
+
+    gap_begin_ = prev_az_;
+    prev_az_ = az;
+
+    if (step_ <= 0)
+    {
+      step_ = diff;
+      return 0;
+    }
+
+    if (diff * 2 <= step_ * 3)
+    {
+      step_ = (step_ * 7 + diff) / 8;
+      return 0;
+    }
+
+    return (int32_t)(diff / step_ + 0.5) - 1;
+  }
+
+#ifndef UNIT_TEST
+private:
+#endif
+
+  int32_t prev_az_;
+  int32_t gap_begin_;
+  float step_;
+  int32_t blind_start_;
+  int32_t blind_range_;
+};
+
+//
+// Account the packets of the frame being decoded, and fill FrameQuality when the frame is split.
+//
+// MEMS Lidars: the received pkt_seq are marked in a bitmap, so a packet reordered within the frame fills its hole.
+// The frame is expected to cover pkt_seq from 1 to seq_max if it is split by seq, 
+// or from its first to its last pkt_seq if it is split by time.
+//
+// Mechanical Lidars: the lost/late blocks found by AzimuthLossEstimator are accumulated, and converted to packets.
+// A gap across two frames is counted in the earlier one.
+//
+class FrameLossTracker
+{
+public:
+
+  FrameLossTracker()
+    : recv_pkts_(0), seq_pkts_(0), late_pkts_(0), lost_blks_(0), late_blks_(0), blks_per_pkt_(1), gap_num_(0), 
+    seq_max_(0), first_seq_(0), last_seq_(0), from_one_(false), first_frame_(true)
+  {
+  }
+
+  void newPacket() // mechanical Lidars
+  {
+    recv_pkts_++;
+  }
+
+  void newSeq(uint16_t seq, uint16_t seq_max, bool late, bool from_one) // MEMS Lidars
+  {
+    if ((seq == 0) || (seq > seq_max))
+    {
+      return;
+    }
+
+    if (seq_max_ != seq_max)
+    {
+      seq_max_ = seq_max;
+      bits_.resize(seq_max / 64 + 1, 0);
+    }
+
+    from_one_ = from_one;
+
+    if (late)
+    {
+      late_pkts_++;
+
+      // reordered within the frame, rather than from the previous frame.
+      if ((seq_pkts_ > 0) && (offset(seq) < offset(last_seq_)))
+      {
+        setBit(seq);
+      }
+      return;
+    }
+
+    if (seq_pkts_ == 0)
+    {
+      first_seq_ = seq;
+    }
+
+    last_seq_ = seq;
+    seq_pkts_++;
+    setBit(seq);
+  }
+
+  void newLostBlocks(uint32_t lost, int32_t begin, int32_t end, uint16_t blks_per_pkt) // mechanical Lidars
+  {
+    blks_per_pkt_ = blks_per_pkt;
+    lost_blks_ += lost;
+    addGap(begin, end, lost);
+  }
+
+  void newLateBlock(int32_t az) // mechanical Lidars
+  {
+    late_blks_++;
+    lost_blks_ -= (lost_blks_ > 0) ? 1 : 0;
+
+    // fill the gap. Remove it if all its blocks arrive.
+    for (int i = (int)gap_num_ - 1; i >= 0; i--)
+    {
+      int32_t off = ((az - (int32_t)gaps_[i].begin) % 36000 + 36000) % 36000;
+      int32_t len = (((int32_t)gaps_[i].end - (int32_t)gaps_[i].begin) % 36000 + 36000) % 36000;
+      if ((off > 0) && (off < len))
+      {
+        if (--gap_lost_[i] == 0)
+        {
+          for (uint16_t j = i + 1; j < gap_num_; j++)
+          {
+            gaps_[j - 1] = gaps_[j];
+            gap_lost_[j - 1] = gap_lost_[j];
+          }
+          gap_num_--;
+        }
+        break;
+      }
+    }
+  }
+
+  void endFrame(FrameQuality& quality)
+  {
+    if (seq_max_ > 0)
+    {
+      endSeqFrame(quality);
+    }
+    else
+    {
+      quality.recv_pkts = recv_pkts_;
+      quality.lost_pkts = (lost_blks_ + blks_per_pkt_ / 2) / blks_per_pkt_;
+      quality.out_of_order_pkts = (late_blks_ + blks_per_pkt_ / 2) / blks_per_pkt_;
+    }
+
+    quality.expected_pkts = quality.recv_pkts + quality.lost_pkts;
+    quality.gap_num = gap_num_;
+    for (uint16_t i = 0; i < gap_num_; i++)
+    {
+      quality.gaps[i] = gaps_[i];
+    }
+
+    recv_pkts_ = 0;
+    seq_pkts_ = 0;
+    late_pkts_ = 0;
+    lost_blks_ = 0;
+    late_blks_ = 0;
+    gap_num_ = 0;
+    first_frame_ = false;
+  }
+
+#ifndef UNIT_TEST
+private:
+#endif
+
+  void setBit(uint16_t seq)
+  {
+    bits_[seq >> 6] |= ((uint64_t)1 << (seq & 63));
+  }
+
+  bool getBit(uint16_t seq) const
+  {
+    return (bits_[seq >> 6] & ((uint64_t)1 << (seq & 63))) != 0;
+  }
+
+  uint16_t beginSeq() const
+  {
+    return (from_one_ && !first_frame_) ? 1 : first_seq_;
+  }
+
+  uint32_t offset(uint16_t seq) const
+  {
+    return ((uint32_t)seq + seq_max_ - beginSeq()) % seq_max_;
+  }
+
+  void addGap(uint32_t begin, uint32_t end, uint32_t lost)
+  {
+    if (gap_num_ < FrameQuality::GAP_MAX)
+    {
+      gaps_[gap_num_].begin = begin;
+      gaps_[gap_num_].end = end;
+      gap_lost_[gap_num_] = lost;
+      gap_num_++;
+    }
+  }
+
+  void endSeqFrame(FrameQuality& quality)
+  {
+    uint32_t recv = 0;
+    uint32_t lost = 0;
+
+    if (seq_pkts_ > 0)
+    {
+      uint16_t seq = beginSeq();
+      uint32_t span = offset(last_seq_) + 1;
+      if (from_one_)
+      {
+        span = seq_max_ - seq + 1; // the frame ends at seq_max.
+      }
+
+      uint16_t gap_begin = 0;
+      for (uint32_t i = 0; i < span; i++)
+      {
+        if (getBit(seq))
+        {
+          recv++;
+          if (gap_begin != 0)
+          {
+            addGap(gap_begin, seq - 1, seq - gap_begin);
+            gap_begin = 0;
+          }
+        }
+        else
+        {
+          lost++;
+          if (gap_begin == 0)
+          {
+            gap_begin = seq;
+          }
+        }
+
+        if (seq == seq_max_) // wrap
+        {
+          if (gap_begin != 0)
+          {
+            addGap(gap_begin, seq, seq - gap_begin + 1);
+            gap_begin = 0;
+          }
+          seq = 1;
+        }
+        else
+        {
+          seq++;
+        }
+      }
+
+      if (gap_begin != 0)
+      {
+        addGap(gap_begin, seq - 1, seq - gap_begin);
+      }
+
+      memset(bits_.data(), 0, bits_.size() * sizeof(uint64_t));
+    }
+
+    quality.recv_pkts = recv;
+    quality.lost_pkts = lost;
+    quality.out_of_order_pkts = late_pkts_;
+  }
+
+  uint32_t recv_pkts_;
+  uint32_t seq_pkts_;
+  uint32_t late_pkts_;
+  uint32_t lost_blks_;
+  uint32_t late_blks_;
+  uint16_t blks_per_pkt_;
+  FrameGap gaps_[FrameQuality::GAP_MAX];
+  uint32_t gap_lost_[FrameQuality::GAP_MAX]; // lost blocks of the gaps
+  uint16_t gap_num_;
+
+  std::vector<uint64_t> bits_;
+  uint16_t seq_max_;
+  uint16_t first_seq_;
+  uint16_t last_seq_;
+  bool from_one_;
+  bool first_frame_;
+};
+
+}  // namespace lidar
+}  // namespace robosense
@@ -32,6 +32,8 @@ THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 #pragma once
 
+#include <rs_driver/msg/frame_quality.hpp>
+
 #define DEFINE_MEMBER_CHECKER(member)                                                                                  \
   template <typename T, typename V = bool>                                                                             \
   struct has_##member : std::false_type                                                                                \
@@ -50,6 +52,8 @@ DEFINE_MEMBER_CHECKER(z)
 DEFINE_MEMBER_CHECKER(intensity)
 DEFINE_MEMBER_CHECKER(ring)
 DEFINE_MEMBER_CHECKER(timestamp)
+DEFINE_MEMBER_CHECKER(lidar_id)
+DEFINE_MEMBER_CHECKER(quality)
 
 #define RS_HAS_MEMBER(C, member) has_##member<C>::value
 
@@ -123,3 +127,28 @@ inline typename std::enable_if<RS_HAS_MEMBER(T_Point, timestamp)>::type setTimes
   point.timestamp = value;
 }
 
+template <typename T_Point>
+inline typename std::enable_if<!RS_HAS_MEMBER(T_Point, lidar_id)>::type setLidarId(T_Point& point,
+                                                                                   const uint8_t& value)
+{
+}
+
+template <typename T_Point>
+inline typename std::enable_if<RS_HAS_MEMBER(T_Point, lidar_id)>::type setLidarId(T_Point& point,
+                                                                                  const uint8_t& value)
+{
+  point.lidar_id = value;
+}
+
+template <typename T_PointCloud>
+inline typename std::enable_if<!RS_HAS_MEMBER(T_PointCloud, quality)>::type setQuality(
+    T_PointCloud& cloud, const robosense::lidar::FrameQuality& value)
+{
+}
+
+template <typename T_PointCloud>
+inline typename std::enable_if<RS_HAS_MEMBER(T_PointCloud, quality)>::type setQuality(
+    T_PointCloud& cloud, const robosense::lidar::FrameQuality& value)
+{
+  cloud.quality = value;
+}
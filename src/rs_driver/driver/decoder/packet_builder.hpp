@@ -0,0 +1,444 @@
+/*********************************************************************************************************************
+Copyright (c) 2020 RoboSense
+All rights reserved
+
+By downloading, copying, installing or using the software you agree to this license. If you do not agree to this
+license, do not download, install, copy or use the software.
+
+License Agreement
+For RoboSense LiDAR SDK Library
+(3-clause BSD License)
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that the
+following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following
+disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following
+disclaimer in the documentation and/or other materials provided with the distribution.
+
+3. Neither the names of the RoboSense, nor Suteng Innovation Technology, nor the names of other contributors may be used
+to endorse or promote products derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*********************************************************************************************************************/
+
+
+#pragma once
+
+#include <rs_driver/driver/decoder/decoder_factory.hpp>
+#include <rs_driver/driver/decoder/member_checker.hpp>
+#include <rs_driver/msg/point_cloud_msg.hpp>
+
+#include <vector>
+#include <functional>
+#include <cstring>
+
+DEFINE_MEMBER_CHECKER(vert_angle_cali)
+
+namespace robosense
+{
+namespace lidar
+{
+
+//
+// Synthetic but valid MSOP/DIFOP packets of a Lidar type, for benchmarks and simulators.
+// The constants (packet ids, lengths, blocks, channels, packet duration) are taken from the decoder of the type.
+// Mechanical Lidars: a round of 360 degree at 600 rpm. The DIFOP packet has rpm and angle calibration.
+// MEMS Lidars: a frame of 0.1 second, with pkt_seq from 1. A jumbo packet carries 63 of them.
+//
+class PacketBuilder
+{
+public:
+
+  PacketBuilder(LidarType type);
+
+  LidarType type() const
+  {
+    return type_;
+  }
+
+  const std::vector<std::vector<uint8_t>>& msops() const
+  {
+    return msops_;
+  }
+
+  const std::vector<uint8_t>& difop() const
+  {
+    return difop_;
+  }
+
+  // points of all msop packets, if dense_points is false.
+  size_t pointNum() const
+  {
+    return point_num_;
+  }
+
+  // seconds between two msop packets, as the Lidar sends them.
+  double pktInterval() const
+  {
+    return pkt_interval_;
+  }
+
+  // azimuth between two blocks. Only for mechanical Lidars.
+  uint16_t azStep() const
+  {
+    return az_step_;
+  }
+
+  // Write the timestamp (microseconds) into a copy of a msop packet, for use_lidar_clock.
+  void stamp(uint8_t* pkt, uint64_t us) const
+  {
+    if (stamp_)
+    {
+      stamp_(pkt, us);
+    }
+  }
+
+private:
+
+  typedef PointCloudT<PointXYZIRT> Cloud;
+
+  template <typename T_Pkt>
+  void buildMech();
+  template <typename T_Pkt>
+  void buildM1(T_Pkt& pkt, uint16_t seq);
+  template <typename T_Pkt>
+  void buildXYZ(T_Pkt& pkt, uint16_t seq);
+  void fill(RSM1MsopPkt& pkt, uint16_t seq)
+  {
+    buildM1(pkt, seq);
+  }
+  void fill(RSM2MsopPkt& pkt, uint16_t seq)
+  {
+    buildXYZ(pkt, seq);
+  }
+  void fill(RSEOSMsopPkt& pkt, uint16_t seq)
+  {
+    buildXYZ(pkt, seq);
+  }
+  template <typename T_Pkt>
+  void buildMems();
+  void buildM1Jumbo();
+
+  template <typename T_Difop>
+  void buildMechDifop();
+  void buildDifop();
+
+  template <typename T_Difop>
+  typename std::enable_if<!RS_HAS_MEMBER(T_Difop, vert_angle_cali)>::type fillAngles(T_Difop& difop)
+  {
+  }
+  template <typename T_Difop>
+  typename std::enable_if<RS_HAS_MEMBER(T_Difop, vert_angle_cali)>::type fillAngles(T_Difop& difop);
+
+  static void setTs(RSTimestampYMD& ts, uint64_t us)
+  {
+    createTimeYMD(us, &ts);
+  }
+  static void setTs(RSTimestampUTC& ts, uint64_t us)
+  {
+    createTimeUTCWithUs(us, &ts);
+  }
+
+  uint16_t distance(uint16_t chan) const
+  {
+    // 5 ~ 20 meters
+    return (uint16_t)((5.0f + (chan % 16)) / const_param_.DISTANCE_RES);
+  }
+
+  template <typename T_Pkt>
+  void append(const T_Pkt& pkt)
+  {
+    const uint8_t* p = (const uint8_t*)&pkt;
+    msops_.emplace_back(p, p + sizeof(pkt));
+  }
+
+  LidarType type_;
+  RSDecoderConstParam const_param_;
+  double pkt_duration_;
+  std::vector<std::vector<uint8_t>> msops_;
+  std::vector<uint8_t> difop_;
+  std::function<void(uint8_t*, uint64_t)> stamp_;
+  size_t point_num_;
+  double pkt_interval_;
+  uint16_t az_step_;
+};
+
+template <typename T_Pkt>
+inline void PacketBuilder::buildMech()
+{
+  const uint16_t blocks = const_param_.BLOCKS_PER_PKT;
+
+  // 10 rounds per second
+  az_step_ = (uint16_t)(36000 * 10 * pkt_duration_ / blocks + 0.5);
+  if (az_step_ == 0)
+  {
+    az_step_ = 1;
+  }
+
+  const uint16_t pkt_num = (36000 + az_step_ * blocks - 1) / (az_step_ * blocks);
+
+  uint16_t azimuth = 0;
+  for (uint16_t i = 0; i < pkt_num; i++)
+  {
+    T_Pkt pkt;
+    memset(&pkt, 0, sizeof(pkt));
+    memcpy(&pkt, const_param_.MSOP_ID, const_param_.MSOP_ID_LEN);
+
+    for (uint16_t blk = 0; blk < blocks; blk++)
+    {
+      auto& block = pkt.blocks[blk];
+      memcpy(block.id, const_param_.BLOCK_ID, sizeof(block.id));
+      block.azimuth = htons(azimuth);
+      azimuth = (azimuth + az_step_) % 36000;
+
+      for (uint16_t chan = 0; chan < const_param_.CHANNELS_PER_BLOCK; chan++)
+      {
+        block.channels[chan].distance = htons(distance(chan));
+        block.channels[chan].intensity = (uint8_t)chan;
+      }
+    }
+
+    append(pkt);
+    point_num_ += blocks * const_param_.CHANNELS_PER_BLOCK;
+  }
+
+  pkt_interval_ = pkt_duration_;
+  stamp_ = [](uint8_t* p, uint64_t us) { setTs(((T_Pkt*)p)->header.timestamp, us); };
+}
+
+template <typename T_Pkt>
+inline void PacketBuilder::buildM1(T_Pkt& pkt, uint16_t seq)
+{
+  memset(&pkt, 0, sizeof(pkt));
+  memcpy(&pkt, const_param_.MSOP_ID, const_param_.MSOP_ID_LEN);
+  pkt.header.pkt_seq = htons(seq);
+
+  for (uint16_t blk = 0; blk < const_param_.BLOCKS_PER_PKT; blk++)
+  {
+    auto& block = pkt.blocks[blk];
+    block.time_offset = (uint8_t)blk;
+
+    for (uint16_t chan = 0; chan < const_param_.CHANNELS_PER_BLOCK; chan++)
+    {
+      // pitch/yaw are offset by 32768, in 0.01 degree.
+      block.channel[chan].distance = htons(distance(chan));
+      block.channel[chan].pitch = htons((uint16_t)(32768 - 1200 + chan * 500 + (seq % 4) * 10));
+      block.channel[chan].yaw = htons((uint16_t)(32768 - 6000 + (seq * 19) % 12000));
+      block.channel[chan].intensity = (uint8_t)chan;
+    }
+  }
+
+  point_num_ += const_param_.BLOCKS_PER_PKT * const_param_.CHANNELS_PER_BLOCK;
+}
+
+template <typename T_Pkt>
+inline void PacketBuilder::buildXYZ(T_Pkt& pkt, uint16_t seq)
+{
+  memset(&pkt, 0, sizeof(pkt));
+  memcpy(&pkt, const_param_.MSOP_ID, const_param_.MSOP_ID_LEN);
+  pkt.header.pkt_seq = htons(seq);
+
+  for (uint16_t blk = 0; blk < const_param_.BLOCKS_PER_PKT; blk++)
+  {
+    auto& block = pkt.blocks[blk];
+    block.time_offset = (uint8_t)blk;
+
+    for (uint16_t chan = 0; chan < const_param_.CHANNELS_PER_BLOCK; chan++)
+    {
+      uint16_t dist = distance(chan);
+      block.channel[chan].distance = htons(dist);
+      block.channel[chan].x = htons((uint16_t)(dist / 2));
+      block.channel[chan].y = htons((uint16_t)(seq % 1000));
+      block.channel[chan].z = htons((uint16_t)(chan * 10));
+      block.channel[chan].intensity = (uint8_t)chan;
+    }
+  }
+
+  point_num_ += const_param_.BLOCKS_PER_PKT * const_param_.CHANNELS_PER_BLOCK;
+}
+
+template <typename T_Pkt>
+inline void PacketBuilder::buildMems()
+{
+  // 10 frames per second
+  const uint16_t pkt_num = (uint16_t)(0.1 / pkt_duration_ + 0.5);
+
+  for (uint16_t seq = 1; seq <= pkt_num; seq++)
+  {
+    T_Pkt pkt;
+    fill(pkt, seq);
+    append(pkt);
+  }
+
+  pkt_interval_ = pkt_duration_;
+  stamp_ = [](uint8_t* p, uint64_t us) { setTs(((T_Pkt*)p)->header.timestamp, us); };
+}
+
+inline void PacketBuilder::buildM1Jumbo()
+{
+  constexpr static uint16_t PACKET_NUM = 63;
+  const uint16_t pkt_num = (uint16_t)(0.1 / pkt_duration_ + 0.5);
+
+  uint16_t seq = 1;
+  for (uint16_t i = 0; i < pkt_num / PACKET_NUM; i++)
+  {
+    std::unique_ptr<RSM1_Jumbo> jumbo(new RSM1_Jumbo);
+    memset(jumbo.get(), 0, sizeof(RSM1_Jumbo));
+
+    for (auto& pkt : jumbo->pkts)
+    {
+      buildM1(pkt, seq++);
+    }
+    append(*jumbo);
+  }
+
+  pkt_interval_ = pkt_duration_ * PACKET_NUM;
+  stamp_ = [this](uint8_t* p, uint64_t us) 
+  {
+    RSM1_Jumbo* jumbo = (RSM1_Jumbo*)p;
+    for (uint16_t i = 0; i < PACKET_NUM; i++)
+    {
+      setTs(jumbo->pkts[i].header.timestamp, us + (uint64_t)(i * pkt_duration_ * 1e6));
+    }
+  };
+}
+
+template <typename T_Difop>
+inline typename std::enable_if<RS_HAS_MEMBER(T_Difop, vert_angle_cali)>::type 
+PacketBuilder::fillAngles(T_Difop& difop)
+{
+  // vertical angles spread over -15 ~ 15 degree. no horizontal offset.
+  const size_t num = sizeof(difop.vert_angle_cali) / sizeof(difop.vert_angle_cali[0]);
+  for (size_t i = 0; i < num; i++)
+  {
+    int32_t angle = -1500 + (int32_t)(3000 * i / num);
+    difop.vert_angle_cali[i].sign = (angle < 0) ? 1 : 0;
+    difop.vert_angle_cali[i].value = htons((uint16_t)std::abs(angle));
+  }
+}
+
+template <typename T_Difop>
+inline void PacketBuilder::buildMechDifop()
+{
+  T_Difop difop;
+  memset(&difop, 0, sizeof(difop));
+  memcpy(&difop, const_param_.DIFOP_ID, const_param_.DIFOP_ID_LEN);
+  difop.rpm = htons(600);
+  fillAngles(difop);
+
+  const uint8_t* p = (const uint8_t*)&difop;
+  difop_.assign(p, p + sizeof(difop));
+}
+
+inline void PacketBuilder::buildDifop()
+{
+  switch (type_)
+  {
+    case LidarType::RS16:
+      buildMechDifop<RS16DifopPkt>();
+      break;
+    case LidarType::RS32:
+      buildMechDifop<RS32DifopPkt>();
+      break;
+    case LidarType::RSBP:
+    case LidarType::RSBPV4:
+      buildMechDifop<RSBPDifopPkt>();
+      break;
+    case LidarType::RSHELIOS:
+    case LidarType::RSHELIOS_16P:
+      buildMechDifop<RSHELIOSDifopPkt>();
+      break;
+    case LidarType::RS128:
+      buildMechDifop<RS128DifopPkt>();
+      break;
+    case LidarType::RS80:
+      buildMechDifop<RS80DifopPkt>();
+      break;
+    case LidarType::RS48:
+    case LidarType::RSP48:
+      buildMechDifop<RSP48DifopPkt>();
+      break;
+    case LidarType::RSP128:
+      buildMechDifop<RSP128DifopPkt>();
+      break;
+    case LidarType::RSP80:
+      buildMechDifop<RSP80DifopPkt>();
+      break;
+    default:
+      // MEMS Lidars: only the id and length matter.
+      difop_.resize(const_param_.DIFOP_LEN, 0);
+      memcpy(difop_.data(), const_param_.DIFOP_ID, const_param_.DIFOP_ID_LEN);
+      break;
+  }
+}
+
+inline PacketBuilder::PacketBuilder(LidarType type)
+  : type_(type), pkt_duration_(0), point_num_(0), pkt_interval_(0), az_step_(0)
+{
+  RSDecoderParam param;
+  std::shared_ptr<Decoder<Cloud>> decoder = DecoderFactory<Cloud>::createDecoder(type, param);
+  const_param_ = decoder->constParam();
+  pkt_duration_ = decoder->getPacketDuration();
+
+  switch (type)
+  {
+    case LidarType::RS16:
+      buildMech<RS16MsopPkt>();
+      break;
+    case LidarType::RS32:
+      buildMech<RS32MsopPkt>();
+      break;
+    case LidarType::RSBP:
+    case LidarType::RSBPV4:
+      buildMech<RSBPMsopPkt>();
+      break;
+    case LidarType::RSHELIOS:
+    case LidarType::RSHELIOS_16P:
+      buildMech<RSHELIOSMsopPkt>();
+      break;
+    case LidarType::RS128:
+      buildMech<RS128MsopPkt>();
+      break;
+    case LidarType::RS80:
+      buildMech<RS80MsopPkt>();
+      break;
+    case LidarType::RS48:
+    case LidarType::RSP48:
+      buildMech<RSP48MsopPkt>();
+      break;
+    case LidarType::RSP128:
+      buildMech<RSP128MsopPkt>();
+      break;
+    case LidarType::RSP80:
+      buildMech<RSP80MsopPkt>();
+      break;
+    case LidarType::RSM1:
+      buildMems<RSM1MsopPkt>();
+      break;
+    case LidarType::RSM2:
+      buildMems<RSM2MsopPkt>();
+      break;
+    case LidarType::RSEOS:
+      buildMems<RSEOSMsopPkt>();
+      break;
+    case LidarType::RSM1_JUMBO:
+      buildM1Jumbo();
+      break;
+    default:
+      break;
+  }
+
+  buildDifop();
+}
+
+}  // namespace lidar
+}  // namespace robosense
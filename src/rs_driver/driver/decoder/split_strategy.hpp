@@ -32,6 +32,9 @@ THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 #pragma once
 
+#include <cmath>
+#include <cstdint>
+
 namespace robosense
 {
 namespace lidar
@@ -41,14 +44,30 @@ class SplitStrategy
 {
 public:
   virtual bool newBlock(int32_t angle) = 0;
+  virtual bool newBlock(int32_t angle, double ts)
+  {
+    return newBlock(angle);
+  }
+  virtual void reset()
+  {
+  }
   virtual ~SplitStrategy() = default;
 };
 
 class SplitStrategyByAngle : public SplitStrategy
 {
 public:
-  SplitStrategyByAngle (int32_t split_angle)
-   : split_angle_(split_angle), prev_angle_(split_angle)
+  using SplitStrategy::newBlock;
+
+  // a late (reordered) block goes back by at most so many blocks.
+  constexpr static int32_t LATE_BLKS_MAX = 60;
+
+  //
+  // block_az_diff: azimuth difference between adjacent blocks. 
+  // If it's NULL, no block is taken as late.
+  //
+  SplitStrategyByAngle (int32_t split_angle, const uint16_t* block_az_diff = NULL)
+   : split_angle_(split_angle), block_az_diff_(block_az_diff), prev_angle_(split_angle), started_(false)
   {
   }
 
@@ -56,6 +75,14 @@ public:
 
   virtual bool newBlock(int32_t angle)
   {
+    // A late block doesn't split. Going back further, it's the next round, 
+    // e.g. across the blind section of a FOV under 180 degrees, or after a loss of half a round.
+    int32_t back = ((prev_angle_ - angle) % 36000 + 36000) % 36000;
+    if (started_ && (block_az_diff_ != NULL) && (back > 0) && (back <= LATE_BLKS_MAX * (*block_az_diff_)))
+    {
+      return false;
+    }
+
     if (angle < prev_angle_)
     {
       prev_angle_ -= 36000;
@@ -69,6 +96,7 @@ public:
     }
 #endif
     prev_angle_ = angle;
+    started_ = true;
     return v;
   }
 
@@ -77,12 +105,16 @@ public:
 private:
 #endif
     const int32_t split_angle_;
+    const uint16_t* block_az_diff_;
     int32_t prev_angle_;
+    bool started_;
 };
 
 class SplitStrategyByNum : public SplitStrategy
 {
 public:
+  using SplitStrategy::newBlock;
+
   SplitStrategyByNum (uint16_t* max_blks)
    : max_blks_(max_blks), blks_(0)
   {
@@ -109,6 +141,143 @@ private:
   uint16_t blks_;
 };
 
+//
+// Split every blks blocks, counted from reset(). It splits a frame into sectors.
+//
+class SplitStrategyByBlks : public SplitStrategy
+{
+public:
+  using SplitStrategy::newBlock;
+
+  SplitStrategyByBlks (uint16_t blks)
+   : blks_((blks > 0) ? blks : 1), cnt_(0)
+  {
+  }
+
+  virtual ~SplitStrategyByBlks() = default;
+
+  virtual bool newBlock(int32_t)
+  {
+    if (cnt_ >= blks_)
+    {
+      cnt_ = 1;
+      return true;
+    }
+
+    cnt_++;
+    return false;
+  }
+
+  virtual void reset()
+  {
+    cnt_ = 0;
+  }
+
+#ifndef UNIT_TEST
+private:
+#endif
+  const uint16_t blks_;
+  uint16_t cnt_;
+};
+
+//
+// Split at start_angle + k * sector_angle (1/100 degree). It splits a frame into sectors.
+//
+class SplitStrategyBySector : public SplitStrategy
+{
+public:
+  using SplitStrategy::newBlock;
+
+  SplitStrategyBySector (int32_t start_angle, int32_t sector_angle)
+   : start_angle_(start_angle), sector_angle_((sector_angle > 0) ? sector_angle : 36000), prev_sector_(-1)
+  {
+  }
+
+  virtual ~SplitStrategyBySector() = default;
+
+  virtual bool newBlock(int32_t angle)
+  {
+    int32_t off = ((angle - start_angle_) % 36000 + 36000) % 36000;
+    int32_t sector = off / sector_angle_;
+
+    bool v = ((prev_sector_ >= 0) && (sector != prev_sector_));
+    prev_sector_ = sector;
+    return v;
+  }
+
+  virtual void reset()
+  {
+    prev_sector_ = -1;
+  }
+
+#ifndef UNIT_TEST
+private:
+#endif
+  const int32_t start_angle_;
+  const int32_t sector_angle_;
+  int32_t prev_sector_;
+};
+
+//
+// Split at phase + k * period (seconds), by the timestamps of blocks/packets. 
+// With lidar clock synchronized by PTP/GPS, frames of different Lidars are aligned in time.
+//
+class SplitStrategyByTime : public SplitStrategy
+{
+public:
+  using SplitStrategy::newBlock;
+
+  SplitStrategyByTime (double period, double phase)
+   : period_((period > 0) ? period : 0.1), phase_(phase), prev_slot_(0), has_prev_(false)
+  {
+  }
+
+  virtual ~SplitStrategyByTime() = default;
+
+  virtual bool newBlock(int32_t)
+  {
+    return false;
+  }
+
+  virtual bool newBlock(int32_t, double ts)
+  {
+    return newTs(ts);
+  }
+
+  bool newTs(double ts)
+  {
+    int64_t slot = (int64_t)std::floor((ts - phase_) / period_);
+    if (!has_prev_)
+    {
+      prev_slot_ = slot;
+      has_prev_ = true;
+      return false;
+    }
+
+    if (slot > prev_slot_)
+    {
+      prev_slot_ = slot;
+      return true;
+    }
+    else if (slot < prev_slot_ - 1) // time jumps back, e.g. PCAP file replayed.
+    {
+      prev_slot_ = slot;
+      return true;
+    }
+
+    // a little out of order. do nothing.
+    return false;
+  }
+
+#ifndef UNIT_TEST
+private:
+#endif
+  const double period_;
+  const double phase_;
+  int64_t prev_slot_;
+  bool has_prev_;
+};
+
 class SplitStrategyBySeq
 {
 public:
@@ -0,0 +1,146 @@
+/*********************************************************************************************************************
+Copyright (c) 2020 RoboSense
+All rights reserved
+
+By downloading, copying, installing or using the software you agree to this license. If you do not agree to this
+license, do not download, install, copy or use the software.
+
+License Agreement
+For RoboSense LiDAR SDK Library
+(3-clause BSD License)
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that the
+following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following
+disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following
+disclaimer in the documentation and/or other materials provided with the distribution.
+
+3. Neither the names of the RoboSense, nor Suteng Innovation Technology, nor the names of other contributors may be used
+to endorse or promote products derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*********************************************************************************************************************/
+
+
+#pragma once
+
+#include <rs_driver/driver/driver_param.hpp>
+
+#include <cstdint>
+
+namespace robosense
+{
+namespace lidar
+{
+
+//
+// Degrade the decoding step by step, when the handling thread can't keep up with the Lidar.
+//
+// Each frame, it compares the decoding time with the frame period. Over the budget (or the packet queue 
+// overflows), it enables the next allowed mode. After recover_frames frames in a row below the recover 
+// threshold, it disables the latest mode. 
+//
+class DegradeController
+{
+public:
+
+  DegradeController();
+
+  void init(const RSDegradeParam& param);
+
+  //
+  // Return true if the modes change.
+  //
+  bool newFrame(double decode_secs, double period, bool overflowed);
+
+  uint8_t modes() const
+  {
+    return modes_;
+  }
+
+  uint64_t changes() const
+  {
+    return changes_;
+  }
+
+#ifndef UNIT_TEST
+private:
+#endif
+
+  RSDegradeParam param_;
+  uint8_t modes_; // modes enabled now
+  uint16_t calm_frames_; // frames in a row below the recover threshold
+  uint64_t changes_;
+};
+
+inline DegradeController::DegradeController()
+  : modes_(0), calm_frames_(0), changes_(0)
+{
+}
+
+inline void DegradeController::init(const RSDegradeParam& param)
+{
+  param_ = param;
+  modes_ = 0;
+  calm_frames_ = 0;
+  changes_ = 0;
+}
+
+inline bool DegradeController::newFrame(double decode_secs, double period, bool overflowed)
+{
+  if (param_.modes == 0)
+  {
+    return false;
+  }
+
+  if (overflowed || (decode_secs > param_.budget * period))
+  {
+    calm_frames_ = 0;
+
+    // the lowest allowed mode not enabled yet.
+    uint8_t todo = param_.modes & ~modes_;
+    if (todo == 0)
+    {
+      return false;
+    }
+
+    modes_ |= (uint8_t)(todo & -todo);
+    changes_++;
+    return true;
+  }
+
+  if ((decode_secs >= param_.recover * period) || (modes_ == 0))
+  {
+    calm_frames_ = 0;
+    return false;
+  }
+
+  if (++calm_frames_ < param_.recover_frames)
+  {
+    return false;
+  }
+
+  // the highest mode enabled.
+  uint8_t mode = 0x80;
+  while ((modes_ & mode) == 0)
+  {
+    mode >>= 1;
+  }
+
+  modes_ &= ~mode;
+  calm_frames_ = 0;
+  changes_++;
+  return true;
+}
+
+}  // namespace lidar
+}  // namespace robosense
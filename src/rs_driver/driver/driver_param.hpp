@@ -35,6 +35,7 @@ THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include <rs_driver/common/rs_log.hpp>
 #include <string>
 #include <map>
+#include <vector>
 
 namespace robosense
 {
@@ -223,7 +224,8 @@ enum InputType
 {
   ONLINE_LIDAR = 1,
   PCAP_FILE,
-  RAW_PACKET
+  RAW_PACKET,
+  LOG_FILE
 };
 
 inline std::string inputTypeToStr(const InputType& type)
@@ -240,6 +242,9 @@ inline std::string inputTypeToStr(const InputType& type)
     case InputType::RAW_PACKET:
       str = "RAW_PACKET";
       break;
+    case InputType::LOG_FILE:
+      str = "LOG_FILE";
+      break;
     default:
       str = "ERROR";
       RS_ERROR << "RS_ERROR" << RS_REND;
@@ -251,7 +256,8 @@ enum SplitFrameMode
 {
   SPLIT_BY_ANGLE = 1,
   SPLIT_BY_FIXED_BLKS,
-  SPLIT_BY_CUSTOM_BLKS
+  SPLIT_BY_CUSTOM_BLKS,
+  SPLIT_BY_TIME
 };
 
 struct RSTransformParam  ///< The Point transform parameter
@@ -290,8 +296,14 @@ struct RSDecoderParam  ///< LiDAR decoder parameter
                                  ///< 1: Split frames by split_angle;
                                  ///< 2: Split frames by fixed number of blocks;
                                  ///< 3: Split frames by custom number of blocks (num_blks_split)
+                                 ///< 4: Split frames at split_phase + k * split_period (seconds)
   float split_angle = 0.0f;      ///< Split angle(degree) used to split frame, only be used when split_frame_mode=1
   uint16_t num_blks_split = 1;   ///< Number of packets in one frame, only be used when split_frame_mode=3
+  double split_period = 0.1;     ///< Seconds of a frame, only be used when split_frame_mode=4
+  double split_phase = 0.0;      ///< Seconds of the split phase, only be used when split_frame_mode=4
+  float sector_angle = 0.0f;     ///< Degrees of a sector, emitted before the whole frame. 0: disabled. Mechanical Lidars only
+  uint16_t sector_blks = 0;      ///< Blocks of a sector, only be used when sector_angle=0. 0: disabled
+  float window_resolution = 0.0f; ///< Degrees of a column of the rolling 360 degree window. 0: disabled. Mechanical Lidars only
   bool use_lidar_clock = false;  ///< true: use LiDAR clock as timestamp; false: use system clock as timestamp
   bool dense_points = false;     ///< true: discard NAN points; false: reserve NAN points
   bool ts_first_point = false;   ///< true: time-stamp point cloud with the first point; false: with the last point;
@@ -313,6 +325,11 @@ struct RSDecoderParam  ///< LiDAR decoder parameter
     RS_INFOL << "split_frame_mode: " << split_frame_mode << RS_REND;
     RS_INFOL << "split_angle: " << split_angle << RS_REND;
     RS_INFOL << "num_blks_split: " << num_blks_split << RS_REND;
+    RS_INFOL << "split_period: " << split_period << RS_REND;
+    RS_INFOL << "split_phase: " << split_phase << RS_REND;
+    RS_INFOL << "sector_angle: " << sector_angle << RS_REND;
+    RS_INFOL << "sector_blks: " << sector_blks << RS_REND;
+    RS_INFOL << "window_resolution: " << window_resolution << RS_REND;
     RS_INFO << "------------------------------------------------------" << RS_REND;
     transform_param.print();
   }
@@ -325,9 +342,13 @@ struct RSInputParam  ///< The LiDAR input parameter
   uint16_t difop_port = 7788;                  ///< Difop packet port number
   std::string host_address = "0.0.0.0";        ///< Address of host
   std::string group_address = "0.0.0.0";       ///< Address of multicast group
-  std::string pcap_path = "";                  ///< Absolute path of pcap file
+  std::string lidar_address = "0.0.0.0";       ///< Address of Lidar. Only its packets are accepted. "0.0.0.0": any Lidar
+  uint16_t socket_num = 1;                     ///< Number of SO_REUSEPORT sockets (and threads) on msop_port. Linux only
+  bool steer_by_cpu = false;                   ///< Steer packets to the socket of the receiving CPU. Only if socket_num > 1
+  uint32_t merge_slack_us = 100;               ///< Time a packet waits for the earlier packets of other sockets. Only if socket_num > 1
+  std::string pcap_path = "";                  ///< Path of pcap file (or log file). May be a list separated by ";", or a glob
   bool pcap_repeat = true;                     ///< true: The pcap bag will repeat play
-  float pcap_rate = 1.0f;                      ///< Rate to read the pcap file
+  float pcap_rate = 1.0f;                      ///< Rate to read the pcap file. <= 0: as fast as possible
   bool use_vlan = false;                       ///< Vlan on-off
   uint16_t user_layer_bytes = 0;    ///< Bytes of user layer. thers is no user layer if it is 0
   uint16_t tail_layer_bytes = 0;    ///< Bytes of tail layer. thers is no tail layer if it is 0
@@ -340,6 +361,10 @@ struct RSInputParam  ///< The LiDAR input parameter
     RS_INFOL << "difop_port: " << difop_port << RS_REND;
     RS_INFOL << "host_address: " << host_address << RS_REND;
     RS_INFOL << "group_address: " << group_address << RS_REND;
+    RS_INFOL << "lidar_address: " << lidar_address << RS_REND;
+    RS_INFOL << "socket_num: " << socket_num << RS_REND;
+    RS_INFOL << "steer_by_cpu: " << steer_by_cpu << RS_REND;
+    RS_INFOL << "merge_slack_us: " << merge_slack_us << RS_REND;
     RS_INFOL << "pcap_path: " << pcap_path << RS_REND;
     RS_INFOL << "pcap_rate: " << pcap_rate << RS_REND;
     RS_INFOL << "pcap_repeat: " << pcap_repeat << RS_REND;
@@ -351,12 +376,177 @@ struct RSInputParam  ///< The LiDAR input parameter
 
 };
 
+enum RecordFormat
+{
+  RECORD_PCAP = 1,
+  RECORD_LOG
+};
+
+inline std::string recordFormatToStr(const RecordFormat& format)
+{
+  std::string str = "";
+  switch (format)
+  {
+    case RecordFormat::RECORD_PCAP:
+      str = "RECORD_PCAP";
+      break;
+    case RecordFormat::RECORD_LOG:
+      str = "RECORD_LOG";
+      break;
+    default:
+      str = "ERROR";
+      RS_ERROR << "RS_ERROR" << RS_REND;
+  }
+  return str;
+}
+
+enum LogCodec
+{
+  LOG_CODEC_NONE = 0,
+  LOG_CODEC_ZLIB,
+  LOG_CODEC_ZSTD
+};
+
+inline std::string logCodecToStr(const LogCodec& codec)
+{
+  std::string str = "";
+  switch (codec)
+  {
+    case LogCodec::LOG_CODEC_NONE:
+      str = "LOG_CODEC_NONE";
+      break;
+    case LogCodec::LOG_CODEC_ZLIB:
+      str = "LOG_CODEC_ZLIB";
+      break;
+    case LogCodec::LOG_CODEC_ZSTD:
+      str = "LOG_CODEC_ZSTD";
+      break;
+    default:
+      str = "ERROR";
+      RS_ERROR << "RS_ERROR" << RS_REND;
+  }
+  return str;
+}
+
+struct RSRecordParam  ///< The packet recorder parameter
+{
+  std::string record_path = "";     ///< Path prefix of record files. Recording is disabled if it is empty
+  RecordFormat record_format = RecordFormat::RECORD_PCAP; ///< Format of record files
+  LogCodec log_codec = LogCodec::LOG_CODEC_NONE; ///< Compression of chunks. Only for RECORD_LOG
+  uint32_t buf_size = 4194304;      ///< Bytes of each write buffer
+  uint16_t buf_num = 8;             ///< Number of write buffers. Packets are dropped if all buffers are full
+  uint32_t file_size_max = 0;       ///< Max MBytes of a record file. 0: no rotation by size
+  uint32_t file_duration_max = 0;   ///< Max seconds of a record file. 0: no rotation by time
+  bool use_direct_io = false;       ///< true: write record files with O_DIRECT (Linux only)
+
+  void print() const
+  {
+    RS_INFO << "------------------------------------------------------" << RS_REND;
+    RS_INFO << "             RoboSense Record Parameters " << RS_REND;
+    RS_INFOL << "record_path: " << record_path << RS_REND;
+    RS_INFOL << "record_format: " << recordFormatToStr(record_format) << RS_REND;
+    RS_INFOL << "log_codec: " << logCodecToStr(log_codec) << RS_REND;
+    RS_INFOL << "buf_size: " << buf_size << RS_REND;
+    RS_INFOL << "buf_num: " << buf_num << RS_REND;
+    RS_INFOL << "file_size_max: " << file_size_max << RS_REND;
+    RS_INFOL << "file_duration_max: " << file_duration_max << RS_REND;
+    RS_INFOL << "use_direct_io: " << use_direct_io << RS_REND;
+    RS_INFO << "------------------------------------------------------" << RS_REND;
+  }
+
+};
+
+struct RSThreadParam  ///< The placement of a driver thread
+{
+  std::vector<uint16_t> cpu_list;   ///< CPUs the thread may run on. Empty: any CPU
+  int priority = 0;                 ///< 1~99: SCHED_FIFO with this priority; 0: default scheduling
+  std::string name = "";            ///< Thread name, at most 15 characters. Empty: the default name
+
+  void print(const std::string& role) const
+  {
+    std::string cpus;
+    for (size_t i = 0; i < cpu_list.size(); i++)
+    {
+      cpus += (i == 0 ? "" : ",") + std::to_string(cpu_list[i]);
+    }
+
+    RS_INFOL << role << ".cpu_list: " << cpus << RS_REND;
+    RS_INFOL << role << ".priority: " << priority << RS_REND;
+    RS_INFOL << role << ".name: " << name << RS_REND;
+  }
+};
+
+enum DegradeMode  ///< Degradation of decoding, when the handling thread is overloaded. Bits of RSDegradeParam::modes
+{
+  DEGRADE_SKIP_NAN = 0x01,         ///< Discard NAN points, as dense_points = true
+  DEGRADE_NO_TRANSFORM = 0x02,     ///< Don't transform points. Only with ENABLE_TRANSFORM
+  DEGRADE_DROP_SECOND_ECHO = 0x04, ///< Drop the second echo of dual return mode. Mechanical Lidars only
+  DEGRADE_DECIMATE_RINGS = 0x08    ///< Drop the points of odd rings
+};
+
+inline std::string degradeModesToStr(uint8_t modes)
+{
+  std::string str;
+  if (modes & DEGRADE_SKIP_NAN)         str += "|SKIP_NAN";
+  if (modes & DEGRADE_NO_TRANSFORM)     str += "|NO_TRANSFORM";
+  if (modes & DEGRADE_DROP_SECOND_ECHO) str += "|DROP_SECOND_ECHO";
+  if (modes & DEGRADE_DECIMATE_RINGS)   str += "|DECIMATE_RINGS";
+  return str.empty() ? "NONE" : str.substr(1);
+}
+
+struct RSDegradeParam  ///< Degradation of decoding under overload
+{
+  uint8_t modes = 0;            ///< Allowed modes, bits of DegradeMode, applied in the order of their values. 0: disabled
+  float budget = 0.8f;          ///< Degrade a step further, if the decoding time of a frame exceeds budget * frame period
+  float recover = 0.5f;         ///< Recover a step, if the decoding time stays below recover * frame period ...
+  uint16_t recover_frames = 10; ///< ... for recover_frames frames in a row
+
+  void print() const
+  {
+    RS_INFO << "------------------------------------------------------" << RS_REND;
+    RS_INFO << "             RoboSense Degrade Parameters " << RS_REND;
+    RS_INFOL << "modes: " << degradeModesToStr(modes) << RS_REND;
+    RS_INFOL << "budget: " << budget << RS_REND;
+    RS_INFOL << "recover: " << recover << RS_REND;
+    RS_INFOL << "recover_frames: " << recover_frames << RS_REND;
+    RS_INFO << "------------------------------------------------------" << RS_REND;
+  }
+};
+
+struct RSAllocParam  ///< Steady state of heap allocations. Only with ENABLE_ALLOC_TRACKING
+{
+  int32_t max_pkt_allocs = -1;   ///< Max allocations of a packet in steady state. -1: no limit
+  int32_t max_frame_allocs = -1; ///< Max allocations of a frame in steady state. -1: no limit
+  uint16_t warmup_frames = 10;   ///< Frames before the steady state, e.g. to fill the buffer pools
+  bool abort_on_exceed = true;   ///< true: abort the process, if a limit is exceeded. false: report the error only
+
+  void print() const
+  {
+    RS_INFO << "------------------------------------------------------" << RS_REND;
+    RS_INFO << "             RoboSense Alloc Parameters " << RS_REND;
+    RS_INFOL << "max_pkt_allocs: " << max_pkt_allocs << RS_REND;
+    RS_INFOL << "max_frame_allocs: " << max_frame_allocs << RS_REND;
+    RS_INFOL << "warmup_frames: " << warmup_frames << RS_REND;
+    RS_INFOL << "abort_on_exceed: " << abort_on_exceed << RS_REND;
+    RS_INFO << "------------------------------------------------------" << RS_REND;
+  }
+};
+
 struct RSDriverParam  ///< The LiDAR driver parameter
 {
   LidarType lidar_type = LidarType::RS16;  ///< Lidar type
   InputType input_type = InputType::ONLINE_LIDAR; ///< Input type
   RSInputParam input_param;          ///< Input parameter
   RSDecoderParam decoder_param;      ///< Decoder parameter
+  RSRecordParam record_param;        ///< Packet recorder parameter
+  RSDegradeParam degrade_param;      ///< Degradation of decoding under overload
+  RSAllocParam alloc_param;          ///< Steady state of heap allocations. Only with ENABLE_ALLOC_TRACKING
+  RSThreadParam recv_thread_param;   ///< Placement of the receiving thread(s)
+  RSThreadParam handle_thread_param; ///< Placement of the handling (decoding) thread
+  uint16_t frame_queue_len = 0;      ///< >0: pull frames by waitForFrame()/tryGetFrame(), instead of the point cloud callbacks. 
+                                     ///< Keep at most frame_queue_len frames, dropping the oldest. 1: the latest frame wins
+  float latency_dump_interval = 0.0f;///< Seconds between the dumps of the latency statistics. Only with ENABLE_LATENCY_STATS. 
+                                     ///< 0: no dump
 
   void print() const
   {
@@ -364,10 +554,86 @@ struct RSDriverParam  ///< The LiDAR driver parameter
     RS_INFO << "             RoboSense Driver Parameters " << RS_REND;
     RS_INFOL << "input type: " << inputTypeToStr(input_type) << RS_REND;
     RS_INFOL << "lidar_type: " << lidarTypeToStr(lidar_type) << RS_REND;
+    RS_INFOL << "frame_queue_len: " << frame_queue_len << RS_REND;
+    RS_INFOL << "latency_dump_interval: " << latency_dump_interval << RS_REND;
     RS_INFOL << "------------------------------------------------------" << RS_REND;
 
     input_param.print();
     decoder_param.print();
+    record_param.print();
+    degrade_param.print();
+    alloc_param.print();
+
+    RS_INFO << "------------------------------------------------------" << RS_REND;
+    RS_INFO << "             RoboSense Thread Parameters " << RS_REND;
+    recv_thread_param.print("recv_thread");
+    handle_thread_param.print("handle_thread");
+    RS_INFO << "------------------------------------------------------" << RS_REND;
+  }
+
+};
+
+struct RSManagerParam  ///< The parameter of LidarDriverManager, shared by its Lidars
+{
+  uint16_t recv_thread_num = 1;      ///< Number of receiving threads (epoll loops). Linux only
+  uint16_t worker_thread_num = 2;    ///< Number of threads to decode packets
+  RSThreadParam recv_thread_param;   ///< Placement of the receiving threads. The names get a suffix of index
+  RSThreadParam worker_thread_param; ///< Placement of the decoding threads. The names get a suffix of index
+
+  void print() const
+  {
+    RS_INFO << "------------------------------------------------------" << RS_REND;
+    RS_INFO << "             RoboSense Manager Parameters " << RS_REND;
+    RS_INFOL << "recv_thread_num: " << recv_thread_num << RS_REND;
+    RS_INFOL << "worker_thread_num: " << worker_thread_num << RS_REND;
+    recv_thread_param.print("recv_thread");
+    worker_thread_param.print("worker_thread");
+    RS_INFO << "------------------------------------------------------" << RS_REND;
+  }
+
+};
+
+struct RSFusionParam  ///< The parameter of FusionDriver
+{
+  std::vector<RSDriverParam> lidars; ///< Lidars to fuse. The index of a Lidar is the lidar_id of its points
+  double split_period = 0.1;         ///< Seconds of a fused frame
+  double split_phase = 0.0;          ///< Frames are split at split_phase + k * split_period (seconds, Lidar clock)
+  double max_wait = 0.1;             ///< Seconds to wait for a late Lidar, before a frame is emitted without it
+
+  void print() const
+  {
+    RS_INFO << "------------------------------------------------------" << RS_REND;
+    RS_INFO << "             RoboSense Fusion Parameters " << RS_REND;
+    RS_INFOL << "lidar num: " << lidars.size() << RS_REND;
+    RS_INFOL << "split_period: " << split_period << RS_REND;
+    RS_INFOL << "split_phase: " << split_phase << RS_REND;
+    RS_INFOL << "max_wait: " << max_wait << RS_REND;
+    RS_INFO << "------------------------------------------------------" << RS_REND;
+
+    for (const auto& lidar : lidars)
+    {
+      lidar.print();
+    }
+  }
+
+};
+
+struct RSMetricsParam  ///< The parameter of MetricsExporter
+{
+  std::string address = "127.0.0.1"; ///< Address of the TCP port to listen on
+  uint16_t port = 0;                  ///< TCP port to listen on. 0: any free port. See MetricsExporter::port()
+  std::string unix_path = "";         ///< Path of the Unix socket to listen on, instead of the TCP port. Empty: TCP
+  RSThreadParam thread_param;         ///< Placement of the exporter thread
+
+  void print() const
+  {
+    RS_INFO << "------------------------------------------------------" << RS_REND;
+    RS_INFO << "             RoboSense Metrics Parameters " << RS_REND;
+    RS_INFOL << "address: " << address << RS_REND;
+    RS_INFOL << "port: " << port << RS_REND;
+    RS_INFOL << "unix_path: " << unix_path << RS_REND;
+    thread_param.print("metrics_thread");
+    RS_INFO << "------------------------------------------------------" << RS_REND;
   }
 
 };
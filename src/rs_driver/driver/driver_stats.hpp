@@ -0,0 +1,118 @@
+/*********************************************************************************************************************
+Copyright (c) 2020 RoboSense
+All rights reserved
+
+By downloading, copying, installing or using the software you agree to this license. If you do not agree to this
+license, do not download, install, copy or use the software.
+
+License Agreement
+For RoboSense LiDAR SDK Library
+(3-clause BSD License)
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that the
+following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following
+disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following
+disclaimer in the documentation and/or other materials provided with the distribution.
+
+3. Neither the names of the RoboSense, nor Suteng Innovation Technology, nor the names of other contributors may be used
+to endorse or promote products derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*********************************************************************************************************************/
+
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+namespace robosense
+{
+namespace lidar
+{
+
+struct DriverStats  ///< Counters of a driver instance, since init()
+{
+  uint64_t pkts = 0;               ///< Packets received
+  uint64_t msop_pkts = 0;          ///< MSOP packets handled
+  uint64_t difop_pkts = 0;         ///< DIFOP packets handled
+  uint64_t wrong_len_pkts = 0;     ///< MSOP/DIFOP packets with wrong length
+  uint64_t wrong_id_pkts = 0;      ///< MSOP/DIFOP packets with wrong id
+  uint64_t no_difop_pkts = 0;      ///< MSOP packets ignored before DIFOP packet is received (wait_for_difop)
+  uint64_t queue_dropped_pkts = 0; ///< Packets dropped since the packet queue overflows
+  uint64_t cloud_overflows = 0;    ///< MSOP packets decoded into a point cloud of too many points
+  uint64_t frames = 0;             ///< Point clouds delivered
+  uint64_t empty_frames = 0;       ///< Frames without any point, and not delivered
+  uint64_t points = 0;             ///< Points of all delivered point clouds
+  uint64_t last_frame_points = 0;  ///< Points of the last delivered point cloud
+  uint64_t lossy_frames = 0;       ///< Frames with lost packets. See FrameQuality
+  uint64_t decode_ns = 0;          ///< Nanoseconds spent in decoding MSOP packets
+  uint64_t lost_pkts = 0;          ///< Estimated lost MSOP packets, by pkt_seq (MEMS) or azimuth gaps (mechanical).
+                                   ///< It goes down if a packet counted lost arrives late
+  uint64_t out_of_order_pkts = 0;  ///< MSOP packets late or duplicated
+  uint64_t degrade_modes = 0;      ///< Degrade modes enabled now, bits of DegradeMode. See RSDegradeParam
+  uint64_t degrade_changes = 0;    ///< Times the degrade modes changed
+  uint64_t queue_depth = 0;        ///< Packets in the packet queue, when the last packet was pushed
+  uint64_t rpm = 0;                ///< RPM in the last DIFOP packet. Mechanical Lidars only
+  uint64_t allocs = 0;             ///< Heap allocations of the driver threads, for packets and frames. Only with ENABLE_ALLOC_TRACKING
+  uint64_t last_frame_allocs = 0;  ///< Heap allocations of the last frame. Only with ENABLE_ALLOC_TRACKING
+  uint64_t max_pkt_allocs = 0;     ///< Max heap allocations of a packet, in steady state. See RSAllocParam
+  uint64_t max_frame_allocs = 0;   ///< Max heap allocations of a frame, in steady state. See RSAllocParam
+};
+
+//
+// Counter read by other threads without lock. 
+// add()/sub()/set() are for a single writer, e.g. the handling thread. inc() may be called by multiple writers.
+//
+class StatCounter
+{
+public:
+
+  StatCounter()
+    : v_(0)
+  {
+  }
+
+  void add(uint64_t n)
+  {
+    v_.store(v_.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+  }
+
+  void sub(uint64_t n)
+  {
+    uint64_t v = v_.load(std::memory_order_relaxed);
+    v_.store((v > n) ? (v - n) : 0, std::memory_order_relaxed);
+  }
+
+  void set(uint64_t v)
+  {
+    v_.store(v, std::memory_order_relaxed);
+  }
+
+  void inc(uint64_t n = 1)
+  {
+    v_.fetch_add(n, std::memory_order_relaxed);
+  }
+
+  uint64_t get() const
+  {
+    return v_.load(std::memory_order_relaxed);
+  }
+
+private:
+
+  std::atomic<uint64_t> v_;
+};
+
+}  // namespace lidar
+}  // namespace robosense
@@ -0,0 +1,671 @@
+/*********************************************************************************************************************
+Copyright (c) 2020 RoboSense
+All rights reserved
+
+By downloading, copying, installing or using the software you agree to this license. If you do not agree to this
+license, do not download, install, copy or use the software.
+
+License Agreement
+For RoboSense LiDAR SDK Library
+(3-clause BSD License)
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that the
+following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following
+disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following
+disclaimer in the documentation and/or other materials provided with the distribution.
+
+3. Neither the names of the RoboSense, nor Suteng Innovation Technology, nor the names of other contributors may be used
+to endorse or promote products derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*********************************************************************************************************************/
+
+
+#pragma once
+
+#include <rs_driver/driver/driver_param.hpp>
+#include <rs_driver/msg/packet.hpp>
+#include <rs_driver/common/error_code.hpp>
+#include <rs_driver/utility/sync_queue.hpp>
+#include <rs_driver/utility/buffer.hpp>
+#include <rs_driver/driver/input/input_factory.hpp>
+#include <rs_driver/driver/decoder/decoder_factory.hpp>
+
+#include <deque>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+
+namespace robosense
+{
+namespace lidar
+{
+
+//
+// Fuse the point clouds of multiple Lidars. 
+// The packets of all Lidars are decoded by one thread, directly into the merged clouds. 
+// The merged clouds are split on a common time grid (phase + k * period), by the timestamps of packets.
+// If the time of a Lidar jumps back (PCAP file replayed, or Lidar clock reset), the open frames are emitted, and 
+// the grid starts again. The other Lidars join it when their time jumps back too.
+//
+template <typename T_PointCloud>
+class FusionDriverImpl
+{
+public:
+
+  FusionDriverImpl();
+  ~FusionDriverImpl();
+
+  void regPointCloudCallback(
+      const std::function<std::shared_ptr<T_PointCloud>(void)>& cb_get_cloud,
+      const std::function<void(std::shared_ptr<T_PointCloud>)>& cb_put_cloud);
+  void regExceptionCallback(const std::function<void(const Error&)>& cb_excep);
+
+  bool init(const RSFusionParam& param);
+  bool start();
+  void stop();
+
+  void decodePacket(size_t lidar_id, const Packet& pkt);
+  uint64_t latePktNum() const;
+
+#ifndef UNIT_TEST
+private:
+#endif
+
+  struct Lidar
+  {
+    std::shared_ptr<Decoder<T_PointCloud>> decoder;
+    std::shared_ptr<Input> input;
+    std::function<void(const uint8_t*, size_t)> cb_feed_pkt;
+    float rotate[3][3]; // extrinsic
+    float translate[3];
+    bool has_ts;
+    double latest_ts; // timestamp of the latest packet
+    int64_t slot; // slot of the latest packet
+    bool stale; // its time is before the jump back of another Lidar. Its packets are dropped.
+  };
+
+  struct Slot
+  {
+    int64_t idx;
+    std::shared_ptr<T_PointCloud> cloud;
+  };
+
+  void runExceptionCallback(const Error& error);
+
+  std::shared_ptr<Buffer> packetGet(size_t size);
+  void packetPut(size_t lidar_id, std::shared_ptr<Buffer> pkt, bool stuffed);
+  void processPacket();
+  void handlePacket(size_t lidar_id, const uint8_t* data, size_t size);
+
+  static void setExtrinsic(Lidar& lidar, const RSTransformParam& trans);
+  void transformPoints(size_t lidar_id, T_PointCloud& cloud, size_t from);
+
+  int64_t slotOf(double ts);
+  std::shared_ptr<T_PointCloud> slotCloud(int64_t idx, bool create);
+  void emitSlots(bool flush = false);
+  void resetSlots(size_t lidar_id);
+  bool inGrid(int64_t slot);
+
+  std::shared_ptr<T_PointCloud> getPointCloud();
+
+  RSFusionParam param_;
+  std::function<std::shared_ptr<T_PointCloud>(void)> cb_get_cloud_;
+  std::function<void(std::shared_ptr<T_PointCloud>)> cb_put_cloud_;
+  std::function<void(const Error&)> cb_excep_;
+  ErrorLimiter err_limiter_;
+
+  std::vector<Lidar> lidars_;
+  std::deque<Slot> slots_; // open slots, by idx
+  std::shared_ptr<T_PointCloud> scratch_cloud_;
+  int64_t next_slot_; // slots before it are emitted
+  bool slot_emitted_;
+  bool dense_points_;
+  uint16_t cloud_height_; // rows of the merged clouds if organized, else 0
+
+  SyncQueue<std::shared_ptr<Buffer>> free_pkt_queue_;
+  SyncQueue<std::pair<size_t, std::shared_ptr<Buffer>>> pkt_queue_;
+  std::thread handle_thread_;
+  uint32_t point_cloud_seq_;
+  std::atomic<uint64_t> late_pkt_num_;
+  bool to_exit_handle_;
+  bool init_flag_;
+  bool start_flag_;
+};
+
+template <typename T_PointCloud>
+inline FusionDriverImpl<T_PointCloud>::FusionDriverImpl()
+  : next_slot_(0), slot_emitted_(false), dense_points_(true), cloud_height_(0), 
+    point_cloud_seq_(0), late_pkt_num_(0), to_exit_handle_(false), init_flag_(false), start_flag_(false)
+{
+}
+
+template <typename T_PointCloud>
+inline FusionDriverImpl<T_PointCloud>::~FusionDriverImpl()
+{
+  stop();
+}
+
+template <typename T_PointCloud>
+inline void FusionDriverImpl<T_PointCloud>::regPointCloudCallback(
+    const std::function<std::shared_ptr<T_PointCloud>(void)>& cb_get_cloud,
+    const std::function<void(std::shared_ptr<T_PointCloud>)>& cb_put_cloud)
+{
+  cb_get_cloud_ = cb_get_cloud;
+  cb_put_cloud_ = cb_put_cloud;
+}
+
+template <typename T_PointCloud>
+inline void FusionDriverImpl<T_PointCloud>::regExceptionCallback(
+    const std::function<void(const Error&)>& cb_excep)
+{
+  cb_excep_ = cb_excep;
+}
+
+template <typename T_PointCloud>
+inline bool FusionDriverImpl<T_PointCloud>::init(const RSFusionParam& param)
+{
+  if (init_flag_)
+  {
+    return true;
+  }
+
+  if (param.lidars.empty() || (param.lidars.size() > 256) || (param.split_period <= 0))
+  {
+    RS_ERROR << "FusionDriver: 1 ~ 256 Lidars, and split_period > 0." << RS_REND;
+    return false;
+  }
+
+  param_ = param;
+  lidars_.resize(param.lidars.size());
+
+  for (size_t i = 0; i < lidars_.size(); i++)
+  {
+    const RSDriverParam& lidar_param = param.lidars[i];
+    Lidar& lidar = lidars_[i];
+
+    //
+    // decoder
+    //
+    RSDecoderParam decoder_param = lidar_param.decoder_param;
+#ifdef ENABLE_TRANSFORM
+    // the decoder transforms the points itself.
+    setExtrinsic(lidar, RSTransformParam());
+#else
+    setExtrinsic(lidar, decoder_param.transform_param);
+#endif
+
+    lidar.decoder = DecoderFactory<T_PointCloud>::createDecoder(lidar_param.lidar_type, decoder_param);
+    lidar.decoder->enableWritePktTs(false);
+    lidar.decoder->setCloudPointMax(Decoder<T_PointCloud>::CLOUD_POINT_MAX * lidars_.size()); // clouds of all Lidars
+    lidar.decoder->regCallback(
+        std::bind(&FusionDriverImpl<T_PointCloud>::runExceptionCallback, this, std::placeholders::_1),
+        [](uint16_t, double) {}); // split by the time grid instead.
+
+    lidar.has_ts = false;
+    lidar.latest_ts = 0;
+    lidar.slot = 0;
+    lidar.stale = false;
+
+    dense_points_ = dense_points_ && decoder_param.dense_points;
+
+    // organized only if the points of all Lidars are in columns of the same height.
+    uint16_t height = decoder_param.dense_points ? 0 : lidar.decoder->constParam().LASER_NUM;
+    cloud_height_ = ((i == 0) || (height == cloud_height_)) ? height : 0;
+
+    //
+    // input
+    //
+    lidar.input = InputFactory::createInput(lidar_param.input_type, lidar_param.input_param, 
+        isJumbo(lidar_param.lidar_type), lidar.decoder->getPacketDuration(), lidar.cb_feed_pkt);
+    lidar.input->regCallback(
+        std::bind(&FusionDriverImpl<T_PointCloud>::runExceptionCallback, this, std::placeholders::_1), 
+        std::bind(&FusionDriverImpl<T_PointCloud>::packetGet, this, std::placeholders::_1), 
+        std::bind(&FusionDriverImpl<T_PointCloud>::packetPut, this, i, std::placeholders::_1, std::placeholders::_2));
+
+    if (!lidar.input->init())
+    {
+      goto failInputInit;
+    }
+  }
+
+  scratch_cloud_ = std::make_shared<T_PointCloud>();
+  init_flag_ = true;
+  return true;
+
+failInputInit:
+  lidars_.clear();
+  return false;
+}
+
+template <typename T_PointCloud>
+inline bool FusionDriverImpl<T_PointCloud>::start()
+{
+  if (start_flag_)
+  {
+    return true;
+  }
+
+  if (!init_flag_)
+  {
+    return false;
+  }
+
+  to_exit_handle_ = false;
+  handle_thread_ = std::thread(std::bind(&FusionDriverImpl<T_PointCloud>::processPacket, this));
+
+  for (auto& lidar : lidars_)
+  {
+    lidar.input->start();
+  }
+
+  start_flag_ = true;
+  return true;
+}
+
+template <typename T_PointCloud>
+inline void FusionDriverImpl<T_PointCloud>::stop()
+{
+  if (!start_flag_)
+  {
+    return;
+  }
+
+  for (auto& lidar : lidars_)
+  {
+    lidar.input->stop();
+  }
+
+  to_exit_handle_ = true;
+  handle_thread_.join();
+
+  start_flag_ = false;
+}
+
+template <typename T_PointCloud>
+inline void FusionDriverImpl<T_PointCloud>::decodePacket(size_t lidar_id, const Packet& pkt)
+{
+  if ((lidar_id < lidars_.size()) && lidars_[lidar_id].cb_feed_pkt)
+  {
+    lidars_[lidar_id].cb_feed_pkt(pkt.buf_.data(), pkt.buf_.size());
+  }
+}
+
+template <typename T_PointCloud>
+inline uint64_t FusionDriverImpl<T_PointCloud>::latePktNum() const
+{
+  return late_pkt_num_;
+}
+
+template <typename T_PointCloud>
+inline void FusionDriverImpl<T_PointCloud>::runExceptionCallback(const Error& error)
+{
+  if (cb_excep_)
+  {
+    cb_excep_(error);
+  }
+}
+
+template <typename T_PointCloud>
+inline std::shared_ptr<Buffer> FusionDriverImpl<T_PointCloud>::packetGet(size_t size)
+{
+  std::shared_ptr<Buffer> pkt = free_pkt_queue_.pop();
+  if (pkt.get() != NULL)
+  {
+    return pkt;
+  }
+
+  return std::make_shared<Buffer>(size);
+}
+
+template <typename T_PointCloud>
+inline void FusionDriverImpl<T_PointCloud>::packetPut(size_t lidar_id, std::shared_ptr<Buffer> pkt, bool stuffed)
+{
+  constexpr static int PACKET_POOL_MAX = 4096;
+
+  if (!stuffed)
+  {
+    free_pkt_queue_.push(pkt);
+    return;
+  }
+
+  size_t sz = pkt_queue_.push(std::make_pair(lidar_id, pkt));
+  if (sz > PACKET_POOL_MAX)
+  {
+    err_limiter_.call(cb_excep_, ERRCODE_PKTBUFOVERFLOW, 1);
+    pkt_queue_.clear();
+  }
+}
+
+template <typename T_PointCloud>
+inline void FusionDriverImpl<T_PointCloud>::processPacket()
+{
+  // without packets for so long, the Lidars are stopped. Don't hold their last frames.
+  const unsigned int idle_us = (unsigned int)((param_.split_period + param_.max_wait) * 1000000);
+  const unsigned int wait_us = std::min(idle_us, 500000u);
+  std::chrono::steady_clock::time_point last_pkt = std::chrono::steady_clock::now();
+
+  while (!to_exit_handle_)
+  {
+    std::pair<size_t, std::shared_ptr<Buffer>> item = pkt_queue_.popWait(wait_us);
+    std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+    if (item.second.get() == NULL)
+    {
+      if (now - last_pkt >= std::chrono::microseconds(idle_us))
+      {
+        emitSlots(true);
+      }
+      continue;
+    }
+
+    last_pkt = now;
+    handlePacket(item.first, item.second->data(), item.second->dataSize());
+    free_pkt_queue_.push(item.second);
+  }
+
+  emitSlots(true);
+}
+
+template <typename T_PointCloud>
+inline void FusionDriverImpl<T_PointCloud>::handlePacket(size_t lidar_id, const uint8_t* data, size_t size)
+{
+  Lidar& lidar = lidars_[lidar_id];
+
+  if (*data == 0xA5)
+  {
+    lidar.decoder->processDifopPkt(data, size);
+    return;
+  }
+  else if (*data != 0x55)
+  {
+    return;
+  }
+
+  //
+  // Decode into the slot of the previous packet. Mostly it is the slot of this packet too.
+  //
+  std::shared_ptr<T_PointCloud> cloud = (lidar.has_ts && !lidar.stale) ? slotCloud(lidar.slot, false) : nullptr;
+  if (!cloud)
+  {
+    cloud = scratch_cloud_;
+    cloud->points.resize(0);
+  }
+
+  size_t from = cloud->points.size();
+  lidar.decoder->point_cloud_ = cloud;
+  lidar.decoder->processMsopPkt(data, size);
+  lidar.decoder->point_cloud_.reset();
+
+  size_t to = cloud->points.size();
+  if (to == from)
+  {
+    return;
+  }
+
+  double ts = lidar.decoder->prevPktTs();
+  int64_t slot = slotOf(ts);
+
+  if (lidar.has_ts && (slot < lidar.slot - 1)) // time jumps back
+  {
+    if (lidar.stale)
+    {
+      lidar.stale = false; // the grid has started again, by another Lidar.
+    }
+    else
+    {
+      if (cloud != scratch_cloud_)
+      {
+        // the points of this packet are not of the open slots.
+        scratch_cloud_->points.assign(cloud->points.begin() + from, cloud->points.begin() + to);
+        cloud->points.resize(from);
+        cloud = scratch_cloud_;
+        from = 0;
+        to = cloud->points.size();
+      }
+
+      resetSlots(lidar_id);
+    }
+  }
+
+  if (lidar.stale && inGrid(slot))
+  {
+    lidar.stale = false; // e.g. the clocks are synchronized again.
+  }
+
+  if (lidar.stale)
+  {
+    cloud->points.resize(from);
+    late_pkt_num_++;
+    lidar.latest_ts = ts;
+    lidar.slot = slot;
+    return;
+  }
+
+  std::shared_ptr<T_PointCloud> target = slotCloud(slot, true);
+  if (!target)
+  {
+    err_limiter_.call(cb_excep_, ERRCODE_FUSIONLATEPKT, 1);
+    late_pkt_num_++;
+    cloud->points.resize(from);
+  }
+  else if (target != cloud)
+  {
+    // move the points of this packet to its slot.
+    size_t target_from = target->points.size();
+    target->points.insert(target->points.end(), cloud->points.begin() + from, cloud->points.begin() + to);
+    cloud->points.resize(from);
+    transformPoints(lidar_id, *target, target_from);
+  }
+  else
+  {
+    transformPoints(lidar_id, *target, from);
+  }
+
+  lidar.has_ts = true;
+  lidar.latest_ts = ts;
+  lidar.slot = slot;
+
+  emitSlots();
+}
+
+template <typename T_PointCloud>
+inline void FusionDriverImpl<T_PointCloud>::setExtrinsic(Lidar& lidar, const RSTransformParam& trans)
+{
+  // the same as Decoder::transformPoint(): translate * rotate_z * rotate_y * rotate_x
+  double cr = cos(trans.roll), sr = sin(trans.roll);
+  double cp = cos(trans.pitch), sp = sin(trans.pitch);
+  double cy = cos(trans.yaw), sy = sin(trans.yaw);
+
+  lidar.rotate[0][0] = (float)(cy * cp);
+  lidar.rotate[0][1] = (float)(cy * sp * sr - sy * cr);
+  lidar.rotate[0][2] = (float)(cy * sp * cr + sy * sr);
+  lidar.rotate[1][0] = (float)(sy * cp);
+  lidar.rotate[1][1] = (float)(sy * sp * sr + cy * cr);
+  lidar.rotate[1][2] = (float)(sy * sp * cr - cy * sr);
+  lidar.rotate[2][0] = (float)(-sp);
+  lidar.rotate[2][1] = (float)(cp * sr);
+  lidar.rotate[2][2] = (float)(cp * cr);
+
+  lidar.translate[0] = trans.x;
+  lidar.translate[1] = trans.y;
+  lidar.translate[2] = trans.z;
+}
+
+template <typename T_PointCloud>
+inline void FusionDriverImpl<T_PointCloud>::transformPoints(size_t lidar_id, T_PointCloud& cloud, size_t from)
+{
+  const Lidar& lidar = lidars_[lidar_id];
+  const float (*r)[3] = lidar.rotate;
+  const float* t = lidar.translate;
+
+  for (size_t i = from; i < cloud.points.size(); i++)
+  {
+    typename T_PointCloud::PointT& point = cloud.points[i];
+
+    float x = point.x, y = point.y, z = point.z;
+    setX(point, r[0][0] * x + r[0][1] * y + r[0][2] * z + t[0]);
+    setY(point, r[1][0] * x + r[1][1] * y + r[1][2] * z + t[1]);
+    setZ(point, r[2][0] * x + r[2][1] * y + r[2][2] * z + t[2]);
+    setLidarId(point, (uint8_t)lidar_id);
+  }
+}
+
+template <typename T_PointCloud>
+inline int64_t FusionDriverImpl<T_PointCloud>::slotOf(double ts)
+{
+  return (int64_t)std::floor((ts - param_.split_phase) / param_.split_period);
+}
+
+template <typename T_PointCloud>
+inline std::shared_ptr<T_PointCloud> FusionDriverImpl<T_PointCloud>::slotCloud(int64_t idx, bool create)
+{
+  if (slot_emitted_ && (idx < next_slot_)) // too late
+  {
+    return nullptr;
+  }
+
+  auto it = slots_.begin();
+  for (; it != slots_.end(); it++)
+  {
+    if (it->idx == idx)
+    {
+      return it->cloud;
+    }
+    else if (it->idx > idx)
+    {
+      break;
+    }
+  }
+
+  if (!create)
+  {
+    return nullptr;
+  }
+
+  Slot slot;
+  slot.idx = idx;
+  slot.cloud = getPointCloud();
+  slots_.insert(it, slot);
+  return slot.cloud;
+}
+
+template <typename T_PointCloud>
+inline void FusionDriverImpl<T_PointCloud>::resetSlots(size_t lidar_id)
+{
+  emitSlots(true);
+  next_slot_ = 0;
+  slot_emitted_ = false;
+
+  for (size_t i = 0; i < lidars_.size(); i++)
+  {
+    if ((i != lidar_id) && lidars_[i].has_ts)
+    {
+      lidars_[i].stale = true;
+    }
+  }
+}
+
+template <typename T_PointCloud>
+inline bool FusionDriverImpl<T_PointCloud>::inGrid(int64_t slot)
+{
+  // near the slots of the Lidars on the grid.
+  for (const auto& lidar : lidars_)
+  {
+    if (lidar.has_ts && !lidar.stale && (slot >= lidar.slot - 1) && (slot <= lidar.slot + 1))
+    {
+      return true;
+    }
+  }
+
+  return false;
+}
+
+template <typename T_PointCloud>
+inline void FusionDriverImpl<T_PointCloud>::emitSlots(bool flush)
+{
+  double max_ts = 0;
+  for (const auto& lidar : lidars_)
+  {
+    if (lidar.has_ts && !lidar.stale && (lidar.latest_ts > max_ts))
+    {
+      max_ts = lidar.latest_ts;
+    }
+  }
+
+  while (!slots_.empty())
+  {
+    Slot& slot = slots_.front();
+    double slot_end = param_.split_phase + (slot.idx + 1) * param_.split_period;
+
+    //
+    // wait until all Lidars pass the end of the slot. 
+    // A Lidar too far behind the others is not waited.
+    //
+    for (const auto& lidar : lidars_)
+    {
+      if (!flush && lidar.has_ts && !lidar.stale && 
+          (lidar.latest_ts < slot_end) && (lidar.latest_ts >= max_ts - param_.max_wait))
+      {
+        return;
+      }
+    }
+
+    std::shared_ptr<T_PointCloud> cloud = slot.cloud;
+    double slot_ts = param_.split_phase + slot.idx * param_.split_period;
+
+    next_slot_ = slot.idx + 1;
+    slot_emitted_ = true;
+    slots_.pop_front();
+
+    if (cloud->points.size() == 0)
+    {
+      runExceptionCallback(Error(ERRCODE_ZEROPOINTS));
+      continue;
+    }
+
+    cloud->seq = point_cloud_seq_++;
+    cloud->timestamp = slot_ts;
+    cloud->is_dense = dense_points_;
+    if ((cloud_height_ > 0) && (cloud->points.size() % cloud_height_ == 0))
+    {
+      cloud->height = cloud_height_;
+      cloud->width = (uint32_t)cloud->points.size() / cloud->height;
+    }
+    else
+    {
+      cloud->height = 1;
+      cloud->width = (uint32_t)cloud->points.size();
+    }
+    cb_put_cloud_(cloud);
+  }
+}
+
+template <typename T_PointCloud>
+inline std::shared_ptr<T_PointCloud> FusionDriverImpl<T_PointCloud>::getPointCloud()
+{
+  while (1)
+  {
+    std::shared_ptr<T_PointCloud> cloud = cb_get_cloud_();
+    if (cloud)
+    {
+      cloud->points.resize(0);
+      return cloud;
+    }
+
+    err_limiter_.call(cb_excep_, ERRCODE_POINTCLOUDNULL, 1);
+  }
+}
+
+}  // namespace lidar
+}  // namespace robosense
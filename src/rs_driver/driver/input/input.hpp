@@ -33,8 +33,13 @@ THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #pragma once
 
 #include <rs_driver/driver/driver_param.hpp>
+#include <rs_driver/common/error_code.hpp>
 #include <rs_driver/utility/buffer.hpp>
+#include <rs_driver/utility/latency_stats.hpp>
+#include <rs_driver/utility/trace.hpp>
+#include <rs_driver/utility/alloc_tracker.hpp>
 
+#include <memory>
 #include <functional>
 #include <thread>
 #include <cstring>
@@ -62,6 +67,24 @@ public:
   virtual bool init() = 0;
   virtual bool start() = 0;
   virtual void stop();
+
+  //
+  // Read a packet and push it, in the caller's thread, instead of the receiving thread.
+  // Only for file inputs. Return false at the end of the files.
+  //
+  virtual bool readPacket()
+  {
+    return false;
+  }
+
+  //
+  // Called first in each receiving thread, with its index, e.g. to place the thread. Register it before start().
+  //
+  inline void regThreadCallback(const std::function<void(size_t)>& cb_thread)
+  {
+    cb_thread_ = cb_thread;
+  }
+
   virtual ~Input()
   {
   }
@@ -69,10 +92,19 @@ public:
 protected:
   inline void pushPacket(std::shared_ptr<Buffer> pkt, bool stuffed = true);
 
+  inline void beginThread(size_t idx)
+  {
+    if (cb_thread_)
+    {
+      cb_thread_(idx);
+    }
+  }
+
   RSInputParam input_param_;
   std::function<std::shared_ptr<Buffer>(size_t size)> cb_get_pkt_;
   std::function<void(std::shared_ptr<Buffer>, bool)> cb_put_pkt_;
   std::function<void(const Error&)> cb_excep_;
+  std::function<void(size_t)> cb_thread_;
   std::thread recv_thread_;
   bool to_exit_recv_;
   bool init_flag_;
@@ -108,6 +140,21 @@ inline void Input::stop()
 
 inline void Input::pushPacket(std::shared_ptr<Buffer> pkt, bool stuffed)
 {
+#ifdef ENABLE_LATENCY_STATS
+  pkt->recv_ns = latencyNow();
+#endif
+
+#ifdef ENABLE_ALLOC_TRACKING
+  if (stuffed)
+  {
+    // e.g. getting the buffer. The allocations of pushing it go with the next packet.
+    static thread_local uint64_t prev_allocs = 0;
+    uint64_t allocs = AllocTracker::threadCount();
+    pkt->allocs = allocs - prev_allocs;
+    prev_allocs = allocs;
+  }
+#endif
+
   cb_put_pkt_(pkt, stuffed);
 }
 
@@ -37,6 +37,12 @@ THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include <rs_driver/driver/input/input_raw_jumbo.hpp>
 #include <rs_driver/driver/input/input_sock.hpp>
 #include <rs_driver/driver/input/input_sock_jumbo.hpp>
+#include <rs_driver/driver/input/input_log.hpp>
+
+#ifndef _WIN32
+#include <rs_driver/driver/input/unix/input_sock_shared.hpp>
+#include <rs_driver/driver/input/unix/input_sock_reuse.hpp>
+#endif
 
 #ifndef DISABLE_PCAP_PARSE
 #include <rs_driver/driver/input/input_pcap.hpp>
@@ -48,15 +54,21 @@ namespace robosense
 namespace lidar
 {
 
+#ifdef _WIN32
+class RecvEngine;
+#endif
+
 class InputFactory
 {
 public:
   static std::shared_ptr<Input> createInput(InputType type, const RSInputParam& param, bool isJumbo,
-      double sec_to_delay, std::function<void(const uint8_t*, size_t)>& cb_feed_pkt);
+      double sec_to_delay, std::function<void(const uint8_t*, size_t)>& cb_feed_pkt,
+      std::shared_ptr<RecvEngine> recv_engine = nullptr);
 };
 
 inline std::shared_ptr<Input> InputFactory::createInput(InputType type, const RSInputParam& param, bool isJumbo,
-    double sec_to_delay, std::function<void(const uint8_t*, size_t)>& cb_feed_pkt)
+    double sec_to_delay, std::function<void(const uint8_t*, size_t)>& cb_feed_pkt,
+    std::shared_ptr<RecvEngine> recv_engine)
 {
   std::shared_ptr<Input> input;
 
@@ -64,6 +76,13 @@ inline std::shared_ptr<Input> InputFactory::createInput(InputType type, const RS
   {
     case InputType::ONLINE_LIDAR:
       {
+#ifndef _WIN32
+        if (recv_engine)
+          input = std::make_shared<InputSockShared>(param, isJumbo, recv_engine);
+        else if (param.socket_num > 1)
+          input = std::make_shared<InputSockReuse>(param, isJumbo);
+        else
+#endif
         if (isJumbo)
           input = std::make_shared<InputSockJumbo>(param);
         else
@@ -98,6 +117,12 @@ inline std::shared_ptr<Input> InputFactory::createInput(InputType type, const RS
       }
       break;
 
+    case InputType::LOG_FILE:
+      {
+        input = std::make_shared<InputLog>(param, isJumbo);
+      }
+      break;
+
     default:
 
       RS_ERROR << "Wrong Input Type " << type << "." << RS_REND;
@@ -0,0 +1,320 @@
+/*********************************************************************************************************************
+Copyright (c) 2020 RoboSense
+All rights reserved
+
+By downloading, copying, installing or using the software you agree to this license. If you do not agree to this
+license, do not download, install, copy or use the software.
+
+License Agreement
+For RoboSense LiDAR SDK Library
+(3-clause BSD License)
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that the
+following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following
+disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following
+disclaimer in the documentation and/or other materials provided with the distribution.
+
+3. Neither the names of the RoboSense, nor Suteng Innovation Technology, nor the names of other contributors may be used
+to endorse or promote products derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*********************************************************************************************************************/
+
+
+#pragma once
+
+#include <rs_driver/driver/input/input.hpp>
+#include <rs_driver/utility/packet_log.hpp>
+#include <rs_driver/utility/file_list.hpp>
+
+#include <chrono>
+
+namespace robosense
+{
+namespace lidar
+{
+
+//
+// A sequence of log files, played back-to-back as one stream.
+// While a file is played, the next one is opened (and prefetched) in the background.
+//
+class LogSequence
+{
+public:
+  LogSequence()
+    : idx_(0), cur_(0), next_ok_(false)
+  {
+  }
+
+  ~LogSequence()
+  {
+    close();
+  }
+
+  bool open(const std::vector<std::string>& files);
+  void close();
+
+  //
+  // Get the next packet. Switch to the next file at the end of each file. Return false at the end of the last file.
+  //
+  bool next(LogPacket& pkt);
+
+  //
+  // Play from the first file again.
+  //
+  bool rewind();
+
+private:
+  void prefetch(size_t idx);
+  void waitPrefetch();
+
+  std::vector<std::string> files_;
+  size_t idx_;
+  PacketLogReader readers_[2];
+  int cur_;
+  bool next_ok_;
+  std::thread prefetch_thread_;
+};
+
+inline bool LogSequence::open(const std::vector<std::string>& files)
+{
+  close();
+
+  files_ = files;
+  return rewind();
+}
+
+inline void LogSequence::close()
+{
+  waitPrefetch();
+  readers_[0].close();
+  readers_[1].close();
+}
+
+inline bool LogSequence::rewind()
+{
+  if (files_.empty())
+  {
+    return false;
+  }
+
+  waitPrefetch();
+
+  idx_ = 0;
+  if (files_.size() == 1)
+  {
+    // single file. no need to reopen it.
+    if (readers_[cur_].isOpen())
+    {
+      readers_[cur_].rewind();
+      return true;
+    }
+  }
+  else
+  {
+    readers_[1 - cur_].close();
+  }
+
+  if (!readers_[cur_].open(files_[0]))
+  {
+    return false;
+  }
+
+  prefetch(1);
+  return true;
+}
+
+inline void LogSequence::prefetch(size_t idx)
+{
+  if (idx >= files_.size())
+  {
+    return;
+  }
+
+  prefetch_thread_ = std::thread([this, idx]() {
+    PacketLogReader& reader = readers_[1 - cur_];
+    next_ok_ = reader.open(files_[idx]);
+    if (next_ok_)
+    {
+      prefetchFile(reader.file());
+    }
+  });
+}
+
+inline void LogSequence::waitPrefetch()
+{
+  if (prefetch_thread_.joinable())
+  {
+    prefetch_thread_.join();
+  }
+}
+
+inline bool LogSequence::next(LogPacket& pkt)
+{
+  while (1)
+  {
+    if (readers_[cur_].isOpen() && readers_[cur_].next(pkt))
+    {
+      return true;
+    }
+
+    if (idx_ + 1 >= files_.size())
+    {
+      return false;
+    }
+
+    // switch to the next file.
+    waitPrefetch();
+
+    readers_[cur_].close();
+    cur_ = 1 - cur_;
+    idx_++;
+
+    if (!next_ok_)
+    {
+      RS_WARNING << "Fail to open log file: " << files_[idx_] << ". Skip it." << RS_REND;
+    }
+
+    prefetch(idx_ + 1);
+  }
+}
+
+//
+// Replay rs_driver log files (.rslog), paced by the recorded timestamps.
+//
+class InputLog : public Input
+{
+public:
+  InputLog(const RSInputParam& input_param, bool isJumbo)
+    : Input(input_param), pkt_buf_len_(isJumbo ? IP_LEN : ETH_LEN), pkt_ts_(0)
+  {
+  }
+
+  virtual bool init();
+  virtual bool start();
+  virtual bool readPacket();
+  virtual ~InputLog();
+
+private:
+  void recvPacket();
+
+  LogSequence log_seq_;
+  size_t pkt_buf_len_;
+  uint64_t pkt_ts_; // timestamp of the last packet read
+};
+
+inline bool InputLog::init()
+{
+  if (init_flag_)
+    return true;
+
+  if (!log_seq_.open(expandFilePaths(input_param_.pcap_path)))
+  {
+    cb_excep_(Error(ERRCODE_PCAPWRONGPATH));
+    return false;
+  }
+
+  init_flag_ = true;
+  return true;
+}
+
+inline bool InputLog::start()
+{
+  if (start_flag_)
+    return true;
+
+  if (!init_flag_)
+  {
+    cb_excep_(Error(ERRCODE_STARTBEFOREINIT));
+    return false;
+  }
+
+  to_exit_recv_ = false;
+  recv_thread_ = std::thread(std::bind(&InputLog::recvPacket, this));
+
+  start_flag_ = true;
+  return true;
+}
+
+inline InputLog::~InputLog()
+{
+  stop();
+  log_seq_.close();
+}
+
+inline bool InputLog::readPacket()
+{
+  LogPacket log_pkt;
+  if (!log_seq_.next(log_pkt))  // reach end of the last file.
+  {
+    return false;
+  }
+
+  std::shared_ptr<Buffer> pkt = cb_get_pkt_(pkt_buf_len_);
+  size_t size = std::min(log_pkt.size, pkt->bufSize());
+  memcpy(pkt->data(), log_pkt.data, size);
+  pkt->setData(0, size);
+  pushPacket(pkt);
+
+  pkt_ts_ = log_pkt.ts;
+  return true;
+}
+
+inline void InputLog::recvPacket()
+{
+  beginThread(0);
+
+  float rate = input_param_.pcap_rate;
+  bool first = true;
+  uint64_t first_ts = 0;
+  std::chrono::steady_clock::time_point first_tp;
+
+  while (!to_exit_recv_)
+  {
+    if (!readPacket())  // reach end of the last file.
+    {
+      if (input_param_.pcap_repeat && log_seq_.rewind())
+      {
+        cb_excep_(Error(ERRCODE_PCAPREPEAT));
+
+        first = true;
+        continue;
+      }
+      else
+      {
+        cb_excep_(Error(ERRCODE_PCAPEXIT));
+        break;
+      }
+    }
+
+    // pace by the recorded timestamps. pcap_rate <= 0: as fast as possible.
+    if (rate <= 0)
+    {
+      continue;
+    }
+    else if (first)
+    {
+      first_ts = pkt_ts_;
+      first_tp = std::chrono::steady_clock::now();
+      first = false;
+    }
+    else if (pkt_ts_ > first_ts)
+    {
+      std::this_thread::sleep_until(first_tp + 
+          std::chrono::microseconds((uint64_t)((pkt_ts_ - first_ts) / rate)));
+    }
+  }
+}
+
+}  // namespace lidar
+}  // namespace robosense
@@ -32,6 +32,7 @@ THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 #pragma once
 #include <rs_driver/driver/input/input.hpp>
+#include <rs_driver/utility/file_list.hpp>
 
 #include <sstream>
 
@@ -42,16 +43,223 @@ THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 #include <pcap.h>
 
+// DecompressStream depends on fopencookie() of glibc
+#if (defined(ENABLE_ZLIB) || defined(ENABLE_ZSTD)) && defined(__linux__)
+#define ENABLE_PCAP_UNZIP
+#include <rs_driver/utility/decompress_stream.hpp>
+#endif
+
 namespace robosense
 {
 namespace lidar
 {
+
+#ifdef ENABLE_PCAP_UNZIP
+typedef DecompressStream PcapUnzip;
+#else
+struct PcapUnzip {};
+#endif
+
+//
+// Open a PCAP file. If it is compressed (.gz/.zst), decompress it in the background with unzip.
+//
+inline pcap_t* openPcapFile(const std::string& path, PcapUnzip& unzip, char* errbuf)
+{
+#ifdef ENABLE_PCAP_UNZIP
+  if (DecompressStream::getFormat(path) != DecompressStream::FORMAT_NONE)
+  {
+    FILE* fp = unzip.open(path);
+    if (fp == NULL)
+    {
+      return NULL;
+    }
+
+    pcap_t* pcap = pcap_fopen_offline(fp, errbuf);
+    if (pcap == NULL)
+    {
+      fclose(fp);
+    }
+
+    return pcap;
+  }
+#endif
+
+  return pcap_open_offline(path.c_str(), errbuf);
+}
+
+//
+// A sequence of PCAP files, played back-to-back as one stream. 
+// While a file is played, the next one is opened (and prefetched) in the background.
+//
+class PcapSequence
+{
+public:
+  PcapSequence()
+    : idx_(0), pcap_(NULL), cur_unzip_(0), next_pcap_(NULL)
+  {
+  }
+
+  ~PcapSequence()
+  {
+    close();
+  }
+
+  bool open(const std::vector<std::string>& files);
+  void close();
+
+  //
+  // The first file, to compile filters with.
+  //
+  pcap_t* pcap() const
+  {
+    return pcap_;
+  }
+
+  //
+  // Like pcap_next_ex(). Switch to the next file at the end of each file. Return < 0 at the end of the last file.
+  //
+  int next(struct pcap_pkthdr** header, const u_char** pkt_data);
+
+  //
+  // Play from the first file again.
+  //
+  bool rewind();
+
+private:
+  bool openFile(size_t idx);
+  void prefetch(size_t idx);
+  void waitPrefetch();
+
+  std::vector<std::string> files_;
+  size_t idx_;
+  pcap_t* pcap_;
+  PcapUnzip unzip_[2];
+  int cur_unzip_;
+  pcap_t* next_pcap_;
+  std::thread prefetch_thread_;
+};
+
+inline bool PcapSequence::open(const std::vector<std::string>& files)
+{
+  close();
+
+  files_ = files;
+  if (files_.empty() || !openFile(0))
+  {
+    return false;
+  }
+
+  prefetch(1);
+  return true;
+}
+
+inline void PcapSequence::close()
+{
+  waitPrefetch();
+
+  if (next_pcap_ != NULL)
+  {
+    pcap_close(next_pcap_);
+    next_pcap_ = NULL;
+  }
+
+  if (pcap_ != NULL)
+  {
+    pcap_close(pcap_);
+    pcap_ = NULL;
+  }
+}
+
+inline bool PcapSequence::openFile(size_t idx)
+{
+  char errbuf[PCAP_ERRBUF_SIZE];
+  pcap_ = openPcapFile(files_[idx], unzip_[cur_unzip_], errbuf);
+  if (pcap_ == NULL)
+  {
+    RS_ERROR << "Fail to open pcap file: " << files_[idx] << RS_REND;
+    return false;
+  }
+
+  idx_ = idx;
+  return true;
+}
+
+inline void PcapSequence::prefetch(size_t idx)
+{
+  if (idx >= files_.size())
+  {
+    return;
+  }
+
+  prefetch_thread_ = std::thread([this, idx]() {
+    char errbuf[PCAP_ERRBUF_SIZE];
+    next_pcap_ = openPcapFile(files_[idx], unzip_[1 - cur_unzip_], errbuf);
+    if (next_pcap_ != NULL)
+    {
+      prefetchFile(pcap_file(next_pcap_));
+    }
+  });
+}
+
+inline void PcapSequence::waitPrefetch()
+{
+  if (prefetch_thread_.joinable())
+  {
+    prefetch_thread_.join();
+  }
+}
+
+inline int PcapSequence::next(struct pcap_pkthdr** header, const u_char** pkt_data)
+{
+  while (1)
+  {
+    int ret = (pcap_ != NULL) ? pcap_next_ex(pcap_, header, pkt_data) : -2;
+    if ((ret >= 0) || (idx_ + 1 >= files_.size()))
+    {
+      return ret;
+    }
+
+    // switch to the next file.
+    waitPrefetch();
+
+    if (pcap_ != NULL)
+    {
+      pcap_close(pcap_);
+    }
+
+    idx_++;
+    pcap_ = next_pcap_;
+    next_pcap_ = NULL;
+    cur_unzip_ = 1 - cur_unzip_;
+
+    if (pcap_ == NULL)
+    {
+      RS_WARNING << "Fail to open pcap file: " << files_[idx_] << ". Skip it." << RS_REND;
+    }
+
+    prefetch(idx_ + 1);
+  }
+}
+
+inline bool PcapSequence::rewind()
+{
+  close();
+
+  if (files_.empty() || !openFile(0))
+  {
+    return false;
+  }
+
+  prefetch(1);
+  return true;
+}
+
 class InputPcap : public Input
 {
 public:
   InputPcap(const RSInputParam& input_param, double sec_to_delay)
-    : Input(input_param), pcap_(NULL), pcap_offset_(ETH_HDR_LEN), pcap_tail_(0), difop_filter_valid_(false), 
-    msec_to_delay_((uint64_t)(sec_to_delay / input_param.pcap_rate * 1000000))
+    : Input(input_param), pcap_offset_(ETH_HDR_LEN), pcap_tail_(0), difop_filter_valid_(false), 
+    msec_to_delay_((input_param.pcap_rate > 0) ? (uint64_t)(sec_to_delay / input_param.pcap_rate * 1000000) : 0)
   {
     if (input_param.use_vlan)
     {
@@ -77,13 +285,14 @@ public:
 
   virtual bool init();
   virtual bool start();
+  virtual bool readPacket();
   virtual ~InputPcap();
 
 private:
   void recvPacket();
 
 private:
-  pcap_t* pcap_;
+  PcapSequence pcap_seq_;
   size_t pcap_offset_;
   size_t pcap_tail_;
   std::string msop_filter_str_;
@@ -99,19 +308,17 @@ inline bool InputPcap::init()
   if (init_flag_)
     return true;
 
-  char errbuf[PCAP_ERRBUF_SIZE];
-  pcap_ = pcap_open_offline(input_param_.pcap_path.c_str(), errbuf);
-  if (pcap_ == NULL)
+  if (!pcap_seq_.open(expandFilePaths(input_param_.pcap_path)))
   {
     cb_excep_(Error(ERRCODE_PCAPWRONGPATH));
     return false;
   }
 
-  pcap_compile(pcap_, &msop_filter_, msop_filter_str_.c_str(), 1, 0xFFFFFFFF);
+  pcap_compile(pcap_seq_.pcap(), &msop_filter_, msop_filter_str_.c_str(), 1, 0xFFFFFFFF);
 
   if ((input_param_.difop_port != 0) && (input_param_.difop_port != input_param_.msop_port))
   {
-    pcap_compile(pcap_, &difop_filter_, difop_filter_str_.c_str(), 1, 0xFFFFFFFF);
+    pcap_compile(pcap_seq_.pcap(), &difop_filter_, difop_filter_str_.c_str(), 1, 0xFFFFFFFF);
     difop_filter_valid_ = true;
   }
 
@@ -140,32 +347,44 @@ inline bool InputPcap::start()
 inline InputPcap::~InputPcap()
 {
   stop();
+  pcap_seq_.close();
+}
 
-  if (pcap_ != NULL)
+inline bool InputPcap::readPacket()
+{
+  while (1)
   {
-    pcap_close(pcap_);
-    pcap_ = NULL;
+    struct pcap_pkthdr* header;
+    const u_char* pkt_data;
+    int ret = pcap_seq_.next(&header, &pkt_data);
+    if (ret < 0)  // reach end of the last file.
+    {
+      return false;
+    }
+
+    if ((pcap_offline_filter(&msop_filter_, header, pkt_data) != 0) || 
+        (difop_filter_valid_ && (pcap_offline_filter(&difop_filter_, header, pkt_data) != 0)))
+    {
+      std::shared_ptr<Buffer> pkt = cb_get_pkt_(ETH_LEN);
+      memcpy(pkt->data(), pkt_data + pcap_offset_, header->len - pcap_offset_ - pcap_tail_);
+      pkt->setData(0, header->len - pcap_offset_ - pcap_tail_);
+      pushPacket(pkt);
+      return true;
+    }
   }
 }
 
 inline void InputPcap::recvPacket()
 {
+  beginThread(0);
+
   while (!to_exit_recv_)
   {
-    struct pcap_pkthdr* header;
-    const u_char* pkt_data;
-    int ret = pcap_next_ex(pcap_, &header, &pkt_data);
-    if (ret < 0)  // reach file end.
+    if (!readPacket())  // reach end of the last file.
     {
-      pcap_close(pcap_);
-      pcap_ = NULL;
-
-      if (input_param_.pcap_repeat)
+      if (input_param_.pcap_repeat && pcap_seq_.rewind())
       {
         cb_excep_(Error(ERRCODE_PCAPREPEAT));
-
-        char errbuf[PCAP_ERRBUF_SIZE];
-        pcap_ = pcap_open_offline(input_param_.pcap_path.c_str(), errbuf);
         continue;
       }
       else
@@ -175,26 +394,11 @@ inline void InputPcap::recvPacket()
       }
     }
 
-    if (pcap_offline_filter(&msop_filter_, header, pkt_data) != 0)
-    {
-      std::shared_ptr<Buffer> pkt = cb_get_pkt_(ETH_LEN);
-      memcpy(pkt->data(), pkt_data + pcap_offset_, header->len - pcap_offset_ - pcap_tail_);
-      pkt->setData(0, header->len - pcap_offset_ - pcap_tail_);
-      pushPacket(pkt);
-    }
-    else if (difop_filter_valid_ && (pcap_offline_filter(&difop_filter_, header, pkt_data) != 0))
+    // pcap_rate <= 0: as fast as possible.
+    if (msec_to_delay_ > 0)
     {
-      std::shared_ptr<Buffer> pkt = cb_get_pkt_(ETH_LEN);
-      memcpy(pkt->data(), pkt_data + pcap_offset_, header->len - pcap_offset_ - pcap_tail_);
-      pkt->setData(0, header->len - pcap_offset_ - pcap_tail_);
-      pushPacket(pkt);
-    }
-    else
-    {
-      continue;
+      std::this_thread::sleep_for(std::chrono::microseconds(msec_to_delay_));
     }
-
-    std::this_thread::sleep_for(std::chrono::microseconds(msec_to_delay_));
   }
 }
 
@@ -31,18 +31,9 @@ THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 *********************************************************************************************************************/
 
 #pragma once
-#include <rs_driver/driver/input/input.hpp>
+#include <rs_driver/driver/input/input_pcap.hpp>
 #include <rs_driver/driver/input/jumbo.hpp>
 
-#include <sstream>
-
-#ifdef _WIN32
-#define WIN32
-#else //__linux__
-#endif
-
-#include <pcap.h>
-
 namespace robosense
 {
 namespace lidar
@@ -51,8 +42,8 @@ class InputPcapJumbo : public Input
 {
 public:
   InputPcapJumbo(const RSInputParam& input_param, double sec_to_delay)
-    : Input(input_param), pcap_(NULL), pcap_offset_(ETH_HDR_LEN), pcap_tail_(0), difop_filter_valid_(false), 
-    msec_to_delay_((uint64_t)(sec_to_delay / input_param.pcap_rate * 1000000))
+    : Input(input_param), pcap_offset_(ETH_HDR_LEN), pcap_tail_(0), difop_filter_valid_(false), 
+    msec_to_delay_((input_param.pcap_rate > 0) ? (uint64_t)(sec_to_delay / input_param.pcap_rate * 1000000) : 0)
   {
     if (input_param.use_vlan)
     {
@@ -75,13 +66,14 @@ public:
 
   virtual bool init();
   virtual bool start();
+  virtual bool readPacket();
   virtual ~InputPcapJumbo();
 
 private:
   void recvPacket();
 
 private:
-  pcap_t* pcap_;
+  PcapSequence pcap_seq_;
   size_t pcap_offset_;
   size_t pcap_tail_;
   std::string msop_filter_str_;
@@ -98,15 +90,13 @@ inline bool InputPcapJumbo::init()
   if (init_flag_)
     return true;
 
-  char errbuf[PCAP_ERRBUF_SIZE];
-  pcap_ = pcap_open_offline(input_param_.pcap_path.c_str(), errbuf);
-  if (pcap_ == NULL)
+  if (!pcap_seq_.open(expandFilePaths(input_param_.pcap_path)))
   {
     cb_excep_(Error(ERRCODE_PCAPWRONGPATH));
     return false;
   }
 
-  pcap_compile(pcap_, &msop_filter_, msop_filter_str_.c_str(), 1, 0xFFFFFFFF);
+  pcap_compile(pcap_seq_.pcap(), &msop_filter_, msop_filter_str_.c_str(), 1, 0xFFFFFFFF);
 
   init_flag_ = true;
   return true;
@@ -133,32 +123,57 @@ inline bool InputPcapJumbo::start()
 inline InputPcapJumbo::~InputPcapJumbo()
 {
   stop();
+  pcap_seq_.close();
+}
 
-  if (pcap_ != NULL)
+inline bool InputPcapJumbo::readPacket()
+{
+  while (1)
   {
-    pcap_close(pcap_);
-    pcap_ = NULL;
+    struct pcap_pkthdr* header;
+    const uint8_t* pkt_data;
+    int ret = pcap_seq_.next(&header, &pkt_data);
+    if (ret < 0)  // reach end of the last file.
+    {
+      return false;
+    }
+
+    if (pcap_offline_filter(&msop_filter_, header, pkt_data) == 0)
+    {
+      continue;
+    }
+
+    uint16_t udp_port = 0;
+    const uint8_t* udp_data = NULL;
+    size_t udp_data_len = 0;
+    bool new_pkt = jumbo_.new_fragment(pkt_data, header->len, &udp_port, &udp_data, &udp_data_len);
+    if (new_pkt)
+    {
+      if ((udp_port == input_param_.msop_port) || (udp_port == input_param_.difop_port))
+      {
+        std::shared_ptr<Buffer> pkt = cb_get_pkt_(IP_LEN);
+        memcpy(pkt->data(), udp_data, udp_data_len);
+        pkt->setData(0, udp_data_len);
+        pushPacket(pkt);
+      }
+    }
+
+    // return for every fragment, to keep the pacing of recvPacket().
+    return true;
   }
 }
 
 inline void InputPcapJumbo::recvPacket()
 {
+  beginThread(0);
+
   while (!to_exit_recv_)
   {
-    struct pcap_pkthdr* header;
-    const uint8_t* pkt_data;
-    int ret = pcap_next_ex(pcap_, &header, &pkt_data);
-    if (ret < 0)  // reach file end.
+    if (!readPacket())  // reach end of the last file.
     {
-      pcap_close(pcap_);
-      pcap_ = NULL;
-
-      if (input_param_.pcap_repeat)
+      if (input_param_.pcap_repeat && pcap_seq_.rewind())
       {
         cb_excep_(Error(ERRCODE_PCAPREPEAT));
-
-        char errbuf[PCAP_ERRBUF_SIZE];
-        pcap_ = pcap_open_offline(input_param_.pcap_path.c_str(), errbuf);
         continue;
       }
       else
@@ -168,29 +183,11 @@ inline void InputPcapJumbo::recvPacket()
       }
     }
 
-    if (pcap_offline_filter(&msop_filter_, header, pkt_data) != 0)
+    // pcap_rate <= 0: as fast as possible.
+    if (msec_to_delay_ > 0)
     {
-      uint16_t udp_port = 0;
-      const uint8_t* udp_data = NULL;
-      size_t udp_data_len = 0;
-      bool new_pkt = jumbo_.new_fragment(pkt_data, header->len, &udp_port, &udp_data, &udp_data_len);
-      if (new_pkt)
-      {
-        if ((udp_port == input_param_.msop_port) || (udp_port == input_param_.difop_port))
-        {
-          std::shared_ptr<Buffer> pkt = cb_get_pkt_(IP_LEN);
-          memcpy(pkt->data(), udp_data, udp_data_len);
-          pkt->setData(0, udp_data_len);
-          pushPacket(pkt);
-        }
-      }
+      std::this_thread::sleep_for(std::chrono::microseconds(msec_to_delay_));
     }
-    else
-    {
-      continue;
-    }
-
-    std::this_thread::sleep_for(std::chrono::microseconds(msec_to_delay_));
   }
 }
 
@@ -0,0 +1,605 @@
+/*********************************************************************************************************************
+Copyright (c) 2020 RoboSense
+All rights reserved
+
+By downloading, copying, installing or using the software you agree to this license. If you do not agree to this
+license, do not download, install, copy or use the software.
+
+License Agreement
+For RoboSense LiDAR SDK Library
+(3-clause BSD License)
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that the
+following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following
+disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following
+disclaimer in the documentation and/or other materials provided with the distribution.
+
+3. Neither the names of the RoboSense, nor Suteng Innovation Technology, nor the names of other contributors may be used
+to endorse or promote products derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*********************************************************************************************************************/
+
+#pragma once
+
+#include <rs_driver/driver/input/input.hpp>
+#include <rs_driver/driver/input/unix/udp_socket.hpp>
+
+#include <poll.h>
+#include <pthread.h>
+#include <time.h>
+#include <sys/eventfd.h>
+
+#include <vector>
+#include <deque>
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+
+namespace robosense
+{
+namespace lidar
+{
+
+//
+// Receive MSOP packets on several SO_REUSEPORT sockets of the same port, each by its own thread.
+// The packets are spread among the sockets (even those of a single Lidar), so they are merged back 
+// in the order of their receive time. The receiving threads merge them themselves, one at a time, 
+// so the packets are pushed in order. The threads sleep in poll() until packets come, or until a held packet 
+// may be released.
+//
+class InputSockReuse : public Input
+{
+public:
+  InputSockReuse(const RSInputParam& input_param, bool isJumbo)
+    : Input(input_param), pkt_buf_len_(isJumbo ? IP_LEN : ETH_LEN), 
+      sock_offset_(input_param.user_layer_bytes), sock_tail_(input_param.tail_layer_bytes),
+      lidar_ip_(htonl(INADDR_ANY)), 
+      slack_ns_((uint64_t)input_param.merge_slack_us * 1000), difop_fd_(-1), stop_fd_(-1), msop_recv_(0), 
+      merging_(false)
+  {
+  }
+
+  virtual bool init();
+  virtual bool start();
+  virtual void stop();
+  virtual ~InputSockReuse();
+
+#ifndef UNIT_TEST
+private:
+#endif
+
+  struct RecvPacket
+  {
+    uint64_t ts;         // receive time by the kernel, in nanoseconds
+    uint64_t queued_ns;  // when it's queued, by steady clock
+    std::shared_ptr<Buffer> pkt;
+  };
+
+  struct SockQueue
+  {
+    std::deque<RecvPacket> pkts;
+    uint64_t watermark = 0;  // packets received before it are all in pkts, or merged
+    uint64_t recv_num = 0;
+  };
+
+  // a packet waits at most so long for the other sockets, e.g. if a receiving thread is stalled.
+  constexpr static uint64_t MERGE_WAIT_NS = 10000000;
+
+  void recvPacket(size_t idx);
+  void readSocket(size_t idx, int fd, bool is_msop);
+  int64_t mergePacket();
+  int64_t holdNs(const RecvPacket& head);
+
+  size_t pkt_buf_len_;
+  size_t sock_offset_;
+  size_t sock_tail_;
+  uint32_t lidar_ip_;
+  uint64_t slack_ns_; // time from the kernel stamping a packet, to queuing it into the socket
+  std::vector<int> msop_fds_;
+  int difop_fd_;
+  int stop_fd_; // eventfd, to wake the receiving threads to exit
+  std::vector<std::thread> recv_threads_;
+  std::atomic<uint64_t> msop_recv_;
+
+  std::vector<SockQueue> queues_;  // one for each msop socket
+  std::vector<std::atomic<bool>> reading_; // the packets read from the socket, are not queued yet
+  std::mutex queue_mtx_;
+  bool merging_; // a thread is merging. Only it pushes packets.
+};
+
+inline bool sockReadable(int fd)
+{
+  struct pollfd pfd;
+  pfd.fd = fd;
+  pfd.events = POLLIN;
+  return (poll(&pfd, 1, 0) > 0) && (pfd.revents & POLLIN);
+}
+
+// same clock as the receive time of the kernel (SO_TIMESTAMPNS)
+inline uint64_t reuseRealtimeNs()
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_REALTIME, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000 + (uint64_t)ts.tv_nsec;
+}
+
+inline bool InputSockReuse::init()
+{
+  if (init_flag_)
+  {
+    return true;
+  }
+
+  if (!parseLidarAddress(input_param_.lidar_address, lidar_ip_))
+  {
+    RS_ERROR << "Wrong lidar_address " << input_param_.lidar_address << "." << RS_REND;
+    return false;
+  }
+
+  uint16_t sock_num = (input_param_.socket_num > 0) ? input_param_.socket_num : 1;
+
+  //
+  // msop
+  //
+
+  // the SO_REUSEPORT group is of this input only. Otherwise the kernel steers its packets to others.
+  if (!isUdpPortFree(input_param_.msop_port, input_param_.host_address, input_param_.group_address))
+  {
+    RS_ERROR << "Port " << input_param_.msop_port << " is used by others. It can't be shared with socket_num > 1." 
+      << RS_REND;
+    cb_excep_(Error(ERRCODE_MSOPPORTBUZY));
+    return false;
+  }
+
+  for (uint16_t i = 0; i < sock_num; i++)
+  {
+    int fd = createUdpSocket(input_param_.msop_port, input_param_.host_address, input_param_.group_address, true);
+    if (fd < 0)
+    {
+      cb_excep_(Error(ERRCODE_MSOPPORTBUZY));
+      goto failMsop;
+    }
+
+#ifdef SO_TIMESTAMPNS
+    {
+      int on = 1;
+      setsockopt(fd, SOL_SOCKET, SO_TIMESTAMPNS, &on, sizeof(on));
+    }
+#endif
+
+    msop_fds_.push_back(fd);
+  }
+
+  if (!steerReusePort(msop_fds_[0], sock_num, input_param_.steer_by_cpu))
+  {
+    RS_WARNING << "Fail to steer packets. Use the default hash of flows." << RS_REND;
+  }
+
+  //
+  // difop
+  //
+  if ((input_param_.difop_port != 0) && (input_param_.difop_port != input_param_.msop_port))
+  {
+    difop_fd_ = createUdpSocket(input_param_.difop_port, input_param_.host_address, input_param_.group_address);
+    if (difop_fd_ < 0)
+    {
+      cb_excep_(Error(ERRCODE_DIFOPPORTBUZY));
+      goto failMsop;
+    }
+  }
+
+  stop_fd_ = eventfd(0, EFD_NONBLOCK);
+  if (stop_fd_ < 0)
+  {
+    perror("eventfd: ");
+    goto failStop;
+  }
+
+  queues_.resize(sock_num);
+  reading_ = std::vector<std::atomic<bool>>(sock_num);
+
+  init_flag_ = true;
+  return true;
+
+failStop:
+  if (difop_fd_ >= 0)
+  {
+    close(difop_fd_);
+    difop_fd_ = -1;
+  }
+failMsop:
+  for (auto fd : msop_fds_)
+  {
+    close(fd);
+  }
+  msop_fds_.clear();
+  return false;
+}
+
+inline bool InputSockReuse::start()
+{
+  if (start_flag_)
+  {
+    return true;
+  }
+
+  if (!init_flag_)
+  {
+    cb_excep_(Error(ERRCODE_STARTBEFOREINIT));
+    return false;
+  }
+
+  // clear the wakeup of the last stop().
+  uint64_t val;
+  if (read(stop_fd_, &val, sizeof(val)) < 0) 
+  {
+  }
+
+  to_exit_recv_ = false;
+  for (size_t i = 0; i < msop_fds_.size(); i++)
+  {
+    recv_threads_.emplace_back(std::bind(&InputSockReuse::recvPacket, this, i));
+  }
+
+  start_flag_ = true;
+  return true;
+}
+
+inline void InputSockReuse::stop()
+{
+  if (start_flag_)
+  {
+    to_exit_recv_ = true;
+
+    // wake up all threads. The counter stays non-zero until the next start().
+    uint64_t val = 1;
+    if (write(stop_fd_, &val, sizeof(val)) < 0)
+    {
+      perror("write: ");
+    }
+
+    for (auto& t : recv_threads_)
+    {
+      t.join();
+    }
+    recv_threads_.clear();
+
+    for (auto& queue : queues_)
+    {
+      queue.pkts.clear();
+      queue.watermark = 0;
+    }
+
+    start_flag_ = false;
+  }
+}
+
+inline InputSockReuse::~InputSockReuse()
+{
+  stop();
+
+  for (auto fd : msop_fds_)
+  {
+    close(fd);
+  }
+
+  if (difop_fd_ >= 0)
+  {
+    close(difop_fd_);
+  }
+
+  if (stop_fd_ >= 0)
+  {
+    close(stop_fd_);
+  }
+}
+
+inline void InputSockReuse::recvPacket(size_t idx)
+{
+  beginThread(idx);
+
+#ifdef __linux__
+  if (input_param_.steer_by_cpu)
+  {
+    // socket idx gets the packets received by CPU idx (and idx + socket_num, ...).
+    cpu_set_t cpus;
+    CPU_ZERO(&cpus);
+    for (size_t cpu = idx; cpu < CPU_SETSIZE; cpu += msop_fds_.size())
+    {
+      CPU_SET(cpu, &cpus);
+    }
+    pthread_setaffinity_np(pthread_self(), sizeof(cpus), &cpus);
+  }
+#endif
+
+  struct pollfd pfds[3];
+  nfds_t pfd_num = 2;
+  pfds[0].fd = msop_fds_[idx];
+  pfds[0].events = POLLIN;
+  pfds[1].fd = stop_fd_;
+  pfds[1].events = POLLIN;
+
+  // the first thread also receives difop packets, and reports timeout.
+  if ((idx == 0) && (difop_fd_ >= 0))
+  {
+    pfds[2].fd = difop_fd_;
+    pfds[2].events = POLLIN;
+    pfd_num = 3;
+  }
+
+  const int64_t TIMEOUT_NS = 1000000000;
+  int64_t hold_ns = -1; // until the held packets may be released. -1: none held by this thread
+  uint64_t last_msop_recv = 0;
+  auto last_msop_time = std::chrono::steady_clock::now();
+
+  // exit only if woken up by stop_fd_.
+  while (1)
+  {
+    int64_t wait_ns = hold_ns;
+    if (idx == 0)
+    {
+      wait_ns = ((wait_ns < 0) || (wait_ns > TIMEOUT_NS)) ? TIMEOUT_NS : wait_ns;
+    }
+
+    struct timespec tm;
+    tm.tv_sec = wait_ns / 1000000000;
+    tm.tv_nsec = wait_ns % 1000000000;
+
+    int retval = ppoll(pfds, pfd_num, (wait_ns >= 0) ? &tm : NULL, NULL);
+    if (retval < 0)
+    {
+      if (errno == EINTR)
+        continue;
+
+      perror("ppoll: ");
+      break;
+    }
+
+    if (pfds[1].revents & POLLIN)
+    {
+      break;
+    }
+
+    for (nfds_t i = 0; i < pfd_num; i++)
+    {
+      if ((i != 1) && (pfds[i].revents & POLLIN))
+      {
+        readSocket(idx, pfds[i].fd, (i == 0));
+      }
+    }
+
+    hold_ns = mergePacket();
+
+    if (idx == 0)
+    {
+      auto now = std::chrono::steady_clock::now();
+      uint64_t msop_recv = msop_recv_;
+      if (msop_recv != last_msop_recv)
+      {
+        last_msop_recv = msop_recv;
+        last_msop_time = now;
+      }
+      else if (now - last_msop_time >= std::chrono::seconds(1))
+      {
+        cb_excep_(Error(ERRCODE_MSOPTIMEOUT));
+        last_msop_time = now;
+      }
+    }
+  }
+}
+
+inline void InputSockReuse::readSocket(size_t idx, int fd, bool is_msop)
+{
+  constexpr static int BATCH_NUM = 16;
+
+  RS_TRACE_SCOPE("recv");
+
+  RecvPacket batch[BATCH_NUM];
+  int batch_num = 0;
+  uint64_t watermark = 0;
+
+  // cleared when they are queued. Till then, the merging thread waits for them.
+  reading_[idx] = true;
+
+  // drain a few packets each time, to save the round trips to poll().
+  for (int i = 0; i < BATCH_NUM; i++)
+  {
+    std::shared_ptr<Buffer> pkt = cb_get_pkt_(pkt_buf_len_);
+
+    struct sockaddr_in addr;
+    struct iovec iov;
+    iov.iov_base = pkt->buf();
+    iov.iov_len = pkt->bufSize();
+
+    char ctrl[64];
+    struct msghdr msg;
+    memset(&msg, 0, sizeof(msg));
+    msg.msg_name = &addr;
+    msg.msg_namelen = sizeof(addr);
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = ctrl;
+    msg.msg_controllen = sizeof(ctrl);
+
+    uint64_t recv_ts = reuseRealtimeNs();
+    ssize_t ret = recvmsg(fd, &msg, MSG_DONTWAIT);
+    if (ret <= 0)
+    {
+      if ((ret < 0) && (errno != EAGAIN) && (errno != EWOULDBLOCK))
+      {
+        perror("recvmsg: ");
+      }
+      else if (is_msop)
+      {
+        // the socket is empty, so the packets received before recv_ts are all read.
+        watermark = recv_ts - slack_ns_;
+      }
+
+      pushPacket(pkt, false);
+      break;
+    }
+
+    if ((lidar_ip_ != htonl(INADDR_ANY)) && (addr.sin_addr.s_addr != lidar_ip_))
+    {
+      pushPacket(pkt, false); // from another Lidar
+      continue;
+    }
+
+#ifdef SO_TIMESTAMPNS
+    for (struct cmsghdr* cmsg = CMSG_FIRSTHDR(&msg); cmsg != NULL; cmsg = CMSG_NXTHDR(&msg, cmsg))
+    {
+      if ((cmsg->cmsg_level == SOL_SOCKET) && (cmsg->cmsg_type == SCM_TIMESTAMPNS))
+      {
+        struct timespec ts;
+        memcpy(&ts, CMSG_DATA(cmsg), sizeof(ts));
+        recv_ts = (uint64_t)ts.tv_sec * 1000000000 + (uint64_t)ts.tv_nsec;
+        break;
+      }
+    }
+#endif
+
+    if (is_msop)
+    {
+      msop_recv_++;
+    }
+
+    pkt->setData(sock_offset_, ret - sock_offset_ - sock_tail_);
+    batch[batch_num].ts = recv_ts;
+    batch[batch_num].pkt = pkt;
+    batch_num++;
+  }
+
+  {
+    std::lock_guard<std::mutex> lg(queue_mtx_);
+    SockQueue& queue = queues_[idx];
+    reading_[idx] = false;
+
+    uint64_t queued_ns = latencyNow();
+    for (int i = 0; i < batch_num; i++)
+    {
+      batch[i].queued_ns = queued_ns;
+      queue.pkts.push_back(batch[i]);
+    }
+
+    queue.recv_num += batch_num;
+    if (watermark > queue.watermark)
+    {
+      queue.watermark = watermark;
+    }
+  }
+}
+
+inline int64_t InputSockReuse::holdNs(const RecvPacket& head)
+{
+  uint64_t queued = latencyNow() - head.queued_ns;
+  if (queued >= MERGE_WAIT_NS)
+  {
+    return 0;
+  }
+
+  //
+  // Released if no earlier packet may come from the other sockets. An idle socket is probed, 
+  // so its packets stamped before (now - slack) are all known.
+  //
+  int64_t hold_ns = 0;
+  uint64_t now = reuseRealtimeNs();
+  for (size_t i = 0; i < queues_.size(); i++)
+  {
+    SockQueue& queue = queues_[i];
+    if (!queue.pkts.empty() || (queue.watermark >= head.ts))
+    {
+      continue;
+    }
+
+    // probe the socket first. A packet read before it, is either queued, or still being read.
+    if (sockReadable(msop_fds_[i]) || reading_[i])
+    {
+      // its thread is reading them, and merges them then. Wait for it at most MERGE_WAIT_NS.
+      hold_ns = std::max(hold_ns, (int64_t)(MERGE_WAIT_NS - queued));
+      continue;
+    }
+
+    queue.watermark = std::max(queue.watermark, now - slack_ns_);
+    if (queue.watermark < head.ts)
+    {
+      hold_ns = std::max(hold_ns, (int64_t)(head.ts - queue.watermark));
+    }
+  }
+
+  return hold_ns;
+}
+
+inline int64_t InputSockReuse::mergePacket()
+{
+  constexpr static size_t BATCH_NUM = 64;
+
+  std::shared_ptr<Buffer> batch[BATCH_NUM];
+
+  std::unique_lock<std::mutex> ul(queue_mtx_);
+  if (merging_)
+  {
+    return -1; // the merging thread sees the packets queued, before it stops merging.
+  }
+
+  merging_ = true;
+  while (1)
+  {
+    int64_t hold_ns = -1;
+    size_t batch_num = 0;
+    while (batch_num < BATCH_NUM)
+    {
+      // the earliest packet of all sockets.
+      SockQueue* first = NULL;
+      for (auto& queue : queues_)
+      {
+        if (!queue.pkts.empty() && ((first == NULL) || (queue.pkts.front().ts < first->pkts.front().ts)))
+        {
+          first = &queue;
+        }
+      }
+
+      if (first == NULL)
+      {
+        break;
+      }
+
+      hold_ns = holdNs(first->pkts.front());
+      if (hold_ns > 0)
+      {
+        break;
+      }
+
+      batch[batch_num++] = first->pkts.front().pkt;
+      first->pkts.pop_front();
+    }
+
+    if (batch_num == 0)
+    {
+      merging_ = false;
+      return hold_ns;
+    }
+
+    // push them out of the lock, in order. The other threads only queue their packets meanwhile.
+    ul.unlock();
+    for (size_t i = 0; i < batch_num; i++)
+    {
+      pushPacket(batch[i]);
+      batch[i].reset();
+    }
+    ul.lock();
+  }
+}
+
+}  // namespace lidar
+}  // namespace robosense
@@ -33,6 +33,7 @@ THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #pragma once
 
 #include <rs_driver/driver/input/input.hpp>
+#include <rs_driver/driver/input/unix/udp_socket.hpp>
 
 #include <unistd.h>
 #include <fcntl.h>
@@ -54,6 +55,7 @@ public:
   {
     sock_offset_ += input_param.user_layer_bytes;
     sock_tail_   += input_param.tail_layer_bytes;
+    lidar_ip_ = htonl(INADDR_ANY);
   }
 
   virtual bool init();
@@ -62,13 +64,13 @@ public:
 
 private:
   inline void recvPacket();
-  inline int createSocket(uint16_t port, const std::string& hostIp, const std::string& grpIp);
 
 protected:
   size_t pkt_buf_len_;
   int fds_[2];
   size_t sock_offset_;
   size_t sock_tail_;
+  uint32_t lidar_ip_;
 };
 
 inline bool InputSock::init()
@@ -78,15 +80,21 @@ inline bool InputSock::init()
     return true;
   }
 
+  if (!parseLidarAddress(input_param_.lidar_address, lidar_ip_))
+  {
+    RS_ERROR << "Wrong lidar_address " << input_param_.lidar_address << "." << RS_REND;
+    return false;
+  }
+
   int msop_fd = -1, difop_fd = -1;
 
-  msop_fd = createSocket(input_param_.msop_port, input_param_.host_address, input_param_.group_address);
+  msop_fd = createUdpSocket(input_param_.msop_port, input_param_.host_address, input_param_.group_address);
   if (msop_fd < 0)
     goto failMsop;
 
   if ((input_param_.difop_port != 0) && (input_param_.difop_port != input_param_.msop_port))
   {
-    difop_fd = createSocket(input_param_.difop_port, input_param_.host_address, input_param_.group_address);
+    difop_fd = createUdpSocket(input_param_.difop_port, input_param_.host_address, input_param_.group_address);
     if (difop_fd < 0)
       goto failDifop;
   }
@@ -132,96 +140,10 @@ inline InputSock::~InputSock()
     close(fds_[1]);
 }
 
-inline int InputSock::createSocket(uint16_t port, const std::string& hostIp, const std::string& grpIp)
-{
-  int fd;
-  int ret;
-  int reuse = 1;
-
-  fd = socket(PF_INET, SOCK_DGRAM, 0);
-  if (fd < 0)
-  {
-    perror("socket: ");
-    goto failSocket;
-  }
-
-  ret = setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
-  if (ret < 0)
-  {
-    perror("setsockopt: ");
-    goto failOption;
-  }
-
-  struct sockaddr_in host_addr;
-  memset(&host_addr, 0, sizeof(host_addr));
-  host_addr.sin_family = AF_INET;
-  host_addr.sin_port = htons(port);
-  host_addr.sin_addr.s_addr = INADDR_ANY;
-  if (hostIp != "0.0.0.0" && grpIp == "0.0.0.0")
-  {
-    inet_pton(AF_INET, hostIp.c_str(), &(host_addr.sin_addr));
-  }
-
-  ret = bind(fd, (struct sockaddr*)&host_addr, sizeof(host_addr));
-  if (ret < 0)
-  {
-    perror("bind: ");
-    goto failBind;
-  }
-
-  if (grpIp != "0.0.0.0")
-  {
-#if 0
-    struct ip_mreqn ipm;
-    memset(&ipm, 0, sizeof(ipm));
-    inet_pton(AF_INET, grpIp.c_str(), &(ipm.imr_multiaddr));
-    inet_pton(AF_INET, hostIp.c_str(), &(ipm.imr_address));
-#else
-    struct ip_mreq ipm;
-    inet_pton(AF_INET, grpIp.c_str(), &(ipm.imr_multiaddr));
-    inet_pton(AF_INET, hostIp.c_str(), &(ipm.imr_interface));
-#endif
-    ret = setsockopt(fd, IPPROTO_IP, IP_ADD_MEMBERSHIP, &ipm, sizeof(ipm));
-    if (ret < 0)
-    {
-      perror("setsockopt: ");
-      goto failGroup;
-    }
-  }
-
-#ifdef ENABLE_DOUBLE_RCVBUF
-  {
-    uint32_t opt_val;
-    socklen_t opt_len = sizeof(uint32_t);
-    getsockopt(fd, SOL_SOCKET, SO_RCVBUF, (char*)&opt_val, &opt_len);
-    opt_val *= 4;
-    setsockopt(fd, SOL_SOCKET, SO_RCVBUF, (char*)&opt_val, opt_len);
-  }
-#endif
-
-  {
-    int flags = fcntl(fd, F_GETFL, 0);
-    ret = fcntl(fd, F_SETFL, flags | O_NONBLOCK);
-    if (ret < 0)
-    {
-      perror("fcntl: ");
-      goto failNonBlock;
-    }
-  }
-
-  return fd;
-
-failNonBlock:
-failGroup:
-failBind:
-failOption:
-  close(fd);
-failSocket:
-  return -1;
-}
-
 inline void InputSock::recvPacket()
 {
+  beginThread(0);
+
   int max_fd = ((fds_[0] > fds_[1]) ? fds_[0] : fds_[1]);
 
   while (!to_exit_recv_)
@@ -250,17 +172,25 @@ inline void InputSock::recvPacket()
       break;
     }
 
+    RS_TRACE_SCOPE("recv");
+
     for (int i = 0; i < 2; i++)
     {
       if ((fds_[i] >= 0) && FD_ISSET(fds_[i], &rfds))
       {
         std::shared_ptr<Buffer> pkt = cb_get_pkt_(pkt_buf_len_);
-        ssize_t ret = recvfrom(fds_[i], pkt->buf(), pkt->bufSize(), 0, NULL, NULL);
+        struct sockaddr_in addr;
+        socklen_t addr_len = sizeof(addr);
+        ssize_t ret = recvfrom(fds_[i], pkt->buf(), pkt->bufSize(), 0, (struct sockaddr*)&addr, &addr_len);
         if (ret < 0)
         {
           perror("recvfrom: ");
           break;
         }
+        else if ((lidar_ip_ != htonl(INADDR_ANY)) && (addr.sin_addr.s_addr != lidar_ip_))
+        {
+          pushPacket(pkt, false); // from another Lidar
+        }
         else if (ret > 0)
         {
           pkt->setData(sock_offset_, ret - sock_offset_ - sock_tail_);
@@ -0,0 +1,214 @@
+/*********************************************************************************************************************
+Copyright (c) 2020 RoboSense
+All rights reserved
+
+By downloading, copying, installing or using the software you agree to this license. If you do not agree to this
+license, do not download, install, copy or use the software.
+
+License Agreement
+For RoboSense LiDAR SDK Library
+(3-clause BSD License)
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that the
+following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following
+disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following
+disclaimer in the documentation and/or other materials provided with the distribution.
+
+3. Neither the names of the RoboSense, nor Suteng Innovation Technology, nor the names of other contributors may be used
+to endorse or promote products derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*********************************************************************************************************************/
+
+
+#pragma once
+
+#include <rs_driver/driver/input/input.hpp>
+#include <rs_driver/driver/input/unix/recv_engine.hpp>
+
+#include <mutex>
+#include <atomic>
+
+namespace robosense
+{
+namespace lidar
+{
+
+//
+// Receive in the loops of a shared RecvEngine, instead of an own thread.
+// The Lidars sending to the same port share a socket, and are told apart by lidar_address.
+//
+class InputSockShared : public Input
+{
+public:
+  InputSockShared(const RSInputParam& input_param, bool isJumbo, std::shared_ptr<RecvEngine> engine)
+    : Input(input_param), engine_(engine), pkt_buf_len_(isJumbo ? IP_LEN : ETH_LEN),
+      sock_offset_(input_param.user_layer_bytes), sock_tail_(input_param.tail_layer_bytes), 
+      has_difop_(false), active_(false), oversize_num_(0)
+  {
+  }
+
+  virtual bool init();
+  virtual bool start();
+  virtual void stop();
+  virtual ~InputSockShared();
+
+  //
+  // Packets larger than the packet buffer, and dropped. 
+  // The shared socket may read a larger packet, if a jumbo Lidar is on the same port.
+  //
+  uint64_t oversizeNum() const
+  {
+    return oversize_num_;
+  }
+
+private:
+  void deliverPacket(const uint8_t* data, size_t size);
+  void onTimeout();
+
+  std::shared_ptr<RecvEngine> engine_;
+  size_t pkt_buf_len_;
+  size_t sock_offset_;
+  size_t sock_tail_;
+  bool has_difop_;
+  bool active_;
+  std::mutex active_mtx_;
+  std::atomic<uint64_t> oversize_num_;
+  ErrorLimiter err_limiter_;
+};
+
+inline bool InputSockShared::init()
+{
+  if (init_flag_)
+  {
+    return true;
+  }
+
+  if (input_param_.socket_num > 1)
+  {
+    RS_WARNING << "socket_num is ignored. The port is received by the threads of LidarDriverManager." << RS_REND;
+  }
+
+  if (!engine_->addSink(input_param_.msop_port, input_param_.host_address, input_param_.group_address, 
+        input_param_.lidar_address, pkt_buf_len_, 
+        std::bind(&InputSockShared::deliverPacket, this, std::placeholders::_1, std::placeholders::_2),
+        std::bind(&InputSockShared::onTimeout, this)))
+  {
+    cb_excep_(Error(ERRCODE_MSOPPORTBUZY));
+    return false;
+  }
+
+  if ((input_param_.difop_port != 0) && (input_param_.difop_port != input_param_.msop_port))
+  {
+    if (!engine_->addSink(input_param_.difop_port, input_param_.host_address, input_param_.group_address, 
+          input_param_.lidar_address, pkt_buf_len_, 
+          std::bind(&InputSockShared::deliverPacket, this, std::placeholders::_1, std::placeholders::_2)))
+    {
+      engine_->removeSink(input_param_.msop_port, input_param_.host_address, input_param_.group_address, 
+          input_param_.lidar_address);
+      cb_excep_(Error(ERRCODE_DIFOPPORTBUZY));
+      return false;
+    }
+
+    has_difop_ = true;
+  }
+
+  init_flag_ = true;
+  return true;
+}
+
+inline bool InputSockShared::start()
+{
+  if (start_flag_)
+  {
+    return true;
+  }
+
+  if (!init_flag_)
+  {
+    cb_excep_(Error(ERRCODE_STARTBEFOREINIT));
+    return false;
+  }
+
+  {
+    std::lock_guard<std::mutex> lg(active_mtx_);
+    active_ = true;
+  }
+
+  start_flag_ = true;
+  return true;
+}
+
+inline void InputSockShared::stop()
+{
+  if (start_flag_)
+  {
+    // no packet is delivered after this.
+    std::lock_guard<std::mutex> lg(active_mtx_);
+    active_ = false;
+    start_flag_ = false;
+  }
+}
+
+inline InputSockShared::~InputSockShared()
+{
+  stop();
+
+  if (init_flag_)
+  {
+    // no callback is running after removeSink().
+    engine_->removeSink(input_param_.msop_port, input_param_.host_address, input_param_.group_address, 
+        input_param_.lidar_address);
+
+    if (has_difop_)
+    {
+      engine_->removeSink(input_param_.difop_port, input_param_.host_address, input_param_.group_address, 
+          input_param_.lidar_address);
+    }
+  }
+}
+
+inline void InputSockShared::deliverPacket(const uint8_t* data, size_t size)
+{
+  std::lock_guard<std::mutex> lg(active_mtx_);
+  if (!active_ || (size <= sock_offset_ + sock_tail_))
+  {
+    return;
+  }
+
+  std::shared_ptr<Buffer> pkt = cb_get_pkt_(pkt_buf_len_);
+  if (size > pkt->bufSize())
+  {
+    // every packet of a jumbo Lidar may be so. Report it once a second at most.
+    oversize_num_++;
+    pushPacket(pkt, false);
+    err_limiter_.call(cb_excep_, ERRCODE_PKTOVERSIZE, 1);
+    return;
+  }
+
+  memcpy(pkt->buf(), data, size);
+  pkt->setData(sock_offset_, size - sock_offset_ - sock_tail_);
+  pushPacket(pkt);
+}
+
+inline void InputSockShared::onTimeout()
+{
+  std::lock_guard<std::mutex> lg(active_mtx_);
+  if (active_)
+  {
+    cb_excep_(Error(ERRCODE_MSOPTIMEOUT));
+  }
+}
+
+}  // namespace lidar
+}  // namespace robosense
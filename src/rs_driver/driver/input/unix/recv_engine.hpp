@@ -0,0 +1,456 @@
+/*********************************************************************************************************************
+Copyright (c) 2020 RoboSense
+All rights reserved
+
+By downloading, copying, installing or using the software you agree to this license. If you do not agree to this
+license, do not download, install, copy or use the software.
+
+License Agreement
+For RoboSense LiDAR SDK Library
+(3-clause BSD License)
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that the
+following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following
+disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following
+disclaimer in the documentation and/or other materials provided with the distribution.
+
+3. Neither the names of the RoboSense, nor Suteng Innovation Technology, nor the names of other contributors may be used
+to endorse or promote products derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*********************************************************************************************************************/
+
+
+#pragma once
+
+#include <rs_driver/common/rs_log.hpp>
+#include <rs_driver/driver/input/unix/sock_demux.hpp>
+#include <rs_driver/utility/trace.hpp>
+
+#include <unistd.h>
+#include <sys/epoll.h>
+
+#include <map>
+#include <string>
+#include <atomic>
+#include <memory>
+#include <vector>
+#include <chrono>
+#include <thread>
+#include <mutex>
+#include <functional>
+#include <cstdio>
+#include <cerrno>
+
+namespace robosense
+{
+namespace lidar
+{
+
+//
+// A few epoll loops, shared by the sockets of many Lidars.
+// Each socket is watched by one loop, and its callback is called in that loop's thread.
+//
+class RecvEngine
+{
+public:
+
+  typedef std::function<void(int fd)> ReadCallback;
+  typedef std::function<void()> TimeoutCallback;
+  typedef std::function<void(size_t)> ThreadCallback;
+
+  RecvEngine()
+    : init_flag_(false), start_flag_(false), next_loop_(0)
+  {
+  }
+
+  ~RecvEngine();
+
+  bool init(uint16_t loop_num);
+
+  //
+  // cb_thread is called first in the thread of each loop, with its index, e.g. to place the thread.
+  //
+  bool start(const ThreadCallback& cb_thread = ThreadCallback());
+  void stop();
+
+  //
+  // Watch the socket. cb_read() is called when it's readable. 
+  // cb_timeout(), if any, is called if nothing is received in 1 second.
+  //
+  bool addSocket(int fd, const ReadCallback& cb_read, const TimeoutCallback& cb_timeout = TimeoutCallback());
+
+  //
+  // Stop watching the socket. After it returns, the callbacks of the socket are not called any more.
+  //
+  void removeSocket(int fd);
+
+  //
+  // Receive the packets sent from lidar_ip to port, on a socket shared by all Lidars sending to the port.
+  // The socket is created for the first sink, and closed with the last one.
+  // If lidar_ip is "0.0.0.0", receive the packets not matched by other sinks.
+  //
+  bool addSink(uint16_t port, const std::string& host_ip, const std::string& group_ip, 
+      const std::string& lidar_ip, size_t buf_len, 
+      const SockDemux::Sink& sink, const TimeoutCallback& cb_timeout = TimeoutCallback());
+  void removeSink(uint16_t port, const std::string& host_ip, const std::string& group_ip,
+      const std::string& lidar_ip);
+
+  size_t loopNum() const
+  {
+    return loops_.size();
+  }
+
+private:
+
+  struct Source
+  {
+    ReadCallback cb_read;
+    TimeoutCallback cb_timeout;
+    std::chrono::steady_clock::time_point last_recv;
+  };
+
+  struct Loop
+  {
+    int epfd;
+    std::thread thread;
+    std::mutex mtx;
+    std::map<int, Source> sources;
+    std::atomic<bool> to_exit;
+  };
+
+  void run(Loop* loop);
+  static std::string portKey(uint16_t port, const std::string& host_ip, const std::string& group_ip);
+
+  std::vector<std::shared_ptr<Loop>> loops_;
+  std::map<int, size_t> fd_loop_;
+  std::mutex mtx_;
+  std::map<std::string, std::shared_ptr<SockDemux>> demuxes_;
+  std::mutex demux_mtx_;
+  bool init_flag_;
+  bool start_flag_;
+  size_t next_loop_;
+};
+
+inline RecvEngine::~RecvEngine()
+{
+  stop();
+
+  for (auto& loop : loops_)
+  {
+    close(loop->epfd);
+  }
+}
+
+inline bool RecvEngine::init(uint16_t loop_num)
+{
+  if (init_flag_)
+  {
+    return true;
+  }
+
+  if (loop_num == 0)
+  {
+    loop_num = 1;
+  }
+
+  for (uint16_t i = 0; i < loop_num; i++)
+  {
+    std::shared_ptr<Loop> loop = std::make_shared<Loop>();
+    loop->epfd = epoll_create(1);
+    if (loop->epfd < 0)
+    {
+      perror("epoll_create: ");
+      goto failEpfd;
+    }
+
+    loop->to_exit = false;
+    loops_.push_back(loop);
+  }
+
+  init_flag_ = true;
+  return true;
+
+failEpfd:
+  for (auto& loop : loops_)
+  {
+    close(loop->epfd);
+  }
+  loops_.clear();
+  return false;
+}
+
+inline bool RecvEngine::start(const ThreadCallback& cb_thread)
+{
+  if (start_flag_)
+  {
+    return true;
+  }
+
+  if (!init_flag_)
+  {
+    return false;
+  }
+
+  for (size_t i = 0; i < loops_.size(); i++)
+  {
+    Loop* loop = loops_[i].get();
+    loop->to_exit = false;
+    loop->thread = std::thread([this, loop, i, cb_thread]() {
+      if (cb_thread)
+      {
+        cb_thread(i);
+      }
+      run(loop);
+    });
+  }
+
+  start_flag_ = true;
+  return true;
+}
+
+inline void RecvEngine::stop()
+{
+  if (!start_flag_)
+  {
+    return;
+  }
+
+  for (auto& loop : loops_)
+  {
+    loop->to_exit = true;
+  }
+
+  for (auto& loop : loops_)
+  {
+    loop->thread.join();
+  }
+
+  start_flag_ = false;
+}
+
+inline bool RecvEngine::addSocket(int fd, const ReadCallback& cb_read, const TimeoutCallback& cb_timeout)
+{
+  if (!init_flag_)
+  {
+    return false;
+  }
+
+  size_t idx;
+  {
+    std::lock_guard<std::mutex> lg(mtx_);
+    if (fd_loop_.find(fd) != fd_loop_.end())
+    {
+      return false;
+    }
+
+    idx = next_loop_;
+    next_loop_ = (next_loop_ + 1) % loops_.size();
+    fd_loop_[fd] = idx;
+  }
+
+  Loop* loop = loops_[idx].get();
+  {
+    std::lock_guard<std::mutex> lg(loop->mtx);
+    Source& src = loop->sources[fd];
+    src.cb_read = cb_read;
+    src.cb_timeout = cb_timeout;
+    src.last_recv = std::chrono::steady_clock::now();
+
+    struct epoll_event ev;
+    ev.data.fd = fd;
+    ev.events = EPOLLIN; // level-triggered
+    if (epoll_ctl(loop->epfd, EPOLL_CTL_ADD, fd, &ev) < 0)
+    {
+      perror("epoll_ctl: ");
+      loop->sources.erase(fd);
+
+      std::lock_guard<std::mutex> lg2(mtx_);
+      fd_loop_.erase(fd);
+      return false;
+    }
+  }
+
+  return true;
+}
+
+inline void RecvEngine::removeSocket(int fd)
+{
+  size_t idx;
+  {
+    std::lock_guard<std::mutex> lg(mtx_);
+    auto it = fd_loop_.find(fd);
+    if (it == fd_loop_.end())
+    {
+      return;
+    }
+
+    idx = it->second;
+    fd_loop_.erase(it);
+  }
+
+  Loop* loop = loops_[idx].get();
+
+  // the callbacks are called with the lock held, so no callback is running after this.
+  std::lock_guard<std::mutex> lg(loop->mtx);
+  epoll_ctl(loop->epfd, EPOLL_CTL_DEL, fd, NULL);
+  loop->sources.erase(fd);
+}
+
+inline std::string RecvEngine::portKey(uint16_t port, const std::string& host_ip, const std::string& group_ip)
+{
+  return host_ip + ":" + std::to_string(port) + "/" + group_ip;
+}
+
+inline bool RecvEngine::addSink(uint16_t port, const std::string& host_ip, const std::string& group_ip, 
+    const std::string& lidar_ip, size_t buf_len, const SockDemux::Sink& sink, const TimeoutCallback& cb_timeout)
+{
+  uint32_t lidar_addr;
+  if (!parseLidarAddress(lidar_ip, lidar_addr))
+  {
+    RS_ERROR << "Wrong lidar_address " << lidar_ip << " on port " << port << "." << RS_REND;
+    return false;
+  }
+
+  std::lock_guard<std::mutex> lg(demux_mtx_);
+
+  std::string key = portKey(port, host_ip, group_ip);
+  std::shared_ptr<SockDemux> demux;
+
+  auto it = demuxes_.find(key);
+  if (it != demuxes_.end())
+  {
+    demux = it->second;
+    if (demux->bufLen() < buf_len)
+    {
+      RS_ERROR << "Lidars of different packet size on the same port " << port << "." << RS_REND;
+      return false;
+    }
+  }
+  else
+  {
+    int fd = createUdpSocket(port, host_ip, group_ip);
+    if (fd < 0)
+    {
+      return false;
+    }
+
+    demux = std::make_shared<SockDemux>(fd, buf_len);
+    if (!addSocket(fd, std::bind(&SockDemux::readSocket, demux.get(), std::placeholders::_1), 
+          std::bind(&SockDemux::onTimeout, demux.get())))
+    {
+      return false;
+    }
+
+    demuxes_[key] = demux;
+  }
+
+  if (!demux->addSink(lidar_addr, sink, cb_timeout))
+  {
+    RS_ERROR << "Lidar " << lidar_ip << " on port " << port << " is already used." << RS_REND;
+    if (demux->empty())
+    {
+      removeSocket(demux->fd());
+      demuxes_.erase(key);
+    }
+    return false;
+  }
+
+  return true;
+}
+
+inline void RecvEngine::removeSink(uint16_t port, const std::string& host_ip, const std::string& group_ip,
+    const std::string& lidar_ip)
+{
+  // never added.
+  uint32_t lidar_addr;
+  if (!parseLidarAddress(lidar_ip, lidar_addr))
+  {
+    return;
+  }
+
+  std::lock_guard<std::mutex> lg(demux_mtx_);
+
+  std::string key = portKey(port, host_ip, group_ip);
+  auto it = demuxes_.find(key);
+  if (it == demuxes_.end())
+  {
+    return;
+  }
+
+  std::shared_ptr<SockDemux> demux = it->second;
+  demux->removeSink(lidar_addr);
+  if (demux->empty())
+  {
+    removeSocket(demux->fd());
+    demuxes_.erase(it);
+  }
+}
+
+inline void RecvEngine::run(Loop* loop)
+{
+  const std::chrono::seconds timeout(1);
+
+  while (!loop->to_exit)
+  {
+    struct epoll_event events[16];
+    int retval = epoll_wait(loop->epfd, events, 16, 100);
+    if (retval < 0)
+    {
+      if (errno == EINTR)
+        continue;
+
+      perror("epoll_wait: ");
+      break;
+    }
+
+    std::lock_guard<std::mutex> lg(loop->mtx);
+    std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+
+    // no span for a wakeup of timeout.
+    if (retval > 0)
+    {
+      RS_TRACE_SCOPE("recv");
+
+      for (int i = 0; i < retval; i++)
+      {
+        if (!(events[i].events & EPOLLIN))
+        {
+          continue;
+        }
+
+        auto it = loop->sources.find(events[i].data.fd);
+        if (it == loop->sources.end()) // removed while waiting.
+        {
+          continue;
+        }
+
+        it->second.last_recv = now;
+        it->second.cb_read(events[i].data.fd);
+      }
+    }
+
+    for (auto& it : loop->sources)
+    {
+      Source& src = it.second;
+      if (src.cb_timeout && (now - src.last_recv >= timeout))
+      {
+        src.last_recv = now;
+        src.cb_timeout();
+      }
+    }
+  }
+}
+
+}  // namespace lidar
+}  // namespace robosense
@@ -0,0 +1,301 @@
+/*********************************************************************************************************************
+Copyright (c) 2020 RoboSense
+All rights reserved
+
+By downloading, copying, installing or using the software you agree to this license. If you do not agree to this
+license, do not download, install, copy or use the software.
+
+License Agreement
+For RoboSense LiDAR SDK Library
+(3-clause BSD License)
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that the
+following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following
+disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following
+disclaimer in the documentation and/or other materials provided with the distribution.
+
+3. Neither the names of the RoboSense, nor Suteng Innovation Technology, nor the names of other contributors may be used
+to endorse or promote products derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*********************************************************************************************************************/
+
+
+#pragma once
+
+#include <rs_driver/driver/input/unix/udp_socket.hpp>
+
+#include <vector>
+#include <chrono>
+#include <mutex>
+#include <functional>
+#include <cerrno>
+
+namespace robosense
+{
+namespace lidar
+{
+
+//
+// A socket shared by the Lidars sending to the same port. 
+// Its packets are dispatched to the sinks by the source address.
+//
+class SockDemux
+{
+public:
+
+  typedef std::function<void(const uint8_t* data, size_t size)> Sink;
+  typedef std::function<void()> TimeoutCallback;
+
+  constexpr static int BATCH_NUM = 16;
+
+  SockDemux(int fd, size_t buf_len);
+  ~SockDemux();
+
+  int fd() const
+  {
+    return fd_;
+  }
+
+  size_t bufLen() const
+  {
+    return buf_len_;
+  }
+
+  //
+  // Dispatch the packets from lidar_ip to sink. If lidar_ip is INADDR_ANY, dispatch the packets not matched by others.
+  //
+  bool addSink(uint32_t lidar_ip, const Sink& sink, const TimeoutCallback& cb_timeout);
+
+  //
+  // After it returns, the sink is not called any more.
+  //
+  void removeSink(uint32_t lidar_ip);
+  bool empty();
+
+  //
+  // Read a batch of packets and dispatch them. Called in the thread of RecvEngine.
+  //
+  void readSocket(int fd);
+
+  //
+  // Nothing is received on the socket for a while.
+  //
+  void onTimeout();
+
+  //
+  // Packets from an unknown address, and dropped.
+  //
+  uint64_t unknownNum() const
+  {
+    return unknown_num_;
+  }
+
+private:
+
+  struct SinkEntry
+  {
+    uint32_t lidar_ip;
+    Sink sink;
+    TimeoutCallback cb_timeout;
+    std::chrono::steady_clock::time_point last_recv;
+  };
+
+  SinkEntry* findSink(uint32_t src_ip);
+  void checkTimeout(std::chrono::steady_clock::time_point now);
+
+  int fd_;
+  size_t buf_len_;
+  std::vector<uint8_t> bufs_;
+  std::vector<struct sockaddr_in> addrs_;
+#ifdef __linux__
+  std::vector<struct iovec> iovs_;
+  std::vector<struct mmsghdr> msgs_;
+#else
+  std::vector<size_t> lens_;
+#endif
+
+  // a few Lidars on a port, so a linear search is fast enough.
+  std::vector<SinkEntry> sinks_;
+  std::mutex mtx_;
+  uint64_t unknown_num_;
+};
+
+inline SockDemux::SockDemux(int fd, size_t buf_len)
+  : fd_(fd), buf_len_(buf_len), bufs_(BATCH_NUM * buf_len), addrs_((size_t)BATCH_NUM), unknown_num_(0)
+{
+#ifdef __linux__
+  iovs_.resize((size_t)BATCH_NUM);
+  msgs_.resize((size_t)BATCH_NUM);
+  for (int i = 0; i < BATCH_NUM; i++)
+  {
+    iovs_[i].iov_base = bufs_.data() + i * buf_len_;
+    iovs_[i].iov_len = buf_len_;
+
+    memset(&msgs_[i], 0, sizeof(msgs_[i]));
+    msgs_[i].msg_hdr.msg_iov = &iovs_[i];
+    msgs_[i].msg_hdr.msg_iovlen = 1;
+  }
+#else
+  lens_.resize((size_t)BATCH_NUM);
+#endif
+}
+
+inline SockDemux::~SockDemux()
+{
+  close(fd_);
+}
+
+inline bool SockDemux::addSink(uint32_t lidar_ip, const Sink& sink, const TimeoutCallback& cb_timeout)
+{
+  std::lock_guard<std::mutex> lg(mtx_);
+
+  for (auto& entry : sinks_)
+  {
+    if (entry.lidar_ip == lidar_ip)
+    {
+      return false;
+    }
+  }
+
+  SinkEntry entry;
+  entry.lidar_ip = lidar_ip;
+  entry.sink = sink;
+  entry.cb_timeout = cb_timeout;
+  entry.last_recv = std::chrono::steady_clock::now();
+  sinks_.push_back(entry);
+  return true;
+}
+
+inline void SockDemux::removeSink(uint32_t lidar_ip)
+{
+  std::lock_guard<std::mutex> lg(mtx_);
+
+  for (auto it = sinks_.begin(); it != sinks_.end(); it++)
+  {
+    if (it->lidar_ip == lidar_ip)
+    {
+      sinks_.erase(it);
+      break;
+    }
+  }
+}
+
+inline bool SockDemux::empty()
+{
+  std::lock_guard<std::mutex> lg(mtx_);
+  return sinks_.empty();
+}
+
+inline SockDemux::SinkEntry* SockDemux::findSink(uint32_t src_ip)
+{
+  SinkEntry* any = NULL;
+
+  for (auto& entry : sinks_)
+  {
+    if (entry.lidar_ip == src_ip)
+    {
+      return &entry;
+    }
+    else if (entry.lidar_ip == htonl(INADDR_ANY))
+    {
+      any = &entry;
+    }
+  }
+
+  return any;
+}
+
+inline void SockDemux::readSocket(int fd)
+{
+  int num = 0;
+
+#ifdef __linux__
+  for (int i = 0; i < BATCH_NUM; i++)
+  {
+    msgs_[i].msg_hdr.msg_name = &addrs_[i];
+    msgs_[i].msg_hdr.msg_namelen = sizeof(addrs_[i]);
+  }
+
+  num = recvmmsg(fd, msgs_.data(), BATCH_NUM, MSG_DONTWAIT, NULL);
+#else
+  for (; num < BATCH_NUM; num++)
+  {
+    socklen_t addr_len = sizeof(addrs_[num]);
+    ssize_t ret = recvfrom(fd, bufs_.data() + num * buf_len_, buf_len_, MSG_DONTWAIT, 
+        (struct sockaddr*)&addrs_[num], &addr_len);
+    if (ret < 0)
+    {
+      break;
+    }
+
+    lens_[num] = ret;
+  }
+#endif
+
+  if (num < 0)
+  {
+    if ((errno != EAGAIN) && (errno != EWOULDBLOCK))
+    {
+      perror("recvmmsg: ");
+    }
+    return;
+  }
+
+  std::lock_guard<std::mutex> lg(mtx_);
+  std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+
+  for (int i = 0; i < num; i++)
+  {
+#ifdef __linux__
+    size_t len = msgs_[i].msg_len;
+#else
+    size_t len = lens_[i];
+#endif
+
+    SinkEntry* entry = findSink(addrs_[i].sin_addr.s_addr);
+    if (entry == NULL)
+    {
+      unknown_num_++;
+      continue;
+    }
+
+    entry->last_recv = now;
+    entry->sink(bufs_.data() + i * buf_len_, len);
+  }
+
+  checkTimeout(now);
+}
+
+inline void SockDemux::onTimeout()
+{
+  std::lock_guard<std::mutex> lg(mtx_);
+  checkTimeout(std::chrono::steady_clock::now());
+}
+
+inline void SockDemux::checkTimeout(std::chrono::steady_clock::time_point now)
+{
+  const std::chrono::seconds timeout(1);
+
+  for (auto& entry : sinks_)
+  {
+    if (entry.cb_timeout && (now - entry.last_recv >= timeout))
+    {
+      entry.last_recv = now;
+      entry.cb_timeout();
+    }
+  }
+}
+
+}  // namespace lidar
+}  // namespace robosense
@@ -0,0 +1,238 @@
+/*********************************************************************************************************************
+Copyright (c) 2020 RoboSense
+All rights reserved
+
+By downloading, copying, installing or using the software you agree to this license. If you do not agree to this
+license, do not download, install, copy or use the software.
+
+License Agreement
+For RoboSense LiDAR SDK Library
+(3-clause BSD License)
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that the
+following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following
+disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following
+disclaimer in the documentation and/or other materials provided with the distribution.
+
+3. Neither the names of the RoboSense, nor Suteng Innovation Technology, nor the names of other contributors may be used
+to endorse or promote products derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*********************************************************************************************************************/
+
+
+#pragma once
+
+#include <unistd.h>
+#include <fcntl.h>
+#include <arpa/inet.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+
+#ifdef __linux__
+#include <linux/filter.h>
+#endif
+
+#include <string>
+#include <cstring>
+#include <cstdio>
+
+namespace robosense
+{
+namespace lidar
+{
+
+//
+// Create a non-blocking UDP socket bound to port, on hostIp, or joined to the multicast group grpIp.
+// With reusePort, more sockets may bind to the same port, and the packets are spread among them by flow.
+//
+inline int createUdpSocket(uint16_t port, const std::string& hostIp, const std::string& grpIp, 
+    bool reusePort = false)
+{
+  int fd;
+  int ret;
+  int reuse = 1;
+
+  fd = socket(PF_INET, SOCK_DGRAM, 0);
+  if (fd < 0)
+  {
+    perror("socket: ");
+    goto failSocket;
+  }
+
+  ret = setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+  if (ret < 0)
+  {
+    perror("setsockopt: ");
+    goto failOption;
+  }
+
+  if (reusePort)
+  {
+#ifdef SO_REUSEPORT
+    ret = setsockopt(fd, SOL_SOCKET, SO_REUSEPORT, &reuse, sizeof(reuse));
+#else
+    ret = -1;
+#endif
+    if (ret < 0)
+    {
+      perror("setsockopt: ");
+      goto failOption;
+    }
+  }
+
+  struct sockaddr_in host_addr;
+  memset(&host_addr, 0, sizeof(host_addr));
+  host_addr.sin_family = AF_INET;
+  host_addr.sin_port = htons(port);
+  host_addr.sin_addr.s_addr = INADDR_ANY;
+  if (hostIp != "0.0.0.0" && grpIp == "0.0.0.0")
+  {
+    inet_pton(AF_INET, hostIp.c_str(), &(host_addr.sin_addr));
+  }
+
+  ret = bind(fd, (struct sockaddr*)&host_addr, sizeof(host_addr));
+  if (ret < 0)
+  {
+    perror("bind: ");
+    goto failBind;
+  }
+
+  if (grpIp != "0.0.0.0")
+  {
+#if 0
+    struct ip_mreqn ipm;
+    memset(&ipm, 0, sizeof(ipm));
+    inet_pton(AF_INET, grpIp.c_str(), &(ipm.imr_multiaddr));
+    inet_pton(AF_INET, hostIp.c_str(), &(ipm.imr_address));
+#else
+    struct ip_mreq ipm;
+    inet_pton(AF_INET, grpIp.c_str(), &(ipm.imr_multiaddr));
+    inet_pton(AF_INET, hostIp.c_str(), &(ipm.imr_interface));
+#endif
+    ret = setsockopt(fd, IPPROTO_IP, IP_ADD_MEMBERSHIP, &ipm, sizeof(ipm));
+    if (ret < 0)
+    {
+      perror("setsockopt: ");
+      goto failGroup;
+    }
+  }
+
+#ifdef ENABLE_DOUBLE_RCVBUF
+  {
+    uint32_t opt_val;
+    socklen_t opt_len = sizeof(uint32_t);
+    getsockopt(fd, SOL_SOCKET, SO_RCVBUF, (char*)&opt_val, &opt_len);
+    opt_val *= 4;
+    setsockopt(fd, SOL_SOCKET, SO_RCVBUF, (char*)&opt_val, opt_len);
+  }
+#endif
+
+  {
+    int flags = fcntl(fd, F_GETFL, 0);
+    ret = fcntl(fd, F_SETFL, flags | O_NONBLOCK);
+    if (ret < 0)
+    {
+      perror("fcntl: ");
+      goto failNonBlock;
+    }
+  }
+
+  return fd;
+
+failNonBlock:
+failGroup:
+failBind:
+failOption:
+  close(fd);
+failSocket:
+  return -1;
+}
+
+//
+// Check that no socket is bound to port. The SO_REUSEPORT sockets bound to it then are a group of the caller only.
+//
+inline bool isUdpPortFree(uint16_t port, const std::string& hostIp, const std::string& grpIp)
+{
+  int fd = socket(PF_INET, SOCK_DGRAM, 0);
+  if (fd < 0)
+  {
+    return false;
+  }
+
+  // no SO_REUSEADDR, so it fails if any other socket is bound.
+  struct sockaddr_in host_addr;
+  memset(&host_addr, 0, sizeof(host_addr));
+  host_addr.sin_family = AF_INET;
+  host_addr.sin_port = htons(port);
+  host_addr.sin_addr.s_addr = INADDR_ANY;
+  if (hostIp != "0.0.0.0" && grpIp == "0.0.0.0")
+  {
+    inet_pton(AF_INET, hostIp.c_str(), &(host_addr.sin_addr));
+  }
+
+  int ret = bind(fd, (struct sockaddr*)&host_addr, sizeof(host_addr));
+  close(fd);
+  return (ret == 0);
+}
+
+//
+// Steer each packet to a socket in the SO_REUSEPORT group of fd. The sockets are indexed by the order they are bound.
+// With byCpu, to the socket of the CPU receiving it; otherwise, to a random socket, so even a single flow is spread.
+//
+inline bool steerReusePort(int fd, uint32_t sock_num, bool byCpu)
+{
+#if defined(__linux__) && defined(SO_ATTACH_REUSEPORT_CBPF)
+  uint32_t ad = byCpu ? SKF_AD_CPU : SKF_AD_RANDOM;
+  struct sock_filter code[] = 
+  {
+    { BPF_LD  | BPF_W | BPF_ABS, 0, 0, (uint32_t)(SKF_AD_OFF + ad) },        // A = cpu, or random
+    { BPF_ALU | BPF_MOD | BPF_K, 0, 0, sock_num },                            // A = A % sock_num
+    { BPF_RET | BPF_A, 0, 0, 0 },                                             // return A
+  };
+
+  struct sock_fprog prog;
+  prog.len = sizeof(code) / sizeof(code[0]);
+  prog.filter = code;
+
+  if (setsockopt(fd, SOL_SOCKET, SO_ATTACH_REUSEPORT_CBPF, &prog, sizeof(prog)) < 0)
+  {
+    perror("setsockopt: ");
+    return false;
+  }
+
+  return true;
+#else
+  return false;
+#endif
+}
+
+//
+// Parse the address of a Lidar. "0.0.0.0" gives INADDR_ANY, i.e. any Lidar.
+// Return false if it is not an IPv4 address. Never take it as any Lidar, or it catches the packets of all 
+// the Lidars on the port.
+//
+inline bool parseLidarAddress(const std::string& ip, uint32_t& lidar_ip)
+{
+  struct in_addr addr;
+  if (inet_pton(AF_INET, ip.c_str(), &addr) != 1)
+  {
+    return false;
+  }
+
+  lidar_ip = addr.s_addr;
+  return true;
+}
+
+}  // namespace lidar
+}  // namespace robosense
@@ -52,6 +52,7 @@ public:
   {
     sock_offset_ += input_param.user_layer_bytes;
     sock_tail_   += input_param.tail_layer_bytes;
+    lidar_ip_ = htonl(INADDR_ANY);
   }
 
   virtual bool init();
@@ -67,6 +68,7 @@ protected:
   int fds_[2];
   size_t sock_offset_;
   size_t sock_tail_;
+  uint32_t lidar_ip_;
 };
 
 inline bool InputSock::init()
@@ -78,6 +80,13 @@ inline bool InputSock::init()
 
   int msop_fd = -1, difop_fd = -1;
 
+  // never take a wrong address as any Lidar.
+  if (inet_pton(AF_INET, input_param_.lidar_address.c_str(), &lidar_ip_) != 1)
+  {
+    RS_ERROR << "Wrong lidar_address " << input_param_.lidar_address << "." << RS_REND;
+    return false;
+  }
+
   WORD version = MAKEWORD(2, 2);
   WSADATA wsaData;
   int ret = WSAStartup(version, &wsaData);
@@ -227,6 +236,8 @@ failSocket:
 
 inline void InputSock::recvPacket()
 {
+  beginThread(0);
+
   int max_fd = ((fds_[0] > fds_[1]) ? fds_[0] : fds_[1]);
 
   while (!to_exit_recv_)
@@ -260,12 +271,18 @@ inline void InputSock::recvPacket()
       if ((fds_[i] >= 0) && FD_ISSET(fds_[i], &rfds))
       {
         std::shared_ptr<Buffer> pkt = cb_get_pkt_(pkt_buf_len_);
-        int ret = recvfrom(fds_[i], (char*)pkt->buf(), (int)pkt->bufSize(), 0, NULL, NULL);
+        struct sockaddr_in addr;
+        int addr_len = sizeof(addr);
+        int ret = recvfrom(fds_[i], (char*)pkt->buf(), (int)pkt->bufSize(), 0, (struct sockaddr*)&addr, &addr_len);
         if (ret < 0)
         {
           perror("recvfrom: ");
           break;
         }
+        else if ((lidar_ip_ != htonl(INADDR_ANY)) && (addr.sin_addr.s_addr != lidar_ip_))
+        {
+          pushPacket(pkt, false); // from another Lidar
+        }
         else if (ret > 0)
         {
           pkt->setData(sock_offset_, ret - sock_offset_ - sock_tail_);
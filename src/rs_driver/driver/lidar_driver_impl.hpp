@@ -34,14 +34,28 @@ THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 #include <rs_driver/driver/driver_param.hpp>
 #include <rs_driver/msg/packet.hpp>
+#include <rs_driver/msg/point_cloud_sector.hpp>
 #include <rs_driver/common/error_code.hpp>
 #include <rs_driver/macro/version.hpp>
 #include <rs_driver/utility/sync_queue.hpp>
 #include <rs_driver/utility/buffer.hpp>
 #include <rs_driver/driver/input/input_factory.hpp>
 #include <rs_driver/driver/decoder/decoder_factory.hpp>
+#include <rs_driver/driver/recorder/recorder.hpp>
+#include <rs_driver/driver/rolling_window.hpp>
+#include <rs_driver/driver/degrade_controller.hpp>
+#include <rs_driver/driver/thread_setting.hpp>
+#include <rs_driver/utility/worker_pool.hpp>
+#include <rs_driver/utility/frame_slot.hpp>
+#include <rs_driver/utility/latency_stats.hpp>
+#include <rs_driver/utility/trace.hpp>
+#include <rs_driver/utility/alloc_tracker.hpp>
 
 #include <sstream>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <algorithm>
 
 namespace robosense
 {
@@ -70,14 +84,30 @@ public:
       const std::function<std::shared_ptr<T_PointCloud>(void)>& cb_get_cloud,
       const std::function<void(std::shared_ptr<T_PointCloud>)>& cb_put_cloud);
   void regPacketCallback(const std::function<void(const Packet&)>& cb_put_pkt);
+  void regSectorCallback(const std::function<void(const PointCloudSector<T_PointCloud>&)>& cb_put_sector);
   void regExceptionCallback(const std::function<void(const Error&)>& cb_excep);
  
   bool init(const RSDriverParam& param);
+
+  //
+  // Receive in the loops of recv_engine, and handle packets in worker_pool, instead of own threads.
+  // Either of them may be null.
+  //
+  bool init(const RSDriverParam& param, 
+      std::shared_ptr<RecvEngine> recv_engine, std::shared_ptr<WorkerPool> worker_pool);
   bool start();
   void stop();
 
   void decodePacket(const Packet& pkt);
   bool getTemperature(float& temp);
+  bool getRecordStats(RecordStats& stats);
+  bool getStats(DriverStats& stats);
+  bool getWindow(std::shared_ptr<const T_PointCloud>& window);
+  bool waitForFrame(std::shared_ptr<T_PointCloud>& cloud, uint32_t timeout_ms);
+  bool tryGetFrame(std::shared_ptr<T_PointCloud>& cloud);
+  uint64_t droppedFrameNum();
+  bool getLatencyReport(LatencyReport& report);
+  void resetLatencyStats();
 
 private:
 
@@ -88,34 +118,149 @@ private:
   void packetPut(std::shared_ptr<Buffer> pkt, bool stuffed);
 
   void processPacket();
+  void schedulePackets();
+  void drainPackets();
+  void handlePacket(std::shared_ptr<Buffer> pkt);
 
   std::shared_ptr<T_PointCloud> getPointCloud();
+  std::shared_ptr<T_PointCloud> getPullCloud();
   void splitFrame(uint16_t height, double ts);
-  void setPointCloudHeader(std::shared_ptr<T_PointCloud> msg, uint16_t height, double chan_ts);
+  void splitSector(bool last);
+  void setPointCloudHeader(std::shared_ptr<T_PointCloud> msg, uint16_t height, double chan_ts, bool dense);
+  void degradeFrame(double ts);
+#ifdef ENABLE_LATENCY_STATS
+  void dumpLatencyStats(uint64_t now_ns);
+#endif
+#ifdef ENABLE_ALLOC_TRACKING
+  void allocPacket(uint64_t allocs);
+  void allocFrame();
+  void allocExceeded(const char* what, uint64_t allocs, int32_t limit);
+#endif
 
   RSDriverParam driver_param_;
   std::function<std::shared_ptr<T_PointCloud>(void)> cb_get_cloud_;
   std::function<void(std::shared_ptr<T_PointCloud>)> cb_put_cloud_;
   std::function<void(const Packet&)> cb_put_pkt_;
+  Packet cb_pkt_; // passed to cb_put_pkt_
+  std::function<void(const PointCloudSector<T_PointCloud>&)> cb_put_sector_;
   std::function<void(const Error&)> cb_excep_;
   std::function<void(const uint8_t*, size_t)> cb_feed_pkt_;
 
   std::shared_ptr<Input> input_ptr_;
   std::shared_ptr<Decoder<T_PointCloud>> decoder_ptr_;
+  std::shared_ptr<Recorder> recorder_ptr_;
+  std::shared_ptr<RollingWindow<T_PointCloud>> window_ptr_;
+  std::shared_ptr<FrameSlot<T_PointCloud>> frame_slot_;
+
+  //
+  // Point clouds for frame_slot_. The caller returns a point cloud by releasing it, 
+  // and the deleter of its shared_ptr puts it back here.
+  //
+  struct PullCloudPool
+  {
+    std::mutex mtx;
+    std::vector<T_PointCloud*> clouds;
+    size_t max_num;
+
+    void put(T_PointCloud* cloud)
+    {
+      {
+        std::lock_guard<std::mutex> lg(mtx);
+        if (clouds.size() < max_num)
+        {
+          clouds.push_back(cloud);
+          return;
+        }
+      }
+
+      delete cloud;
+    }
+
+    ~PullCloudPool()
+    {
+      for (auto cloud : clouds)
+      {
+        delete cloud;
+      }
+    }
+  };
+
+  std::shared_ptr<PullCloudPool> pull_pool_;
+  std::shared_ptr<RecvEngine> recv_engine_;
+  std::shared_ptr<WorkerPool> worker_pool_;
+  std::atomic<bool> handle_scheduled_;
+  std::mutex drain_mtx_;
+  std::condition_variable drain_cv_;
+  size_t drain_num_; // drainPackets() tasks submitted, and not returned yet
   SyncQueue<std::shared_ptr<Buffer>> free_pkt_queue_;
   SyncQueue<std::shared_ptr<Buffer>> pkt_queue_;
   std::thread handle_thread_;
   uint32_t pkt_seq_;
   uint32_t point_cloud_seq_;
-  bool to_exit_handle_;
+  size_t sector_begin_;
+  uint16_t sector_idx_;
+  size_t sector_reserve_; // capacity reserved for a frame, learned from the frames
+  std::atomic<bool> to_exit_handle_;
+  bool replay_fast_; // replay the file as fast as possible, without dropping packets
+  std::mutex replay_mtx_;
+  std::condition_variable replay_cv_; // signaled when pkt_queue_ is drained, if replay_fast_
   bool init_flag_;
   bool start_flag_;
+
+  ErrorLimiter err_limiter_; // rate limit of errors, per driver
+  StatCounter pkts_;
+  StatCounter msop_pkts_;
+  StatCounter difop_pkts_;
+  StatCounter queue_dropped_pkts_;
+  StatCounter queue_depth_;
+  StatCounter frames_;
+  StatCounter empty_frames_;
+  StatCounter points_;
+  StatCounter last_frame_points_;
+  StatCounter lossy_frames_;
+  StatCounter decode_ns_;
+  FrameQuality frame_quality_; // of the frame being split
+
+  DegradeController degrade_;
+  std::atomic<bool> pkt_overflowed_; // since the last frame
+  std::chrono::steady_clock::time_point pkt_decode_begin_;
+  uint64_t frame_decode_ns_; // of the frame being decoded
+  double prev_frame_ts_;
+  StatCounter degrade_modes_;
+  StatCounter degrade_changes_;
+  StatCounter allocs_;
+  StatCounter last_frame_allocs_;
+  StatCounter max_pkt_allocs_;
+  StatCounter max_frame_allocs_;
+
+#ifdef ENABLE_LATENCY_STATS
+  LatencyStats latency_stats_;
+  uint64_t cur_recv_ns_;   // receive time of the packet being decoded
+  uint64_t last_dump_ns_;
+#endif
+
+#ifdef ENABLE_ALLOC_TRACKING
+  uint64_t pkt_alloc_begin_; // allocations of the thread, when the packet began. Moved by allocFrame()
+  uint64_t frame_allocs_;    // of the frame being decoded
+  uint64_t alloc_frames_;    // frames split, for warmup_frames
+#endif
 };
 
 template <typename T_PointCloud>
 inline LidarDriverImpl<T_PointCloud>::LidarDriverImpl()
-  : pkt_seq_(0), point_cloud_seq_(0), init_flag_(false), start_flag_(false)
+  : handle_scheduled_(false), drain_num_(0), pkt_seq_(0), point_cloud_seq_(0), sector_begin_(0), sector_idx_(0), sector_reserve_(0), replay_fast_(false), init_flag_(false), start_flag_(false)
+  , pkt_overflowed_(false), frame_decode_ns_(0), prev_frame_ts_(0.0)
 {
+#ifdef ENABLE_LATENCY_STATS
+  cur_recv_ns_ = 0;
+  last_dump_ns_ = 0;
+#endif
+
+#ifdef ENABLE_ALLOC_TRACKING
+  pkt_alloc_begin_ = 0;
+  frame_allocs_ = 0;
+  alloc_frames_ = 0;
+#endif
 }
 
 template <typename T_PointCloud>
@@ -129,6 +274,8 @@ std::shared_ptr<T_PointCloud> LidarDriverImpl<T_PointCloud>::getPointCloud()
 {
   while (1)
   {
+    RS_TRACE_SCOPE("get_cloud_callback");
+
     std::shared_ptr<T_PointCloud> cloud = cb_get_cloud_();
     if (cloud)
     {
@@ -136,10 +283,34 @@ std::shared_ptr<T_PointCloud> LidarDriverImpl<T_PointCloud>::getPointCloud()
       return cloud;
     }
 
-    LIMIT_CALL(runExceptionCallback(Error(ERRCODE_POINTCLOUDNULL)), 1);
+    err_limiter_.call(cb_excep_, ERRCODE_POINTCLOUDNULL, 1);
   }
 }
 
+template <typename T_PointCloud>
+std::shared_ptr<T_PointCloud> LidarDriverImpl<T_PointCloud>::getPullCloud()
+{
+  // reuse a point cloud released by the caller and frame_slot_.
+  T_PointCloud* cloud = NULL;
+  {
+    std::lock_guard<std::mutex> lg(pull_pool_->mtx);
+    if (!pull_pool_->clouds.empty())
+    {
+      cloud = pull_pool_->clouds.back();
+      pull_pool_->clouds.pop_back();
+    }
+  }
+
+  if (cloud == NULL)
+  {
+    cloud = new T_PointCloud();
+  }
+
+  // the pool lives until all its point clouds are released, even after the driver.
+  std::shared_ptr<PullCloudPool> pool = pull_pool_;
+  return std::shared_ptr<T_PointCloud>(cloud, [pool](T_PointCloud* released) { pool->put(released); });
+}
+
 template <typename T_PointCloud>
 void LidarDriverImpl<T_PointCloud>::regPointCloudCallback( 
     const std::function<std::shared_ptr<T_PointCloud>(void)>& cb_get_cloud,
@@ -156,6 +327,13 @@ inline void LidarDriverImpl<T_PointCloud>::regPacketCallback(
   cb_put_pkt_ = cb_put_pkt;
 }
 
+template <typename T_PointCloud>
+inline void LidarDriverImpl<T_PointCloud>::regSectorCallback(
+    const std::function<void(const PointCloudSector<T_PointCloud>&)>& cb_put_sector)
+{
+  cb_put_sector_ = cb_put_sector;
+}
+
 template <typename T_PointCloud>
 inline void LidarDriverImpl<T_PointCloud>::regExceptionCallback(
     const std::function<void(const Error&)>& cb_excep)
@@ -165,6 +343,13 @@ inline void LidarDriverImpl<T_PointCloud>::regExceptionCallback(
 
 template <typename T_PointCloud>
 inline bool LidarDriverImpl<T_PointCloud>::init(const RSDriverParam& param)
+{
+  return init(param, nullptr, nullptr);
+}
+
+template <typename T_PointCloud>
+inline bool LidarDriverImpl<T_PointCloud>::init(const RSDriverParam& param, 
+    std::shared_ptr<RecvEngine> recv_engine, std::shared_ptr<WorkerPool> worker_pool)
 {
   if (init_flag_)
   {
@@ -175,23 +360,66 @@ inline bool LidarDriverImpl<T_PointCloud>::init(const RSDriverParam& param)
   // decoder
   //
   decoder_ptr_ = DecoderFactory<T_PointCloud>::createDecoder(param.lidar_type, param.decoder_param);
+  driver_param_ = param;
+  degrade_.init(param.degrade_param);
+
+  if (param.frame_queue_len > 0)
+  {
+    // the caller pulls the frames from frame_slot_, instead of the point cloud callbacks.
+    if (cb_put_cloud_)
+    {
+      RS_WARNING << "frame_queue_len > 0. Ignore the point cloud callbacks." << RS_REND;
+    }
+
+    frame_slot_ = std::make_shared<FrameSlot<T_PointCloud>>(param.frame_queue_len);
+    pull_pool_ = std::make_shared<PullCloudPool>();
+    pull_pool_->max_num = (size_t)param.frame_queue_len + 3;
+    pull_pool_->clouds.reserve(pull_pool_->max_num);
+    cb_get_cloud_ = std::bind(&LidarDriverImpl<T_PointCloud>::getPullCloud, this);
+    cb_put_cloud_ = [this](std::shared_ptr<T_PointCloud> cloud) { frame_slot_->push(cloud); };
+  }
   
   // rewrite pkt timestamp or not ?
   decoder_ptr_->enableWritePktTs((cb_put_pkt_ == nullptr) ? false : true);
 
   // point cloud related
-  decoder_ptr_->point_cloud_ = getPointCloud();
   decoder_ptr_->regCallback( 
       std::bind(&LidarDriverImpl<T_PointCloud>::runExceptionCallback, this, std::placeholders::_1),
       std::bind(&LidarDriverImpl<T_PointCloud>::splitFrame, this, std::placeholders::_1, std::placeholders::_2));
 
+  if (param.decoder_param.window_resolution > 0)
+  {
+    if (isMech(param.lidar_type))
+    {
+      // the point cloud of decoder is only a scratch of each packet.
+      window_ptr_ = std::make_shared<RollingWindow<T_PointCloud>>(param.decoder_param.window_resolution);
+      decoder_ptr_->point_cloud_ = std::make_shared<T_PointCloud>();
+      decoder_ptr_->regBlockCallback([this](int32_t angle) {
+          window_ptr_->newBlock(angle, decoder_ptr_->point_cloud_->points.size()); });
+    }
+    else
+    {
+      RS_WARNING << "Rolling window is only for mechanical Lidars. Ignore window_resolution." << RS_REND;
+    }
+  }
+  else if (cb_put_sector_)
+  {
+    decoder_ptr_->regSectorCallback(std::bind(&LidarDriverImpl<T_PointCloud>::splitSector, this, false));
+  }
+
+  if (!window_ptr_)
+  {
+    decoder_ptr_->point_cloud_ = getPointCloud();
+  }
+
   double packet_duration = decoder_ptr_->getPacketDuration();
   bool is_jumbo = isJumbo(param.lidar_type);
 
   //
   // input
   //
-  input_ptr_ = InputFactory::createInput(param.input_type, param.input_param, is_jumbo, packet_duration, cb_feed_pkt_);
+  input_ptr_ = InputFactory::createInput(param.input_type, param.input_param, is_jumbo, packet_duration, cb_feed_pkt_,
+      recv_engine);
 
   input_ptr_->regCallback(
       std::bind(&LidarDriverImpl<T_PointCloud>::runExceptionCallback, this, std::placeholders::_1), 
@@ -203,13 +431,36 @@ inline bool LidarDriverImpl<T_PointCloud>::init(const RSDriverParam& param)
     goto failInputInit;
   }
 
-  driver_param_ = param;
+  //
+  // recorder
+  //
+  if (!param.record_param.record_path.empty())
+  {
+    recorder_ptr_ = std::make_shared<Recorder>(param.record_param, param.input_param);
+    recorder_ptr_->regCallback(
+        std::bind(&LidarDriverImpl<T_PointCloud>::runExceptionCallback, this, std::placeholders::_1));
+
+    if (!recorder_ptr_->init())
+    {
+      goto failRecorderInit;
+    }
+  }
+
+  replay_fast_ = ((param.input_type == InputType::PCAP_FILE) || (param.input_type == InputType::LOG_FILE)) && 
+    (param.input_param.pcap_rate <= 0);
+
+  recv_engine_ = recv_engine;
+  worker_pool_ = worker_pool;
   init_flag_ = true;
   return true;
 
+failRecorderInit:
+  recorder_ptr_.reset();
 failInputInit:
   input_ptr_.reset();
   decoder_ptr_.reset();
+  frame_slot_.reset();
+  pull_pool_.reset();
   return false;
 }
 
@@ -226,8 +477,42 @@ inline bool LidarDriverImpl<T_PointCloud>::start()
     return false;
   }
 
+  if (recorder_ptr_)
+  {
+    recorder_ptr_->start();
+  }
+
+  //
+  // the threads place themselves first, so they never run (and allocate their buffers) anywhere else.
+  //
   to_exit_handle_ = false;
-  handle_thread_ = std::thread(std::bind(&LidarDriverImpl<T_PointCloud>::processPacket, this));
+  if (!worker_pool_)
+  {
+    handle_thread_ = std::thread([this]() {
+      applyThreadParam(driver_param_.handle_thread_param, "rs_handle");
+      processPacket();
+    });
+  }
+
+  {
+    // with steer_by_cpu, the receiving threads pin themselves to the CPUs of their sockets.
+    RSThreadParam recv_param = driver_param_.recv_thread_param;
+    if (driver_param_.input_param.steer_by_cpu)
+    {
+      recv_param.cpu_list.clear();
+    }
+
+    input_ptr_->regThreadCallback([recv_param](size_t idx) {
+      if (idx == 0)
+      {
+        applyThreadParam(recv_param, "rs_recv");
+      }
+      else
+      {
+        applyThreadParam(indexThreadParam(recv_param, idx), "rs_recv" + std::to_string(idx));
+      }
+    });
+  }
 
   input_ptr_->start();
 
@@ -246,7 +531,26 @@ inline void LidarDriverImpl<T_PointCloud>::stop()
   input_ptr_->stop();
 
   to_exit_handle_ = true;
-  handle_thread_.join();
+  {
+    std::lock_guard<std::mutex> lg(replay_mtx_);
+    replay_cv_.notify_all();
+  }
+
+  if (worker_pool_)
+  {
+    // wait for the tasks in worker_pool_. They still use this driver until they return.
+    std::unique_lock<std::mutex> ul(drain_mtx_);
+    drain_cv_.wait(ul, [this] { return (drain_num_ == 0); });
+  }
+  else
+  {
+    handle_thread_.join();
+  }
+
+  if (recorder_ptr_)
+  {
+    recorder_ptr_->stop();
+  }
 
   start_flag_ = false;
 }
@@ -269,13 +573,142 @@ inline bool LidarDriverImpl<T_PointCloud>::getTemperature(float& temp)
   return true;
 }
 
+template <typename T_PointCloud>
+inline bool LidarDriverImpl<T_PointCloud>::getRecordStats(RecordStats& stats)
+{
+  if (recorder_ptr_ == nullptr)
+  {
+    return false;
+  }
+
+  stats = recorder_ptr_->getStats();
+  return true;
+}
+
+template <typename T_PointCloud>
+inline bool LidarDriverImpl<T_PointCloud>::getStats(DriverStats& stats)
+{
+  if (decoder_ptr_ == nullptr)
+  {
+    return false;
+  }
+
+  decoder_ptr_->getStats(stats);
+  stats.pkts = pkts_.get();
+  stats.msop_pkts = msop_pkts_.get();
+  stats.difop_pkts = difop_pkts_.get();
+  stats.queue_dropped_pkts = queue_dropped_pkts_.get();
+  stats.queue_depth = queue_depth_.get();
+  stats.frames = frames_.get();
+  stats.empty_frames = empty_frames_.get();
+  stats.points = points_.get();
+  stats.last_frame_points = last_frame_points_.get();
+  stats.lossy_frames = lossy_frames_.get();
+  stats.decode_ns = decode_ns_.get();
+  stats.degrade_modes = degrade_modes_.get();
+  stats.degrade_changes = degrade_changes_.get();
+  stats.allocs = allocs_.get();
+  stats.last_frame_allocs = last_frame_allocs_.get();
+  stats.max_pkt_allocs = max_pkt_allocs_.get();
+  stats.max_frame_allocs = max_frame_allocs_.get();
+  return true;
+}
+
+template <typename T_PointCloud>
+inline bool LidarDriverImpl<T_PointCloud>::getWindow(std::shared_ptr<const T_PointCloud>& window)
+{
+  if (window_ptr_ == nullptr)
+  {
+    window.reset();
+    return false;
+  }
+
+  return window_ptr_->snapshot(window);
+}
+
+template <typename T_PointCloud>
+inline bool LidarDriverImpl<T_PointCloud>::waitForFrame(std::shared_ptr<T_PointCloud>& cloud, uint32_t timeout_ms)
+{
+  if (frame_slot_ == nullptr)
+  {
+    return false;
+  }
+
+  return frame_slot_->pop(cloud, timeout_ms);
+}
+
+template <typename T_PointCloud>
+inline bool LidarDriverImpl<T_PointCloud>::tryGetFrame(std::shared_ptr<T_PointCloud>& cloud)
+{
+  if (frame_slot_ == nullptr)
+  {
+    return false;
+  }
+
+  return frame_slot_->tryPop(cloud);
+}
+
+template <typename T_PointCloud>
+inline uint64_t LidarDriverImpl<T_PointCloud>::droppedFrameNum()
+{
+  return (frame_slot_ == nullptr) ? 0 : frame_slot_->dropNum();
+}
+
+template <typename T_PointCloud>
+inline bool LidarDriverImpl<T_PointCloud>::getLatencyReport(LatencyReport& report)
+{
+#ifdef ENABLE_LATENCY_STATS
+  report = latency_stats_.report();
+  return true;
+#else
+  (void)report;
+  return false;
+#endif
+}
+
+template <typename T_PointCloud>
+inline void LidarDriverImpl<T_PointCloud>::resetLatencyStats()
+{
+#ifdef ENABLE_LATENCY_STATS
+  latency_stats_.reset();
+#endif
+}
+
+#ifdef ENABLE_LATENCY_STATS
+template <typename T_PointCloud>
+inline void LidarDriverImpl<T_PointCloud>::dumpLatencyStats(uint64_t now_ns)
+{
+  if (driver_param_.latency_dump_interval <= 0)
+  {
+    return;
+  }
+
+  if (last_dump_ns_ == 0)
+  {
+    last_dump_ns_ = now_ns;
+    return;
+  }
+
+  if (now_ns - last_dump_ns_ >= (uint64_t)(driver_param_.latency_dump_interval * 1e9))
+  {
+    RS_INFOL << "Latency of " << lidarTypeToStr(driver_param_.lidar_type) 
+      << " (msop port " << driver_param_.input_param.msop_port << "):" << std::endl
+      << latency_stats_.report().toString() << RS_REND;
+    last_dump_ns_ = now_ns;
+  }
+}
+#endif
+
 template <typename T_PointCloud>
 inline void LidarDriverImpl<T_PointCloud>::runPacketCallBack(uint8_t* data, size_t data_size,
     double timestamp, uint8_t is_difop, uint8_t is_frame_begin)
 {
   if (cb_put_pkt_)
   {
-    Packet pkt;
+    RS_TRACE_SCOPE("packet_callback");
+
+    // reuse the buffer of the previous packet, so no allocation in steady state.
+    Packet& pkt = cb_pkt_;
     pkt.timestamp = timestamp;
     pkt.is_difop = is_difop;
     pkt.is_frame_begin = is_frame_begin;
@@ -292,6 +725,7 @@ inline void LidarDriverImpl<T_PointCloud>::runExceptionCallback(const Error& err
 {
   if (cb_excep_)
   {
+    RS_TRACE_SCOPE("exception_callback");
     cb_excep_(error);
   }
 }
@@ -319,11 +753,33 @@ inline void LidarDriverImpl<T_PointCloud>::packetPut(std::shared_ptr<Buffer> pkt
     return;
   }
 
+#ifdef ENABLE_LATENCY_STATS
+  pkt->enqueue_ns = latencyNow();
+  latency_stats_.record(LAT_RECV, pkt->recv_ns, pkt->enqueue_ns);
+#endif
+
+  pkts_.inc();
+
   size_t sz = pkt_queue_.push(pkt);
+  queue_depth_.set(sz);
   if (sz > PACKET_POOL_MAX)
   {
-    LIMIT_CALL(runExceptionCallback(Error(ERRCODE_PKTBUFOVERFLOW)), 1);
+    err_limiter_.call(cb_excep_, ERRCODE_PKTBUFOVERFLOW, 1);
+    queue_dropped_pkts_.inc(sz);
     pkt_queue_.clear();
+    pkt_overflowed_ = true;
+  }
+
+  if (worker_pool_)
+  {
+    schedulePackets();
+  }
+
+  // the file is read faster than decoded. wait for the queue to drain, instead of dropping packets.
+  if (replay_fast_ && (sz >= PACKET_POOL_MAX / 2))
+  {
+    std::unique_lock<std::mutex> ul(replay_mtx_);
+    replay_cv_.wait(ul, [this] { return (pkt_queue_.empty() || to_exit_handle_); });
   }
 }
 
@@ -338,45 +794,377 @@ inline void LidarDriverImpl<T_PointCloud>::processPacket()
       continue;
     }
 
-    uint8_t* id = pkt->data();
-    if (*id == 0x55)
+    handlePacket(pkt);
+  }
+}
+
+template <typename T_PointCloud>
+inline void LidarDriverImpl<T_PointCloud>::schedulePackets()
+{
+  //
+  // At most one task of this driver is in worker_pool_ at any time, 
+  // so the packets are decoded in order, though by different threads.
+  //
+  bool scheduled = false;
+  if (handle_scheduled_.compare_exchange_strong(scheduled, true))
+  {
     {
-      bool pkt_to_split = decoder_ptr_->processMsopPkt(pkt->data(), pkt->dataSize());
-      runPacketCallBack(pkt->data(), pkt->dataSize(), decoder_ptr_->prevPktTs(), false, pkt_to_split); // msop packet
+      std::lock_guard<std::mutex> lg(drain_mtx_);
+      drain_num_++;
     }
-    else if (*id == 0xA5)
+
+    worker_pool_->submit(std::bind(&LidarDriverImpl<T_PointCloud>::drainPackets, this));
+  }
+}
+
+template <typename T_PointCloud>
+inline void LidarDriverImpl<T_PointCloud>::drainPackets()
+{
+  // handle a batch, then give way to the other drivers.
+  constexpr static int PACKET_BATCH_MAX = 64;
+
+  for (int i = 0; (i < PACKET_BATCH_MAX) && !to_exit_handle_; i++)
+  {
+    std::shared_ptr<Buffer> pkt = pkt_queue_.pop();
+    if (pkt.get() == NULL)
     {
-      decoder_ptr_->processDifopPkt(pkt->data(), pkt->dataSize());
-      runPacketCallBack(pkt->data(), pkt->dataSize(), 0, true, false); // difop packet
+      break;
     }
 
-    free_pkt_queue_.push(pkt);
+    handlePacket(pkt);
+  }
+
+  handle_scheduled_ = false;
+
+  // packets may have come after the last pop().
+  if (!pkt_queue_.empty() && !to_exit_handle_)
+  {
+    schedulePackets();
+  }
+
+  // the last access to this driver. stop() may return, and the driver be destructed, after it.
+  std::lock_guard<std::mutex> lg(drain_mtx_);
+  drain_num_--;
+  drain_cv_.notify_all();
+}
+
+template <typename T_PointCloud>
+inline void LidarDriverImpl<T_PointCloud>::handlePacket(std::shared_ptr<Buffer> pkt)
+{
+  uint8_t* id = pkt->data();
+
+#ifdef ENABLE_ALLOC_TRACKING
+  uint64_t pkt_allocs = pkt->allocs;
+  uint64_t pkt_begin = AllocTracker::threadCount();
+  pkt_alloc_begin_ = pkt_begin;
+  frame_allocs_ += pkt_allocs;
+#endif
+
+#ifdef ENABLE_LATENCY_STATS
+  uint64_t dequeue_ns = latencyNow();
+  latency_stats_.record(LAT_QUEUE, pkt->enqueue_ns, dequeue_ns);
+  cur_recv_ns_ = pkt->recv_ns;
+#endif
+
+  if (*id == 0x55)
+  {
+    RS_TRACE_SCOPE("msop");
+
+    if (window_ptr_)
+    {
+      window_ptr_->beginPacket();
+    }
+
+    auto decode_begin = std::chrono::steady_clock::now();
+    pkt_decode_begin_ = decode_begin; // moved by splitFrame(), to exclude the callbacks
+    bool pkt_to_split = decoder_ptr_->processMsopPkt(pkt->data(), pkt->dataSize());
+    msop_pkts_.add(1);
+
+    auto decode_end = std::chrono::steady_clock::now();
+    decode_ns_.add((uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+          decode_end - decode_begin).count());
+    frame_decode_ns_ += (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+          decode_end - pkt_decode_begin_).count();
+
+#ifdef ENABLE_LATENCY_STATS
+    uint64_t decoded_ns = latencyNow();
+    latency_stats_.record(LAT_DECODE, dequeue_ns, decoded_ns);
+    dumpLatencyStats(decoded_ns);
+#endif
+
+    if (window_ptr_)
+    {
+      window_ptr_->endPacket(*(decoder_ptr_->point_cloud_), decoder_ptr_->prevPktTs());
+      decoder_ptr_->point_cloud_->points.resize(0);
+    }
+    runPacketCallBack(pkt->data(), pkt->dataSize(), decoder_ptr_->prevPktTs(), false, pkt_to_split); // msop packet
+
+    if (recorder_ptr_)
+    {
+      recorder_ptr_->record(pkt->data(), pkt->dataSize(), false);
+    }
   }
+  else if (*id == 0xA5)
+  {
+    RS_TRACE_SCOPE("difop");
+
+    decoder_ptr_->processDifopPkt(pkt->data(), pkt->dataSize());
+    difop_pkts_.add(1);
+    runPacketCallBack(pkt->data(), pkt->dataSize(), 0, true, false); // difop packet
+
+    if (recorder_ptr_)
+    {
+      recorder_ptr_->record(pkt->data(), pkt->dataSize(), true);
+    }
+  }
+
+  free_pkt_queue_.push(pkt);
+
+  // the reading thread waits for it in packetPut().
+  if (replay_fast_ && pkt_queue_.empty())
+  {
+    std::lock_guard<std::mutex> lg(replay_mtx_);
+    replay_cv_.notify_one();
+  }
+
+#ifdef ENABLE_ALLOC_TRACKING
+  allocPacket(pkt_allocs + AllocTracker::threadCount() - pkt_begin);
+#endif
 }
 
 template <typename T_PointCloud>
 void LidarDriverImpl<T_PointCloud>::splitFrame(uint16_t height, double ts)
 {
+#ifdef ENABLE_LATENCY_STATS
+  uint64_t split_ns = latencyNow();
+#endif
+
+  RS_TRACE_SCOPE("split");
+
+  decoder_ptr_->endFrame(frame_quality_);
+  if (frame_quality_.lost_pkts > 0)
+  {
+    lossy_frames_.add(1);
+  }
+
+  // the frame is decoded with the modes before degradeFrame().
+  bool dense = decoder_ptr_->densePoints();
+  degradeFrame(ts);
+
+  if (window_ptr_)
+  {
+    // a whole round is in the window. No point cloud per frame.
+    window_ptr_->setComplete();
+#ifdef ENABLE_ALLOC_TRACKING
+    allocFrame();
+#endif
+    return;
+  }
+
   std::shared_ptr<T_PointCloud> cloud = decoder_ptr_->point_cloud_;
+
+  if (cb_put_sector_)
+  {
+    splitSector(true);
+    sector_begin_ = 0;
+    sector_idx_ = 0;
+
+    // a larger frame next time, or even a frame not fitting in the reserved capacity.
+    size_t points = cloud->points.size();
+    if (points + decoder_ptr_->pointsPerPkt() > sector_reserve_)
+    {
+      sector_reserve_ = std::max(sector_reserve_ * 2, points + points / 4);
+    }
+
+    // the next cloud is not referred to by any sector yet.
+    decoder_ptr_->fixCloudCapacity(false);
+  }
   if (cloud->points.size() > 0)
   {
-    setPointCloudHeader(cloud, height, ts);
-    cb_put_cloud_(cloud);
+    setPointCloudHeader(cloud, height, ts, dense);
+    setQuality(*cloud, frame_quality_);
+    frames_.add(1);
+    points_.add(cloud->points.size());
+    last_frame_points_.set(cloud->points.size());
+
+#ifdef ENABLE_LATENCY_STATS
+    uint64_t callback_ns = latencyNow();
+    latency_stats_.record(LAT_SPLIT, split_ns, callback_ns);
+    latency_stats_.record(LAT_TOTAL, cur_recv_ns_, callback_ns);
+#endif
+
+    {
+      RS_TRACE_SCOPE("cloud_callback");
+      cb_put_cloud_(cloud);
+    }
+
+#ifdef ENABLE_LATENCY_STATS
+    latency_stats_.record(LAT_CALLBACK, callback_ns, latencyNow());
+#endif
+
     decoder_ptr_->point_cloud_ = getPointCloud();
   }
   else
   {
+    empty_frames_.add(1);
     runExceptionCallback(Error(ERRCODE_ZEROPOINTS));
   }
+
+#ifdef ENABLE_ALLOC_TRACKING
+  allocFrame();
+#endif
+
+  pkt_decode_begin_ = std::chrono::steady_clock::now();
+}
+
+#ifdef ENABLE_ALLOC_TRACKING
+template <typename T_PointCloud>
+void LidarDriverImpl<T_PointCloud>::allocPacket(uint64_t allocs)
+{
+  allocs_.add(allocs);
+  frame_allocs_ += AllocTracker::threadCount() - pkt_alloc_begin_;
+
+  if (alloc_frames_ < driver_param_.alloc_param.warmup_frames)
+  {
+    return;
+  }
+
+  if (allocs > max_pkt_allocs_.get())
+  {
+    max_pkt_allocs_.set(allocs);
+  }
+
+  int32_t limit = driver_param_.alloc_param.max_pkt_allocs;
+  if ((limit >= 0) && (allocs > (uint64_t)limit))
+  {
+    allocExceeded("packet", allocs, limit);
+  }
+}
+
+template <typename T_PointCloud>
+void LidarDriverImpl<T_PointCloud>::allocFrame()
+{
+  // the rest of the packet goes with the next frame.
+  uint64_t now_allocs = AllocTracker::threadCount();
+  uint64_t allocs = frame_allocs_ + now_allocs - pkt_alloc_begin_;
+  frame_allocs_ = 0;
+  pkt_alloc_begin_ = now_allocs;
+
+  last_frame_allocs_.set(allocs);
+  if (++alloc_frames_ <= driver_param_.alloc_param.warmup_frames)
+  {
+    return;
+  }
+
+  if (allocs > max_frame_allocs_.get())
+  {
+    max_frame_allocs_.set(allocs);
+  }
+
+  int32_t limit = driver_param_.alloc_param.max_frame_allocs;
+  if ((limit >= 0) && (allocs > (uint64_t)limit))
+  {
+    allocExceeded("frame", allocs, limit);
+  }
+}
+
+template <typename T_PointCloud>
+void LidarDriverImpl<T_PointCloud>::allocExceeded(const char* what, uint64_t allocs, int32_t limit)
+{
+  if (driver_param_.alloc_param.abort_on_exceed)
+  {
+    RS_ERROR << "Heap allocations of a " << what << " (" << allocs << ") exceed the steady state (" 
+             << limit << "). Abort." << RS_REND;
+    runExceptionCallback(Error(ERRCODE_ALLOCEXCEEDED));
+    std::abort();
+  }
+
+  err_limiter_.call(cb_excep_, ERRCODE_ALLOCEXCEEDED, 1);
+}
+#endif
+
+template <typename T_PointCloud>
+void LidarDriverImpl<T_PointCloud>::degradeFrame(double ts)
+{
+  constexpr static double FRAME_PERIOD_DEFAULT = 0.1;
+
+  auto now = std::chrono::steady_clock::now();
+  uint64_t decode_ns = frame_decode_ns_ + (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+      now - pkt_decode_begin_).count();
+  frame_decode_ns_ = 0;
+  pkt_decode_begin_ = now;
+
+  double period = ts - prev_frame_ts_;
+  if ((period <= 0) || (period > 1.0))
+  {
+    period = FRAME_PERIOD_DEFAULT;
+  }
+  prev_frame_ts_ = ts;
+
+  bool overflowed = pkt_overflowed_.exchange(false);
+  uint8_t prev_modes = degrade_.modes();
+  if (!degrade_.newFrame(decode_ns * 1e-9, period, overflowed))
+  {
+    return;
+  }
+
+  uint8_t modes = degrade_.modes();
+  decoder_ptr_->setDegrade(modes);
+  degrade_modes_.set(modes);
+  degrade_changes_.set(degrade_.changes());
+
+  if (modes > prev_modes)
+  {
+    RS_WARNING << "Decoding overloaded (" << decode_ns / 1000 << " us in a frame of " << period * 1e6 
+               << " us). Degrade to " << degradeModesToStr(modes) << RS_REND;
+    runExceptionCallback(Error(ERRCODE_DECODEDEGRADE));
+  }
+  else
+  {
+    RS_INFO << "Decoding recovered. Degrade to " << degradeModesToStr(modes) << RS_REND;
+    runExceptionCallback(Error(ERRCODE_DECODERECOVER));
+  }
+}
+
+template <typename T_PointCloud>
+void LidarDriverImpl<T_PointCloud>::splitSector(bool last)
+{
+  std::shared_ptr<T_PointCloud> cloud = decoder_ptr_->point_cloud_;
+  size_t end = cloud->points.size();
+
+  if (end > sector_begin_)
+  {
+    // the points of the sector may be read by other threads. Never reallocate them.
+    if (!last && !decoder_ptr_->cloudFixed())
+    {
+      // as estimated by the decoder at first. Learn from the frames later.
+      cloud->points.reserve(std::max(sector_reserve_, decoder_ptr_->framePoints()));
+      decoder_ptr_->fixCloudCapacity(true);
+    }
+
+    PointCloudSector<T_PointCloud> sector;
+    sector.cloud = cloud;
+    sector.begin = sector_begin_;
+    sector.end = end;
+    sector.frame_seq = point_cloud_seq_; // seq of the frame, when it is delivered.
+    sector.sector_idx = sector_idx_;
+    sector.last = last;
+
+    RS_TRACE_SCOPE("sector_callback");
+    cb_put_sector_(sector);
+  }
+
+  sector_begin_ = end;
+  sector_idx_++;
 }
 
 template <typename T_PointCloud>
 void LidarDriverImpl<T_PointCloud>::setPointCloudHeader(std::shared_ptr<T_PointCloud> msg, 
-    uint16_t height, double ts)
+    uint16_t height, double ts, bool dense)
 {
   msg->seq = point_cloud_seq_++;
   msg->timestamp = ts;
-  msg->is_dense = driver_param_.decoder_param.dense_points;
+  msg->is_dense = dense;
   if (msg->is_dense)
   {
     msg->height = 1;
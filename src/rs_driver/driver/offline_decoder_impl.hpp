@@ -0,0 +1,298 @@
+/*********************************************************************************************************************
+Copyright (c) 2020 RoboSense
+All rights reserved
+
+By downloading, copying, installing or using the software you agree to this license. If you do not agree to this
+license, do not download, install, copy or use the software.
+
+License Agreement
+For RoboSense LiDAR SDK Library
+(3-clause BSD License)
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that the
+following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following
+disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following
+disclaimer in the documentation and/or other materials provided with the distribution.
+
+3. Neither the names of the RoboSense, nor Suteng Innovation Technology, nor the names of other contributors may be used
+to endorse or promote products derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*********************************************************************************************************************/
+
+
+#pragma once
+
+#include <rs_driver/driver/driver_param.hpp>
+#include <rs_driver/common/error_code.hpp>
+#include <rs_driver/utility/buffer.hpp>
+#include <rs_driver/driver/input/input_factory.hpp>
+#include <rs_driver/driver/decoder/decoder_factory.hpp>
+
+#include <deque>
+
+namespace robosense
+{
+namespace lidar
+{
+
+//
+// Decode a PCAP file or a log file in the caller's thread. 
+// No receiving/handling thread, no packet queue, and no sleeping.
+//
+template <typename T_PointCloud>
+class OfflineDecoderImpl
+{
+public:
+
+  OfflineDecoderImpl();
+  ~OfflineDecoderImpl();
+
+  void regExceptionCallback(const std::function<void(const Error&)>& cb_excep);
+
+  bool open(const RSDriverParam& param);
+  bool nextFrame(std::shared_ptr<T_PointCloud>& cloud);
+  void close();
+
+  bool getTemperature(float& temp);
+
+private:
+
+  void runExceptionCallback(const Error& error);
+
+  std::shared_ptr<Buffer> packetGet(size_t size);
+  void packetPut(std::shared_ptr<Buffer> pkt, bool stuffed);
+
+  std::shared_ptr<T_PointCloud> getPointCloud();
+  void splitFrame(uint16_t height, double ts);
+
+  RSDriverParam driver_param_;
+  std::function<void(const Error&)> cb_excep_;
+  std::function<void(const uint8_t*, size_t)> cb_feed_pkt_;
+
+  std::shared_ptr<Input> input_ptr_;
+  std::shared_ptr<Decoder<T_PointCloud>> decoder_ptr_;
+  std::shared_ptr<Buffer> pkt_buf_;
+  std::shared_ptr<T_PointCloud> free_cloud_;
+  std::deque<std::shared_ptr<T_PointCloud>> frames_;
+  uint32_t point_cloud_seq_;
+  bool init_flag_;
+};
+
+template <typename T_PointCloud>
+inline OfflineDecoderImpl<T_PointCloud>::OfflineDecoderImpl()
+  : point_cloud_seq_(0), init_flag_(false)
+{
+}
+
+template <typename T_PointCloud>
+inline OfflineDecoderImpl<T_PointCloud>::~OfflineDecoderImpl()
+{
+  close();
+}
+
+template <typename T_PointCloud>
+inline void OfflineDecoderImpl<T_PointCloud>::regExceptionCallback(
+    const std::function<void(const Error&)>& cb_excep)
+{
+  cb_excep_ = cb_excep;
+}
+
+template <typename T_PointCloud>
+inline bool OfflineDecoderImpl<T_PointCloud>::open(const RSDriverParam& param)
+{
+  close();
+
+  if ((param.input_type != InputType::PCAP_FILE) && (param.input_type != InputType::LOG_FILE))
+  {
+    RS_ERROR << "OfflineDecoder supports only PCAP_FILE and LOG_FILE." << RS_REND;
+    return false;
+  }
+
+  driver_param_ = param;
+
+  // host time differs from run to run. Use lidar time, so the result is reproducible.
+  driver_param_.decoder_param.use_lidar_clock = true;
+
+  //
+  // decoder
+  //
+  decoder_ptr_ = DecoderFactory<T_PointCloud>::createDecoder(driver_param_.lidar_type, driver_param_.decoder_param);
+  decoder_ptr_->enableWritePktTs(false);
+  decoder_ptr_->point_cloud_ = getPointCloud();
+  decoder_ptr_->regCallback( 
+      std::bind(&OfflineDecoderImpl<T_PointCloud>::runExceptionCallback, this, std::placeholders::_1),
+      std::bind(&OfflineDecoderImpl<T_PointCloud>::splitFrame, this, std::placeholders::_1, std::placeholders::_2));
+
+  //
+  // input
+  //
+  input_ptr_ = InputFactory::createInput(driver_param_.input_type, driver_param_.input_param, 
+      isJumbo(driver_param_.lidar_type), 0, cb_feed_pkt_);
+  input_ptr_->regCallback(
+      std::bind(&OfflineDecoderImpl<T_PointCloud>::runExceptionCallback, this, std::placeholders::_1), 
+      std::bind(&OfflineDecoderImpl<T_PointCloud>::packetGet, this, std::placeholders::_1), 
+      std::bind(&OfflineDecoderImpl<T_PointCloud>::packetPut, this, std::placeholders::_1, std::placeholders::_2));
+
+  if (!input_ptr_->init())
+  {
+    goto failInputInit;
+  }
+
+  point_cloud_seq_ = 0;
+  init_flag_ = true;
+  return true;
+
+failInputInit:
+  input_ptr_.reset();
+  decoder_ptr_.reset();
+  return false;
+}
+
+template <typename T_PointCloud>
+inline void OfflineDecoderImpl<T_PointCloud>::close()
+{
+  input_ptr_.reset();
+  decoder_ptr_.reset();
+  frames_.clear();
+  init_flag_ = false;
+}
+
+template <typename T_PointCloud>
+inline bool OfflineDecoderImpl<T_PointCloud>::nextFrame(std::shared_ptr<T_PointCloud>& cloud)
+{
+  if (!init_flag_)
+  {
+    return false;
+  }
+
+  // recycle the caller's cloud for the next frame, unless the caller keeps another copy of it.
+  if (cloud && (cloud.use_count() == 1))
+  {
+    free_cloud_ = cloud;
+  }
+  cloud.reset();
+
+  while (frames_.empty())
+  {
+    if (!input_ptr_->readPacket())
+    {
+      return false;
+    }
+  }
+
+  cloud = frames_.front();
+  frames_.pop_front();
+  return true;
+}
+
+template <typename T_PointCloud>
+inline bool OfflineDecoderImpl<T_PointCloud>::getTemperature(float& temp)
+{
+  if (decoder_ptr_ == nullptr)
+  {
+    return false;
+  }
+
+  temp = decoder_ptr_->getTemperature();
+  return true;
+}
+
+template <typename T_PointCloud>
+inline void OfflineDecoderImpl<T_PointCloud>::runExceptionCallback(const Error& error)
+{
+  if (cb_excep_)
+  {
+    cb_excep_(error);
+  }
+}
+
+template <typename T_PointCloud>
+inline std::shared_ptr<Buffer> OfflineDecoderImpl<T_PointCloud>::packetGet(size_t size)
+{
+  if (!pkt_buf_ || (pkt_buf_->bufSize() < size))
+  {
+    pkt_buf_ = std::make_shared<Buffer>(size);
+  }
+
+  return pkt_buf_;
+}
+
+template <typename T_PointCloud>
+inline void OfflineDecoderImpl<T_PointCloud>::packetPut(std::shared_ptr<Buffer> pkt, bool stuffed)
+{
+  if (!stuffed)
+  {
+    return;
+  }
+
+  uint8_t* id = pkt->data();
+  if (*id == 0x55)
+  {
+    decoder_ptr_->processMsopPkt(pkt->data(), pkt->dataSize());
+  }
+  else if (*id == 0xA5)
+  {
+    decoder_ptr_->processDifopPkt(pkt->data(), pkt->dataSize());
+  }
+}
+
+template <typename T_PointCloud>
+inline std::shared_ptr<T_PointCloud> OfflineDecoderImpl<T_PointCloud>::getPointCloud()
+{
+  std::shared_ptr<T_PointCloud> cloud;
+  cloud.swap(free_cloud_);
+
+  if (!cloud)
+  {
+    cloud = std::make_shared<T_PointCloud>();
+  }
+
+  cloud->points.resize(0);
+  return cloud;
+}
+
+template <typename T_PointCloud>
+inline void OfflineDecoderImpl<T_PointCloud>::splitFrame(uint16_t height, double ts)
+{
+  FrameQuality quality;
+  decoder_ptr_->endFrame(quality);
+
+  std::shared_ptr<T_PointCloud> cloud = decoder_ptr_->point_cloud_;
+  if (cloud->points.size() == 0)
+  {
+    runExceptionCallback(Error(ERRCODE_ZEROPOINTS));
+    return;
+  }
+
+  setQuality(*cloud, quality);
+  cloud->seq = point_cloud_seq_++;
+  cloud->timestamp = ts;
+  cloud->is_dense = driver_param_.decoder_param.dense_points;
+  if (cloud->is_dense)
+  {
+    cloud->height = 1;
+    cloud->width = (uint32_t)cloud->points.size();
+  }
+  else
+  {
+    cloud->height = height;
+    cloud->width = (uint32_t)cloud->points.size() / cloud->height;
+  }
+
+  frames_.push_back(cloud);
+  decoder_ptr_->point_cloud_ = getPointCloud();
+}
+
+}  // namespace lidar
+}  // namespace robosense
@@ -0,0 +1,801 @@
+/*********************************************************************************************************************
+Copyright (c) 2020 RoboSense
+All rights reserved
+
+By downloading, copying, installing or using the software you agree to this license. If you do not agree to this
+license, do not download, install, copy or use the software.
+
+License Agreement
+For RoboSense LiDAR SDK Library
+(3-clause BSD License)
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that the
+following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following
+disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following
+disclaimer in the documentation and/or other materials provided with the distribution.
+
+3. Neither the names of the RoboSense, nor Suteng Innovation Technology, nor the names of other contributors may be used
+to endorse or promote products derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*********************************************************************************************************************/
+
+#pragma once
+
+#include <memory>
+#include <cstring>
+
+#include <rs_driver/driver/driver_param.hpp>
+#include <rs_driver/common/error_code.hpp>
+#include <rs_driver/driver/decoder/basic_attr.hpp>
+#include <rs_driver/driver/input/input.hpp>
+#include <rs_driver/driver/input/jumbo.hpp>
+#include <rs_driver/utility/sync_queue.hpp>
+#include <rs_driver/utility/packet_log.hpp>
+
+#include <fcntl.h>
+#include <sys/stat.h>
+
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+#include <atomic>
+#include <functional>
+#include <sstream>
+#include <iomanip>
+#include <cstring>
+#include <cstdlib>
+#include <cerrno>
+#include <ctime>
+
+namespace robosense
+{
+namespace lidar
+{
+
+#pragma pack(push, 1)
+
+struct PcapFileHeader
+{
+  uint32_t magic;
+  uint16_t version_major;
+  uint16_t version_minor;
+  int32_t thiszone;
+  uint32_t sigfigs;
+  uint32_t snaplen;
+  uint32_t linktype;
+};
+
+struct PcapRecordHeader
+{
+  uint32_t ts_sec;
+  uint32_t ts_usec;
+  uint32_t caplen;
+  uint32_t len;
+};
+
+struct EthHeader
+{
+  uint8_t dst[6];
+  uint8_t src[6];
+  uint16_t type;
+};
+
+struct UdpPktHeader
+{
+  EthHeader eth;
+  iphdr ip;
+  udphdr udp;
+};
+
+#pragma pack(pop)
+
+struct RecordStats
+{
+  uint64_t packets = 0;   ///< Packets recorded
+  uint64_t dropped = 0;   ///< Packets dropped because all write buffers are full
+  uint64_t bytes = 0;     ///< Bytes written to record files
+  uint32_t files = 0;     ///< Record files created
+};
+
+//
+// Record MSOP/DIFOP packets into files, in PCAP format or rs_driver log format.
+//
+// The caller (the handle thread) copies packets into large preallocated write buffers, 
+// and the write thread flushes full buffers with big sequential writes. 
+// If all the buffers are full, the packet is dropped, so recording never blocks the caller.
+// In log format, every buffer is written as a compressed chunk, so records never span buffers.
+//
+class Recorder
+{
+public:
+
+  constexpr static size_t IO_ALIGN = 4096;
+  constexpr static size_t BUF_SIZE_MIN = 262144;
+
+  Recorder(const RSRecordParam& param, const RSInputParam& input_param);
+  ~Recorder();
+
+  void regCallback(const std::function<void(const Error&)>& cb_excep);
+  bool init();
+  bool start();
+  void stop();
+
+  void record(const uint8_t* data, size_t size, bool is_difop);
+  RecordStats getStats() const;
+
+#ifndef UNIT_TEST
+private:
+#endif
+
+  struct RecordBuffer
+  {
+    uint8_t* data;
+    size_t size;
+    size_t used;
+    bool first; // first buffer of the file. In PCAP format, it starts with the file header.
+    bool last; // last buffer of the file
+    uint32_t pkt_num;
+    uint64_t ts_first;
+    uint64_t ts_last;
+  };
+
+  bool reserve(size_t len);
+  bool reserveChunk(size_t len);
+  void append(const void* data, size_t len);
+  void handOver(RecordBuffer* buf, bool last);
+  bool toRotate(size_t rec_len, uint64_t ts);
+  void appendPcapFileHeader();
+  void appendPcapRecord(const uint8_t* data, size_t size, bool is_difop, uint64_t ts);
+  void appendLogRecord(const uint8_t* data, size_t size, bool is_difop, uint64_t ts);
+
+  void writeFiles();
+  bool openFile();
+  void closeFile();
+  bool writeData(const uint8_t* data, size_t size);
+  void writeBuffer(RecordBuffer* buf);
+
+  static uint8_t* allocAligned(size_t size);
+  static void freeAligned(uint8_t* p);
+  static uint16_t ipChecksum(const uint8_t* data, size_t size);
+
+  RSRecordParam param_;
+  RSInputParam input_param_;
+  std::function<void(const Error&)> cb_excep_;
+  ErrorLimiter err_limiter_;
+
+  std::vector<RecordBuffer> bufs_;
+  SyncQueue<RecordBuffer*> free_queue_;
+  SyncQueue<RecordBuffer*> full_queue_;
+
+  // used by the caller thread
+  RecordBuffer* cur_;
+  RecordBuffer* next_;
+  bool new_file_;
+  uint64_t file_bytes_;
+  uint64_t file_start_ts_;
+  UdpPktHeader udp_hdr_;
+  uint16_t ip_id_;
+
+  // used by the write thread
+  int fd_;
+  PacketLogWriter log_writer_;
+  bool direct_io_;
+  uint32_t file_seq_;
+  std::string file_prefix_;
+
+  std::atomic<bool> file_broken_; // the file is closed on error. The next record starts a new one.
+
+  std::thread write_thread_;
+  bool to_exit_write_;
+  bool init_flag_;
+  bool start_flag_;
+
+  std::atomic<uint64_t> packets_;
+  std::atomic<uint64_t> dropped_;
+  std::atomic<uint64_t> bytes_;
+  std::atomic<uint32_t> files_;
+};
+
+inline Recorder::Recorder(const RSRecordParam& param, const RSInputParam& input_param)
+  : param_(param), input_param_(input_param), cur_(NULL), next_(NULL), new_file_(true), 
+    file_bytes_(0), file_start_ts_(0), ip_id_(0), fd_(-1), direct_io_(false), file_seq_(0),
+    file_broken_(false), to_exit_write_(false), init_flag_(false), start_flag_(false),
+    packets_(0), dropped_(0), bytes_(0), files_(0)
+{
+  // every buffer should be able to hold the biggest packet, and be aligned for O_DIRECT.
+  // in log format, a buffer is written as a chunk.
+  size_t buf_size = (param_.buf_size < BUF_SIZE_MIN) ? BUF_SIZE_MIN : (size_t)param_.buf_size;
+  if (buf_size > LOG_MAX_CHUNK_SIZE)
+  {
+    buf_size = LOG_MAX_CHUNK_SIZE;
+  }
+  param_.buf_size = (uint32_t)((buf_size + IO_ALIGN - 1) / IO_ALIGN * IO_ALIGN);
+
+  if (param_.buf_num < 2)
+  {
+    param_.buf_num = 2;
+  }
+
+  const static uint8_t lidar_mac[6] = {0x40, 0x2c, 0x76, 0x08, 0x4a, 0xcc};
+  const static uint8_t host_mac[6] = {0xff, 0xff, 0xff, 0xff, 0xff, 0xff};
+
+  memset (&udp_hdr_, 0, sizeof(udp_hdr_));
+  memcpy (udp_hdr_.eth.dst, host_mac, 6);
+  memcpy (udp_hdr_.eth.src, lidar_mac, 6);
+  udp_hdr_.eth.type = htons(0x0800);
+  udp_hdr_.ip.version = 0x45; // ipv4, 20 bytes header
+  udp_hdr_.ip.frag_off = htons(0x4000); // don't fragment
+  udp_hdr_.ip.ttl = 64;
+  udp_hdr_.ip.protocol = 0x11; // udp
+  inet_pton(AF_INET, "192.168.1.200", &udp_hdr_.ip.saddr);
+  inet_pton(AF_INET, "192.168.1.102", &udp_hdr_.ip.daddr);
+}
+
+inline Recorder::~Recorder()
+{
+  stop();
+
+  for (auto& buf : bufs_)
+  {
+    freeAligned(buf.data);
+  }
+}
+
+inline void Recorder::regCallback(const std::function<void(const Error&)>& cb_excep)
+{
+  cb_excep_ = cb_excep;
+}
+
+inline bool Recorder::init()
+{
+  if (init_flag_)
+  {
+    return true;
+  }
+
+  if (param_.record_format == RECORD_LOG)
+  {
+    if (param_.use_direct_io)
+    {
+      RS_WARNING << "use_direct_io is ignored for RECORD_LOG." << RS_REND;
+      param_.use_direct_io = false;
+    }
+
+    if (!isLogCodecSupported(param_.log_codec))
+    {
+      RS_WARNING << logCodecToStr(param_.log_codec) << " is not compiled in. Record without compression." << RS_REND;
+      param_.log_codec = LOG_CODEC_NONE;
+    }
+  }
+
+  bufs_.resize(param_.buf_num);
+  for (auto& buf : bufs_)
+  {
+    buf.data = allocAligned(param_.buf_size);
+    if (buf.data == NULL)
+    {
+      RS_ERROR << "Fail to allocate record buffers." << RS_REND;
+      return false;
+    }
+
+    buf.size = param_.buf_size;
+    buf.used = 0;
+    buf.first = false;
+    buf.last = false;
+    buf.pkt_num = 0;
+    free_queue_.push(&buf);
+  }
+
+  init_flag_ = true;
+  return true;
+}
+
+inline bool Recorder::start()
+{
+  if (start_flag_)
+  {
+    return true;
+  }
+
+  if (!init_flag_)
+  {
+    return false;
+  }
+
+  time_t tm = time(NULL);
+  char tm_str[32];
+  strftime(tm_str, sizeof(tm_str), "%Y%m%d_%H%M%S", localtime(&tm));
+  file_prefix_ = param_.record_path + "_" + tm_str;
+  file_seq_ = 0;
+  new_file_ = true;
+  file_broken_ = false;
+
+  to_exit_write_ = false;
+  write_thread_ = std::thread(std::bind(&Recorder::writeFiles, this));
+
+  start_flag_ = true;
+  return true;
+}
+
+inline void Recorder::stop()
+{
+  if (!start_flag_)
+  {
+    return;
+  }
+
+  if (cur_ != NULL)
+  {
+    handOver(cur_, true);
+    cur_ = NULL;
+  }
+
+  if (next_ != NULL)
+  {
+    free_queue_.push(next_);
+    next_ = NULL;
+  }
+  new_file_ = true;
+
+  to_exit_write_ = true;
+  write_thread_.join();
+
+  start_flag_ = false;
+}
+
+inline RecordStats Recorder::getStats() const
+{
+  RecordStats stats;
+  stats.packets = packets_.load(std::memory_order_relaxed);
+  stats.dropped = dropped_.load(std::memory_order_relaxed);
+  stats.bytes = bytes_.load(std::memory_order_relaxed);
+  stats.files = files_.load(std::memory_order_relaxed);
+  return stats;
+}
+
+inline void Recorder::record(const uint8_t* data, size_t size, bool is_difop)
+{
+  uint64_t ts = getTimeHost();
+  bool is_log = (param_.record_format == RECORD_LOG);
+  size_t rec_len = is_log ? PacketLogWriter::recordSize(size) : 
+    (sizeof(PcapRecordHeader) + sizeof(UdpPktHeader) + size);
+
+  // no buffer to close the file with, if all are in flight. Rotate when there is one.
+  if (!new_file_ && (cur_ != NULL) && (file_broken_.exchange(false) || toRotate(rec_len, ts)))
+  {
+    handOver(cur_, true);
+    cur_ = NULL;
+    new_file_ = true;
+  }
+
+  size_t hdr_len = (new_file_ && !is_log) ? sizeof(PcapFileHeader) : 0;
+  bool reserved = is_log ? reserveChunk(rec_len) : reserve(hdr_len + rec_len);
+  if ((hdr_len + rec_len > param_.buf_size) || !reserved)
+  {
+    dropped_.fetch_add(1, std::memory_order_relaxed);
+    err_limiter_.call(cb_excep_, ERRCODE_RECORDOVERFLOW, 1);
+    return;
+  }
+
+  if (new_file_)
+  {
+    cur_->first = true;
+    if (!is_log)
+    {
+      appendPcapFileHeader();
+    }
+    file_bytes_ = hdr_len;
+    file_start_ts_ = ts;
+    new_file_ = false;
+  }
+
+  if (is_log)
+  {
+    appendLogRecord(data, size, is_difop, ts);
+  }
+  else
+  {
+    appendPcapRecord(data, size, is_difop, ts);
+  }
+
+  file_bytes_ += rec_len;
+  packets_.fetch_add(1, std::memory_order_relaxed);
+}
+
+inline bool Recorder::toRotate(size_t rec_len, uint64_t ts)
+{
+  if ((param_.file_size_max > 0) && 
+      (file_bytes_ + rec_len > (uint64_t)param_.file_size_max * 1024 * 1024))
+  {
+    return true;
+  }
+
+  if ((param_.file_duration_max > 0) && 
+      (ts - file_start_ts_ >= (uint64_t)param_.file_duration_max * 1000000))
+  {
+    return true;
+  }
+
+  return false;
+}
+
+inline bool Recorder::reserve(size_t len)
+{
+  if (cur_ == NULL)
+  {
+    cur_ = free_queue_.pop();
+    if (cur_ == NULL)
+    {
+      return false;
+    }
+
+    cur_->used = 0;
+    cur_->first = false;
+    cur_->last = false;
+  }
+
+  if (cur_->size - cur_->used >= len)
+  {
+    return true;
+  }
+
+  // the data spans two buffers.
+  if (next_ == NULL)
+  {
+    next_ = free_queue_.pop();
+    if (next_ == NULL)
+    {
+      return false;
+    }
+
+    next_->used = 0;
+    next_->first = false;
+    next_->last = false;
+  }
+
+  return true;
+}
+
+inline bool Recorder::reserveChunk(size_t len)
+{
+  if ((cur_ != NULL) && (cur_->size - cur_->used < len))
+  {
+    handOver(cur_, false);
+    cur_ = NULL;
+  }
+
+  if (cur_ == NULL)
+  {
+    cur_ = free_queue_.pop();
+    if (cur_ == NULL)
+    {
+      return false;
+    }
+
+    cur_->used = 0;
+    cur_->first = false;
+    cur_->last = false;
+    cur_->pkt_num = 0;
+  }
+
+  return (cur_->size - cur_->used >= len);
+}
+
+inline void Recorder::append(const void* data, size_t len)
+{
+  const uint8_t* p = (const uint8_t*)data;
+
+  while (len > 0)
+  {
+    size_t n = std::min(len, cur_->size - cur_->used);
+    memcpy (cur_->data + cur_->used, p, n);
+    cur_->used += n;
+    p += n;
+    len -= n;
+
+    if (len > 0)
+    {
+      handOver(cur_, false);
+      cur_ = next_;
+      next_ = NULL;
+    }
+  }
+}
+
+inline void Recorder::handOver(RecordBuffer* buf, bool last)
+{
+  buf->last = last;
+  full_queue_.push(buf);
+}
+
+inline void Recorder::appendPcapFileHeader()
+{
+  PcapFileHeader hdr;
+  hdr.magic = 0xa1b2c3d4;
+  hdr.version_major = 2;
+  hdr.version_minor = 4;
+  hdr.thiszone = 0;
+  hdr.sigfigs = 0;
+  hdr.snaplen = 262144;
+  hdr.linktype = 1; // ethernet
+
+  append(&hdr, sizeof(hdr));
+}
+
+inline void Recorder::appendPcapRecord(const uint8_t* data, size_t size, bool is_difop, uint64_t ts)
+{
+  PcapRecordHeader rec_hdr;
+  rec_hdr.ts_sec = (uint32_t)(ts / 1000000);
+  rec_hdr.ts_usec = (uint32_t)(ts % 1000000);
+  rec_hdr.caplen = (uint32_t)(sizeof(UdpPktHeader) + size);
+  rec_hdr.len = rec_hdr.caplen;
+  append(&rec_hdr, sizeof(rec_hdr));
+
+  uint16_t port = is_difop ? input_param_.difop_port : input_param_.msop_port;
+  udp_hdr_.ip.tot_len = htons((uint16_t)(sizeof(iphdr) + sizeof(udphdr) + size));
+  udp_hdr_.ip.id = htons(ip_id_++);
+  udp_hdr_.ip.check = 0;
+  udp_hdr_.ip.check = ipChecksum((const uint8_t*)&udp_hdr_.ip, sizeof(iphdr));
+  udp_hdr_.udp.source = htons(port);
+  udp_hdr_.udp.dest = htons(port);
+  udp_hdr_.udp.len = htons((uint16_t)(sizeof(udphdr) + size));
+  udp_hdr_.udp.check = 0;
+  append(&udp_hdr_, sizeof(udp_hdr_));
+
+  append(data, size);
+}
+
+inline void Recorder::appendLogRecord(const uint8_t* data, size_t size, bool is_difop, uint64_t ts)
+{
+  if (cur_->pkt_num == 0)
+  {
+    cur_->ts_first = ts;
+  }
+  cur_->ts_last = ts;
+  cur_->pkt_num++;
+
+  cur_->used += PacketLogWriter::encodeRecord(cur_->data + cur_->used, ts, 
+      is_difop ? LOG_PKT_DIFOP : LOG_PKT_MSOP, 0, data, size);
+}
+
+inline void Recorder::writeFiles()
+{
+  while (1)
+  {
+    RecordBuffer* buf = full_queue_.popWait(100000);
+    if (buf == NULL)
+    {
+      if (to_exit_write_)
+        break;
+
+      continue;
+    }
+
+    writeBuffer(buf);
+    if (buf->last)
+    {
+      closeFile();
+    }
+
+    free_queue_.push(buf);
+  }
+
+  closeFile();
+}
+
+inline bool Recorder::openFile()
+{
+  std::stringstream ss;
+  ss << file_prefix_ << "_" << std::setw(4) << std::setfill('0') << file_seq_++ 
+    << ((param_.record_format == RECORD_LOG) ? ".rslog" : ".pcap");
+  std::string path = ss.str();
+
+  if (param_.record_format == RECORD_LOG)
+  {
+    if (!log_writer_.open(path, param_.log_codec))
+    {
+      return false;
+    }
+
+    files_.fetch_add(1, std::memory_order_relaxed);
+    return true;
+  }
+
+  int flags = O_WRONLY | O_CREAT | O_TRUNC;
+#ifdef _WIN32
+  flags |= O_BINARY;
+#endif
+
+  direct_io_ = false;
+#ifdef O_DIRECT
+  if (param_.use_direct_io)
+  {
+    flags |= O_DIRECT;
+    direct_io_ = true;
+  }
+#endif
+
+  fd_ = open(path.c_str(), flags, 0644);
+#ifdef O_DIRECT
+  if ((fd_ < 0) && direct_io_)
+  {
+    // filesystem without O_DIRECT support
+    RS_WARNING << "Fail to open record file with O_DIRECT. Try without it." << RS_REND;
+    flags &= ~O_DIRECT;
+    direct_io_ = false;
+    fd_ = open(path.c_str(), flags, 0644);
+  }
+#endif
+
+  if (fd_ < 0)
+  {
+    RS_ERROR << "Fail to open record file: " << path << RS_REND;
+    return false;
+  }
+
+  files_.fetch_add(1, std::memory_order_relaxed);
+  return true;
+}
+
+inline void Recorder::closeFile()
+{
+  if (log_writer_.isOpen())
+  {
+    uint64_t bytes = log_writer_.bytes();
+    log_writer_.close();
+    bytes_.fetch_add(log_writer_.bytes() - bytes, std::memory_order_relaxed);
+  }
+
+  if (fd_ >= 0)
+  {
+    close(fd_);
+    fd_ = -1;
+  }
+}
+
+inline bool Recorder::writeData(const uint8_t* data, size_t size)
+{
+  while (size > 0)
+  {
+    int ret = (int)write(fd_, data, (unsigned int)size);
+    if (ret < 0)
+    {
+      if (errno == EINTR)
+        continue;
+
+      perror("write: ");
+      return false;
+    }
+
+    data += ret;
+    size -= ret;
+    bytes_.fetch_add(ret, std::memory_order_relaxed);
+  }
+
+  return true;
+}
+
+inline void Recorder::writeBuffer(RecordBuffer* buf)
+{
+  if (buf->used == 0)
+  {
+    return;
+  }
+
+  if (param_.record_format == RECORD_LOG)
+  {
+    if (!log_writer_.isOpen() && !openFile())
+    {
+      return;
+    }
+
+    uint64_t bytes = log_writer_.bytes();
+    bool ok = log_writer_.writeChunk(buf->data, buf->used, buf->pkt_num, buf->ts_first, buf->ts_last);
+    bytes_.fetch_add(log_writer_.bytes() - bytes, std::memory_order_relaxed);
+
+    if (!ok)
+    {
+      closeFile();
+    }
+    return;
+  }
+
+  if (fd_ < 0)
+  {
+    // the rest of a broken file, without the file header. Drop it.
+    if (!buf->first)
+    {
+      return;
+    }
+
+    if (!openFile())
+    {
+      file_broken_ = true;
+      return;
+    }
+  }
+
+  size_t aligned = buf->used;
+#ifdef O_DIRECT
+  if (direct_io_)
+  {
+    // only the last buffer of a file may be partial. Write its tail without O_DIRECT.
+    aligned = buf->used / IO_ALIGN * IO_ALIGN;
+  }
+#endif
+
+  bool ok = writeData(buf->data, aligned);
+
+#ifdef O_DIRECT
+  if (ok && (aligned < buf->used))
+  {
+    int flags = fcntl(fd_, F_GETFL);
+    fcntl(fd_, F_SETFL, flags & ~O_DIRECT);
+    direct_io_ = false;
+
+    ok = writeData(buf->data + aligned, buf->used - aligned);
+  }
+#endif
+
+  if (!ok)
+  {
+    closeFile();
+    file_broken_ = true;
+  }
+}
+
+inline uint8_t* Recorder::allocAligned(size_t size)
+{
+#ifdef _WIN32
+  return (uint8_t*)_aligned_malloc(size, IO_ALIGN);
+#else
+  void* p = NULL;
+  if (posix_memalign(&p, IO_ALIGN, size) != 0)
+  {
+    return NULL;
+  }
+  return (uint8_t*)p;
+#endif
+}
+
+inline void Recorder::freeAligned(uint8_t* p)
+{
+#ifdef _WIN32
+  _aligned_free(p);
+#else
+  free(p);
+#endif
+}
+
+inline uint16_t Recorder::ipChecksum(const uint8_t* data, size_t size)
+{
+  uint32_t sum = 0;
+  for (size_t i = 0; i + 1 < size; i += 2)
+  {
+    sum += (uint32_t)((data[i] << 8) | data[i + 1]);
+  }
+
+  while (sum >> 16)
+  {
+    sum = (sum & 0xFFFF) + (sum >> 16);
+  }
+
+  return htons((uint16_t)(~sum));
+}
+
+}  // namespace lidar
+}  // namespace robosense
@@ -0,0 +1,416 @@
+/*********************************************************************************************************************
+Copyright (c) 2020 RoboSense
+All rights reserved
+
+By downloading, copying, installing or using the software you agree to this license. If you do not agree to this
+license, do not download, install, copy or use the software.
+
+License Agreement
+For RoboSense LiDAR SDK Library
+(3-clause BSD License)
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that the
+following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following
+disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following
+disclaimer in the documentation and/or other materials provided with the distribution.
+
+3. Neither the names of the RoboSense, nor Suteng Innovation Technology, nor the names of other contributors may be used
+to endorse or promote products derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*********************************************************************************************************************/
+
+
+#pragma once
+
+#include <rs_driver/driver/decoder/member_checker.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace robosense
+{
+namespace lidar
+{
+
+//
+// A rolling 360 degree window of a mechanical Lidar. 
+// Its columns are indexed by azimuth, and the blocks of each new packet overwrite their columns in place.
+//
+// After each packet, the handling thread publishes the buffer it has written, and continues writing on another one. 
+// It copies into that buffer only the columns updated since the buffer was published last time.
+// snapshot() only hands out the published buffer. The caller returns it by releasing it, 
+// and the deleter of its shared_ptr puts it back to the pool.
+//
+template <typename T_PointCloud>
+class RollingWindow
+{
+public:
+
+  typedef typename T_PointCloud::PointT T_Point;
+
+  RollingWindow(float resolution);
+  ~RollingWindow();
+
+  void beginPacket();
+  void newBlock(int32_t angle, size_t begin);
+  void endPacket(const T_PointCloud& cloud, double ts);
+  void setComplete();
+
+  bool snapshot(std::shared_ptr<const T_PointCloud>& window);
+
+#ifndef UNIT_TEST
+private:
+#endif
+
+  struct Buffer
+  {
+    T_PointCloud cloud;
+    std::vector<uint32_t> versions; // version of each column
+    std::vector<uint16_t> counts; // points of each column
+    uint32_t version; // latest version of the columns
+    uint16_t rows;
+  };
+
+  struct BufferPool
+  {
+    std::mutex mtx;
+    std::vector<Buffer*> buffers;
+    size_t max_num;
+
+    void put(Buffer* buf)
+    {
+      {
+        std::lock_guard<std::mutex> lg(mtx);
+        if (buffers.size() < max_num)
+        {
+          buffers.push_back(buf);
+          return;
+        }
+      }
+
+      delete buf;
+    }
+
+    ~BufferPool()
+    {
+      for (auto buf : buffers)
+      {
+        delete buf;
+      }
+    }
+  };
+
+  Buffer* newBuffer();
+  Buffer* takeBuffer();
+  void publish(double ts);
+  void writeColumn(uint32_t col, const T_Point* points, size_t num);
+  void resize(uint16_t rows);
+
+  int32_t col_angle_; // 1/100 degree
+  uint32_t col_num_;
+  uint16_t rows_; // points per column
+  T_Point nan_point_;
+
+  std::vector<std::pair<int32_t, size_t>> blocks_; // blocks of current packet
+  Buffer* active_; // being written by the handling thread
+  uint32_t version_;
+  uint32_t last_col_;
+  uint32_t seq_;
+  std::shared_ptr<BufferPool> pool_;
+
+  std::mutex mtx_; // for the members below
+  Buffer* published_;
+  std::shared_ptr<const T_PointCloud> window_; // published_ handed out by snapshot()
+  bool complete_;
+};
+
+template <typename T_PointCloud>
+inline RollingWindow<T_PointCloud>::RollingWindow(float resolution)
+  : rows_(0), active_(NULL), version_(0), last_col_(0xFFFFFFFF), seq_(0), 
+  pool_(std::make_shared<BufferPool>()), published_(NULL), complete_(false)
+{
+  col_angle_ = (int32_t)(resolution * 100);
+  if (col_angle_ < 1)
+  {
+    col_angle_ = 1;
+  }
+
+  col_num_ = (uint32_t)((36000 + col_angle_ - 1) / col_angle_);
+
+  setX(nan_point_, NAN);
+  setY(nan_point_, NAN);
+  setZ(nan_point_, NAN);
+  setIntensity(nan_point_, 0);
+  setTimestamp(nan_point_, 0);
+  setRing(nan_point_, 0);
+
+  blocks_.reserve(64);
+
+  // one published, one held by the caller, and one to write on.
+  pool_->max_num = 3;
+  pool_->buffers.reserve(pool_->max_num);
+}
+
+template <typename T_PointCloud>
+inline RollingWindow<T_PointCloud>::~RollingWindow()
+{
+  delete active_;
+
+  // if handed out, published_ is owned by window_.
+  if (!window_)
+  {
+    delete published_;
+  }
+}
+
+template <typename T_PointCloud>
+inline void RollingWindow<T_PointCloud>::beginPacket()
+{
+  blocks_.clear();
+}
+
+template <typename T_PointCloud>
+inline void RollingWindow<T_PointCloud>::newBlock(int32_t angle, size_t begin)
+{
+  blocks_.emplace_back(angle, begin);
+}
+
+template <typename T_PointCloud>
+inline void RollingWindow<T_PointCloud>::endPacket(const T_PointCloud& cloud, double ts)
+{
+  for (size_t i = 0; i < blocks_.size(); i++)
+  {
+    size_t begin = blocks_[i].second;
+    size_t end = (i + 1 < blocks_.size()) ? blocks_[i + 1].second : cloud.points.size();
+    if (end > cloud.points.size())
+    {
+      end = cloud.points.size();
+    }
+
+    int32_t angle = ((blocks_[i].first % 36000) + 36000) % 36000;
+    uint32_t col = (uint32_t)(angle / col_angle_);
+
+    writeColumn(col, cloud.points.data() + begin, (end > begin) ? (end - begin) : 0);
+  }
+
+  if (active_)
+  {
+    publish(ts);
+  }
+}
+
+template <typename T_PointCloud>
+inline void RollingWindow<T_PointCloud>::setComplete()
+{
+  std::lock_guard<std::mutex> lg(mtx_);
+  complete_ = true;
+}
+
+template <typename T_PointCloud>
+inline void RollingWindow<T_PointCloud>::writeColumn(uint32_t col, const T_Point* points, size_t num)
+{
+  // blocks of the same column in a row (e.g. dual return), are appended. Otherwise, overwrite the column.
+  uint16_t count = ((col == last_col_) && active_) ? active_->counts[col] : 0;
+  last_col_ = col;
+
+  if (!active_ || (count + num > rows_))
+  {
+    resize((uint16_t)(count + num));
+  }
+
+  T_Point* dst = active_->cloud.points.data() + (size_t)col * rows_;
+  std::copy(points, points + num, dst + count);
+
+  uint16_t prev_count = active_->counts[col];
+  count += (uint16_t)num;
+  for (uint16_t r = count; r < prev_count; r++)
+  {
+    dst[r] = nan_point_;
+  }
+
+  active_->counts[col] = count;
+  active_->versions[col] = ++version_;
+}
+
+template <typename T_PointCloud>
+inline void RollingWindow<T_PointCloud>::resize(uint16_t rows)
+{
+  // Mostly at the beginning. Keep the content of the active buffer. 
+  // The others are dropped when they are taken from the pool.
+  Buffer* prev = active_;
+  uint16_t prev_rows = rows_;
+
+  rows_ = rows;
+  active_ = newBuffer();
+
+  if (prev)
+  {
+    for (uint32_t col = 0; col < col_num_; col++)
+    {
+      const T_Point* src = prev->cloud.points.data() + (size_t)col * prev_rows;
+      T_Point* dst = active_->cloud.points.data() + (size_t)col * rows_;
+      std::copy(src, src + prev->counts[col], dst);
+
+      active_->counts[col] = prev->counts[col];
+      active_->versions[col] = prev->versions[col];
+    }
+
+    delete prev;
+  }
+}
+
+template <typename T_PointCloud>
+inline typename RollingWindow<T_PointCloud>::Buffer* RollingWindow<T_PointCloud>::newBuffer()
+{
+  Buffer* buf = new Buffer();
+  buf->cloud.points.assign((size_t)col_num_ * rows_, nan_point_);
+  buf->cloud.height = 1;
+  buf->cloud.width = (uint32_t)buf->cloud.points.size();
+  buf->cloud.is_dense = false;
+  buf->versions.assign(col_num_, 0);
+  buf->counts.assign(col_num_, 0);
+  buf->version = 0;
+  buf->rows = rows_;
+  return buf;
+}
+
+template <typename T_PointCloud>
+inline typename RollingWindow<T_PointCloud>::Buffer* RollingWindow<T_PointCloud>::takeBuffer()
+{
+  // the latest one, so least columns to copy.
+  Buffer* buf = NULL;
+  std::vector<Buffer*> stale;
+  {
+    std::lock_guard<std::mutex> lg(pool_->mtx);
+    for (auto it = pool_->buffers.begin(); it != pool_->buffers.end(); )
+    {
+      if ((*it)->rows != rows_)
+      {
+        stale.push_back(*it);
+        it = pool_->buffers.erase(it);
+        continue;
+      }
+
+      if ((buf == NULL) || ((*it)->version > buf->version))
+      {
+        buf = *it;
+      }
+
+      ++it;
+    }
+
+    if (buf != NULL)
+    {
+      pool_->buffers.erase(std::find(pool_->buffers.begin(), pool_->buffers.end(), buf));
+    }
+  }
+
+  for (auto s : stale)
+  {
+    delete s;
+  }
+
+  return (buf != NULL) ? buf : newBuffer();
+}
+
+template <typename T_PointCloud>
+inline void RollingWindow<T_PointCloud>::publish(double ts)
+{
+  active_->cloud.timestamp = ts;
+  active_->cloud.seq = seq_++;
+  active_->version = version_;
+
+  Buffer* prev = NULL;
+  std::shared_ptr<const T_PointCloud> prev_window;
+  {
+    std::lock_guard<std::mutex> lg(mtx_);
+    prev = published_;
+    prev_window.swap(window_);
+    published_ = active_;
+  }
+
+  //
+  // a buffer to write on. If the previous one wasn't handed out, it is the latest. 
+  // Otherwise, it goes to the pool after the caller releases it.
+  //
+  Buffer* next = NULL;
+  if (prev_window)
+  {
+    prev_window.reset();
+  }
+  else if ((prev != NULL) && (prev->rows == rows_))
+  {
+    next = prev;
+  }
+  else
+  {
+    delete prev;
+  }
+
+  if (next == NULL)
+  {
+    next = takeBuffer();
+  }
+
+  //
+  // bring it up to date, out of the lock. The published buffer is never written any more.
+  //
+  const Buffer* src = active_;
+  for (uint32_t col = 0; col < col_num_; col++)
+  {
+    if (next->versions[col] != src->versions[col])
+    {
+      const T_Point* from = src->cloud.points.data() + (size_t)col * rows_;
+      T_Point* to = next->cloud.points.data() + (size_t)col * rows_;
+      std::copy(from, from + rows_, to);
+
+      next->counts[col] = src->counts[col];
+      next->versions[col] = src->versions[col];
+    }
+  }
+
+  next->version = src->version;
+  active_ = next;
+}
+
+template <typename T_PointCloud>
+inline bool RollingWindow<T_PointCloud>::snapshot(std::shared_ptr<const T_PointCloud>& window)
+{
+  // return the caller's window first, so it may be reused.
+  window.reset();
+
+  std::lock_guard<std::mutex> lg(mtx_);
+
+  if (!complete_ || (published_ == NULL))
+  {
+    return false;
+  }
+
+  if (!window_)
+  {
+    // the pool lives until all its buffers are released, even after the window.
+    std::shared_ptr<BufferPool> pool = pool_;
+    Buffer* buf = published_;
+    window_ = std::shared_ptr<const T_PointCloud>(&buf->cloud, [pool, buf](const T_PointCloud*) { pool->put(buf); });
+  }
+
+  window = window_;
+  return true;
+}
+
+}  // namespace lidar
+}  // namespace robosense
@@ -0,0 +1,192 @@
+/*********************************************************************************************************************
+Copyright (c) 2020 RoboSense
+All rights reserved
+
+By downloading, copying, installing or using the software you agree to this license. If you do not agree to this
+license, do not download, install, copy or use the software.
+
+License Agreement
+For RoboSense LiDAR SDK Library
+(3-clause BSD License)
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that the
+following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following
+disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following
+disclaimer in the documentation and/or other materials provided with the distribution.
+
+3. Neither the names of the RoboSense, nor Suteng Innovation Technology, nor the names of other contributors may be used
+to endorse or promote products derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*********************************************************************************************************************/
+
+
+#pragma once
+
+#include <rs_driver/driver/driver_param.hpp>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <pthread.h>
+#include <sched.h>
+#include <cstring>
+#endif
+
+#include <thread>
+#include <string>
+
+namespace robosense
+{
+namespace lidar
+{
+
+//
+// Pin the thread to param.cpu_list, set its scheduling policy and its name.
+// If param.name is empty, default_name is used. Return false if any of them fails, 
+// e.g. SCHED_FIFO without the privilege (CAP_SYS_NICE). The thread keeps running anyway.
+//
+inline bool setThreadParam(std::thread::native_handle_type handle, const RSThreadParam& param, 
+    const std::string& default_name)
+{
+  bool ret = true;
+  std::string name = param.name.empty() ? default_name : param.name;
+
+#ifdef __linux__
+
+  if (!param.cpu_list.empty())
+  {
+    cpu_set_t cpus;
+    CPU_ZERO(&cpus);
+    for (auto cpu : param.cpu_list)
+    {
+      if (cpu < CPU_SETSIZE)
+      {
+        CPU_SET(cpu, &cpus);
+      }
+    }
+
+    int err = pthread_setaffinity_np(handle, sizeof(cpus), &cpus);
+    if (err != 0)
+    {
+      RS_WARNING << "Failed to set affinity of thread " << name << ": " << strerror(err) << RS_REND;
+      ret = false;
+    }
+  }
+
+  if (param.priority > 0)
+  {
+    struct sched_param sp;
+    memset(&sp, 0, sizeof(sp));
+    sp.sched_priority = param.priority;
+
+    int err = pthread_setschedparam(handle, SCHED_FIFO, &sp);
+    if (err != 0)
+    {
+      RS_WARNING << "Failed to set SCHED_FIFO priority of thread " << name << ": " << strerror(err) << RS_REND;
+      ret = false;
+    }
+  }
+
+  if (!name.empty())
+  {
+    // the kernel keeps at most 15 characters.
+    int err = pthread_setname_np(handle, name.substr(0, 15).c_str());
+    if (err != 0)
+    {
+      RS_WARNING << "Failed to set name of thread " << name << ": " << strerror(err) << RS_REND;
+      ret = false;
+    }
+  }
+
+#elif defined(_WIN32)
+
+  if (!param.cpu_list.empty())
+  {
+    DWORD_PTR mask = 0;
+    for (auto cpu : param.cpu_list)
+    {
+      if (cpu < sizeof(DWORD_PTR) * 8)
+      {
+        mask |= ((DWORD_PTR)1 << cpu);
+      }
+    }
+
+    if (SetThreadAffinityMask((HANDLE)handle, mask) == 0)
+    {
+      RS_WARNING << "Failed to set affinity of thread " << name << RS_REND;
+      ret = false;
+    }
+  }
+
+  if (param.priority > 0)
+  {
+    if (!SetThreadPriority((HANDLE)handle, THREAD_PRIORITY_TIME_CRITICAL))
+    {
+      RS_WARNING << "Failed to set priority of thread " << name << RS_REND;
+      ret = false;
+    }
+  }
+
+#else
+
+  (void)handle;
+  if (!param.cpu_list.empty() || (param.priority > 0))
+  {
+    RS_WARNING << "Thread placement is not supported on this platform. Ignore it for thread " << name << RS_REND;
+    ret = false;
+  }
+
+#endif
+
+  return ret;
+}
+
+inline bool setThreadParam(std::thread& t, const RSThreadParam& param, const std::string& default_name)
+{
+  if (!t.joinable())
+  {
+    return false;
+  }
+
+  return setThreadParam(t.native_handle(), param, default_name);
+}
+
+//
+// Place the calling thread. Call it first in the thread, so the thread never runs 
+// (and allocates its buffers) anywhere else.
+//
+inline bool applyThreadParam(const RSThreadParam& param, const std::string& default_name)
+{
+#ifdef _WIN32
+  return setThreadParam((std::thread::native_handle_type)GetCurrentThread(), param, default_name);
+#else
+  return setThreadParam(pthread_self(), param, default_name);
+#endif
+}
+
+//
+// Parameter of the idx-th thread of a group. The given name gets idx as suffix, so the threads are told apart.
+//
+inline RSThreadParam indexThreadParam(const RSThreadParam& param, size_t idx)
+{
+  RSThreadParam ret = param;
+  if (!ret.name.empty())
+  {
+    ret.name += std::to_string(idx);
+  }
+  return ret;
+}
+
+}  // namespace lidar
+}  // namespace robosense
@@ -0,0 +1,66 @@
+/*********************************************************************************************************************
+Copyright (c) 2020 RoboSense
+All rights reserved
+
+By downloading, copying, installing or using the software you agree to this license. If you do not agree to this
+license, do not download, install, copy or use the software.
+
+License Agreement
+For RoboSense LiDAR SDK Library
+(3-clause BSD License)
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that the
+following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following
+disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following
+disclaimer in the documentation and/or other materials provided with the distribution.
+
+3. Neither the names of the RoboSense, nor Suteng Innovation Technology, nor the names of other contributors may be used
+to endorse or promote products derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*********************************************************************************************************************/
+
+
+#pragma once
+
+#include <cstdint>
+
+namespace robosense
+{
+namespace lidar
+{
+
+struct FrameGap  ///< Lost packets in a frame
+{
+  uint32_t begin = 0; ///< MEMS Lidars: pkt_seq of the first lost packet. Mechanical Lidars: azimuth (in 0.01 degree) of the block before the gap
+  uint32_t end = 0;   ///< MEMS Lidars: pkt_seq of the last lost packet. Mechanical Lidars: azimuth (in 0.01 degree) of the block after the gap
+};
+
+//
+// Packets of a frame, expected vs. received. 
+// It is filled into the member `quality` of the point cloud, if the point cloud type has it.
+//
+struct FrameQuality
+{
+  constexpr static uint16_t GAP_MAX = 16;
+
+  uint32_t expected_pkts = 0;     ///< Packets expected in the frame, i.e. received + lost
+  uint32_t recv_pkts = 0;         ///< Packets received in the frame
+  uint32_t lost_pkts = 0;         ///< Packets lost in the frame
+  uint32_t out_of_order_pkts = 0; ///< Packets arriving late or duplicated
+  uint16_t gap_num = 0;           ///< Gaps in gaps[]. More than GAP_MAX gaps are counted in lost_pkts only
+  FrameGap gaps[GAP_MAX];         ///< Ranges of lost packets
+};
+
+}  // namespace lidar
+}  // namespace robosense
@@ -49,6 +49,20 @@ struct PointXYZIRT
 POINT_CLOUD_REGISTER_POINT_STRUCT(PointXYZIRT, (float, x, x)(float, y, y)(float, z, z)
     (std::uint8_t, intensity, intensity)(std::uint16_t, ring, ring)(double, timestamp, timestamp))
 
+struct PointXYZIRTL
+{
+  PCL_ADD_POINT4D;
+  uint8_t intensity;
+  uint16_t ring = 0;
+  double timestamp = 0;
+  uint8_t lidar_id = 0;
+  EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+} EIGEN_ALIGN16;
+
+POINT_CLOUD_REGISTER_POINT_STRUCT(PointXYZIRTL, (float, x, x)(float, y, y)(float, z, z)
+    (std::uint8_t, intensity, intensity)(std::uint16_t, ring, ring)(double, timestamp, timestamp)
+    (std::uint8_t, lidar_id, lidar_id))
+
 template <typename T_Point>
 class PointCloudT : public pcl::PointCloud<T_Point>
 {
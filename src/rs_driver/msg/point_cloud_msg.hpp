@@ -32,6 +32,8 @@ THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 #pragma once
 
+#include <rs_driver/msg/frame_quality.hpp>
+
 #include <vector>
 #include <string>
 
@@ -53,6 +55,17 @@ struct PointXYZIRT
   double timestamp;
 };
 
+struct PointXYZIRTL  ///< With the id of the source Lidar, for FusionDriver
+{
+  float x;
+  float y;
+  float z;
+  uint8_t intensity;
+  uint16_t ring;
+  double timestamp;
+  uint8_t lidar_id;
+};
+
 template <typename T_Point>
 class PointCloudT
 {
@@ -65,6 +78,7 @@ public:
   bool is_dense = false;  ///< If is_dense is true, the point cloud does not contain NAN points,
   double timestamp = 0.0;
   uint32_t seq = 0;           ///< Sequence number of message
+  robosense::lidar::FrameQuality quality; ///< Packets expected vs. received
 
   VectorT points;
 };
@@ -0,0 +1,144 @@
+/*********************************************************************************************************************
+Copyright (c) 2020 RoboSense
+All rights reserved
+
+By downloading, copying, installing or using the software you agree to this license. If you do not agree to this
+license, do not download, install, copy or use the software.
+
+License Agreement
+For RoboSense LiDAR SDK Library
+(3-clause BSD License)
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that the
+following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following
+disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following
+disclaimer in the documentation and/or other materials provided with the distribution.
+
+3. Neither the names of the RoboSense, nor Suteng Innovation Technology, nor the names of other contributors may be used
+to endorse or promote products derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*********************************************************************************************************************/
+
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+
+namespace robosense
+{
+namespace lidar
+{
+
+//
+// AllocTracker counts the heap allocations (operator new) of each thread, and of the whole process.
+//
+// The counts are valid only if rs_driver is compiled with ENABLE_ALLOC_TRACKING, which replaces the global 
+// operator new. The driver attributes the allocations of the receiving thread and the handling thread to 
+// packets and frames, and checks them against RSAllocParam. It is a debug mode, to prove zero allocation in 
+// steady state, and to keep it.
+//
+class AllocTracker
+{
+public:
+
+  static bool enabled()
+  {
+#ifdef ENABLE_ALLOC_TRACKING
+    return true;
+#else
+    return false;
+#endif
+  }
+
+  // allocations of the calling thread.
+  static uint64_t& threadCount()
+  {
+    static thread_local uint64_t count = 0;
+    return count;
+  }
+
+  // allocations of all the threads.
+  static std::atomic<uint64_t>& totalCount()
+  {
+    static std::atomic<uint64_t> count(0);
+    return count;
+  }
+
+  static void count()
+  {
+    threadCount()++;
+    totalCount().fetch_add(1, std::memory_order_relaxed);
+  }
+};
+
+}  // namespace lidar
+}  // namespace robosense
+
+#ifdef ENABLE_ALLOC_TRACKING
+
+//
+// Every translation unit including this header defines them, so they are weak, and the linker keeps one.
+//
+__attribute__((weak)) void* operator new(size_t size)
+{
+  robosense::lidar::AllocTracker::count();
+
+  void* p = malloc(size ? size : 1);
+  if (p == NULL)
+  {
+    throw std::bad_alloc();
+  }
+  return p;
+}
+
+__attribute__((weak)) void* operator new[](size_t size)
+{
+  return operator new(size);
+}
+
+__attribute__((weak)) void* operator new(size_t size, const std::nothrow_t&) noexcept
+{
+  robosense::lidar::AllocTracker::count();
+  return malloc(size ? size : 1);
+}
+
+__attribute__((weak)) void* operator new[](size_t size, const std::nothrow_t&) noexcept
+{
+  return operator new(size, std::nothrow);
+}
+
+__attribute__((weak)) void operator delete(void* p) noexcept
+{
+  free(p);
+}
+
+__attribute__((weak)) void operator delete[](void* p) noexcept
+{
+  free(p);
+}
+
+__attribute__((weak)) void operator delete(void* p, size_t) noexcept
+{
+  operator delete(p);
+}
+
+__attribute__((weak)) void operator delete[](void* p, size_t) noexcept
+{
+  operator delete[](p);
+}
+
+#endif
@@ -79,6 +79,15 @@ public:
     data_size_ = data_size;
   }
 
+#ifdef ENABLE_LATENCY_STATS
+  uint64_t recv_ns = 0;    // when the packet is received, by latencyNow()
+  uint64_t enqueue_ns = 0; // when the packet is pushed into the packet queue
+#endif
+
+#ifdef ENABLE_ALLOC_TRACKING
+  uint64_t allocs = 0;     // allocations of the receiving thread, since its previous packet
+#endif
+
 private:
   std::vector<uint8_t> buf_;
   size_t buf_size_;
@@ -0,0 +1,373 @@
+/*********************************************************************************************************************
+Copyright (c) 2020 RoboSense
+All rights reserved
+
+By downloading, copying, installing or using the software you agree to this license. If you do not agree to this
+license, do not download, install, copy or use the software.
+
+License Agreement
+For RoboSense LiDAR SDK Library
+(3-clause BSD License)
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that the
+following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following
+disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following
+disclaimer in the documentation and/or other materials provided with the distribution.
+
+3. Neither the names of the RoboSense, nor Suteng Innovation Technology, nor the names of other contributors may be used
+to endorse or promote products derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*********************************************************************************************************************/
+
+#pragma once
+
+#ifdef __linux__
+
+#include <rs_driver/common/rs_log.hpp>
+
+#ifdef ENABLE_ZLIB
+#include <zlib.h>
+#endif
+
+#ifdef ENABLE_ZSTD
+#include <zstd.h>
+#endif
+
+#include <stdio.h>
+#include <sys/types.h>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <functional>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+namespace robosense
+{
+namespace lidar
+{
+
+//
+// Decompress a .gz/.zst file in a separate thread, into a bounded ring.
+// The consumer reads the decompressed data through a FILE*, so it may be fed to pcap_fopen_offline().
+//
+class DecompressStream
+{
+public:
+
+  enum Format
+  {
+    FORMAT_NONE = 0,
+    FORMAT_GZIP,
+    FORMAT_ZSTD
+  };
+
+  static Format getFormat(const std::string& path);
+
+  DecompressStream(size_t ring_size = 4 * 1024 * 1024)
+    : ring_(ring_size), head_(0), tail_(0), eof_(false), to_exit_(false), format_(FORMAT_NONE)
+  {
+  }
+
+  ~DecompressStream()
+  {
+    close();
+  }
+
+  FILE* open(const std::string& path);
+  void close();
+
+private:
+
+  void decompress();
+#ifdef ENABLE_ZLIB
+  void decompressGzip();
+#endif
+#ifdef ENABLE_ZSTD
+  void decompressZstd();
+#endif
+
+  bool push(const uint8_t* data, size_t size);
+  size_t pop(uint8_t* data, size_t size);
+  void finish();
+
+  static ssize_t cookieRead(void* cookie, char* buf, size_t size);
+  static int cookieClose(void* cookie);
+
+  std::vector<uint8_t> ring_;
+  size_t head_; // total bytes pushed
+  size_t tail_; // total bytes popped
+  bool eof_;
+  bool to_exit_;
+  std::mutex mtx_;
+  std::condition_variable cv_not_empty_;
+  std::condition_variable cv_not_full_;
+
+  std::string path_;
+  Format format_;
+  std::thread thread_;
+};
+
+inline DecompressStream::Format DecompressStream::getFormat(const std::string& path)
+{
+  auto endsWith = [&path](const std::string& suffix) {
+    return (path.size() > suffix.size()) && 
+      (path.compare(path.size() - suffix.size(), suffix.size(), suffix) == 0);
+  };
+
+  if (endsWith(".gz"))
+    return FORMAT_GZIP;
+  else if (endsWith(".zst") || endsWith(".zstd"))
+    return FORMAT_ZSTD;
+
+  return FORMAT_NONE;
+}
+
+inline FILE* DecompressStream::open(const std::string& path)
+{
+  close();
+
+  format_ = getFormat(path);
+  switch (format_)
+  {
+#ifdef ENABLE_ZLIB
+    case FORMAT_GZIP:
+      break;
+#endif
+#ifdef ENABLE_ZSTD
+    case FORMAT_ZSTD:
+      break;
+#endif
+    default:
+      RS_ERROR << "Unsupported compressed file: " << path 
+        << ". Please specify the make option ENABLE_ZLIB/ENABLE_ZSTD." << RS_REND;
+      return NULL;
+  }
+
+  cookie_io_functions_t funcs;
+  memset (&funcs, 0, sizeof(funcs));
+  funcs.read = cookieRead;
+  funcs.close = cookieClose;
+
+  FILE* fp = fopencookie(this, "r", funcs);
+  if (fp == NULL)
+  {
+    return NULL;
+  }
+
+  path_ = path;
+  head_ = tail_ = 0;
+  eof_ = false;
+  to_exit_ = false;
+  thread_ = std::thread(std::bind(&DecompressStream::decompress, this));
+
+  return fp;
+}
+
+inline void DecompressStream::close()
+{
+  {
+    std::lock_guard<std::mutex> lg(mtx_);
+    to_exit_ = true;
+  }
+  cv_not_full_.notify_all();
+  cv_not_empty_.notify_all();
+
+  if (thread_.joinable())
+  {
+    thread_.join();
+  }
+}
+
+inline void DecompressStream::decompress()
+{
+  switch (format_)
+  {
+#ifdef ENABLE_ZLIB
+    case FORMAT_GZIP:
+      decompressGzip();
+      break;
+#endif
+#ifdef ENABLE_ZSTD
+    case FORMAT_ZSTD:
+      decompressZstd();
+      break;
+#endif
+    default:
+      break;
+  }
+
+  finish();
+}
+
+#ifdef ENABLE_ZLIB
+inline void DecompressStream::decompressGzip()
+{
+  gzFile gz = gzopen(path_.c_str(), "rb");
+  if (gz == NULL)
+  {
+    RS_ERROR << "Fail to open gzip file: " << path_ << RS_REND;
+    return;
+  }
+
+  gzbuffer(gz, 256 * 1024);
+
+  std::vector<uint8_t> out(256 * 1024);
+  while (1)
+  {
+    int ret = gzread(gz, out.data(), (unsigned)out.size());
+    if (ret <= 0)
+    {
+      if (ret < 0)
+      {
+        int err;
+        RS_ERROR << "Fail to decompress gzip file: " << gzerror(gz, &err) << RS_REND;
+      }
+      break;
+    }
+
+    if (!push(out.data(), (size_t)ret))
+      break;
+  }
+
+  gzclose(gz);
+}
+#endif
+
+#ifdef ENABLE_ZSTD
+inline void DecompressStream::decompressZstd()
+{
+  FILE* fp = fopen(path_.c_str(), "rb");
+  if (fp == NULL)
+  {
+    RS_ERROR << "Fail to open zstd file: " << path_ << RS_REND;
+    return;
+  }
+
+  ZSTD_DCtx* dctx = ZSTD_createDCtx();
+  std::vector<uint8_t> in(ZSTD_DStreamInSize());
+  std::vector<uint8_t> out(ZSTD_DStreamOutSize());
+
+  bool to_stop = false;
+  while (!to_stop)
+  {
+    size_t in_size = fread(in.data(), 1, in.size(), fp);
+    if (in_size == 0)
+      break;
+
+    ZSTD_inBuffer input = { in.data(), in_size, 0 };
+    while (input.pos < input.size)
+    {
+      ZSTD_outBuffer output = { out.data(), out.size(), 0 };
+      size_t ret = ZSTD_decompressStream(dctx, &output, &input);
+      if (ZSTD_isError(ret))
+      {
+        RS_ERROR << "Fail to decompress zstd file: " << ZSTD_getErrorName(ret) << RS_REND;
+        to_stop = true;
+        break;
+      }
+
+      if (!push(out.data(), output.pos))
+      {
+        to_stop = true;
+        break;
+      }
+    }
+  }
+
+  ZSTD_freeDCtx(dctx);
+  fclose(fp);
+}
+#endif
+
+inline bool DecompressStream::push(const uint8_t* data, size_t size)
+{
+  while (size > 0)
+  {
+    size_t n = 0;
+
+    {
+      std::unique_lock<std::mutex> ul(mtx_);
+      cv_not_full_.wait(ul, [this] { return (to_exit_ || (head_ - tail_ < ring_.size())); });
+      if (to_exit_)
+        return false;
+
+      size_t off = head_ % ring_.size();
+      n = std::min(size, ring_.size() - (head_ - tail_));
+      n = std::min(n, ring_.size() - off);
+      memcpy (ring_.data() + off, data, n);
+      head_ += n;
+    }
+
+    cv_not_empty_.notify_one();
+    data += n;
+    size -= n;
+  }
+
+  return true;
+}
+
+inline size_t DecompressStream::pop(uint8_t* data, size_t size)
+{
+  size_t n = 0;
+
+  {
+    std::unique_lock<std::mutex> ul(mtx_);
+    cv_not_empty_.wait(ul, [this] { return (to_exit_ || eof_ || (head_ != tail_)); });
+
+    size_t off = tail_ % ring_.size();
+    n = std::min(size, head_ - tail_);
+    n = std::min(n, ring_.size() - off);
+    memcpy (data, ring_.data() + off, n);
+    tail_ += n;
+  }
+
+  cv_not_full_.notify_one();
+  return n;
+}
+
+inline void DecompressStream::finish()
+{
+  {
+    std::lock_guard<std::mutex> lg(mtx_);
+    eof_ = true;
+  }
+  cv_not_empty_.notify_all();
+}
+
+inline ssize_t DecompressStream::cookieRead(void* cookie, char* buf, size_t size)
+{
+  DecompressStream* stream = (DecompressStream*)cookie;
+  return (ssize_t)stream->pop((uint8_t*)buf, size);
+}
+
+inline int DecompressStream::cookieClose(void* cookie)
+{
+  DecompressStream* stream = (DecompressStream*)cookie;
+
+  {
+    std::lock_guard<std::mutex> lg(stream->mtx_);
+    stream->to_exit_ = true;
+  }
+  stream->cv_not_full_.notify_all();
+  return 0;
+}
+
+}  // namespace lidar
+}  // namespace robosense
+
+#endif  // __linux__
@@ -0,0 +1,118 @@
+/*********************************************************************************************************************
+Copyright (c) 2020 RoboSense
+All rights reserved
+
+By downloading, copying, installing or using the software you agree to this license. If you do not agree to this
+license, do not download, install, copy or use the software.
+
+License Agreement
+For RoboSense LiDAR SDK Library
+(3-clause BSD License)
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that the
+following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following
+disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following
+disclaimer in the documentation and/or other materials provided with the distribution.
+
+3. Neither the names of the RoboSense, nor Suteng Innovation Technology, nor the names of other contributors may be used
+to endorse or promote products derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*********************************************************************************************************************/
+
+
+#pragma once
+
+#ifndef _WIN32
+#include <glob.h>
+#include <fcntl.h>
+#endif
+
+#include <stdio.h>
+#include <string>
+#include <vector>
+#include <algorithm>
+
+namespace robosense
+{
+namespace lidar
+{
+
+//
+// Expand the file paths, separated by ';'. Each of them may be a glob pattern, such as "/data/lidar_*.pcap".
+// Files matched by a pattern are sorted by name, so rotated files are in order.
+//
+inline std::vector<std::string> expandFilePaths(const std::string& paths)
+{
+  std::vector<std::string> files;
+
+  size_t start = 0;
+  while (start <= paths.size())
+  {
+    size_t end = paths.find(';', start);
+    if (end == std::string::npos)
+    {
+      end = paths.size();
+    }
+
+    std::string path = paths.substr(start, end - start);
+    start = end + 1;
+
+    // trim spaces
+    size_t first = path.find_first_not_of(" \t");
+    size_t last = path.find_last_not_of(" \t");
+    if (first == std::string::npos)
+    {
+      continue;
+    }
+    path = path.substr(first, last - first + 1);
+
+#ifndef _WIN32
+    if (path.find_first_of("*?[") != std::string::npos)
+    {
+      glob_t g;
+      if (glob(path.c_str(), 0, NULL, &g) == 0)
+      {
+        std::vector<std::string> matched(g.gl_pathv, g.gl_pathv + g.gl_pathc);
+        std::sort(matched.begin(), matched.end());
+        files.insert(files.end(), matched.begin(), matched.end());
+      }
+      globfree(&g);
+      continue;
+    }
+#endif
+
+    files.push_back(path);
+  }
+
+  return files;
+}
+
+//
+// Ask the OS to read the file into page cache in the background.
+//
+inline void prefetchFile(FILE* fp)
+{
+#if !defined(_WIN32) && defined(POSIX_FADV_WILLNEED)
+  int fd = (fp != NULL) ? fileno(fp) : -1;
+  if (fd >= 0)
+  {
+    posix_fadvise(fd, 0, 0, POSIX_FADV_WILLNEED);
+  }
+#else
+  (void)fp;
+#endif
+}
+
+}  // namespace lidar
+}  // namespace robosense
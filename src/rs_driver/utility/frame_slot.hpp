@@ -0,0 +1,196 @@
+/*********************************************************************************************************************
+Copyright (c) 2020 RoboSense
+All rights reserved
+
+By downloading, copying, installing or using the software you agree to this license. If you do not agree to this
+license, do not download, install, copy or use the software.
+
+License Agreement
+For RoboSense LiDAR SDK Library
+(3-clause BSD License)
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that the
+following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following
+disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following
+disclaimer in the documentation and/or other materials provided with the distribution.
+
+3. Neither the names of the RoboSense, nor Suteng Innovation Technology, nor the names of other contributors may be used
+to endorse or promote products derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*********************************************************************************************************************/
+
+
+#pragma once
+
+#include <memory>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+
+namespace robosense
+{
+namespace lidar
+{
+
+//
+// Hand frames over from one producer thread to the consumer threads, without lock.
+// It keeps at most capacity frames. If it's full, the oldest frame is dropped for the new one,
+// so with capacity 1, the consumer always gets the latest frame.
+// The mutex is only for a consumer waiting for a frame.
+//
+template <typename T>
+class FrameSlot
+{
+public:
+
+  FrameSlot(size_t capacity = 1);
+  ~FrameSlot();
+
+  // Only from one thread.
+  void push(const std::shared_ptr<T>& frame);
+
+  bool tryPop(std::shared_ptr<T>& frame);
+  bool pop(std::shared_ptr<T>& frame, uint32_t timeout_ms);
+
+  size_t size() const
+  {
+    return tail_ - head_;
+  }
+
+  uint64_t dropNum() const
+  {
+    return drop_num_;
+  }
+
+#ifndef UNIT_TEST
+private:
+#endif
+
+  bool takeHead(size_t head, std::shared_ptr<T>*& box);
+
+  size_t capacity_;
+  std::unique_ptr<std::atomic<std::shared_ptr<T>*>[]> cells_;
+  std::atomic<size_t> head_; // next frame to pop
+  std::atomic<size_t> tail_; // next frame to push
+  std::atomic<uint64_t> drop_num_;
+  std::atomic<int> waiter_num_;
+  std::mutex mtx_;
+  std::condition_variable cv_;
+};
+
+template <typename T>
+inline FrameSlot<T>::FrameSlot(size_t capacity)
+  : capacity_((capacity > 0) ? capacity : 1), cells_(new std::atomic<std::shared_ptr<T>*>[capacity_]),
+    head_(0), tail_(0), drop_num_(0), waiter_num_(0)
+{
+  for (size_t i = 0; i < capacity_; i++)
+  {
+    cells_[i] = nullptr;
+  }
+}
+
+template <typename T>
+inline FrameSlot<T>::~FrameSlot()
+{
+  for (size_t i = head_; i < tail_; i++)
+  {
+    delete cells_[i % capacity_].load();
+  }
+}
+
+template <typename T>
+inline bool FrameSlot<T>::takeHead(size_t head, std::shared_ptr<T>*& box)
+{
+  // read the cell before moving head_. After that, the producer may overwrite it.
+  box = cells_[head % capacity_].load();
+  return head_.compare_exchange_strong(head, head + 1);
+}
+
+template <typename T>
+inline void FrameSlot<T>::push(const std::shared_ptr<T>& frame)
+{
+  size_t tail = tail_;
+
+  // full. drop the oldest one, unless a consumer has just taken it.
+  while (1)
+  {
+    size_t head = head_;
+    if (tail - head < capacity_)
+    {
+      break;
+    }
+
+    std::shared_ptr<T>* box;
+    if (takeHead(head, box))
+    {
+      delete box;
+      drop_num_++;
+    }
+  }
+
+  cells_[tail % capacity_] = new std::shared_ptr<T>(frame);
+  tail_ = tail + 1;
+
+  if (waiter_num_ > 0)
+  {
+    std::lock_guard<std::mutex> lg(mtx_);
+    cv_.notify_one();
+  }
+}
+
+template <typename T>
+inline bool FrameSlot<T>::tryPop(std::shared_ptr<T>& frame)
+{
+  while (1)
+  {
+    size_t head = head_;
+    if (head == tail_)
+    {
+      return false;
+    }
+
+    std::shared_ptr<T>* box;
+    if (takeHead(head, box))
+    {
+      frame = std::move(*box);
+      delete box;
+      return true;
+    }
+  }
+}
+
+template <typename T>
+inline bool FrameSlot<T>::pop(std::shared_ptr<T>& frame, uint32_t timeout_ms)
+{
+  if (tryPop(frame))
+  {
+    return true;
+  }
+
+  // push() checks waiter_num_ after tail_ is moved. So either it notifies, or tryPop() below sees the frame.
+  waiter_num_++;
+
+  bool ret;
+  {
+    std::unique_lock<std::mutex> ul(mtx_);
+    ret = cv_.wait_for(ul, std::chrono::milliseconds(timeout_ms), [this, &frame] { return tryPop(frame); });
+  }
+
+  waiter_num_--;
+  return ret;
+}
+
+}  // namespace lidar
+}  // namespace robosense
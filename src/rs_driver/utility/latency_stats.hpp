@@ -0,0 +1,334 @@
+/*********************************************************************************************************************
+Copyright (c) 2020 RoboSense
+All rights reserved
+
+By downloading, copying, installing or using the software you agree to this license. If you do not agree to this
+license, do not download, install, copy or use the software.
+
+License Agreement
+For RoboSense LiDAR SDK Library
+(3-clause BSD License)
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that the
+following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following
+disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following
+disclaimer in the documentation and/or other materials provided with the distribution.
+
+3. Neither the names of the RoboSense, nor Suteng Innovation Technology, nor the names of other contributors may be used
+to endorse or promote products derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*********************************************************************************************************************/
+
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <iomanip>
+#include <sstream>
+#include <string>
+
+namespace robosense
+{
+namespace lidar
+{
+
+//
+// Stages of a packet, from receiving to the point cloud callback. 
+// With ENABLE_LATENCY_STATS, the driver timestamps the packet at 
+//   receive (the socket/file read returns), enqueue (push into the packet queue), dequeue (the handle thread pops it),
+//   decode finish, split (a frame is complete), and callback (cb_put_cloud is called, and returns).
+//
+enum LatencyStage
+{
+  LAT_RECV = 0,      ///< receive -> enqueue
+  LAT_QUEUE,         ///< enqueue -> dequeue
+  LAT_DECODE,        ///< dequeue -> decode finish. Includes the split and callback of the packet ending a frame.
+  LAT_SPLIT,         ///< split -> callback, i.e. the point cloud header and the sector callback
+  LAT_CALLBACK,      ///< time spent in the point cloud callback
+  LAT_TOTAL,         ///< receive of the packet ending a frame -> callback
+  LAT_STAGE_NUM
+};
+
+inline const char* latencyStageToStr(int stage)
+{
+  static const char* names[LAT_STAGE_NUM] = 
+  {
+    "recv", "queue", "decode", "split", "callback", "total"
+  };
+
+  return (stage >= 0 && stage < LAT_STAGE_NUM) ? names[stage] : "unknown";
+}
+
+// monotonic time in nanoseconds
+inline uint64_t latencyNow()
+{
+  return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+      std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+struct LatencySummary
+{
+  uint64_t count = 0;  ///< Samples recorded
+  double min = 0;      ///< in microseconds
+  double mean = 0;
+  double p50 = 0;
+  double p90 = 0;
+  double p99 = 0;
+  double p999 = 0;
+  double max = 0;
+};
+
+struct LatencyReport
+{
+  LatencySummary stages[LAT_STAGE_NUM];
+
+  std::string toString() const;
+};
+
+inline std::string LatencyReport::toString() const
+{
+  std::stringstream ss;
+  ss << std::fixed << std::setprecision(1)
+    << std::left << std::setw(10) << "stage(us)" << std::right
+    << std::setw(10) << "count" << std::setw(10) << "min" << std::setw(10) << "mean" 
+    << std::setw(10) << "p50" << std::setw(10) << "p90" << std::setw(10) << "p99" 
+    << std::setw(10) << "p99.9" << std::setw(10) << "max" << std::endl;
+
+  for (int i = 0; i < LAT_STAGE_NUM; i++)
+  {
+    const LatencySummary& s = stages[i];
+    ss << std::left << std::setw(10) << latencyStageToStr(i) << std::right
+      << std::setw(10) << s.count << std::setw(10) << s.min << std::setw(10) << s.mean
+      << std::setw(10) << s.p50 << std::setw(10) << s.p90 << std::setw(10) << s.p99 
+      << std::setw(10) << s.p999 << std::setw(10) << s.max << std::endl;
+  }
+
+  return ss.str();
+}
+
+//
+// HDR style histogram of nanoseconds. Values below 2^SUB_BITS are exact. Above it, each power of 2 
+// is split into 2^SUB_BITS linear sub-buckets, so the relative error is below 1/2^SUB_BITS (about 3%),
+// for values up to 2^MAX_BITS ns (about 18 minutes). Larger values are clamped.
+//
+// record() is lock free and may be called by multiple threads. The readers may see a sample partially
+// recorded, which is fine for statistics.
+//
+class LatencyHistogram
+{
+public:
+
+  constexpr static int SUB_BITS = 5;
+  constexpr static int SUB_NUM = (1 << SUB_BITS);
+  constexpr static int MAX_BITS = 40;
+  constexpr static int BUCKET_NUM = (MAX_BITS - SUB_BITS + 1) * SUB_NUM;
+
+  LatencyHistogram()
+  {
+    reset();
+  }
+
+  void record(uint64_t ns);
+  void reset();
+  LatencySummary summary() const;
+
+  uint64_t count() const
+  {
+    return count_.load(std::memory_order_relaxed);
+  }
+
+  // value (ns) below which p (0 ~ 1) of the samples are.
+  uint64_t percentile(double p) const;
+
+#ifndef UNIT_TEST
+private:
+#endif
+
+  static int bucketIndex(uint64_t ns);
+  static uint64_t bucketUpper(int idx);
+
+  std::atomic<uint64_t> buckets_[BUCKET_NUM];
+  std::atomic<uint64_t> count_;
+  std::atomic<uint64_t> sum_;
+  std::atomic<uint64_t> min_;
+  std::atomic<uint64_t> max_;
+};
+
+inline int LatencyHistogram::bucketIndex(uint64_t ns)
+{
+  if (ns < (uint64_t)SUB_NUM)
+  {
+    return (int)ns;
+  }
+
+  int msb;
+#if defined(__GNUC__) || defined(__clang__)
+  msb = 63 - __builtin_clzll(ns);
+#else
+  msb = 0;
+  for (uint64_t v = ns >> 1; v != 0; v >>= 1)
+  {
+    msb++;
+  }
+#endif
+
+  if (msb >= MAX_BITS)
+  {
+    return BUCKET_NUM - 1;
+  }
+
+  int shift = msb - SUB_BITS;
+  return (shift + 1) * SUB_NUM + (int)((ns >> shift) & (SUB_NUM - 1));
+}
+
+inline uint64_t LatencyHistogram::bucketUpper(int idx)
+{
+  if (idx < SUB_NUM)
+  {
+    return (uint64_t)idx;
+  }
+
+  int shift = idx / SUB_NUM - 1;
+  uint64_t sub = (uint64_t)(idx % SUB_NUM);
+  return (((uint64_t)SUB_NUM + sub + 1) << shift) - 1;
+}
+
+inline void LatencyHistogram::record(uint64_t ns)
+{
+  buckets_[bucketIndex(ns)].fetch_add(1, std::memory_order_relaxed);
+  count_.fetch_add(1, std::memory_order_relaxed);
+  sum_.fetch_add(ns, std::memory_order_relaxed);
+
+  uint64_t cur = min_.load(std::memory_order_relaxed);
+  while (ns < cur && !min_.compare_exchange_weak(cur, ns, std::memory_order_relaxed))
+  {
+  }
+
+  cur = max_.load(std::memory_order_relaxed);
+  while (ns > cur && !max_.compare_exchange_weak(cur, ns, std::memory_order_relaxed))
+  {
+  }
+}
+
+inline void LatencyHistogram::reset()
+{
+  for (auto& b : buckets_)
+  {
+    b.store(0, std::memory_order_relaxed);
+  }
+
+  count_.store(0, std::memory_order_relaxed);
+  sum_.store(0, std::memory_order_relaxed);
+  min_.store(UINT64_MAX, std::memory_order_relaxed);
+  max_.store(0, std::memory_order_relaxed);
+}
+
+inline uint64_t LatencyHistogram::percentile(double p) const
+{
+  uint64_t total = 0;
+  for (const auto& b : buckets_)
+  {
+    total += b.load(std::memory_order_relaxed);
+  }
+
+  if (total == 0)
+  {
+    return 0;
+  }
+
+  uint64_t rank = (uint64_t)(p * total + 0.5);
+  if (rank == 0)
+  {
+    rank = 1;
+  }
+
+  uint64_t acc = 0;
+  for (int i = 0; i < BUCKET_NUM; i++)
+  {
+    acc += buckets_[i].load(std::memory_order_relaxed);
+    if (acc >= rank)
+    {
+      // not beyond the max sample.
+      uint64_t upper = bucketUpper(i);
+      uint64_t max = max_.load(std::memory_order_relaxed);
+      return (upper < max) ? upper : max;
+    }
+  }
+
+  return max_.load(std::memory_order_relaxed);
+}
+
+inline LatencySummary LatencyHistogram::summary() const
+{
+  LatencySummary s;
+  s.count = count();
+  if (s.count == 0)
+  {
+    return s;
+  }
+
+  s.min = min_.load(std::memory_order_relaxed) / 1e3;
+  s.max = max_.load(std::memory_order_relaxed) / 1e3;
+  s.mean = (double)sum_.load(std::memory_order_relaxed) / s.count / 1e3;
+  s.p50 = percentile(0.5) / 1e3;
+  s.p90 = percentile(0.9) / 1e3;
+  s.p99 = percentile(0.99) / 1e3;
+  s.p999 = percentile(0.999) / 1e3;
+  return s;
+}
+
+//
+// Histograms of all stages of a driver instance (a Lidar).
+//
+class LatencyStats
+{
+public:
+
+  void record(LatencyStage stage, uint64_t begin_ns, uint64_t end_ns)
+  {
+    // the stamps may be missing, e.g. packets fed by decodePacket(). 
+    if (begin_ns != 0 && end_ns >= begin_ns)
+    {
+      hists_[stage].record(end_ns - begin_ns);
+    }
+  }
+
+  LatencyReport report() const
+  {
+    LatencyReport r;
+    for (int i = 0; i < LAT_STAGE_NUM; i++)
+    {
+      r.stages[i] = hists_[i].summary();
+    }
+
+    return r;
+  }
+
+  void reset()
+  {
+    for (auto& h : hists_)
+    {
+      h.reset();
+    }
+  }
+
+private:
+
+  LatencyHistogram hists_[LAT_STAGE_NUM];
+};
+
+}  // namespace lidar
+}  // namespace robosense
@@ -0,0 +1,389 @@
+/*********************************************************************************************************************
+Copyright (c) 2020 RoboSense
+All rights reserved
+
+By downloading, copying, installing or using the software you agree to this license. If you do not agree to this
+license, do not download, install, copy or use the software.
+
+License Agreement
+For RoboSense LiDAR SDK Library
+(3-clause BSD License)
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that the
+following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following
+disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following
+disclaimer in the documentation and/or other materials provided with the distribution.
+
+3. Neither the names of the RoboSense, nor Suteng Innovation Technology, nor the names of other contributors may be used
+to endorse or promote products derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*********************************************************************************************************************/
+
+
+#pragma once
+
+#include <rs_driver/common/rs_log.hpp>
+#include <rs_driver/driver/driver_param.hpp>
+#include <rs_driver/driver/thread_setting.hpp>
+
+#include <unistd.h>
+#include <poll.h>
+#include <arpa/inet.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <thread>
+#include <functional>
+#include <cstring>
+#include <cstdio>
+#include <cerrno>
+
+#ifndef MSG_NOSIGNAL
+#define MSG_NOSIGNAL 0
+#endif
+
+namespace robosense
+{
+namespace lidar
+{
+
+//
+// A minimal HTTP/1.0 server in its own thread. It serves a text rendered by the callback at each request, 
+// on a TCP port or a Unix socket. Requests are served one by one, and each connection is closed after the reply.
+//
+class MetricsServer
+{
+public:
+
+  typedef std::function<std::string(void)> RenderCallback;
+
+  MetricsServer()
+    : fd_(-1), port_(0), to_exit_(false), start_flag_(false)
+  {
+  }
+
+  ~MetricsServer();
+
+  bool init(const RSMetricsParam& param, const RenderCallback& cb_render);
+  bool start();
+  void stop();
+
+  uint16_t port() const
+  {
+    return port_;
+  }
+
+#ifndef UNIT_TEST
+private:
+#endif
+
+  void serve();
+  void reply(int fd);
+  bool waitConn(int fd, short events, const std::chrono::steady_clock::time_point& deadline);
+
+  RSMetricsParam param_;
+  RenderCallback cb_render_;
+  int fd_;
+  uint16_t port_;
+  std::thread thread_;
+  std::atomic<bool> to_exit_;
+  bool start_flag_;
+};
+
+inline MetricsServer::~MetricsServer()
+{
+  stop();
+
+  if (fd_ >= 0)
+  {
+    close(fd_);
+
+    if (!param_.unix_path.empty())
+    {
+      unlink(param_.unix_path.c_str());
+    }
+  }
+}
+
+inline bool MetricsServer::init(const RSMetricsParam& param, const RenderCallback& cb_render)
+{
+  int fd;
+  int ret;
+
+  if (fd_ >= 0)
+  {
+    return true;
+  }
+
+  param_ = param;
+  cb_render_ = cb_render;
+
+  if (!param.unix_path.empty())
+  {
+    struct sockaddr_un addr;
+    if (param.unix_path.size() >= sizeof(addr.sun_path))
+    {
+      RS_ERROR << "Unix socket path too long: " << param.unix_path << RS_REND;
+      goto failSocket;
+    }
+
+    fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0)
+    {
+      perror("socket: ");
+      goto failSocket;
+    }
+
+    // a stale socket file of a previous run.
+    unlink(param.unix_path.c_str());
+
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strncpy(addr.sun_path, param.unix_path.c_str(), sizeof(addr.sun_path) - 1);
+
+    ret = bind(fd, (struct sockaddr*)&addr, sizeof(addr));
+    if (ret < 0)
+    {
+      perror("bind: ");
+      goto failBind;
+    }
+  }
+  else
+  {
+    fd = socket(PF_INET, SOCK_STREAM, 0);
+    if (fd < 0)
+    {
+      perror("socket: ");
+      goto failSocket;
+    }
+
+    int reuse = 1;
+    ret = setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+    if (ret < 0)
+    {
+      perror("setsockopt: ");
+      goto failBind;
+    }
+
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(param.port);
+    if (inet_pton(AF_INET, param.address.c_str(), &(addr.sin_addr)) != 1)
+    {
+      RS_ERROR << "Wrong metrics address: " << param.address << RS_REND;
+      goto failBind;
+    }
+
+    ret = bind(fd, (struct sockaddr*)&addr, sizeof(addr));
+    if (ret < 0)
+    {
+      perror("bind: ");
+      goto failBind;
+    }
+
+    // the port chosen by the system, if param.port is 0.
+    socklen_t addr_len = sizeof(addr);
+    getsockname(fd, (struct sockaddr*)&addr, &addr_len);
+    port_ = ntohs(addr.sin_port);
+  }
+
+  ret = listen(fd, 8);
+  if (ret < 0)
+  {
+    perror("listen: ");
+    goto failBind;
+  }
+
+  fd_ = fd;
+  return true;
+
+failBind:
+  close(fd);
+failSocket:
+  return false;
+}
+
+inline bool MetricsServer::start()
+{
+  if (start_flag_)
+  {
+    return true;
+  }
+
+  if (fd_ < 0)
+  {
+    return false;
+  }
+
+  to_exit_ = false;
+  thread_ = std::thread(std::bind(&MetricsServer::serve, this));
+
+  start_flag_ = true;
+  return true;
+}
+
+inline void MetricsServer::stop()
+{
+  if (!start_flag_)
+  {
+    return;
+  }
+
+  to_exit_ = true;
+  thread_.join();
+
+  start_flag_ = false;
+}
+
+inline void MetricsServer::serve()
+{
+  applyThreadParam(param_.thread_param, "rs_metrics");
+
+  while (!to_exit_)
+  {
+    struct pollfd pfd;
+    pfd.fd = fd_;
+    pfd.events = POLLIN;
+    pfd.revents = 0;
+
+    int ret = poll(&pfd, 1, 200);
+    if (ret <= 0)
+    {
+      if ((ret < 0) && (errno != EINTR))
+      {
+        perror("poll: ");
+        break;
+      }
+
+      continue;
+    }
+
+    int conn = accept(fd_, NULL, NULL);
+    if (conn < 0)
+    {
+      continue;
+    }
+
+    reply(conn);
+    close(conn);
+  }
+}
+
+inline bool MetricsServer::waitConn(int fd, short events, const std::chrono::steady_clock::time_point& deadline)
+{
+  while (!to_exit_)
+  {
+    int64_t left_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+        deadline - std::chrono::steady_clock::now()).count();
+    if (left_ms <= 0)
+    {
+      return false;
+    }
+
+    struct pollfd pfd;
+    pfd.fd = fd;
+    pfd.events = events;
+    pfd.revents = 0;
+
+    int ret = poll(&pfd, 1, (int)std::min<int64_t>(left_ms, 200));
+    if (ret > 0)
+    {
+      return true;
+    }
+    else if ((ret < 0) && (errno != EINTR))
+    {
+      return false;
+    }
+  }
+
+  return false;
+}
+
+inline void MetricsServer::reply(int fd)
+{
+  constexpr static int REQUEST_TIMEOUT_MS = 1000;
+  constexpr static size_t REQUEST_MAX = 4096;
+
+  // the whole exchange with a client is bounded, so a slow or silent client doesn't block the server long.
+  std::chrono::steady_clock::time_point deadline = 
+    std::chrono::steady_clock::now() + std::chrono::milliseconds(REQUEST_TIMEOUT_MS);
+
+  // read the request header.
+  std::string req;
+  char buf[512];
+  while ((req.find("\r\n\r\n") == std::string::npos) && (req.size() < REQUEST_MAX))
+  {
+    if (!waitConn(fd, POLLIN, deadline))
+    {
+      return;
+    }
+
+    ssize_t n = recv(fd, buf, sizeof(buf), 0);
+    if (n <= 0)
+    {
+      return;
+    }
+
+    req.append(buf, (size_t)n);
+  }
+
+  std::string status;
+  std::string body;
+  if ((req.compare(0, 13, "GET /metrics ") == 0) || (req.compare(0, 6, "GET / ") == 0))
+  {
+    status = "200 OK";
+    body = cb_render_();
+  }
+  else
+  {
+    status = "404 Not Found";
+  }
+
+  std::string rsp = "HTTP/1.0 " + status + "\r\n"
+    "Content-Type: text/plain; version=0.0.4; charset=utf-8\r\n"
+    "Content-Length: " + std::to_string(body.size()) + "\r\n"
+    "Connection: close\r\n\r\n" + body;
+
+  // send the reply.
+  size_t sent = 0;
+  while (sent < rsp.size())
+  {
+    if (!waitConn(fd, POLLOUT, deadline))
+    {
+      return;
+    }
+
+    ssize_t n = send(fd, rsp.data() + sent, rsp.size() - sent, MSG_NOSIGNAL | MSG_DONTWAIT);
+    if (n <= 0)
+    {
+      if ((n < 0) && ((errno == EAGAIN) || (errno == EWOULDBLOCK) || (errno == EINTR)))
+      {
+        continue;
+      }
+
+      return;
+    }
+
+    sent += (size_t)n;
+  }
+}
+
+}  // namespace lidar
+}  // namespace robosense
@@ -0,0 +1,799 @@
+/*********************************************************************************************************************
+Copyright (c) 2020 RoboSense
+All rights reserved
+
+By downloading, copying, installing or using the software you agree to this license. If you do not agree to this
+license, do not download, install, copy or use the software.
+
+License Agreement
+For RoboSense LiDAR SDK Library
+(3-clause BSD License)
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that the
+following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following
+disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following
+disclaimer in the documentation and/or other materials provided with the distribution.
+
+3. Neither the names of the RoboSense, nor Suteng Innovation Technology, nor the names of other contributors may be used
+to endorse or promote products derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*********************************************************************************************************************/
+
+
+#pragma once
+
+#include <rs_driver/common/rs_log.hpp>
+#include <rs_driver/driver/driver_param.hpp>
+
+#ifdef ENABLE_ZLIB
+#include <zlib.h>
+#endif
+
+#ifdef ENABLE_ZSTD
+#include <zstd.h>
+#endif
+
+#include <stdio.h>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <algorithm>
+
+namespace robosense
+{
+namespace lidar
+{
+
+//
+// rs_driver packet log (.rslog)
+//
+// A log file keeps only the UDP payload of MSOP/DIFOP packets, with their timestamps, 
+// packet kind and source. Packets are grouped into chunks, and each chunk is compressed as a whole.
+// An index of the chunks is appended at the end of the file, for seeking.
+//
+// +-----------------+
+// | LogFileHeader   |   index_offset is written when the file is closed.
+// +-----------------+
+// | LogChunkHeader  |
+// | chunk data      |   (LogPacketHeader + payload) * pkt_num, compressed with codec
+// +-----------------+
+// | ...             |
+// +-----------------+
+// | LogIndexEntry   |   one for each chunk
+// | ...             |
+// +-----------------+
+//
+// If the file is not closed normally (no index), the reader rebuilds the index by scanning the chunks.
+// All fields are written in the byte order of the host, i.e. little endian on the supported platforms.
+// A file written on a big endian host is rejected by the magic checks.
+//
+
+#pragma pack(push, 1)
+
+struct LogFileHeader
+{
+  char magic[8];
+  uint16_t version;
+  uint16_t codec;
+  uint32_t reserved;
+  uint64_t index_offset;
+  uint64_t chunk_num;
+};
+
+struct LogChunkHeader
+{
+  uint32_t magic;
+  uint16_t codec;
+  uint16_t reserved;
+  uint32_t raw_size;
+  uint32_t comp_size;
+  uint32_t pkt_num;
+  uint32_t reserved2;
+  uint64_t ts_first;
+  uint64_t ts_last;
+};
+
+struct LogPacketHeader
+{
+  uint64_t ts;      // host time in microseconds
+  uint16_t len;     // length of payload
+  uint8_t kind;     // LogPacketKind
+  uint8_t source;   // which Lidar the packet is from
+};
+
+struct LogIndexEntry
+{
+  uint64_t offset;  // offset of LogChunkHeader
+  uint64_t ts_first;
+  uint64_t ts_last;
+  uint32_t pkt_num;
+  uint32_t reserved;
+};
+
+#pragma pack(pop)
+
+enum LogPacketKind
+{
+  LOG_PKT_MSOP = 0,
+  LOG_PKT_DIFOP = 1
+};
+
+const char LOG_FILE_MAGIC[8] = {'R', 'S', 'L', 'O', 'G', 0, 0, 0};
+const uint16_t LOG_FILE_VERSION = 1;
+const uint32_t LOG_CHUNK_MAGIC = 0x4b434c52; // "RLCK"
+
+// raw size of a chunk. The writer never writes a larger one, and the reader rejects it.
+const size_t LOG_MAX_CHUNK_SIZE = 67108864;
+
+struct LogPacket
+{
+  uint64_t ts;
+  uint8_t kind;
+  uint8_t source;
+  const uint8_t* data;
+  size_t size;
+};
+
+inline int logSeek(FILE* fp, uint64_t offset, int whence)
+{
+#ifdef _WIN32
+  return _fseeki64(fp, (int64_t)offset, whence);
+#else
+  return fseeko(fp, (off_t)offset, whence);
+#endif
+}
+
+inline uint64_t logTell(FILE* fp)
+{
+#ifdef _WIN32
+  return (uint64_t)_ftelli64(fp);
+#else
+  return (uint64_t)ftello(fp);
+#endif
+}
+
+//
+// Whether the codec is compiled in.
+//
+inline bool isLogCodecSupported(LogCodec codec)
+{
+  switch (codec)
+  {
+    case LOG_CODEC_NONE:
+      return true;
+#ifdef ENABLE_ZLIB
+    case LOG_CODEC_ZLIB:
+      return true;
+#endif
+#ifdef ENABLE_ZSTD
+    case LOG_CODEC_ZSTD:
+      return true;
+#endif
+    default:
+      return false;
+  }
+}
+
+class PacketLogWriter
+{
+public:
+
+  PacketLogWriter(size_t chunk_size = 1048576)
+    : fp_(NULL), codec_(LOG_CODEC_NONE), chunk_size_(chunk_size), chunk_pkts_(0), 
+      chunk_ts_first_(0), chunk_ts_last_(0), bytes_(0)
+  {
+    // a chunk may exceed chunk_size_ by a packet.
+    if (chunk_size_ > LOG_MAX_CHUNK_SIZE - 65536)
+    {
+      chunk_size_ = LOG_MAX_CHUNK_SIZE - 65536;
+    }
+  }
+
+  ~PacketLogWriter()
+  {
+    close();
+  }
+
+  //
+  // Size of a packet record in chunk data.
+  //
+  static size_t recordSize(size_t size)
+  {
+    return sizeof(LogPacketHeader) + size;
+  }
+
+  //
+  // Encode a packet record into buf, which should have at least recordSize(size) bytes.
+  //
+  static size_t encodeRecord(uint8_t* buf, uint64_t ts, uint8_t kind, uint8_t source, 
+      const uint8_t* data, size_t size);
+
+  bool open(const std::string& path, LogCodec codec);
+  bool isOpen() const
+  {
+    return (fp_ != NULL);
+  }
+
+  //
+  // Append a packet to the current chunk. The chunk is written when it exceeds chunk_size.
+  //
+  bool write(uint64_t ts, uint8_t kind, uint8_t source, const uint8_t* data, size_t size);
+
+  //
+  // Write a chunk of encoded packet records.
+  //
+  bool writeChunk(const uint8_t* raw, size_t raw_size, uint32_t pkt_num, uint64_t ts_first, uint64_t ts_last);
+
+  bool flush();
+  void close();
+
+  uint64_t bytes() const
+  {
+    return bytes_;
+  }
+
+private:
+
+  bool compress(const uint8_t* raw, size_t raw_size);
+
+  FILE* fp_;
+  LogCodec codec_;
+  size_t chunk_size_;
+  std::vector<uint8_t> chunk_;
+  uint32_t chunk_pkts_;
+  uint64_t chunk_ts_first_;
+  uint64_t chunk_ts_last_;
+  std::vector<uint8_t> comp_;
+  std::vector<LogIndexEntry> index_;
+  uint64_t bytes_;
+};
+
+class PacketLogReader
+{
+public:
+
+  PacketLogReader()
+    : fp_(NULL), file_size_(0), chunk_idx_(0), raw_pos_(0), raw_size_(0)
+  {
+    memset (&hdr_, 0, sizeof(hdr_));
+  }
+
+  ~PacketLogReader()
+  {
+    close();
+  }
+
+  bool open(const std::string& path);
+  void close();
+
+  bool isOpen() const
+  {
+    return (fp_ != NULL);
+  }
+
+  FILE* file() const
+  {
+    return fp_;
+  }
+
+  //
+  // Get the next packet. pkt.data is valid until the next call. Return false at the end of file.
+  //
+  bool next(LogPacket& pkt);
+
+  //
+  // Move to the first packet whose timestamp is not earlier than ts.
+  //
+  bool seek(uint64_t ts);
+  void rewind();
+
+  const std::vector<LogIndexEntry>& index() const
+  {
+    return index_;
+  }
+
+  LogCodec codec() const
+  {
+    return (LogCodec)hdr_.codec;
+  }
+
+private:
+
+  bool loadIndex();
+  bool scanChunks();
+  bool loadChunk(size_t idx);
+  bool decompress(uint16_t codec, size_t raw_size);
+
+  FILE* fp_;
+  uint64_t file_size_;
+  LogFileHeader hdr_;
+  std::vector<LogIndexEntry> index_;
+  size_t chunk_idx_;   // index of the next chunk to load
+  std::vector<uint8_t> comp_;
+  std::vector<uint8_t> raw_;
+  size_t raw_pos_;
+  size_t raw_size_;
+};
+
+inline size_t PacketLogWriter::encodeRecord(uint8_t* buf, uint64_t ts, uint8_t kind, uint8_t source,
+    const uint8_t* data, size_t size)
+{
+  LogPacketHeader hdr;
+  hdr.ts = ts;
+  hdr.len = (uint16_t)size;
+  hdr.kind = kind;
+  hdr.source = source;
+
+  memcpy (buf, &hdr, sizeof(hdr));
+  memcpy (buf + sizeof(hdr), data, size);
+  return sizeof(hdr) + size;
+}
+
+inline bool PacketLogWriter::open(const std::string& path, LogCodec codec)
+{
+  close();
+
+  if (!isLogCodecSupported(codec))
+  {
+    RS_WARNING << logCodecToStr(codec) << " is not compiled in. Write log file without compression." << RS_REND;
+    codec = LOG_CODEC_NONE;
+  }
+
+  fp_ = fopen(path.c_str(), "wb");
+  if (fp_ == NULL)
+  {
+    RS_ERROR << "Fail to open log file: " << path << RS_REND;
+    return false;
+  }
+
+  codec_ = codec;
+  chunk_.clear();
+  chunk_.reserve(chunk_size_ + 65536);
+  chunk_pkts_ = 0;
+  index_.clear();
+  bytes_ = 0;
+
+  LogFileHeader hdr;
+  memset (&hdr, 0, sizeof(hdr));
+  memcpy (hdr.magic, LOG_FILE_MAGIC, sizeof(hdr.magic));
+  hdr.version = LOG_FILE_VERSION;
+  hdr.codec = (uint16_t)codec_;
+
+  if (fwrite(&hdr, sizeof(hdr), 1, fp_) != 1)
+  {
+    close();
+    return false;
+  }
+
+  bytes_ += sizeof(hdr);
+  return true;
+}
+
+inline bool PacketLogWriter::write(uint64_t ts, uint8_t kind, uint8_t source, const uint8_t* data, size_t size)
+{
+  if (fp_ == NULL)
+  {
+    return false;
+  }
+
+  if (chunk_pkts_ == 0)
+  {
+    chunk_ts_first_ = ts;
+  }
+  chunk_ts_last_ = ts;
+
+  size_t offset = chunk_.size();
+  chunk_.resize(offset + recordSize(size));
+  encodeRecord(chunk_.data() + offset, ts, kind, source, data, size);
+  chunk_pkts_++;
+
+  if (chunk_.size() >= chunk_size_)
+  {
+    return flush();
+  }
+
+  return true;
+}
+
+inline bool PacketLogWriter::flush()
+{
+  if (chunk_pkts_ == 0)
+  {
+    return true;
+  }
+
+  bool ret = writeChunk(chunk_.data(), chunk_.size(), chunk_pkts_, chunk_ts_first_, chunk_ts_last_);
+  chunk_.clear();
+  chunk_pkts_ = 0;
+  return ret;
+}
+
+inline bool PacketLogWriter::compress(const uint8_t* raw, size_t raw_size)
+{
+  switch (codec_)
+  {
+#ifdef ENABLE_ZLIB
+    case LOG_CODEC_ZLIB:
+      {
+        uLongf comp_size = compressBound((uLong)raw_size);
+        comp_.resize(comp_size);
+        if (compress2(comp_.data(), &comp_size, raw, (uLong)raw_size, 1) != Z_OK)
+        {
+          return false;
+        }
+        comp_.resize(comp_size);
+      }
+      return true;
+#endif
+
+#ifdef ENABLE_ZSTD
+    case LOG_CODEC_ZSTD:
+      {
+        comp_.resize(ZSTD_compressBound(raw_size));
+        size_t comp_size = ZSTD_compress(comp_.data(), comp_.size(), raw, raw_size, 3);
+        if (ZSTD_isError(comp_size))
+        {
+          return false;
+        }
+        comp_.resize(comp_size);
+      }
+      return true;
+#endif
+
+    default:
+      return false;
+  }
+}
+
+inline bool PacketLogWriter::writeChunk(const uint8_t* raw, size_t raw_size, 
+    uint32_t pkt_num, uint64_t ts_first, uint64_t ts_last)
+{
+  if ((fp_ == NULL) || (pkt_num == 0))
+  {
+    return (fp_ != NULL);
+  }
+
+  if (raw_size > LOG_MAX_CHUNK_SIZE)
+  {
+    RS_ERROR << "Log chunk is too large." << RS_REND;
+    return false;
+  }
+
+  const uint8_t* data = raw;
+  size_t data_size = raw_size;
+
+  if (codec_ != LOG_CODEC_NONE)
+  {
+    if (!compress(raw, raw_size))
+    {
+      RS_ERROR << "Fail to compress log chunk." << RS_REND;
+      return false;
+    }
+
+    data = comp_.data();
+    data_size = comp_.size();
+  }
+
+  LogChunkHeader chunk_hdr;
+  memset (&chunk_hdr, 0, sizeof(chunk_hdr));
+  chunk_hdr.magic = LOG_CHUNK_MAGIC;
+  chunk_hdr.codec = (uint16_t)codec_;
+  chunk_hdr.raw_size = (uint32_t)raw_size;
+  chunk_hdr.comp_size = (uint32_t)data_size;
+  chunk_hdr.pkt_num = pkt_num;
+  chunk_hdr.ts_first = ts_first;
+  chunk_hdr.ts_last = ts_last;
+
+  LogIndexEntry entry;
+  entry.offset = bytes_;
+  entry.ts_first = ts_first;
+  entry.ts_last = ts_last;
+  entry.pkt_num = pkt_num;
+  entry.reserved = 0;
+
+  if ((fwrite(&chunk_hdr, sizeof(chunk_hdr), 1, fp_) != 1) || 
+      (fwrite(data, 1, data_size, fp_) != data_size))
+  {
+    RS_ERROR << "Fail to write log chunk." << RS_REND;
+    return false;
+  }
+
+  bytes_ += sizeof(chunk_hdr) + data_size;
+  index_.push_back(entry);
+  return true;
+}
+
+inline void PacketLogWriter::close()
+{
+  if (fp_ == NULL)
+  {
+    return;
+  }
+
+  flush();
+
+  uint64_t index_offset = bytes_;
+  size_t index_size = index_.size() * sizeof(LogIndexEntry);
+  if ((index_size == 0) || (fwrite(index_.data(), 1, index_size, fp_) == index_size))
+  {
+    bytes_ += index_size;
+
+    LogFileHeader hdr;
+    memset (&hdr, 0, sizeof(hdr));
+    memcpy (hdr.magic, LOG_FILE_MAGIC, sizeof(hdr.magic));
+    hdr.version = LOG_FILE_VERSION;
+    hdr.codec = (uint16_t)codec_;
+    hdr.index_offset = index_offset;
+    hdr.chunk_num = index_.size();
+
+    logSeek(fp_, 0, SEEK_SET);
+    fwrite(&hdr, sizeof(hdr), 1, fp_);
+  }
+
+  fclose(fp_);
+  fp_ = NULL;
+}
+
+inline bool PacketLogReader::open(const std::string& path)
+{
+  close();
+
+  fp_ = fopen(path.c_str(), "rb");
+  if (fp_ == NULL)
+  {
+    RS_ERROR << "Fail to open log file: " << path << RS_REND;
+    return false;
+  }
+
+  // the sizes read from the file are checked against it.
+  logSeek(fp_, 0, SEEK_END);
+  file_size_ = logTell(fp_);
+  logSeek(fp_, 0, SEEK_SET);
+
+  if ((fread(&hdr_, sizeof(hdr_), 1, fp_) != 1) || 
+      (memcmp(hdr_.magic, LOG_FILE_MAGIC, sizeof(hdr_.magic)) != 0))
+  {
+    RS_ERROR << "Not a rs_driver log file: " << path << RS_REND;
+    close();
+    return false;
+  }
+
+  if (hdr_.version > LOG_FILE_VERSION)
+  {
+    RS_ERROR << "Unsupported log file version: " << hdr_.version << RS_REND;
+    close();
+    return false;
+  }
+
+  if (!loadIndex() && !scanChunks())
+  {
+    close();
+    return false;
+  }
+
+  rewind();
+  return true;
+}
+
+inline void PacketLogReader::close()
+{
+  if (fp_ != NULL)
+  {
+    fclose(fp_);
+    fp_ = NULL;
+  }
+
+  index_.clear();
+  chunk_idx_ = 0;
+  raw_pos_ = raw_size_ = 0;
+}
+
+inline bool PacketLogReader::loadIndex()
+{
+  if ((hdr_.index_offset == 0) || (hdr_.chunk_num == 0) || 
+      (hdr_.index_offset > file_size_) || (hdr_.chunk_num > (file_size_ - hdr_.index_offset) / sizeof(LogIndexEntry)))
+  {
+    return false;
+  }
+
+  index_.resize(hdr_.chunk_num);
+  if ((logSeek(fp_, hdr_.index_offset, SEEK_SET) != 0) || 
+      (fread(index_.data(), sizeof(LogIndexEntry), index_.size(), fp_) != index_.size()))
+  {
+    index_.clear();
+    return false;
+  }
+
+  return true;
+}
+
+inline bool PacketLogReader::scanChunks()
+{
+  RS_WARNING << "Log file is not closed normally. Scan its chunks." << RS_REND;
+
+  index_.clear();
+
+  uint64_t offset = sizeof(LogFileHeader);
+  while (1)
+  {
+    LogChunkHeader chunk_hdr;
+    if ((logSeek(fp_, offset, SEEK_SET) != 0) || 
+        (fread(&chunk_hdr, sizeof(chunk_hdr), 1, fp_) != 1) || 
+        (chunk_hdr.magic != LOG_CHUNK_MAGIC))
+    {
+      break;
+    }
+
+    // the last chunk may be truncated.
+    uint64_t next = offset + sizeof(chunk_hdr) + chunk_hdr.comp_size;
+    if ((logSeek(fp_, next - 1, SEEK_SET) != 0) || (fgetc(fp_) == EOF))
+    {
+      break;
+    }
+
+    LogIndexEntry entry;
+    entry.offset = offset;
+    entry.ts_first = chunk_hdr.ts_first;
+    entry.ts_last = chunk_hdr.ts_last;
+    entry.pkt_num = chunk_hdr.pkt_num;
+    entry.reserved = 0;
+    index_.push_back(entry);
+
+    offset = next;
+  }
+
+  return true;
+}
+
+inline bool PacketLogReader::decompress(uint16_t codec, size_t raw_size)
+{
+  raw_.resize(raw_size);
+
+  switch (codec)
+  {
+#ifdef ENABLE_ZLIB
+    case LOG_CODEC_ZLIB:
+      {
+        uLongf size = (uLongf)raw_size;
+        return (uncompress(raw_.data(), &size, comp_.data(), (uLong)comp_.size()) == Z_OK) && (size == raw_size);
+      }
+#endif
+
+#ifdef ENABLE_ZSTD
+    case LOG_CODEC_ZSTD:
+      {
+        size_t size = ZSTD_decompress(raw_.data(), raw_size, comp_.data(), comp_.size());
+        return !ZSTD_isError(size) && (size == raw_size);
+      }
+#endif
+
+    default:
+      RS_ERROR << logCodecToStr((LogCodec)codec) << " is not compiled in. Can not read log file." << RS_REND;
+      return false;
+  }
+}
+
+inline bool PacketLogReader::loadChunk(size_t idx)
+{
+  raw_pos_ = raw_size_ = 0;
+
+  LogChunkHeader chunk_hdr;
+  if ((logSeek(fp_, index_[idx].offset, SEEK_SET) != 0) || 
+      (fread(&chunk_hdr, sizeof(chunk_hdr), 1, fp_) != 1) || 
+      (chunk_hdr.magic != LOG_CHUNK_MAGIC))
+  {
+    RS_ERROR << "Wrong log chunk." << RS_REND;
+    return false;
+  }
+
+  //
+  // the sizes may be corrupt. Don't allocate for them blindly.
+  // An uncompressed chunk is read into raw_ directly. Its size should be the same.
+  //
+  uint64_t data_offset = index_[idx].offset + sizeof(chunk_hdr);
+  if ((chunk_hdr.raw_size > LOG_MAX_CHUNK_SIZE) || 
+      (data_offset + chunk_hdr.comp_size > file_size_) || 
+      ((chunk_hdr.codec == LOG_CODEC_NONE) && (chunk_hdr.raw_size != chunk_hdr.comp_size)))
+  {
+    RS_ERROR << "Wrong log chunk size." << RS_REND;
+    return false;
+  }
+
+  std::vector<uint8_t>& dst = (chunk_hdr.codec == LOG_CODEC_NONE) ? raw_ : comp_;
+  dst.resize(chunk_hdr.comp_size);
+  if (fread(dst.data(), 1, dst.size(), fp_) != dst.size())
+  {
+    RS_ERROR << "Truncated log chunk." << RS_REND;
+    return false;
+  }
+
+  if ((chunk_hdr.codec != LOG_CODEC_NONE) && !decompress(chunk_hdr.codec, chunk_hdr.raw_size))
+  {
+    return false;
+  }
+
+  raw_size_ = chunk_hdr.raw_size;
+  return true;
+}
+
+inline bool PacketLogReader::next(LogPacket& pkt)
+{
+  while (raw_pos_ + sizeof(LogPacketHeader) > raw_size_)
+  {
+    if ((chunk_idx_ >= index_.size()) || !loadChunk(chunk_idx_++))
+    {
+      return false;
+    }
+  }
+
+  LogPacketHeader hdr;
+  memcpy (&hdr, raw_.data() + raw_pos_, sizeof(hdr));
+  if (raw_pos_ + sizeof(hdr) + hdr.len > raw_size_)
+  {
+    RS_ERROR << "Wrong log packet." << RS_REND;
+    return false;
+  }
+
+  pkt.ts = hdr.ts;
+  pkt.kind = hdr.kind;
+  pkt.source = hdr.source;
+  pkt.data = raw_.data() + raw_pos_ + sizeof(hdr);
+  pkt.size = hdr.len;
+
+  raw_pos_ += sizeof(hdr) + hdr.len;
+  return true;
+}
+
+inline void PacketLogReader::rewind()
+{
+  chunk_idx_ = 0;
+  raw_pos_ = raw_size_ = 0;
+}
+
+inline bool PacketLogReader::seek(uint64_t ts)
+{
+  auto it = std::lower_bound(index_.begin(), index_.end(), ts, 
+      [](const LogIndexEntry& entry, uint64_t ts) { return entry.ts_last < ts; });
+  if (it == index_.end())
+  {
+    chunk_idx_ = index_.size();
+    raw_pos_ = raw_size_ = 0;
+    return false;
+  }
+
+  chunk_idx_ = (size_t)(it - index_.begin());
+  if (!loadChunk(chunk_idx_++))
+  {
+    return false;
+  }
+
+  // skip the earlier packets in the chunk.
+  while (raw_pos_ + sizeof(LogPacketHeader) <= raw_size_)
+  {
+    LogPacketHeader hdr;
+    memcpy (&hdr, raw_.data() + raw_pos_, sizeof(hdr));
+    if (hdr.ts >= ts)
+    {
+      break;
+    }
+
+    raw_pos_ += sizeof(hdr) + hdr.len;
+  }
+
+  return true;
+}
+
+}  // namespace lidar
+}  // namespace robosense
@@ -71,7 +71,7 @@ public:
 
   inline T pop()
   {
-    T value;
+    T value{};
 
     std::lock_guard<std::mutex> lg(mtx_);
     if (!queue_.empty())
@@ -90,7 +90,7 @@ public:
     //                                            - Hamlet
 
 #ifdef ENABLE_WAIT_IF_QUEUE_EMPTY
-    T value;
+    T value{};
 
     {
       std::lock_guard<std::mutex> lg(mtx_);
@@ -106,7 +106,7 @@ public:
     return value;
 #else
 
-    T value;
+    T value{};
 
     std::unique_lock<std::mutex> ul(mtx_);
     cv_.wait_for(ul, std::chrono::microseconds(usec), [this] { return (!queue_.empty()); });
@@ -121,6 +121,12 @@ public:
 #endif
   }
 
+  inline bool empty()
+  {
+    std::lock_guard<std::mutex> lg(mtx_);
+    return queue_.empty();
+  }
+
   inline void clear()
   {
     std::queue<T> empty;
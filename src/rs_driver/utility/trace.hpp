@@ -0,0 +1,364 @@
+/*********************************************************************************************************************
+Copyright (c) 2020 RoboSense
+All rights reserved
+
+By downloading, copying, installing or using the software you agree to this license. If you do not agree to this
+license, do not download, install, copy or use the software.
+
+License Agreement
+For RoboSense LiDAR SDK Library
+(3-clause BSD License)
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that the
+following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following
+disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following
+disclaimer in the documentation and/or other materials provided with the distribution.
+
+3. Neither the names of the RoboSense, nor Suteng Innovation Technology, nor the names of other contributors may be used
+to endorse or promote products derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*********************************************************************************************************************/
+
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <iomanip>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#ifdef __linux__
+#include <pthread.h>
+#endif
+
+namespace robosense
+{
+namespace lidar
+{
+
+//
+// Tracer records begin/end events of the driver threads, e.g. receiving a batch of packets, 
+// decoding a packet, splitting a frame and the user callbacks, and saves them as a Chrome trace JSON file.
+// Open it with chrome://tracing or https://ui.perfetto.dev to see the timeline of the threads.
+//
+// The events are recorded only if rs_driver is compiled with ENABLE_TRACE, and between Tracer::start() and stop().
+// Each thread writes its own buffer without lock. If the buffer is full, the later events are dropped.
+//
+
+struct TraceEvent
+{
+  const char* name;  // string literal
+  uint64_t begin_ns; // steady clock
+  uint64_t dur_ns;
+};
+
+class TraceBuffer
+{
+public:
+
+  TraceBuffer(size_t capacity, uint32_t tid, const std::string& thread_name)
+    : events_(capacity), size_(0), dropped_(0), tid_(tid), thread_name_(thread_name)
+  {
+  }
+
+  void push(const char* name, uint64_t begin_ns, uint64_t end_ns)
+  {
+    size_t n = size_.load(std::memory_order_relaxed);
+    if (n >= events_.size())
+    {
+      dropped_.store(dropped_.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+      return;
+    }
+
+    TraceEvent& e = events_[n];
+    e.name = name;
+    e.begin_ns = begin_ns;
+    e.dur_ns = end_ns - begin_ns;
+    size_.store(n + 1, std::memory_order_release);
+  }
+
+  size_t size() const
+  {
+    return size_.load(std::memory_order_acquire);
+  }
+
+  const TraceEvent& at(size_t i) const
+  {
+    return events_[i];
+  }
+
+  size_t dropped() const
+  {
+    return dropped_.load(std::memory_order_relaxed);
+  }
+
+  uint32_t tid() const
+  {
+    return tid_;
+  }
+
+  const std::string& threadName() const
+  {
+    return thread_name_;
+  }
+
+private:
+
+  std::vector<TraceEvent> events_;
+  std::atomic<size_t> size_;
+  std::atomic<size_t> dropped_;
+  uint32_t tid_;
+  std::string thread_name_;
+};
+
+class Tracer
+{
+public:
+
+  constexpr static size_t DEFAULT_EVENTS_PER_THREAD = 65536;
+
+  static Tracer& instance()
+  {
+    static Tracer tracer;
+    return tracer;
+  }
+
+  static uint64_t now()
+  {
+    return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+  }
+
+  // Start recording. The events of the previous recording are cleared.
+  void start(size_t events_per_thread = DEFAULT_EVENTS_PER_THREAD);
+  void stop();
+
+  bool enabled() const
+  {
+    return enabled_.load(std::memory_order_relaxed);
+  }
+
+  void record(const char* name, uint64_t begin_ns, uint64_t end_ns)
+  {
+    TraceBuffer* buf = threadBuffer();
+    if (buf != NULL)
+    {
+      buf->push(name, begin_ns, end_ns);
+    }
+  }
+
+  size_t eventNum();
+  size_t droppedNum();
+
+  // Save as Chrome trace JSON. It may be called while recording.
+  bool save(const std::string& file_path);
+
+#ifndef UNIT_TEST
+private:
+#endif
+
+  Tracer()
+    : enabled_(false), generation_(0), capacity_(DEFAULT_EVENTS_PER_THREAD), next_tid_(1)
+  {
+  }
+
+  TraceBuffer* threadBuffer();
+  static std::string currentThreadName(uint32_t tid);
+
+  std::atomic<bool> enabled_;
+  std::atomic<uint32_t> generation_;
+  size_t capacity_;
+  uint32_t next_tid_;
+  std::mutex mtx_;
+  std::vector<std::shared_ptr<TraceBuffer>> buffers_;
+  std::vector<std::shared_ptr<TraceBuffer>> retired_; // of the previous recording, in case a thread is still writing
+};
+
+inline void Tracer::start(size_t events_per_thread)
+{
+  std::lock_guard<std::mutex> lg(mtx_);
+
+  capacity_ = DEFAULT_EVENTS_PER_THREAD;
+  if (events_per_thread > 0)
+  {
+    capacity_ = events_per_thread;
+  }
+
+  retired_.swap(buffers_);
+  buffers_.clear();
+  generation_.fetch_add(1, std::memory_order_release);
+  enabled_.store(true, std::memory_order_release);
+}
+
+inline void Tracer::stop()
+{
+  enabled_.store(false, std::memory_order_release);
+}
+
+inline TraceBuffer* Tracer::threadBuffer()
+{
+  struct Cache
+  {
+    uint32_t generation;
+    TraceBuffer* buf;
+  };
+
+  static thread_local Cache cache = {0, NULL};
+
+  uint32_t generation = generation_.load(std::memory_order_acquire);
+  if (cache.generation != generation)
+  {
+    std::lock_guard<std::mutex> lg(mtx_);
+
+    uint32_t tid = next_tid_++;
+    std::shared_ptr<TraceBuffer> buf = std::make_shared<TraceBuffer>(capacity_, tid, currentThreadName(tid));
+    buffers_.push_back(buf);
+
+    cache.generation = generation;
+    cache.buf = buf.get();
+  }
+
+  return cache.buf;
+}
+
+inline std::string Tracer::currentThreadName(uint32_t tid)
+{
+#ifdef __linux__
+  char name[16] = {0};
+  if ((pthread_getname_np(pthread_self(), name, sizeof(name)) == 0) && (name[0] != 0))
+  {
+    return name;
+  }
+#endif
+
+  return "thread " + std::to_string(tid);
+}
+
+inline size_t Tracer::eventNum()
+{
+  std::lock_guard<std::mutex> lg(mtx_);
+
+  size_t num = 0;
+  for (auto& buf : buffers_)
+  {
+    num += buf->size();
+  }
+
+  return num;
+}
+
+inline size_t Tracer::droppedNum()
+{
+  std::lock_guard<std::mutex> lg(mtx_);
+
+  size_t num = 0;
+  for (auto& buf : buffers_)
+  {
+    num += buf->dropped();
+  }
+
+  return num;
+}
+
+inline bool Tracer::save(const std::string& file_path)
+{
+  std::ofstream ofs(file_path.c_str(), std::ios::out | std::ios::trunc);
+  if (!ofs.is_open())
+  {
+    return false;
+  }
+
+  std::vector<std::shared_ptr<TraceBuffer>> buffers;
+  {
+    std::lock_guard<std::mutex> lg(mtx_);
+    buffers = buffers_;
+  }
+
+  // an event is stored when its scope ends, so an outer scope may begin before the first event of the buffer.
+  uint64_t base_ns = UINT64_MAX;
+  for (auto& buf : buffers)
+  {
+    size_t size = buf->size();
+    for (size_t i = 0; i < size; i++)
+    {
+      base_ns = std::min(base_ns, buf->at(i).begin_ns);
+    }
+  }
+
+  ofs << "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[";
+  ofs << std::fixed << std::setprecision(3);
+
+  bool first = true;
+  for (auto& buf : buffers)
+  {
+    ofs << (first ? "" : ",") << "\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << buf->tid() 
+      << ",\"args\":{\"name\":\"" << buf->threadName() << "\"}}";
+    first = false;
+
+    size_t size = buf->size();
+    for (size_t i = 0; i < size; i++)
+    {
+      const TraceEvent& e = buf->at(i);
+      ofs << ",\n{\"name\":\"" << e.name << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << buf->tid() 
+        << ",\"ts\":" << (e.begin_ns - base_ns) * 1e-3 << ",\"dur\":" << e.dur_ns * 1e-3 << "}";
+    }
+  }
+
+  ofs << "\n]}\n";
+  return ofs.good();
+}
+
+//
+// Record the scope as an event.
+//
+class TraceScope
+{
+public:
+
+  explicit TraceScope(const char* name)
+    : name_(name), begin_ns_(Tracer::instance().enabled() ? Tracer::now() : 0)
+  {
+  }
+
+  ~TraceScope()
+  {
+    if ((begin_ns_ != 0) && Tracer::instance().enabled())
+    {
+      Tracer::instance().record(name_, begin_ns_, Tracer::now());
+    }
+  }
+
+private:
+
+  const char* name_;
+  uint64_t begin_ns_;
+};
+
+#define RS_TRACE_CONCAT_INNER(a, b) a##b
+#define RS_TRACE_CONCAT(a, b) RS_TRACE_CONCAT_INNER(a, b)
+
+#ifdef ENABLE_TRACE
+#define RS_TRACE_SCOPE(name) robosense::lidar::TraceScope RS_TRACE_CONCAT(rs_trace_scope_, __LINE__)(name)
+#else
+#define RS_TRACE_SCOPE(name)
+#endif
+
+}  // namespace lidar
+}  // namespace robosense
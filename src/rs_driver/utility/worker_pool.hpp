@@ -0,0 +1,309 @@
+/*********************************************************************************************************************
+Copyright (c) 2020 RoboSense
+All rights reserved
+
+By downloading, copying, installing or using the software you agree to this license. If you do not agree to this
+license, do not download, install, copy or use the software.
+
+License Agreement
+For RoboSense LiDAR SDK Library
+(3-clause BSD License)
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that the
+following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following
+disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following
+disclaimer in the documentation and/or other materials provided with the distribution.
+
+3. Neither the names of the RoboSense, nor Suteng Innovation Technology, nor the names of other contributors may be used
+to endorse or promote products derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*********************************************************************************************************************/
+
+
+#pragma once
+
+#include <deque>
+#include <vector>
+#include <memory>
+#include <functional>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <condition_variable>
+
+namespace robosense
+{
+namespace lidar
+{
+
+//
+// A fixed number of threads running submitted tasks, with work stealing. 
+// Each thread has its own task queue. A task submitted by a thread of the pool goes to its own queue, 
+// and a task from outside goes to the queues in turn. An idle thread steals tasks from the others.
+// submit() locks only the queue it pushes to. The pool-wide lock is taken only to sleep, and to wake a sleeping thread.
+//
+class WorkerPool
+{
+public:
+
+  WorkerPool()
+    : pending_(0), next_queue_(0), steal_num_(0), sleeping_(0), submitting_(0), running_(false), 
+      to_exit_(false), start_flag_(false)
+  {
+  }
+
+  ~WorkerPool()
+  {
+    stop();
+  }
+
+  typedef std::function<void(size_t)> ThreadCallback;
+
+  //
+  // cb_thread is called first in each thread, with its index, e.g. to place the thread.
+  //
+  bool start(uint16_t thread_num, const ThreadCallback& cb_thread = ThreadCallback());
+
+  //
+  // Stop the threads. The pending tasks are done before that.
+  //
+  void stop();
+
+  //
+  // Run the task in one of the threads. If the pool is not started, run it in the caller's thread.
+  //
+  void submit(const std::function<void()>& task);
+
+  size_t threadNum() const
+  {
+    return threads_.size();
+  }
+
+  //
+  // Number of tasks stolen from other threads' queues.
+  //
+  uint64_t stealNum() const
+  {
+    return steal_num_;
+  }
+
+private:
+
+  struct TaskQueue
+  {
+    std::deque<std::function<void()>> tasks;
+    std::mutex mtx;
+  };
+
+  void run(size_t idx);
+  bool popTask(size_t idx, std::function<void()>& task);
+
+  static WorkerPool*& currentPool()
+  {
+    static thread_local WorkerPool* pool = nullptr;
+    return pool;
+  }
+
+  static size_t& currentIndex()
+  {
+    static thread_local size_t idx = 0;
+    return idx;
+  }
+
+  std::vector<std::unique_ptr<TaskQueue>> queues_;
+  std::atomic<size_t> pending_; // tasks in all queues
+  std::atomic<size_t> next_queue_;
+  std::atomic<uint64_t> steal_num_;
+  std::atomic<size_t> sleeping_;   // threads waiting on cv_
+  std::atomic<size_t> submitting_; // submit() calls pushing a task
+  std::atomic<bool> running_;      // tasks are accepted
+  std::mutex mtx_;
+  std::condition_variable cv_;
+  std::vector<std::thread> threads_;
+  bool to_exit_;
+  bool start_flag_;
+};
+
+inline bool WorkerPool::start(uint16_t thread_num, const ThreadCallback& cb_thread)
+{
+  std::lock_guard<std::mutex> lg(mtx_);
+
+  if (start_flag_)
+  {
+    return true;
+  }
+
+  if (thread_num == 0)
+  {
+    thread_num = 1;
+  }
+
+  queues_.clear();
+  for (uint16_t i = 0; i < thread_num; i++)
+  {
+    queues_.emplace_back(new TaskQueue());
+  }
+
+  to_exit_ = false;
+  for (uint16_t i = 0; i < thread_num; i++)
+  {
+    size_t idx = i;
+    threads_.emplace_back([this, idx, cb_thread]() {
+      if (cb_thread)
+      {
+        cb_thread(idx);
+      }
+      run(idx);
+    });
+  }
+
+  running_ = true;
+  start_flag_ = true;
+  return true;
+}
+
+inline void WorkerPool::stop()
+{
+  {
+    std::lock_guard<std::mutex> lg(mtx_);
+    if (!start_flag_)
+    {
+      return;
+    }
+
+    running_ = false;
+  }
+
+  // the tasks being pushed are done too.
+  while (submitting_ > 0)
+  {
+    std::this_thread::yield();
+  }
+
+  {
+    std::lock_guard<std::mutex> lg(mtx_);
+    to_exit_ = true;
+  }
+
+  cv_.notify_all();
+  for (auto& t : threads_)
+  {
+    t.join();
+  }
+  threads_.clear();
+
+  std::lock_guard<std::mutex> lg(mtx_);
+  start_flag_ = false;
+}
+
+inline void WorkerPool::submit(const std::function<void()>& task)
+{
+  submitting_++;
+  if (!running_)
+  {
+    submitting_--;
+    task();
+    return;
+  }
+
+  size_t idx = (currentPool() == this) ? 
+    currentIndex() : (next_queue_.fetch_add(1) % queues_.size());
+
+  TaskQueue& q = *queues_[idx];
+  {
+    std::lock_guard<std::mutex> lg(q.mtx);
+    q.tasks.push_back(task);
+  }
+
+  pending_++;
+  submitting_--;
+
+  //
+  // A thread going to sleep counts itself in sleeping_ before it checks pending_, both under mtx_. 
+  // So either it sees the task, or it is seen here, and is woken after it waits.
+  //
+  if (sleeping_ > 0)
+  {
+    std::lock_guard<std::mutex> lg(mtx_);
+    cv_.notify_one();
+  }
+}
+
+inline bool WorkerPool::popTask(size_t idx, std::function<void()>& task)
+{
+  //
+  // own queue first, FIFO.
+  //
+  {
+    TaskQueue& q = *queues_[idx];
+    std::lock_guard<std::mutex> lg(q.mtx);
+    if (!q.tasks.empty())
+    {
+      task = std::move(q.tasks.front());
+      q.tasks.pop_front();
+      pending_--;
+      return true;
+    }
+  }
+
+  //
+  // steal from the back of the others.
+  //
+  for (size_t i = 1; i < queues_.size(); i++)
+  {
+    TaskQueue& q = *queues_[(idx + i) % queues_.size()];
+    std::lock_guard<std::mutex> lg(q.mtx);
+    if (!q.tasks.empty())
+    {
+      task = std::move(q.tasks.back());
+      q.tasks.pop_back();
+      pending_--;
+      steal_num_++;
+      return true;
+    }
+  }
+
+  return false;
+}
+
+inline void WorkerPool::run(size_t idx)
+{
+  currentPool() = this;
+  currentIndex() = idx;
+
+  while (1)
+  {
+    std::function<void()> task;
+    if (popTask(idx, task))
+    {
+      task();
+      continue;
+    }
+
+    std::unique_lock<std::mutex> ul(mtx_);
+    sleeping_++;
+    cv_.wait(ul, [this] { return (to_exit_ || (pending_ > 0)); });
+    sleeping_--;
+
+    if (to_exit_ && (pending_ == 0))
+    {
+      break;
+    }
+  }
+
+  currentPool() = nullptr;
+}
+
+}  // namespace lidar
+}  // namespace robosense
@@ -0,0 +1,146 @@
+#include <gtest/gtest.h>
+
+#include <rs_driver/api/lidar_driver.hpp>
+#include <rs_driver/driver/decoder/packet_builder.hpp>
+#include <rs_driver/msg/point_cloud_msg.hpp>
+
+#include <atomic>
+#include <thread>
+
+using namespace robosense::lidar;
+
+typedef PointCloudT<PointXYZIRT> PointCloud;
+
+TEST(TestAllocTracker, count)
+{
+  // the allocations are kept, so the compiler does not elide them.
+  std::vector<std::unique_ptr<int>> kept;
+  kept.reserve(3);
+
+  uint64_t thread_begin = AllocTracker::threadCount();
+  uint64_t total_begin = AllocTracker::totalCount();
+
+  kept.emplace_back(new int(1));
+  uint64_t thread_allocs = AllocTracker::threadCount() - thread_begin;
+
+  // allocations of another thread
+  uint64_t other_allocs = 0;
+  std::thread t([&kept, &other_allocs]()
+  {
+    uint64_t begin = AllocTracker::threadCount();
+    kept.emplace_back(new int(2));
+    kept.emplace_back(new int(3));
+    other_allocs = AllocTracker::threadCount() - begin;
+  });
+  t.join();
+
+  if (AllocTracker::enabled())
+  {
+    ASSERT_EQ(thread_allocs, 1u);
+    ASSERT_EQ(other_allocs, 2u);
+    ASSERT_GE(AllocTracker::totalCount(), total_begin + 3);
+  }
+  else
+  {
+    ASSERT_EQ(thread_allocs, 0u);
+    ASSERT_EQ(other_allocs, 0u);
+    ASSERT_EQ(AllocTracker::totalCount(), 0u);
+  }
+}
+
+// a round at a time, so the buffer pool stops growing after the first round.
+static void decodeRounds(LidarDriver<PointCloud>& driver, const std::vector<Packet>& pkts, size_t rounds)
+{
+  DriverStats stats;
+  ASSERT_TRUE(driver.getStats(stats));
+  uint64_t decoded = stats.msop_pkts;
+
+  for (size_t r = 0; r < rounds; r++)
+  {
+    for (const auto& pkt : pkts)
+    {
+      driver.decodePacket(pkt);
+    }
+
+    decoded += pkts.size();
+    for (size_t i = 0; (i < 100) && driver.getStats(stats) && (stats.msop_pkts < decoded); i++)
+    {
+      std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+  }
+}
+
+TEST(TestAllocTracker, driver)
+{
+  PacketBuilder builder(LidarType::RS16);
+
+  std::vector<Packet> pkts;
+  for (const auto& msop : builder.msops())
+  {
+    Packet pkt(msop.size());
+    memcpy(pkt.buf_.data(), msop.data(), msop.size());
+    pkts.push_back(pkt);
+  }
+
+  RSDriverParam param;
+  param.lidar_type = LidarType::RS16;
+  param.input_type = InputType::RAW_PACKET;
+  param.decoder_param.wait_for_difop = false;
+  param.frame_queue_len = 1;
+  param.alloc_param.warmup_frames = 5; // e.g. the point clouds in the pool grow
+  param.alloc_param.max_pkt_allocs = 3; // e.g. nodes of the packet queues
+  param.alloc_param.abort_on_exceed = false;
+
+  std::atomic<int> exceeded(0);
+  std::atomic<bool> to_alloc(false);
+  std::vector<std::unique_ptr<int>> kept;
+  kept.reserve(16);
+
+  LidarDriver<PointCloud> driver;
+  driver.regExceptionCallback([&exceeded](const Error& err) {
+      if (err.error_code == ERRCODE_ALLOCEXCEEDED) exceeded++; });
+  driver.regPacketCallback([&to_alloc, &kept](const Packet&) {
+      for (int i = 0; to_alloc && (i < 8); i++)
+      {
+        kept.emplace_back(new int(i));
+      }
+      to_alloc = false; });
+
+  ASSERT_TRUE(driver.init(param));
+  ASSERT_TRUE(driver.start());
+
+  decodeRounds(driver, pkts, 10);
+
+  DriverStats stats;
+  ASSERT_TRUE(driver.getStats(stats));
+  ASSERT_EQ(exceeded, 0);
+  if (AllocTracker::enabled())
+  {
+    // allocations of the warmup frames, e.g. the packet buffers.
+    ASSERT_GT(stats.allocs, 0u);
+    ASSERT_LE(stats.max_pkt_allocs, 3u);
+  }
+  else
+  {
+    ASSERT_EQ(stats.allocs, 0u);
+  }
+
+  // the packet callback allocates.
+  to_alloc = true;
+  decodeRounds(driver, pkts, 1);
+  driver.stop();
+
+  ASSERT_TRUE(driver.getStats(stats));
+  if (AllocTracker::enabled())
+  {
+    ASSERT_GE(stats.max_pkt_allocs, 8u);
+    ASSERT_GE(stats.max_frame_allocs, 8u);
+    ASSERT_EQ(exceeded, 1);
+  }
+  else
+  {
+    ASSERT_EQ(stats.max_pkt_allocs, 0u);
+    ASSERT_EQ(stats.max_frame_allocs, 0u);
+    ASSERT_EQ(exceeded, 0);
+  }
+}
@@ -285,3 +285,39 @@ TEST(TestDecoder, processMsopPkt)
   ASSERT_EQ(errCode, ERRCODE_SUCCESS);
 }
 
+
+TEST(TestDecoder, setDegrade)
+{
+  RSDecoderMechConstParam const_param;
+  const_param.base.LASER_NUM = 2;
+  RSDecoderParam param;
+  MyDecoder decoder(const_param, param);
+
+  ASSERT_FALSE(decoder.densePoints());
+  ASSERT_FALSE(decoder.skipPoint(1));
+
+  // skip NAN points
+  decoder.setDegrade(DEGRADE_SKIP_NAN);
+  ASSERT_TRUE(decoder.densePoints());
+  decoder.setDegrade(0);
+  ASSERT_FALSE(decoder.densePoints());
+
+  // decimate rings
+  decoder.setDegrade(DEGRADE_DECIMATE_RINGS);
+  ASSERT_FALSE(decoder.skipPoint(0));
+  ASSERT_TRUE(decoder.skipPoint(1));
+
+  // drop the second echo, only in dual return mode
+  decoder.setDegrade(DEGRADE_DROP_SECOND_ECHO);
+  decoder.splitBlock(100, 0.0);
+  decoder.splitBlock(100, 0.0);
+  ASSERT_FALSE(decoder.skipPoint(0));
+
+  decoder.echo_mode_ = ECHO_DUAL;
+  decoder.splitBlock(120, 0.0);
+  ASSERT_FALSE(decoder.skipPoint(0));
+  decoder.splitBlock(120, 0.0);
+  ASSERT_TRUE(decoder.skipPoint(0));
+  decoder.splitBlock(140, 0.0);
+  ASSERT_FALSE(decoder.skipPoint(0));
+}
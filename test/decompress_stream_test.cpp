@@ -0,0 +1,55 @@
+
+#include <gtest/gtest.h>
+
+#include <rs_driver/utility/decompress_stream.hpp>
+
+#ifdef __linux__
+
+using namespace robosense::lidar;
+
+TEST(TestDecompressStream, getFormat)
+{
+  ASSERT_EQ(DecompressStream::getFormat("lidar.pcap"), DecompressStream::FORMAT_NONE);
+  ASSERT_EQ(DecompressStream::getFormat("lidar.pcap.gz"), DecompressStream::FORMAT_GZIP);
+  ASSERT_EQ(DecompressStream::getFormat("lidar.pcap.zst"), DecompressStream::FORMAT_ZSTD);
+  ASSERT_EQ(DecompressStream::getFormat(".gz"), DecompressStream::FORMAT_NONE);
+}
+
+#ifdef ENABLE_ZLIB
+TEST(TestDecompressStream, readGzip)
+{
+  const char* path = "/tmp/rs_driver_test.bin.gz";
+
+  std::vector<uint8_t> data(1000000);
+  for (size_t i = 0; i < data.size(); i++)
+  {
+    data[i] = (uint8_t)(i * 7);
+  }
+
+  gzFile gz = gzopen(path, "wb");
+  ASSERT_TRUE(gz != NULL);
+  ASSERT_EQ(gzwrite(gz, data.data(), (unsigned)data.size()), (int)data.size());
+  gzclose(gz);
+
+  // ring smaller than file, to make the decompressing thread wait.
+  DecompressStream stream(4096);
+  FILE* fp = stream.open(path);
+  ASSERT_TRUE(fp != NULL);
+
+  std::vector<uint8_t> rdata(data.size() + 1);
+  ASSERT_EQ(fread(rdata.data(), 1, rdata.size(), fp), data.size());
+  ASSERT_EQ(memcmp(rdata.data(), data.data(), data.size()), 0);
+  fclose(fp);
+
+  // close before reaching the end.
+  fp = stream.open(path);
+  ASSERT_TRUE(fp != NULL);
+  ASSERT_EQ(fread(rdata.data(), 1, 100, fp), 100u);
+  fclose(fp);
+  stream.close();
+
+  remove(path);
+}
+#endif
+
+#endif
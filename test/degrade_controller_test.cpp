@@ -0,0 +1,83 @@
+#include <gtest/gtest.h>
+
+#include <rs_driver/driver/degrade_controller.hpp>
+
+using namespace robosense::lidar;
+
+TEST(TestDegradeController, disabled)
+{
+  DegradeController ctrl;
+  ctrl.init(RSDegradeParam());
+
+  ASSERT_FALSE(ctrl.newFrame(1.0, 0.1, true));
+  ASSERT_EQ(ctrl.modes(), 0);
+}
+
+TEST(TestDegradeController, degrade)
+{
+  RSDegradeParam param;
+  param.modes = DEGRADE_SKIP_NAN | DEGRADE_DECIMATE_RINGS;
+
+  DegradeController ctrl;
+  ctrl.init(param);
+
+  // within budget
+  ASSERT_FALSE(ctrl.newFrame(0.07, 0.1, false));
+  ASSERT_EQ(ctrl.modes(), 0);
+
+  // over budget. a step each frame, in order.
+  ASSERT_TRUE(ctrl.newFrame(0.09, 0.1, false));
+  ASSERT_EQ(ctrl.modes(), DEGRADE_SKIP_NAN);
+  ASSERT_TRUE(ctrl.newFrame(0.09, 0.1, false));
+  ASSERT_EQ(ctrl.modes(), DEGRADE_SKIP_NAN | DEGRADE_DECIMATE_RINGS);
+
+  // no more mode
+  ASSERT_FALSE(ctrl.newFrame(0.09, 0.1, false));
+  ASSERT_EQ(ctrl.changes(), 2u);
+}
+
+TEST(TestDegradeController, overflowed)
+{
+  RSDegradeParam param;
+  param.modes = DEGRADE_NO_TRANSFORM;
+
+  DegradeController ctrl;
+  ctrl.init(param);
+
+  ASSERT_TRUE(ctrl.newFrame(0.01, 0.1, true));
+  ASSERT_EQ(ctrl.modes(), DEGRADE_NO_TRANSFORM);
+}
+
+TEST(TestDegradeController, recover)
+{
+  RSDegradeParam param;
+  param.modes = DEGRADE_SKIP_NAN | DEGRADE_DROP_SECOND_ECHO;
+  param.recover_frames = 3;
+
+  DegradeController ctrl;
+  ctrl.init(param);
+
+  ASSERT_TRUE(ctrl.newFrame(0.09, 0.1, false));
+  ASSERT_TRUE(ctrl.newFrame(0.09, 0.1, false));
+
+  // between the thresholds, neither degrade nor recover
+  for (int i = 0; i < 5; i++)
+  {
+    ASSERT_FALSE(ctrl.newFrame(0.06, 0.1, false));
+  }
+
+  // the latest mode first
+  ASSERT_FALSE(ctrl.newFrame(0.01, 0.1, false));
+  ASSERT_FALSE(ctrl.newFrame(0.01, 0.1, false));
+  ASSERT_TRUE(ctrl.newFrame(0.01, 0.1, false));
+  ASSERT_EQ(ctrl.modes(), DEGRADE_SKIP_NAN);
+
+  // frames in a row
+  ASSERT_FALSE(ctrl.newFrame(0.01, 0.1, false));
+  ASSERT_FALSE(ctrl.newFrame(0.06, 0.1, false));
+  ASSERT_FALSE(ctrl.newFrame(0.01, 0.1, false));
+  ASSERT_FALSE(ctrl.newFrame(0.01, 0.1, false));
+  ASSERT_TRUE(ctrl.newFrame(0.01, 0.1, false));
+  ASSERT_EQ(ctrl.modes(), 0);
+  ASSERT_EQ(ctrl.changes(), 4u);
+}
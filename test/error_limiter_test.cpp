@@ -0,0 +1,50 @@
+
+#include <gtest/gtest.h>
+
+#include <rs_driver/common/error_code.hpp>
+
+using namespace robosense::lidar;
+
+TEST(TestErrorLimiter, allow)
+{
+  ErrorLimiter limiter;
+
+  ASSERT_TRUE(limiter.allow(ERRCODE_WRONGMSOPLEN, 1));
+  ASSERT_FALSE(limiter.allow(ERRCODE_WRONGMSOPLEN, 1));
+
+  // other error codes
+  ASSERT_TRUE(limiter.allow(ERRCODE_WRONGMSOPID, 1));
+
+  // other instances
+  ErrorLimiter limiter2;
+  ASSERT_TRUE(limiter2.allow(ERRCODE_WRONGMSOPLEN, 1));
+}
+
+TEST(TestErrorLimiter, delay)
+{
+  ErrorLimiter limiter;
+
+  ASSERT_FALSE(limiter.allow(ERRCODE_NODIFOPRECV, 1, true));
+  ASSERT_FALSE(limiter.allow(ERRCODE_NODIFOPRECV, 1, true));
+}
+
+TEST(TestErrorLimiter, call)
+{
+  ErrorLimiter limiter;
+  int num = 0;
+  ErrCode code = ERRCODE_SUCCESS;
+
+  std::function<void(const Error&)> cb = [&](const Error& err) 
+  { 
+    num++; 
+    code = err.error_code; 
+  };
+
+  limiter.call(cb, ERRCODE_PKTBUFOVERFLOW, 1);
+  limiter.call(cb, ERRCODE_PKTBUFOVERFLOW, 1);
+  ASSERT_EQ(num, 1);
+  ASSERT_EQ(code, ERRCODE_PKTBUFOVERFLOW);
+
+  // no callback
+  limiter.call(nullptr, ERRCODE_ZEROPOINTS, 1);
+}
@@ -0,0 +1,41 @@
+#include <gtest/gtest.h>
+
+#include <rs_driver/utility/file_list.hpp>
+
+using namespace robosense::lidar;
+
+TEST(TestFileList, expandList)
+{
+  std::vector<std::string> files = expandFilePaths("/data/a.pcap; /data/b.pcap;;/data/c.pcap ");
+  ASSERT_EQ(files.size(), 3u);
+  ASSERT_EQ(files[0], "/data/a.pcap");
+  ASSERT_EQ(files[1], "/data/b.pcap");
+  ASSERT_EQ(files[2], "/data/c.pcap");
+
+  files = expandFilePaths("/data/a.pcap");
+  ASSERT_EQ(files.size(), 1u);
+
+  files = expandFilePaths("");
+  ASSERT_EQ(files.size(), 0u);
+}
+
+TEST(TestFileList, expandGlob)
+{
+  std::string dir = "/tmp/rs_driver_file_list_test";
+  system(("rm -rf " + dir + " && mkdir -p " + dir).c_str());
+  system(("touch " + dir + "/lidar_0002.pcap " + dir + "/lidar_0000.pcap " + 
+        dir + "/lidar_0001.pcap " + dir + "/other.txt").c_str());
+
+  std::vector<std::string> files = expandFilePaths(dir + "/lidar_*.pcap;" + dir + "/other.txt");
+  ASSERT_EQ(files.size(), 4u);
+  ASSERT_EQ(files[0], dir + "/lidar_0000.pcap");
+  ASSERT_EQ(files[1], dir + "/lidar_0001.pcap");
+  ASSERT_EQ(files[2], dir + "/lidar_0002.pcap");
+  ASSERT_EQ(files[3], dir + "/other.txt");
+
+  // no match
+  files = expandFilePaths(dir + "/none_*.pcap");
+  ASSERT_EQ(files.size(), 0u);
+
+  system(("rm -rf " + dir).c_str());
+}
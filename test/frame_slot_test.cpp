@@ -0,0 +1,90 @@
+#include <gtest/gtest.h>
+
+#include <rs_driver/utility/frame_slot.hpp>
+
+#include <thread>
+
+using namespace robosense::lidar;
+
+TEST(TestFrameSlot, latestWins)
+{
+  FrameSlot<int> slot(1);
+
+  std::shared_ptr<int> frame;
+  ASSERT_FALSE(slot.tryPop(frame));
+
+  slot.push(std::make_shared<int>(1));
+  slot.push(std::make_shared<int>(2));
+  slot.push(std::make_shared<int>(3));
+  ASSERT_EQ(slot.size(), 1u);
+  ASSERT_EQ(slot.dropNum(), 2u);
+
+  ASSERT_TRUE(slot.tryPop(frame));
+  ASSERT_EQ(*frame, 3);
+  ASSERT_FALSE(slot.tryPop(frame));
+}
+
+TEST(TestFrameSlot, dropOldest)
+{
+  FrameSlot<int> slot(3);
+
+  for (int i = 0; i < 5; i++)
+  {
+    slot.push(std::make_shared<int>(i));
+  }
+  ASSERT_EQ(slot.size(), 3u);
+  ASSERT_EQ(slot.dropNum(), 2u);
+
+  std::shared_ptr<int> frame;
+  for (int i = 2; i < 5; i++)
+  {
+    ASSERT_TRUE(slot.tryPop(frame));
+    ASSERT_EQ(*frame, i);
+  }
+  ASSERT_FALSE(slot.tryPop(frame));
+
+  // dropped frames and popped frames are released
+  std::weak_ptr<int> weak = frame;
+  frame.reset();
+  ASSERT_TRUE(weak.expired());
+}
+
+TEST(TestFrameSlot, popTimeout)
+{
+  FrameSlot<int> slot(1);
+
+  std::shared_ptr<int> frame;
+  auto begin = std::chrono::steady_clock::now();
+  ASSERT_FALSE(slot.pop(frame, 20));
+  ASSERT_GE(std::chrono::steady_clock::now() - begin, std::chrono::milliseconds(20));
+}
+
+TEST(TestFrameSlot, producerConsumer)
+{
+  FrameSlot<int> slot(2);
+  const int frame_num = 100000;
+
+  std::thread producer([&slot, frame_num]() {
+    for (int i = 1; i <= frame_num; i++)
+    {
+      slot.push(std::make_shared<int>(i));
+    }
+  });
+
+  // frames are got in order, and each one at most once.
+  int last = 0;
+  size_t got = 0;
+  std::shared_ptr<int> frame;
+  while (last < frame_num)
+  {
+    if (slot.pop(frame, 1000))
+    {
+      ASSERT_GT(*frame, last);
+      last = *frame;
+      got++;
+    }
+  }
+
+  producer.join();
+  ASSERT_EQ(got + slot.dropNum(), (size_t)frame_num);
+}
@@ -0,0 +1,304 @@
+#include <gtest/gtest.h>
+
+#include <rs_driver/api/fusion_driver.hpp>
+#include <rs_driver/msg/point_cloud_msg.hpp>
+
+#include "packet_source.hpp"
+
+#include <mutex>
+#include <atomic>
+
+using namespace robosense::lidar;
+
+typedef PointXYZIRTL PointT;
+typedef PointCloudT<PointT> PointCloud;
+
+class FusionClient
+{
+public:
+
+  bool init(size_t lidar_num, float translate_x, bool dense = true, double max_wait = 0.05)
+  {
+    RSFusionParam param;
+    param.split_period = 0.1;
+    param.max_wait = max_wait;
+
+    for (size_t i = 0; i < lidar_num; i++)
+    {
+      RSDriverParam lidar_param;
+      lidar_param.lidar_type = LidarType::RS16;
+      lidar_param.input_type = InputType::RAW_PACKET;
+      lidar_param.decoder_param.wait_for_difop = false;
+      lidar_param.decoder_param.use_lidar_clock = true;
+      lidar_param.decoder_param.dense_points = dense;
+      lidar_param.decoder_param.transform_param.x = translate_x * i;
+      param.lidars.push_back(lidar_param);
+    }
+
+    driver.regPointCloudCallback(
+        []() { return std::make_shared<PointCloud>(); }, 
+        [this](std::shared_ptr<PointCloud> cloud) 
+        { 
+          std::lock_guard<std::mutex> lg(mtx); 
+          clouds.push_back(cloud); 
+        });
+
+    return driver.init(param) && driver.start();
+  }
+
+  size_t cloudNum()
+  {
+    std::lock_guard<std::mutex> lg(mtx);
+    return clouds.size();
+  }
+
+  bool waitClouds(size_t num)
+  {
+    for (size_t i = 0; i < 200; i++)
+    {
+      if (cloudNum() >= num)
+      {
+        return true;
+      }
+
+      std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+
+    return false;
+  }
+
+  FusionDriver<PointCloud> driver;
+  std::mutex mtx;
+  std::vector<std::shared_ptr<PointCloud>> clouds;
+};
+
+TEST(TestFusionDriver, merge)
+{
+  FusionClient client;
+  ASSERT_TRUE(client.init(2, 100.0f));
+
+  // 0.3 second, with the clock of Lidar 1 a little behind.
+  uint64_t start = 1600000000000000 + 600;
+  PacketSource source[2];
+  for (size_t i = 0; i < 250; i++)
+  {
+    client.driver.decodePacket(0, source[0].next(start + i * 1200));
+    client.driver.decodePacket(1, source[1].next(start + i * 1200 - 500));
+  }
+
+  ASSERT_TRUE(client.waitClouds(2));
+  client.driver.stop();
+
+  for (size_t i = 0; i < client.clouds.size(); i++)
+  {
+    const PointCloud& cloud = *client.clouds[i];
+    ASSERT_EQ(cloud.seq, i);
+    ASSERT_EQ(cloud.width, cloud.points.size());
+
+    size_t num[2] = {0, 0};
+    for (const auto& point : cloud.points)
+    {
+      ASSERT_LT(point.lidar_id, 2);
+      num[point.lidar_id]++;
+
+      // translated by the extrinsic
+      if (point.lidar_id == 0)
+      {
+        ASSERT_LT(point.x, 50.0f);
+      }
+      else
+      {
+        ASSERT_GT(point.x, 50.0f);
+      }
+
+      // on the common time grid
+      ASSERT_GE(point.timestamp, cloud.timestamp - 0.002);
+      ASSERT_LT(point.timestamp, cloud.timestamp + 0.1 + 0.002);
+    }
+
+    ASSERT_GT(num[0], 0u);
+    ASSERT_GT(num[1], 0u);
+  }
+
+  // frames are on the grid
+  ASSERT_NEAR(client.clouds[1]->timestamp - client.clouds[0]->timestamp, 0.1, 1e-6);
+  ASSERT_EQ(client.driver.latePktNum(), 0u);
+}
+
+TEST(TestFusionDriver, lateLidar)
+{
+  FusionClient client;
+  ASSERT_TRUE(client.init(2, 0.0f));
+
+  uint64_t start = 1600000000000000 + 600;
+  PacketSource source[2];
+
+  // Lidar 1 sends only at the beginning. Lidar 0 is not blocked by it.
+  client.driver.decodePacket(1, source[1].next(start));
+  for (size_t i = 0; i < 250; i++)
+  {
+    client.driver.decodePacket(0, source[0].next(start + i * 1200));
+  }
+
+  ASSERT_TRUE(client.waitClouds(2));
+
+  // too late for the emitted frame.
+  client.driver.decodePacket(1, source[1].next(start + 1200));
+  for (size_t i = 0; (i < 100) && (client.driver.latePktNum() == 0); i++)
+  {
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+
+  client.driver.stop();
+  ASSERT_EQ(client.driver.latePktNum(), 1u);
+}
+
+TEST(TestFusionDriver, cloudPointMax)
+{
+  // a slot of 3 Lidars has more points than a Lidar's cloud may have, but not more than theirs together.
+  FusionClient client;
+  std::atomic<int> overflows(0);
+  client.driver.regExceptionCallback([&overflows](const Error& err) { 
+      if (err.error_code == ERRCODE_CLOUDOVERFLOW) overflows++; });
+  ASSERT_TRUE(client.init(3, 100.0f));
+
+  uint64_t start = 1600000000000000 + 600;
+  PacketSource source[3];
+  for (size_t i = 0; i < 1400; i++)
+  {
+    for (size_t lidar = 0; lidar < 3; lidar++)
+    {
+      client.driver.decodePacket(lidar, source[lidar].next(start + i * 20));
+    }
+  }
+
+  // a packet of the next slot flushes it.
+  for (size_t lidar = 0; lidar < 3; lidar++)
+  {
+    client.driver.decodePacket(lidar, source[lidar].next(start + 200000));
+  }
+
+  ASSERT_TRUE(client.waitClouds(1));
+  client.driver.stop();
+
+  ASSERT_GT(client.clouds[0]->points.size(), (size_t)Decoder<PointCloud>::CLOUD_POINT_MAX);
+  ASSERT_EQ(overflows, 0);
+}
+
+TEST(TestFusionDriver, timeJumpsBack)
+{
+  FusionClient client;
+  ASSERT_TRUE(client.init(2, 100.0f));
+
+  // 0.3 second, and again, as a PCAP file replayed.
+  uint64_t start = 1600000000000000 + 600;
+  PacketSource source[2];
+  for (size_t round = 0; round < 2; round++)
+  {
+    for (size_t i = 0; i < 250; i++)
+    {
+      client.driver.decodePacket(0, source[0].next(start + i * 1200));
+      client.driver.decodePacket(1, source[1].next(start + i * 1200 - 500));
+    }
+  }
+
+  ASSERT_TRUE(client.waitClouds(5));
+  client.driver.stop();
+
+  // the grid starts again, with both Lidars.
+  size_t back = 0;
+  for (size_t i = 1; i < client.clouds.size(); i++)
+  {
+    if (client.clouds[i]->timestamp < client.clouds[i - 1]->timestamp)
+    {
+      back = i;
+    }
+  }
+  ASSERT_GT(back, 0u);
+  ASSERT_LT(back + 1, client.clouds.size());
+
+  size_t num[2] = {0, 0};
+  for (const auto& point : client.clouds[back + 1]->points)
+  {
+    num[point.lidar_id]++;
+  }
+  ASSERT_GT(num[0], 0u);
+  ASSERT_GT(num[1], 0u);
+  ASSERT_EQ(client.driver.latePktNum(), 0u);
+}
+
+TEST(TestFusionDriver, emitIdle)
+{
+  FusionClient client;
+  ASSERT_TRUE(client.init(2, 100.0f));
+
+  // 0.06 second, in one slot. Then the Lidars stop.
+  uint64_t start = 1600000000000000 + 10000;
+  PacketSource source[2];
+  for (size_t i = 0; i < 50; i++)
+  {
+    client.driver.decodePacket(0, source[0].next(start + i * 1200));
+    client.driver.decodePacket(1, source[1].next(start + i * 1200));
+  }
+
+  ASSERT_TRUE(client.waitClouds(1));
+  client.driver.stop();
+
+  ASSERT_EQ(client.clouds.size(), 1u);
+  ASSERT_EQ(client.clouds[0]->points.size(), 2u * 50u * 384u);
+}
+
+TEST(TestFusionDriver, emitOnStop)
+{
+  FusionClient client;
+  ASSERT_TRUE(client.init(2, 100.0f, true, 10.0));
+
+  uint64_t start = 1600000000000000 + 10000;
+  PacketSource source[2];
+  for (size_t i = 0; i < 50; i++)
+  {
+    client.driver.decodePacket(0, source[0].next(start + i * 1200));
+    client.driver.decodePacket(1, source[1].next(start + i * 1200));
+  }
+
+  // not emitted, since the Lidars may send again.
+  std::this_thread::sleep_for(std::chrono::milliseconds(300));
+  ASSERT_EQ(client.cloudNum(), 0u);
+
+  client.driver.stop();
+  ASSERT_EQ(client.cloudNum(), 1u);
+}
+
+TEST(TestFusionDriver, organized)
+{
+  FusionClient client;
+  ASSERT_TRUE(client.init(2, 100.0f, false));
+
+  uint64_t start = 1600000000000000 + 600;
+  PacketSource source[2];
+  for (size_t i = 0; i < 250; i++)
+  {
+    client.driver.decodePacket(0, source[0].next(start + i * 1200));
+    client.driver.decodePacket(1, source[1].next(start + i * 1200 - 500));
+  }
+
+  ASSERT_TRUE(client.waitClouds(2));
+  client.driver.stop();
+
+  // columns of 16 channels.
+  for (const auto& cloud : client.clouds)
+  {
+    ASSERT_FALSE(cloud->is_dense);
+    ASSERT_EQ(cloud->height, 16u);
+    ASSERT_EQ(cloud->width * cloud->height, cloud->points.size());
+  }
+}
+
+TEST(TestFusionDriver, wrongParam)
+{
+  RSFusionParam param;
+
+  FusionDriver<PointCloud> driver;
+  ASSERT_FALSE(driver.init(param));
+  ASSERT_FALSE(driver.start());
+}
@@ -0,0 +1,112 @@
+#include <gtest/gtest.h>
+
+#include <rs_driver/driver/input/input_log.hpp>
+
+using namespace robosense::lidar;
+
+static std::string writeLogs(size_t file_num, size_t pkt_num)
+{
+  std::string dir = "/tmp/rs_driver_input_log_test";
+  system(("rm -rf " + dir + " && mkdir -p " + dir).c_str());
+
+  std::vector<uint8_t> pkt(1248);
+  for (size_t f = 0; f < file_num; f++)
+  {
+    PacketLogWriter writer(16384);
+    writer.open(dir + "/lidar_000" + std::to_string(f) + ".rslog", LOG_CODEC_NONE);
+
+    for (size_t i = 0; i < pkt_num; i++)
+    {
+      size_t seq = f * pkt_num + i;
+      memcpy (pkt.data(), &seq, sizeof(seq));
+      writer.write(seq * 100, LOG_PKT_MSOP, 0, pkt.data(), pkt.size());
+    }
+  }
+
+  return dir;
+}
+
+TEST(TestLogSequence, playBackToBack)
+{
+  std::string dir = writeLogs(3, 100);
+
+  LogSequence seq;
+  ASSERT_TRUE(seq.open(expandFilePaths(dir + "/lidar_*.rslog")));
+
+  for (int round = 0; round < 2; round++)
+  {
+    LogPacket pkt;
+    size_t num = 0;
+    while (seq.next(pkt))
+    {
+      size_t val;
+      memcpy (&val, pkt.data, sizeof(val));
+      ASSERT_EQ(val, num);
+      ASSERT_EQ(pkt.ts, num * 100);
+      num++;
+    }
+    ASSERT_EQ(num, 300u);
+
+    ASSERT_TRUE(seq.rewind());
+  }
+
+  system(("rm -rf " + dir).c_str());
+}
+
+TEST(TestLogSequence, skipWrongFile)
+{
+  std::string dir = writeLogs(2, 100);
+
+  LogSequence seq;
+  ASSERT_TRUE(seq.open({dir + "/lidar_0000.rslog", dir + "/not_exist.rslog", dir + "/lidar_0001.rslog"}));
+
+  LogPacket pkt;
+  size_t num = 0;
+  while (seq.next(pkt))
+  {
+    num++;
+  }
+  ASSERT_EQ(num, 200u);
+
+  ASSERT_FALSE(seq.open({dir + "/not_exist.rslog"}));
+
+  system(("rm -rf " + dir).c_str());
+}
+
+TEST(TestInputLog, replay)
+{
+  std::string dir = writeLogs(2, 100);
+
+  RSInputParam param;
+  param.pcap_path = dir + "/lidar_*.rslog";
+  param.pcap_repeat = false;
+  param.pcap_rate = 10.0f;
+
+  std::atomic<size_t> num(0);
+  std::atomic<bool> exited(false);
+
+  InputLog input(param, false);
+  input.regCallback(
+      [&exited](const Error& err) { if (err.error_code == ERRCODE_PCAPEXIT) exited = true; },
+      [](size_t size) { return std::make_shared<Buffer>(size); },
+      [&num](std::shared_ptr<Buffer> pkt, bool) {
+        size_t val;
+        memcpy (&val, pkt->data(), sizeof(val));
+        ASSERT_EQ(val, num.load());
+        num++;
+      });
+
+  ASSERT_TRUE(input.init());
+  ASSERT_TRUE(input.start());
+
+  for (int i = 0; (i < 1000) && !exited; i++)
+  {
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+
+  input.stop();
+  ASSERT_TRUE(exited);
+  ASSERT_EQ(num, 200u);
+
+  system(("rm -rf " + dir).c_str());
+}
@@ -0,0 +1,213 @@
+#include <gtest/gtest.h>
+
+#include <rs_driver/driver/input/unix/input_sock_reuse.hpp>
+#include <rs_driver/utility/sync_queue.hpp>
+
+#include <set>
+
+using namespace robosense::lidar;
+
+struct FlowPacket
+{
+  uint8_t id;
+  uint8_t flow;
+  uint32_t seq;
+} __attribute__((packed));
+
+static void sendFlow(uint16_t port, uint8_t flow, uint32_t pkt_num)
+{
+  int fd = socket(AF_INET, SOCK_DGRAM, 0);
+  ASSERT_GE(fd, 0);
+
+  struct sockaddr_in addr;
+  memset(&addr, 0, sizeof(addr));
+  addr.sin_family = AF_INET;
+  addr.sin_port = htons(port);
+  inet_pton(AF_INET, "127.0.0.1", &(addr.sin_addr));
+
+  for (uint32_t i = 0; i < pkt_num; i++)
+  {
+    FlowPacket pkt;
+    pkt.id = 0x55;
+    pkt.flow = flow;
+    pkt.seq = i;
+
+    sendto(fd, &pkt, sizeof(pkt), 0, (struct sockaddr*)&addr, sizeof(addr));
+    if (i % 16 == 0)
+    {
+      std::this_thread::sleep_for(std::chrono::microseconds(100));
+    }
+  }
+
+  close(fd);
+}
+
+TEST(TestInputSockReuse, singleFlow)
+{
+  RSInputParam param;
+  param.msop_port = 26730;
+  param.difop_port = 26731;
+  param.socket_num = 4;
+
+  std::vector<uint32_t> seqs;
+  std::set<std::thread::id> push_threads;
+  std::atomic<int> pushing(0);
+  bool overlapped = false;
+
+  InputSockReuse input(param, false);
+  input.regCallback(
+      [](const Error&) {}, 
+      [](size_t size) { return std::make_shared<Buffer>(size); },
+      [&](std::shared_ptr<Buffer> pkt, bool stuffed) 
+      {
+        // by one merging thread at a time, so no lock.
+        if (stuffed)
+        {
+          if (pushing++ != 0)
+          {
+            overlapped = true;
+          }
+
+          const FlowPacket* fp = (const FlowPacket*)pkt->data();
+          seqs.push_back(fp->seq);
+          push_threads.insert(std::this_thread::get_id());
+
+          pushing--;
+        }
+      });
+
+  ASSERT_TRUE(input.init());
+  ASSERT_TRUE(input.start());
+
+  // a single flow, spread among the sockets.
+  sendFlow(26730, 0, 4000);
+  std::this_thread::sleep_for(std::chrono::milliseconds(100));
+  input.stop();
+
+  size_t sock_used = 0;
+  for (auto& queue : input.queues_)
+  {
+    if (queue.recv_num > 0)
+    {
+      sock_used++;
+    }
+  }
+  ASSERT_GT(sock_used, 1u);
+
+  // merged in order.
+  ASSERT_GT(seqs.size(), 3600u);
+  for (size_t i = 1; i < seqs.size(); i++)
+  {
+    ASSERT_LT(seqs[i - 1], seqs[i]);
+  }
+
+  ASSERT_FALSE(overlapped);
+  ASSERT_GE(push_threads.size(), 1u);
+  ASSERT_LE(push_threads.size(), 4u);
+}
+
+TEST(TestInputSockReuse, releaseIdle)
+{
+  RSInputParam param;
+  param.msop_port = 26736;
+  param.difop_port = 26737;
+  param.socket_num = 4;
+  param.merge_slack_us = 2000;
+
+  std::atomic<int> pkt_num(0);
+
+  InputSockReuse input(param, false);
+  input.regCallback(
+      [](const Error&) {}, 
+      [](size_t size) { return std::make_shared<Buffer>(size); },
+      [&pkt_num](std::shared_ptr<Buffer>, bool stuffed) 
+      { 
+        if (stuffed) 
+          pkt_num++; 
+      });
+
+  ASSERT_TRUE(input.init());
+  ASSERT_TRUE(input.start());
+
+  // held for the slack, and then released though no other packet comes.
+  sendFlow(26736, 0, 1);
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  ASSERT_EQ(pkt_num, 1);
+
+  // the threads are blocked in poll(), and woken up to exit at once.
+  auto begin = std::chrono::steady_clock::now();
+  input.stop();
+  ASSERT_LT(std::chrono::steady_clock::now() - begin, std::chrono::milliseconds(50));
+
+  // started again.
+  ASSERT_TRUE(input.start());
+  sendFlow(26736, 0, 1);
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  input.stop();
+  ASSERT_EQ(pkt_num, 2);
+}
+
+TEST(TestInputSockReuse, samePort)
+{
+  RSInputParam param;
+  param.msop_port = 26734;
+  param.difop_port = 26734;
+  param.socket_num = 2;
+
+  std::atomic<int> busy(0);
+  auto cb_excep = [&busy](const Error& err) { 
+      if (err.error_code == ERRCODE_MSOPPORTBUZY) busy++; };
+  auto cb_get_pkt = [](size_t size) { return std::make_shared<Buffer>(size); };
+  auto cb_put_pkt = [](std::shared_ptr<Buffer>, bool) {};
+
+  InputSockReuse input1(param, false);
+  input1.regCallback(cb_excep, cb_get_pkt, cb_put_pkt);
+  ASSERT_TRUE(input1.init());
+
+  // its SO_REUSEPORT group is not joined by others.
+  InputSockReuse input2(param, false);
+  input2.regCallback(cb_excep, cb_get_pkt, cb_put_pkt);
+  ASSERT_FALSE(input2.init());
+  ASSERT_EQ(busy, 1);
+
+  // nor does it join others.
+  int fd = createUdpSocket(26735, "0.0.0.0", "0.0.0.0", true);
+  ASSERT_GE(fd, 0);
+  param.msop_port = 26735;
+  param.difop_port = 26735;
+  InputSockReuse input3(param, false);
+  input3.regCallback(cb_excep, cb_get_pkt, cb_put_pkt);
+  ASSERT_FALSE(input3.init());
+  ASSERT_EQ(busy, 2);
+  close(fd);
+}
+
+TEST(TestInputSockReuse, steerByCpu)
+{
+  RSInputParam param;
+  param.msop_port = 26732;
+  param.difop_port = 26732;
+  param.socket_num = 2;
+  param.steer_by_cpu = true;
+
+  std::atomic<int> pkt_num(0);
+
+  InputSockReuse input(param, false);
+  input.regCallback(
+      [](const Error&) {}, 
+      [](size_t size) { return std::make_shared<Buffer>(size); },
+      [&pkt_num](std::shared_ptr<Buffer> pkt, bool stuffed) 
+      { 
+        if (stuffed) 
+          pkt_num++; 
+      });
+
+  ASSERT_TRUE(input.init());
+  ASSERT_TRUE(input.start());
+
+  sendFlow(26732, 0, 100);
+  std::this_thread::sleep_for(std::chrono::milliseconds(100));
+  input.stop();
+
+  ASSERT_GT(pkt_num, 0);
+}
@@ -0,0 +1,101 @@
+
+#include <gtest/gtest.h>
+
+#include <rs_driver/utility/latency_stats.hpp>
+
+#include <thread>
+#include <vector>
+
+using namespace robosense::lidar;
+
+TEST(TestLatencyHistogram, bucket)
+{
+  // exact below 2^SUB_BITS
+  for (uint64_t v = 0; v < (uint64_t)LatencyHistogram::SUB_NUM; v++)
+  {
+    ASSERT_EQ(LatencyHistogram::bucketUpper(LatencyHistogram::bucketIndex(v)), v);
+  }
+
+  // each value is in its bucket, and the buckets are ordered.
+  int prev = -1;
+  for (uint64_t v = 1; v < (1ull << 30); v = v * 3 / 2 + 1)
+  {
+    int idx = LatencyHistogram::bucketIndex(v);
+    ASSERT_GE(idx, prev);
+    ASSERT_GE(LatencyHistogram::bucketUpper(idx), v);
+    ASSERT_LE(LatencyHistogram::bucketUpper(idx) - v, v / LatencyHistogram::SUB_NUM);
+    prev = idx;
+  }
+
+  // clamped
+  ASSERT_EQ(LatencyHistogram::bucketIndex(UINT64_MAX), LatencyHistogram::BUCKET_NUM - 1);
+}
+
+TEST(TestLatencyHistogram, percentile)
+{
+  LatencyHistogram hist;
+  ASSERT_EQ(hist.percentile(0.5), 0u);
+  ASSERT_EQ(hist.summary().count, 0u);
+
+  // 1 ~ 10000 us
+  for (uint64_t i = 1; i <= 10000; i++)
+  {
+    hist.record(i * 1000);
+  }
+
+  LatencySummary s = hist.summary();
+  ASSERT_EQ(s.count, 10000u);
+  ASSERT_DOUBLE_EQ(s.min, 1.0);
+  ASSERT_DOUBLE_EQ(s.max, 10000.0);
+  ASSERT_NEAR(s.mean, 5000.5, 0.01);
+  ASSERT_NEAR(s.p50, 5000, 5000 * 0.04);
+  ASSERT_NEAR(s.p90, 9000, 9000 * 0.04);
+  ASSERT_NEAR(s.p99, 9900, 9900 * 0.04);
+  ASSERT_LE(s.p999, s.max);
+
+  hist.reset();
+  ASSERT_EQ(hist.count(), 0u);
+}
+
+TEST(TestLatencyHistogram, concurrent)
+{
+  LatencyHistogram hist;
+
+  std::vector<std::thread> threads;
+  for (int t = 0; t < 4; t++)
+  {
+    threads.emplace_back([&hist, t]() {
+      for (uint64_t i = 0; i < 10000; i++)
+      {
+        hist.record(i + t);
+      }
+    });
+  }
+
+  for (auto& t : threads)
+  {
+    t.join();
+  }
+
+  LatencySummary s = hist.summary();
+  ASSERT_EQ(s.count, 40000u);
+  ASSERT_DOUBLE_EQ(s.min, 0.0);
+  ASSERT_DOUBLE_EQ(s.max, 10002 / 1e3);
+}
+
+TEST(TestLatencyStats, record)
+{
+  LatencyStats stats;
+  stats.record(LAT_QUEUE, 1000, 3000);
+  stats.record(LAT_QUEUE, 0, 3000);     // no begin stamp
+  stats.record(LAT_QUEUE, 5000, 3000);  // not in order
+
+  LatencyReport report = stats.report();
+  ASSERT_EQ(report.stages[LAT_QUEUE].count, 1u);
+  ASSERT_DOUBLE_EQ(report.stages[LAT_QUEUE].max, 2.0);
+  ASSERT_EQ(report.stages[LAT_DECODE].count, 0u);
+
+  std::string str = report.toString();
+  ASSERT_NE(str.find("queue"), std::string::npos);
+  ASSERT_NE(str.find("p99.9"), std::string::npos);
+}
@@ -0,0 +1,391 @@
+#include <gtest/gtest.h>
+
+#include <rs_driver/api/lidar_driver.hpp>
+#include <rs_driver/msg/point_cloud_msg.hpp>
+
+#include <atomic>
+
+#include "packet_source.hpp"
+
+using namespace robosense::lidar;
+
+typedef PointXYZIRT PointT;
+typedef PointCloudT<PointT> PointCloud;
+
+static void sendRS16Packets(uint16_t port, size_t pkt_num, const std::string& src_ip = "127.0.0.1")
+{
+  int fd = socket(AF_INET, SOCK_DGRAM, 0);
+  ASSERT_GE(fd, 0);
+
+  struct sockaddr_in src_addr;
+  memset(&src_addr, 0, sizeof(src_addr));
+  src_addr.sin_family = AF_INET;
+  inet_pton(AF_INET, src_ip.c_str(), &(src_addr.sin_addr));
+  ASSERT_EQ(bind(fd, (struct sockaddr*)&src_addr, sizeof(src_addr)), 0);
+
+  struct sockaddr_in addr;
+  memset(&addr, 0, sizeof(addr));
+  addr.sin_family = AF_INET;
+  addr.sin_port = htons(port);
+  inet_pton(AF_INET, "127.0.0.1", &(addr.sin_addr));
+
+  PacketSource source;
+  for (size_t i = 0; i < pkt_num; i++)
+  {
+    const std::vector<uint8_t>& msop = source.nextMsop();
+    sendto(fd, msop.data(), msop.size(), 0, (struct sockaddr*)&addr, sizeof(addr));
+    std::this_thread::sleep_for(std::chrono::microseconds(100));
+  }
+
+  close(fd);
+}
+
+class ManagedClient
+{
+public:
+
+  ManagedClient()
+    : cloud_num(0), seq_in_order(true), next_seq_(0)
+  {
+  }
+
+  bool init(uint16_t port, const LidarDriverManager& manager, const std::string& lidar_ip = "0.0.0.0")
+  {
+    RSDriverParam param;
+    param.lidar_type = LidarType::RS16;
+    param.input_type = InputType::ONLINE_LIDAR;
+    param.input_param.msop_port = port;
+    param.input_param.difop_port = port;
+    param.input_param.lidar_address = lidar_ip;
+    param.decoder_param.wait_for_difop = false;
+
+    driver.regPointCloudCallback(
+        []() { return std::make_shared<PointCloud>(); }, 
+        std::bind(&ManagedClient::putCloud, this, std::placeholders::_1));
+
+    return driver.init(param, manager);
+  }
+
+  void putCloud(std::shared_ptr<PointCloud> cloud)
+  {
+    if (cloud->seq != next_seq_)
+    {
+      seq_in_order = false;
+    }
+
+    next_seq_ = cloud->seq + 1;
+    cloud_num++;
+  }
+
+  LidarDriver<PointCloud> driver;
+  std::atomic<int> cloud_num;
+  std::atomic<bool> seq_in_order;
+
+private:
+  uint32_t next_seq_;
+};
+
+TEST(TestLidarDriverManager, sharedThreads)
+{
+  RSManagerParam manager_param;
+  manager_param.recv_thread_num = 1;
+  manager_param.worker_thread_num = 2;
+
+  LidarDriverManager manager;
+  ASSERT_TRUE(manager.init(manager_param));
+  ASSERT_TRUE(manager.start());
+
+  ManagedClient client1, client2;
+  ASSERT_TRUE(client1.init(26699, manager));
+  ASSERT_TRUE(client2.init(26700, manager));
+  ASSERT_TRUE(client1.driver.start());
+  ASSERT_TRUE(client2.driver.start());
+
+  // 75 packets per round.
+  std::thread sender1(std::bind(sendRS16Packets, 26699, 500, "127.0.0.1"));
+  std::thread sender2(std::bind(sendRS16Packets, 26700, 500, "127.0.0.1"));
+  sender1.join();
+  sender2.join();
+  std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+  client1.driver.stop();
+  client2.driver.stop();
+  manager.stop();
+
+  ASSERT_GE(client1.cloud_num, 1);
+  ASSERT_GE(client2.cloud_num, 1);
+  ASSERT_TRUE(client1.seq_in_order);
+  ASSERT_TRUE(client2.seq_in_order);
+}
+
+TEST(TestLidarDriverManager, stopWhileDecoding)
+{
+  RSManagerParam manager_param;
+  manager_param.worker_thread_num = 2;
+
+  LidarDriverManager manager;
+  ASSERT_TRUE(manager.init(manager_param));
+  ASSERT_TRUE(manager.start());
+
+  RSDriverParam param;
+  param.lidar_type = LidarType::RS16;
+  param.input_type = InputType::RAW_PACKET;
+  param.decoder_param.wait_for_difop = false;
+
+  // the drivers are destructed right after stop(), while their packets are being decoded by the workers.
+  PacketSource source;
+  for (int round = 0; round < 500; round++)
+  {
+    std::unique_ptr<LidarDriver<PointCloud>> driver(new LidarDriver<PointCloud>);
+    driver->regPointCloudCallback(
+        []() { return std::make_shared<PointCloud>(); }, [](std::shared_ptr<PointCloud>) {});
+    ASSERT_TRUE(driver->init(param, manager));
+    ASSERT_TRUE(driver->start());
+
+    for (size_t i = 0; i < 200; i++)
+    {
+      driver->decodePacket(source.next());
+    }
+
+    driver->stop();
+    driver.reset();
+  }
+
+  manager.stop();
+}
+
+TEST(TestLidarDriverManager, initBeforeManager)
+{
+  LidarDriverManager manager;
+
+  RSDriverParam param;
+  param.lidar_type = LidarType::RS16;
+  param.input_type = InputType::ONLINE_LIDAR;
+  param.input_param.msop_port = 26701;
+  param.input_param.difop_port = 26701;
+
+  // the manager is not initialized, so the driver uses its own threads.
+  LidarDriver<PointCloud> driver;
+  driver.regPointCloudCallback(
+      []() { return std::make_shared<PointCloud>(); }, [](std::shared_ptr<PointCloud>) {});
+  ASSERT_TRUE(driver.init(param, manager));
+  ASSERT_TRUE(driver.start());
+  driver.stop();
+}
+
+TEST(TestLidarDriverManager, samePort)
+{
+  LidarDriverManager manager;
+  ASSERT_TRUE(manager.init());
+  ASSERT_TRUE(manager.start());
+
+  // three Lidars send to the same port, from different addresses.
+  ManagedClient client1, client2, client3;
+  ASSERT_TRUE(client1.init(26710, manager, "127.0.0.1"));
+  ASSERT_TRUE(client2.init(26710, manager, "127.0.0.2"));
+  ASSERT_TRUE(client3.init(26710, manager, "127.0.0.3"));
+  ASSERT_TRUE(client1.driver.start());
+  ASSERT_TRUE(client2.driver.start());
+  ASSERT_TRUE(client3.driver.start());
+
+  // an address is used only once on a port.
+  ManagedClient client4;
+  ASSERT_FALSE(client4.init(26710, manager, "127.0.0.1"));
+
+  std::thread sender1(std::bind(sendRS16Packets, 26710, 500, "127.0.0.1"));
+  std::thread sender2(std::bind(sendRS16Packets, 26710, 100, "127.0.0.2"));
+  sender1.join();
+  sender2.join();
+  std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+  client1.driver.stop();
+  client2.driver.stop();
+  client3.driver.stop();
+  manager.stop();
+
+  // 75 packets per round.
+  ASSERT_GE(client1.cloud_num, 2);
+  ASSERT_GE(client2.cloud_num, 1);
+  ASSERT_LE(client2.cloud_num, 1);
+  ASSERT_EQ(client3.cloud_num, 0);
+}
+
+TEST(TestLidarDriverManager, filterByLidarAddress)
+{
+  RSDriverParam param;
+  param.lidar_type = LidarType::RS16;
+  param.input_type = InputType::ONLINE_LIDAR;
+  param.input_param.msop_port = 26720;
+  param.input_param.difop_port = 26720;
+  param.input_param.lidar_address = "127.0.0.2";
+  param.decoder_param.wait_for_difop = false;
+
+  // own threads. Packets from other Lidars are dropped.
+  std::atomic<int> cloud_num(0);
+  LidarDriver<PointCloud> driver;
+  driver.regPointCloudCallback(
+      []() { return std::make_shared<PointCloud>(); }, 
+      [&cloud_num](std::shared_ptr<PointCloud>) { cloud_num++; });
+  ASSERT_TRUE(driver.init(param));
+  ASSERT_TRUE(driver.start());
+
+  sendRS16Packets(26720, 400, "127.0.0.1");
+  std::this_thread::sleep_for(std::chrono::milliseconds(100));
+  ASSERT_EQ(cloud_num, 0);
+
+  sendRS16Packets(26720, 400, "127.0.0.2");
+  std::this_thread::sleep_for(std::chrono::milliseconds(100));
+  ASSERT_GE(cloud_num, 1);
+
+  driver.stop();
+}
+
+TEST(TestLidarDriverManager, wrongLidarAddress)
+{
+  std::shared_ptr<RecvEngine> engine = std::make_shared<RecvEngine>();
+  ASSERT_TRUE(engine->init(1));
+
+  RSInputParam param;
+  param.msop_port = 26725;
+  param.difop_port = 26725;
+  param.lidar_address = "192.168.1.200 ";
+
+  // never taken as any Lidar.
+  auto cb_excep = [](const Error&) {};
+  auto cb_get_pkt = [](size_t size) { return std::make_shared<Buffer>(size); };
+  auto cb_put_pkt = [](std::shared_ptr<Buffer>, bool) {};
+
+  InputSockShared shared(param, false, engine);
+  shared.regCallback(cb_excep, cb_get_pkt, cb_put_pkt);
+  ASSERT_FALSE(shared.init());
+
+  InputSock sock(param);
+  sock.regCallback(cb_excep, cb_get_pkt, cb_put_pkt);
+  ASSERT_FALSE(sock.init());
+
+  // the port is free.
+  param.lidar_address = "0.0.0.0";
+  InputSockShared any(param, false, engine);
+  any.regCallback(cb_excep, cb_get_pkt, cb_put_pkt);
+  ASSERT_TRUE(any.init());
+}
+
+TEST(TestLidarDriverManager, oversizePacket)
+{
+  std::shared_ptr<RecvEngine> engine = std::make_shared<RecvEngine>();
+  ASSERT_TRUE(engine->init(1));
+  ASSERT_TRUE(engine->start());
+
+  RSInputParam param;
+  param.msop_port = 26730;
+  param.difop_port = 26730;
+
+  std::atomic<int> oversizes(0);
+  std::atomic<int> overflows(0);
+  std::atomic<int> pkts(0);
+  auto cb_excep = [&oversizes, &overflows](const Error& err) { 
+      if (err.error_code == ERRCODE_PKTOVERSIZE) oversizes++; 
+      if (err.error_code == ERRCODE_PKTBUFOVERFLOW) overflows++; };
+  auto cb_get_pkt = [](size_t size) { return std::make_shared<Buffer>(size); };
+  auto cb_put_pkt = [&pkts](std::shared_ptr<Buffer>, bool stuffed) { if (stuffed) pkts++; };
+
+  // a jumbo Lidar creates the shared socket, with large buffers.
+  param.lidar_address = "127.0.0.2";
+  InputSockShared jumbo(param, true, engine);
+  jumbo.regCallback(cb_excep, cb_get_pkt, cb_put_pkt);
+  ASSERT_TRUE(jumbo.init());
+
+  param.lidar_address = "127.0.0.1";
+  InputSockShared input(param, false, engine);
+  input.regCallback(cb_excep, cb_get_pkt, cb_put_pkt);
+  ASSERT_TRUE(input.init());
+  ASSERT_TRUE(input.start());
+
+  int fd = socket(AF_INET, SOCK_DGRAM, 0);
+  ASSERT_GE(fd, 0);
+
+  struct sockaddr_in addr;
+  memset(&addr, 0, sizeof(addr));
+  addr.sin_family = AF_INET;
+  addr.sin_port = htons(26730);
+  inet_pton(AF_INET, "127.0.0.1", &(addr.sin_addr));
+
+  // larger than the buffer of the non-jumbo Lidar.
+  std::vector<uint8_t> big(ETH_LEN + 1000, 0x5A);
+  std::vector<uint8_t> small(1248, 0x5A);
+  for (int i = 0; i < 3; i++)
+  {
+    sendto(fd, big.data(), big.size(), 0, (struct sockaddr*)&addr, sizeof(addr));
+  }
+  sendto(fd, small.data(), small.size(), 0, (struct sockaddr*)&addr, sizeof(addr));
+  close(fd);
+
+  for (int i = 0; (i < 100) && (pkts == 0); i++)
+  {
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+
+  input.stop();
+  engine->stop();
+
+  // all counted, but reported once.
+  ASSERT_EQ(pkts, 1);
+  ASSERT_EQ(oversizes, 1);
+  ASSERT_EQ(overflows, 0);
+  ASSERT_EQ(input.oversizeNum(), 3u);
+}
+
+#ifdef ENABLE_TRACE
+TEST(TestLidarDriverManager, traceRecv)
+{
+  std::shared_ptr<RecvEngine> engine = std::make_shared<RecvEngine>();
+  ASSERT_TRUE(engine->init(1));
+  ASSERT_TRUE(engine->start());
+
+  RSInputParam param;
+  param.msop_port = 26740;
+  param.difop_port = 26740;
+
+  std::atomic<int> pkts(0);
+  auto cb_excep = [](const Error&) {};
+  auto cb_get_pkt = [](size_t size) { return std::make_shared<Buffer>(size); };
+  auto cb_put_pkt = [&pkts](std::shared_ptr<Buffer>, bool stuffed) { if (stuffed) pkts++; };
+
+  InputSockShared input(param, false, engine);
+  input.regCallback(cb_excep, cb_get_pkt, cb_put_pkt);
+  ASSERT_TRUE(input.init());
+  ASSERT_TRUE(input.start());
+
+  Tracer& tracer = Tracer::instance();
+  tracer.start();
+
+  // the engine wakes up every 100 ms, but only a wakeup with packets is traced.
+  std::this_thread::sleep_for(std::chrono::milliseconds(350));
+  ASSERT_EQ(tracer.eventNum(), 0u);
+
+  int fd = socket(AF_INET, SOCK_DGRAM, 0);
+  ASSERT_GE(fd, 0);
+
+  struct sockaddr_in addr;
+  memset(&addr, 0, sizeof(addr));
+  addr.sin_family = AF_INET;
+  addr.sin_port = htons(26740);
+  inet_pton(AF_INET, "127.0.0.1", &(addr.sin_addr));
+
+  std::vector<uint8_t> pkt(1248, 0x5A);
+  sendto(fd, pkt.data(), pkt.size(), 0, (struct sockaddr*)&addr, sizeof(addr));
+  close(fd);
+
+  for (int i = 0; (i < 100) && (pkts == 0); i++)
+  {
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+
+  input.stop();
+  engine->stop();
+  tracer.stop();
+
+  ASSERT_EQ(pkts, 1);
+  ASSERT_EQ(tracer.eventNum(), 1u);
+}
+#endif
@@ -0,0 +1,579 @@
+#include <gtest/gtest.h>
+
+#include <rs_driver/api/lidar_driver.hpp>
+#include <rs_driver/msg/point_cloud_msg.hpp>
+
+#include "packet_source.hpp"
+
+#include <mutex>
+#include <atomic>
+#include <set>
+
+using namespace robosense::lidar;
+
+typedef PointXYZIRT PointT;
+typedef PointCloudT<PointT> PointCloud;
+
+class SectorClient
+{
+public:
+
+  bool init(float sector_angle, uint16_t sector_blks, double split_period = 0.0)
+  {
+    RSDriverParam param;
+    param.lidar_type = LidarType::RS16;
+    param.input_type = InputType::RAW_PACKET;
+    param.decoder_param.wait_for_difop = false;
+    param.decoder_param.dense_points = true;
+    param.decoder_param.sector_angle = sector_angle;
+    param.decoder_param.sector_blks = sector_blks;
+    if (split_period > 0)
+    {
+      param.decoder_param.split_frame_mode = SplitFrameMode::SPLIT_BY_TIME;
+      param.decoder_param.split_period = split_period;
+      param.decoder_param.use_lidar_clock = true;
+    }
+
+    driver.regPointCloudCallback(
+        []() { return std::make_shared<PointCloud>(); }, 
+        [this](std::shared_ptr<PointCloud> cloud) 
+        { 
+          std::lock_guard<std::mutex> lg(mtx); 
+          clouds.push_back(cloud); 
+        });
+
+    driver.regSectorCallback(
+        [this](const PointCloudSector<PointCloud>& sector)
+        {
+          std::lock_guard<std::mutex> lg(mtx); 
+          sectors.push_back(sector);
+        });
+
+    return driver.init(param) && driver.start();
+  }
+
+  void feed(size_t pkt_num)
+  {
+    PacketSource source;
+    for (size_t i = 0; i < pkt_num; i++)
+    {
+      driver.decodePacket(source.next());
+    }
+  }
+
+  bool waitClouds(size_t num)
+  {
+    for (size_t i = 0; i < 200; i++)
+    {
+      {
+        std::lock_guard<std::mutex> lg(mtx); 
+        if (clouds.size() >= num)
+        {
+          return true;
+        }
+      }
+
+      std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+
+    return false;
+  }
+
+  //
+  // The sectors of a frame cover its points in order.
+  //
+  void checkSectors(size_t sector_num)
+  {
+    size_t s = 0;
+    for (const auto& cloud : clouds)
+    {
+      size_t next_begin = 0;
+      for (size_t idx = 0; idx < sector_num; idx++, s++)
+      {
+        ASSERT_LT(s, sectors.size());
+        const PointCloudSector<PointCloud>& sector = sectors[s];
+
+        ASSERT_EQ(sector.cloud.get(), cloud.get());
+        ASSERT_EQ(sector.frame_seq, cloud->seq);
+        ASSERT_EQ(sector.sector_idx, idx);
+        ASSERT_EQ(sector.begin, next_begin);
+        ASSERT_GT(sector.end, sector.begin);
+        ASSERT_EQ(sector.last, (idx == sector_num - 1));
+        next_begin = sector.end;
+      }
+
+      ASSERT_EQ(next_begin, cloud->points.size());
+    }
+  }
+
+  LidarDriver<PointCloud> driver;
+  std::mutex mtx;
+  std::vector<std::shared_ptr<PointCloud>> clouds;
+  std::vector<PointCloudSector<PointCloud>> sectors;
+};
+
+TEST(TestLidarDriver, sectorByAngle)
+{
+  SectorClient client;
+  ASSERT_TRUE(client.init(30.0f, 0));
+
+  // 75 packets per round.
+  client.feed(400);
+  ASSERT_TRUE(client.waitClouds(2));
+  client.driver.stop();
+
+  client.checkSectors(12);
+}
+
+TEST(TestLidarDriver, sectorByBlks)
+{
+  SectorClient client;
+  ASSERT_TRUE(client.init(0.0f, 50));
+
+  // 900 blocks per round.
+  client.feed(400);
+  ASSERT_TRUE(client.waitClouds(2));
+  client.driver.stop();
+
+  client.checkSectors(18);
+}
+
+TEST(TestLidarDriver, noSector)
+{
+  SectorClient client;
+  ASSERT_TRUE(client.init(0.0f, 0));
+
+  client.feed(400);
+  ASSERT_TRUE(client.waitClouds(2));
+  client.driver.stop();
+
+  // the whole frame as the last sector
+  client.checkSectors(1);
+}
+
+TEST(TestLidarDriver, sectorReadByOtherThread)
+{
+  SectorClient client;
+  ASSERT_TRUE(client.init(30.0f, 0));
+
+  // another thread reads the sectors, while the frame is still being decoded.
+  std::vector<const PointT*> sector_points;
+  std::atomic<bool> to_exit(false);
+  std::atomic<size_t> read_num(0);
+  std::atomic<bool> read_ok(true);
+  std::thread reader([&]()
+  {
+    size_t s = 0;
+    while (!to_exit)
+    {
+      PointCloudSector<PointCloud> sector;
+      {
+        std::lock_guard<std::mutex> lg(client.mtx);
+        if (s >= client.sectors.size())
+        {
+          sector.cloud.reset();
+        }
+        else
+        {
+          sector = client.sectors[s++];
+        }
+      }
+
+      if (!sector.cloud)
+      {
+        std::this_thread::sleep_for(std::chrono::microseconds(100));
+        continue;
+      }
+
+      for (size_t i = sector.begin; i < sector.end; i++)
+      {
+        if (sector.cloud->points[i].ring >= 16)
+        {
+          read_ok = false;
+        }
+      }
+
+      sector_points.push_back(sector.cloud->points.data());
+      read_num++;
+    }
+  });
+
+  client.feed(400);
+  ASSERT_TRUE(client.waitClouds(2));
+  client.driver.stop();
+
+  for (size_t i = 0; (i < 100) && (read_num < client.sectors.size()); i++)
+  {
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+  to_exit = true;
+  reader.join();
+
+  ASSERT_TRUE(read_ok);
+  ASSERT_EQ(read_num, client.sectors.size());
+
+  // the points of a frame are never reallocated after its first sector.
+  for (size_t s = 0; s < client.sectors.size(); s++)
+  {
+    ASSERT_EQ(sector_points[s], client.sectors[s].cloud->points.data());
+  }
+
+  client.checkSectors(12);
+}
+
+TEST(TestLidarDriver, sectorOverflow)
+{
+  SectorClient client;
+  std::atomic<int> overflows(0);
+  client.driver.regExceptionCallback([&overflows](const Error& err) {
+      if (err.error_code == ERRCODE_CLOUDOVERFLOW) overflows++; });
+  ASSERT_TRUE(client.init(0.0f, 120, 0.1));
+
+  // all packets in the same 0.1 second, so the frame never splits. 
+  // It overflows its reserved capacity (about 150 packets) again and again.
+  PacketSource source;
+  for (size_t i = 0; i < 1000; i++)
+  {
+    client.driver.decodePacket(source.next(1600000000000000 + 1000));
+    if (i % 50 == 0)
+    {
+      std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+  }
+
+  ASSERT_TRUE(client.waitClouds(3));
+  client.driver.stop();
+
+  ASSERT_GT(overflows, 0);
+
+  // frames keep coming, each one reserved larger than the last.
+  std::lock_guard<std::mutex> lg(client.mtx);
+  for (size_t i = 1; i < client.clouds.size(); i++)
+  {
+    ASSERT_GT(client.clouds[i]->points.size(), client.clouds[i - 1]->points.size());
+  }
+}
+
+TEST(TestLidarDriver, rollingWindow)
+{
+  RSDriverParam param;
+  param.lidar_type = LidarType::RS16;
+  param.input_type = InputType::RAW_PACKET;
+  param.decoder_param.wait_for_difop = false;
+  param.decoder_param.window_resolution = 0.4f;
+
+  std::atomic<size_t> cloud_num(0);
+
+  LidarDriver<PointCloud> driver;
+  driver.regPointCloudCallback(
+      []() { return std::make_shared<PointCloud>(); }, 
+      [&cloud_num](std::shared_ptr<PointCloud>) { cloud_num++; });
+  ASSERT_TRUE(driver.init(param));
+  ASSERT_TRUE(driver.start());
+
+  std::shared_ptr<const PointCloud> window;
+  ASSERT_FALSE(driver.getWindow(window));
+
+  PacketSource source;
+  for (size_t i = 0; i < 200; i++)
+  {
+    driver.decodePacket(source.next());
+  }
+
+  bool ok = false;
+  for (size_t i = 0; (i < 200) && !ok; i++)
+  {
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    ok = driver.getWindow(window);
+  }
+
+  driver.stop();
+  ASSERT_TRUE(ok);
+
+  // 900 columns of 32 points (a block of 2 x 16 channels)
+  ASSERT_EQ(window->points.size(), 900u * 32u);
+  size_t valid = 0;
+  for (const auto& point : window->points)
+  {
+    if (!std::isnan(point.x))
+    {
+      valid++;
+    }
+  }
+  ASSERT_EQ(valid, 900u * 32u);
+
+  // no point cloud per frame
+  ASSERT_EQ(cloud_num, 0u);
+}
+
+TEST(TestLidarDriver, pullFrame)
+{
+  RSDriverParam param;
+  param.lidar_type = LidarType::RS16;
+  param.input_type = InputType::RAW_PACKET;
+  param.decoder_param.wait_for_difop = false;
+  param.frame_queue_len = 1;
+
+  LidarDriver<PointCloud> driver;
+  ASSERT_TRUE(driver.init(param));
+  ASSERT_TRUE(driver.start());
+
+  std::shared_ptr<PointCloud> cloud;
+  ASSERT_FALSE(driver.tryGetFrame(cloud));
+  ASSERT_FALSE(driver.waitForFrame(cloud, 10));
+
+  // 75 packets a round
+  PacketSource source;
+  for (size_t i = 0; i < 85; i++)
+  {
+    driver.decodePacket(source.next());
+  }
+
+  ASSERT_TRUE(driver.waitForFrame(cloud, 1000));
+  ASSERT_GT(cloud->points.size(), 0u);
+  uint32_t first_seq = cloud->seq;
+
+  // 4 more frames. Only the latest is kept.
+  for (size_t i = 0; i < 300; i++)
+  {
+    driver.decodePacket(source.next());
+  }
+
+  for (size_t i = 0; (i < 200) && (driver.droppedFrameNum() < 3); i++)
+  {
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+
+  driver.stop();
+  ASSERT_EQ(driver.droppedFrameNum(), 3u);
+
+  ASSERT_TRUE(driver.tryGetFrame(cloud));
+  ASSERT_EQ(cloud->seq, first_seq + 4);
+  ASSERT_FALSE(driver.tryGetFrame(cloud));
+}
+
+TEST(TestLidarDriver, pullFrameReuse)
+{
+  RSDriverParam param;
+  param.lidar_type = LidarType::RS16;
+  param.input_type = InputType::RAW_PACKET;
+  param.decoder_param.wait_for_difop = false;
+  param.frame_queue_len = 1;
+
+  LidarDriver<PointCloud> driver;
+  ASSERT_TRUE(driver.init(param));
+  ASSERT_TRUE(driver.start());
+
+  PacketSource source;
+  for (size_t i = 0; i < 85; i++)
+  {
+    driver.decodePacket(source.next());
+  }
+
+  // held by the caller, so never reused.
+  std::shared_ptr<PointCloud> held;
+  ASSERT_TRUE(driver.waitForFrame(held, 1000));
+  size_t held_points = held->points.size();
+
+  std::set<const PointCloud*> clouds;
+  for (size_t round = 0; round < 20; round++)
+  {
+    for (size_t i = 0; i < 75; i++)
+    {
+      driver.decodePacket(source.next());
+    }
+
+    std::shared_ptr<PointCloud> cloud;
+    ASSERT_TRUE(driver.waitForFrame(cloud, 1000));
+    ASSERT_NE(cloud.get(), held.get());
+    clouds.insert(cloud.get());
+  }
+
+  driver.stop();
+
+  ASSERT_EQ(held->points.size(), held_points);
+
+  // the released ones are reused.
+  ASSERT_LE(clouds.size(), (size_t)param.frame_queue_len + 3);
+}
+
+TEST(TestLidarDriver, latencyReport)
+{
+  RSDriverParam param;
+  param.lidar_type = LidarType::RS16;
+  param.input_type = InputType::RAW_PACKET;
+  param.decoder_param.wait_for_difop = false;
+  param.frame_queue_len = 4;
+
+  LidarDriver<PointCloud> driver;
+  ASSERT_TRUE(driver.init(param));
+  ASSERT_TRUE(driver.start());
+
+  LatencyReport report;
+
+#ifdef ENABLE_LATENCY_STATS
+  PacketSource source;
+  for (size_t i = 0; i < 170; i++)
+  {
+    driver.decodePacket(source.next());
+  }
+
+  std::shared_ptr<PointCloud> cloud;
+  ASSERT_TRUE(driver.waitForFrame(cloud, 1000));
+  ASSERT_TRUE(driver.waitForFrame(cloud, 1000));
+
+  // the packets after the second frame
+  DriverStats stats;
+  for (size_t i = 0; (i < 100) && driver.getStats(stats) && (stats.msop_pkts < 170); i++)
+  {
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+  driver.stop();
+
+  ASSERT_TRUE(driver.getLatencyReport(report));
+  ASSERT_EQ(report.stages[LAT_RECV].count, 170u);
+  ASSERT_EQ(report.stages[LAT_DECODE].count, 170u);
+  ASSERT_EQ(report.stages[LAT_TOTAL].count, 2u);
+  ASSERT_EQ(report.stages[LAT_CALLBACK].count, 2u);
+  ASSERT_LE(report.stages[LAT_TOTAL].min, report.stages[LAT_TOTAL].max);
+
+  driver.resetLatencyStats();
+  ASSERT_TRUE(driver.getLatencyReport(report));
+  ASSERT_EQ(report.stages[LAT_TOTAL].count, 0u);
+#else
+  driver.stop();
+  ASSERT_FALSE(driver.getLatencyReport(report));
+#endif
+}
+
+TEST(TestLidarDriver, stats)
+{
+  RSDriverParam param;
+  param.lidar_type = LidarType::RS16;
+  param.input_type = InputType::RAW_PACKET;
+  param.decoder_param.wait_for_difop = false;
+  param.frame_queue_len = 4;
+
+  LidarDriver<PointCloud> driver;
+  DriverStats stats;
+  ASSERT_FALSE(driver.getStats(stats));
+
+  std::atomic<int> errors(0);
+  driver.regExceptionCallback([&errors](const Error& err) {
+      if (err.error_code == ERRCODE_WRONGMSOPLEN) errors++; });
+
+  ASSERT_TRUE(driver.init(param));
+  ASSERT_TRUE(driver.start());
+
+  // 2 rounds of 75 packets, and 3 of them lost.
+  PacketSource source;
+  for (size_t i = 0; i < 150; i++)
+  {
+    Packet pkt = source.next();
+    if (i == 25 || i == 50 || i == 51)
+    {
+      continue;
+    }
+
+    driver.decodePacket(pkt);
+  }
+
+  // wrong length
+  Packet wrong = source.next();
+  wrong.buf_.resize(100);
+  driver.decodePacket(wrong);
+  driver.decodePacket(wrong);
+
+  std::shared_ptr<PointCloud> cloud;
+  ASSERT_TRUE(driver.waitForFrame(cloud, 1000));
+
+  for (size_t i = 0; (i < 100) && driver.getStats(stats) && (stats.msop_pkts < 149); i++)
+  {
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+  driver.stop();
+
+  ASSERT_TRUE(driver.getStats(stats));
+  ASSERT_EQ(stats.pkts, 149u);
+  ASSERT_EQ(stats.msop_pkts, 149u);
+  ASSERT_EQ(stats.difop_pkts, 0u);
+  ASSERT_EQ(stats.wrong_len_pkts, 2u);
+  ASSERT_EQ(stats.lost_pkts, 3u);
+  ASSERT_EQ(stats.out_of_order_pkts, 0u);
+  ASSERT_EQ(stats.frames, 1u);
+  ASSERT_EQ(stats.points, stats.last_frame_points);
+  ASSERT_EQ(stats.points, cloud->points.size());
+  ASSERT_GT(stats.decode_ns, 0u);
+  ASSERT_EQ(stats.lossy_frames, 1u);
+
+  // packets of the frame
+  const FrameQuality& quality = cloud->quality;
+  ASSERT_EQ(quality.expected_pkts, 75u);
+  ASSERT_EQ(quality.recv_pkts, 72u);
+  ASSERT_EQ(quality.lost_pkts, 3u);
+  ASSERT_EQ(quality.gap_num, 2u);
+  ASSERT_LT(quality.gaps[0].begin, quality.gaps[0].end);
+  ASSERT_LT(quality.gaps[0].end, quality.gaps[1].begin);
+
+  // rate limited, but not by the errors of the other tests.
+  ASSERT_EQ(errors, 1);
+}
+
+TEST(TestLidarDriver, replayFast)
+{
+  // 20 rounds of 75 packets, recorded 1 second apart.
+  std::string path = "/tmp/rs_driver_replay_fast_test.rslog";
+  {
+    PacketLogWriter writer;
+    ASSERT_TRUE(writer.open(path, LOG_CODEC_NONE));
+
+    PacketSource source;
+    for (size_t i = 0; i < 1500; i++)
+    {
+      Packet pkt = source.next();
+      writer.write(i * 1000000, LOG_PKT_MSOP, 0, pkt.buf_.data(), pkt.buf_.size());
+    }
+    writer.close();
+  }
+
+  RSDriverParam param;
+  param.lidar_type = LidarType::RS16;
+  param.input_type = InputType::LOG_FILE;
+  param.input_param.pcap_path = path;
+  param.input_param.pcap_repeat = false;
+  param.input_param.pcap_rate = 0;
+  param.decoder_param.wait_for_difop = false;
+
+  std::atomic<int> frames(0);
+  std::atomic<bool> exited(false);
+
+  LidarDriver<PointCloud> driver;
+  driver.regPointCloudCallback(
+      []() { return std::make_shared<PointCloud>(); },
+      [&frames](std::shared_ptr<PointCloud>) 
+      {
+        // decode slower than reading, so the packets pile up in the queue.
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        frames++;
+      });
+  driver.regExceptionCallback([&exited](const Error& err) {
+      if (err.error_code == ERRCODE_PCAPEXIT) exited = true; });
+
+  ASSERT_TRUE(driver.init(param));
+  ASSERT_TRUE(driver.start());
+
+  DriverStats stats;
+  for (size_t i = 0; (i < 500) && driver.getStats(stats) && (!exited || (stats.msop_pkts < 1500)); i++)
+  {
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+  driver.stop();
+
+  ASSERT_TRUE(exited);
+  ASSERT_TRUE(driver.getStats(stats));
+  ASSERT_EQ(stats.msop_pkts, 1500u);
+  ASSERT_EQ(stats.queue_dropped_pkts, 0u);
+  ASSERT_EQ(frames, 19);
+
+  remove(path.c_str());
+}
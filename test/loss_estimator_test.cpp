@@ -0,0 +1,272 @@
+
+#include <gtest/gtest.h>
+
+#include <rs_driver/driver/decoder/loss_estimator.hpp>
+
+using namespace robosense::lidar;
+
+TEST(TestSeqLossEstimator, inOrder)
+{
+  SeqLossEstimator est(10);
+
+  for (uint16_t seq = 1; seq <= 10; seq++)
+  {
+    ASSERT_EQ(est.newPacket(seq), 0);
+  }
+
+  // next frame
+  ASSERT_EQ(est.newPacket(1), 0);
+  ASSERT_EQ(est.newPacket(2), 0);
+}
+
+TEST(TestSeqLossEstimator, lost)
+{
+  SeqLossEstimator est(10);
+
+  ASSERT_EQ(est.newPacket(1), 0);
+  ASSERT_EQ(est.newPacket(4), 2);
+  ASSERT_EQ(est.newPacket(8), 3);
+
+  // 9, 10 of this frame, and 1 of the next frame
+  ASSERT_EQ(est.newPacket(2), 3);
+}
+
+TEST(TestSeqLossEstimator, late)
+{
+  SeqLossEstimator est(20);
+
+  ASSERT_EQ(est.newPacket(1), 0);
+  ASSERT_EQ(est.newPacket(3), 1);
+  ASSERT_EQ(est.newPacket(2), -1);
+  ASSERT_EQ(est.newPacket(3), -1); // duplicated
+  ASSERT_EQ(est.newPacket(4), 0);
+
+  // late from the previous frame
+  ASSERT_EQ(est.newPacket(12), 7);
+  ASSERT_EQ(est.newPacket(1), 8);
+  ASSERT_EQ(est.newPacket(19), -1);
+  ASSERT_EQ(est.newPacket(2), 0);
+}
+
+TEST(TestSeqLossEstimator, seqMax)
+{
+  SeqLossEstimator est(10);
+
+  // more packets per frame than guessed
+  for (uint16_t seq = 1; seq <= 12; seq++)
+  {
+    ASSERT_EQ(est.newPacket(seq), 0);
+  }
+
+  ASSERT_EQ(est.newPacket(1), 0);
+}
+
+TEST(TestAzimuthLossEstimator, lost)
+{
+  AzimuthLossEstimator est;
+
+  int32_t az = 35900;
+  for (int i = 0; i < 10; i++)
+  {
+    ASSERT_EQ(est.newBlock(az), 0);
+    az = (az + 20) % 36000;
+  }
+
+  // 3 blocks lost
+  az = (az + 60) % 36000;
+  ASSERT_EQ(est.newBlock(az), 3);
+
+  // dual return
+  ASSERT_EQ(est.newBlock(az), 0);
+
+  // late
+  ASSERT_EQ(est.newBlock(az - 20), -1);
+  ASSERT_EQ(est.newBlock(az + 20), 0);
+}
+
+TEST(TestAzimuthLossEstimator, rpm)
+{
+  AzimuthLossEstimator est;
+
+  int32_t az = 0;
+  for (int i = 0; i < 10; i++)
+  {
+    ASSERT_EQ(est.newBlock(az), 0);
+    az += 20;
+  }
+
+  // 1200 rpm
+  est.reset();
+  for (int i = 0; i < 40; i++)
+  {
+    az += 40;
+    ASSERT_EQ(est.newBlock(az), 0);
+  }
+
+  az += 80;
+  ASSERT_EQ(est.newBlock(az), 1);
+}
+
+TEST(TestAzimuthLossEstimator, blind)
+{
+  AzimuthLossEstimator est;
+  est.setBlind(18000, 9000); // FOV 27000 ~ 18000
+
+  int32_t az = 17900;
+  for (int i = 0; i < 6; i++)
+  {
+    ASSERT_EQ(est.newBlock(az), 0);
+    az += 20;
+  }
+
+  // across the blind section
+  ASSERT_EQ(est.newBlock(az - 20 + 9000 + 20), 0);
+}
+
+TEST(TestAzimuthLossEstimator, limitedFov)
+{
+  AzimuthLossEstimator est;
+  est.setBlind(9000, 27000); // FOV 0 ~ 9000
+
+  for (int round = 0; round < 3; round++)
+  {
+    for (int32_t az = 0; az < 9000; az += 20)
+    {
+      ASSERT_EQ(est.newBlock(az), 0);
+    }
+  }
+
+  // a block lost, across the blind section
+  ASSERT_EQ(est.newBlock(20), 1);
+  ASSERT_EQ(est.newBlock(40), 0);
+
+  // late
+  ASSERT_EQ(est.newBlock(20), -1);
+}
+
+TEST(TestFrameLossTracker, seqSplitBySeq)
+{
+  FrameLossTracker tracker;
+  FrameQuality quality;
+
+  // first frame from seq 3. 5 lost, and 7 late.
+  for (uint16_t seq : {3, 4, 6, 8, 9, 10})
+  {
+    tracker.newSeq(seq, 10, false, true);
+  }
+  tracker.newSeq(7, 10, true, true);
+
+  tracker.endFrame(quality);
+  ASSERT_EQ(quality.expected_pkts, 8u);
+  ASSERT_EQ(quality.recv_pkts, 7u);
+  ASSERT_EQ(quality.lost_pkts, 1u);
+  ASSERT_EQ(quality.out_of_order_pkts, 1u);
+  ASSERT_EQ(quality.gap_num, 1u);
+  ASSERT_EQ(quality.gaps[0].begin, 5u);
+  ASSERT_EQ(quality.gaps[0].end, 5u);
+
+  // 1, 2 and 9, 10 lost. 10 of the previous frame late.
+  for (uint16_t seq : {3, 4, 5, 6, 7, 8})
+  {
+    tracker.newSeq(seq, 10, false, true);
+  }
+  tracker.newSeq(10, 10, true, true);
+
+  tracker.endFrame(quality);
+  ASSERT_EQ(quality.expected_pkts, 10u);
+  ASSERT_EQ(quality.recv_pkts, 6u);
+  ASSERT_EQ(quality.lost_pkts, 4u);
+  ASSERT_EQ(quality.out_of_order_pkts, 1u);
+  ASSERT_EQ(quality.gap_num, 2u);
+  ASSERT_EQ(quality.gaps[0].begin, 1u);
+  ASSERT_EQ(quality.gaps[0].end, 2u);
+  ASSERT_EQ(quality.gaps[1].begin, 9u);
+  ASSERT_EQ(quality.gaps[1].end, 10u);
+
+  // complete
+  for (uint16_t seq = 1; seq <= 10; seq++)
+  {
+    tracker.newSeq(seq, 10, false, true);
+  }
+
+  tracker.endFrame(quality);
+  ASSERT_EQ(quality.expected_pkts, 10u);
+  ASSERT_EQ(quality.lost_pkts, 0u);
+  ASSERT_EQ(quality.gap_num, 0u);
+}
+
+TEST(TestFrameLossTracker, seqSplitByTime)
+{
+  FrameLossTracker tracker;
+  FrameQuality quality;
+
+  // across the wrap of seq. 10 and 2 lost.
+  for (uint16_t seq : {7, 8, 9, 1, 3, 4})
+  {
+    tracker.newSeq(seq, 10, false, false);
+  }
+
+  tracker.endFrame(quality);
+  ASSERT_EQ(quality.expected_pkts, 8u);
+  ASSERT_EQ(quality.recv_pkts, 6u);
+  ASSERT_EQ(quality.lost_pkts, 2u);
+  ASSERT_EQ(quality.gap_num, 2u);
+  ASSERT_EQ(quality.gaps[0].begin, 10u);
+  ASSERT_EQ(quality.gaps[0].end, 10u);
+  ASSERT_EQ(quality.gaps[1].begin, 2u);
+  ASSERT_EQ(quality.gaps[1].end, 2u);
+}
+
+TEST(TestFrameLossTracker, blocks)
+{
+  FrameLossTracker tracker;
+  FrameQuality quality;
+
+  for (int i = 0; i < 10; i++)
+  {
+    tracker.newPacket();
+  }
+
+  // 24 blocks lost, and 1 of them late, in packets of 12 blocks
+  tracker.newLostBlocks(24, 1000, 1500, 12);
+  tracker.newLateBlock(1020);
+
+  tracker.endFrame(quality);
+  ASSERT_EQ(quality.recv_pkts, 10u);
+  ASSERT_EQ(quality.lost_pkts, 2u);
+  ASSERT_EQ(quality.expected_pkts, 12u);
+  ASSERT_EQ(quality.out_of_order_pkts, 0u);
+  ASSERT_EQ(quality.gap_num, 1u);
+  ASSERT_EQ(quality.gaps[0].begin, 1000u);
+  ASSERT_EQ(quality.gaps[0].end, 1500u);
+
+  // gap filled by the late blocks
+  tracker.newLostBlocks(2, 35980, 40, 1);
+  tracker.newLateBlock(0);
+  tracker.newLateBlock(20);
+
+  tracker.endFrame(quality);
+  ASSERT_EQ(quality.lost_pkts, 0u);
+  ASSERT_EQ(quality.out_of_order_pkts, 2u);
+  ASSERT_EQ(quality.gap_num, 0u);
+
+  // reset
+  tracker.endFrame(quality);
+  ASSERT_EQ(quality.expected_pkts, 0u);
+  ASSERT_EQ(quality.gap_num, 0u);
+}
+
+TEST(TestFrameLossTracker, gapMax)
+{
+  FrameLossTracker tracker;
+  FrameQuality quality;
+
+  for (int i = 0; i < FrameQuality::GAP_MAX + 4; i++)
+  {
+    tracker.newLostBlocks(1, i * 100, i * 100 + 40, 1);
+  }
+
+  tracker.endFrame(quality);
+  ASSERT_EQ(quality.lost_pkts, (uint32_t)(FrameQuality::GAP_MAX + 4));
+  ASSERT_EQ(quality.gap_num, (uint16_t)FrameQuality::GAP_MAX);
+}
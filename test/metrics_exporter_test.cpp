@@ -0,0 +1,269 @@
+#include <gtest/gtest.h>
+
+#include <rs_driver/api/metrics_exporter.hpp>
+#include <rs_driver/msg/point_cloud_msg.hpp>
+
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <arpa/inet.h>
+#include <unistd.h>
+
+#include "packet_source.hpp"
+
+using namespace robosense::lidar;
+
+typedef PointCloudT<PointXYZI> PointCloud;
+
+static std::string request(int fd, const std::string& req)
+{
+  send(fd, req.data(), req.size(), 0);
+
+  std::string rsp;
+  char buf[1024];
+  ssize_t n;
+  while ((n = recv(fd, buf, sizeof(buf), 0)) > 0)
+  {
+    rsp.append(buf, (size_t)n);
+  }
+
+  close(fd);
+  return rsp;
+}
+
+static int connectTcp(uint16_t port)
+{
+  int fd = socket(PF_INET, SOCK_STREAM, 0);
+  struct sockaddr_in addr;
+  memset(&addr, 0, sizeof(addr));
+  addr.sin_family = AF_INET;
+  addr.sin_port = htons(port);
+  inet_pton(AF_INET, "127.0.0.1", &(addr.sin_addr));
+  if (connect(fd, (struct sockaddr*)&addr, sizeof(addr)) < 0)
+  {
+    close(fd);
+    return -1;
+  }
+
+  return fd;
+}
+
+static std::string getTcp(uint16_t port, const std::string& path)
+{
+  int fd = connectTcp(port);
+  if (fd < 0)
+  {
+    return "";
+  }
+
+  return request(fd, "GET " + path + " HTTP/1.1\r\nHost: localhost\r\n\r\n");
+}
+
+static std::string getUnix(const std::string& sock_path)
+{
+  int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+  struct sockaddr_un addr;
+  memset(&addr, 0, sizeof(addr));
+  addr.sun_family = AF_UNIX;
+  strncpy(addr.sun_path, sock_path.c_str(), sizeof(addr.sun_path) - 1);
+  if (connect(fd, (struct sockaddr*)&addr, sizeof(addr)) < 0)
+  {
+    close(fd);
+    return "";
+  }
+
+  return request(fd, "GET /metrics HTTP/1.0\r\n\r\n");
+}
+
+TEST(TestMetricsExporter, render)
+{
+  RSDriverParam param;
+  param.lidar_type = LidarType::RS16;
+  param.input_type = InputType::RAW_PACKET;
+  param.decoder_param.wait_for_difop = false;
+  param.frame_queue_len = 1;
+
+  LidarDriver<PointCloud> driver;
+  LidarDriver<PointCloud> driver2; // not initialized
+
+  MetricsExporter exporter;
+  exporter.addDriver("front", driver);
+  exporter.addDriver("rear\"", driver2);
+
+  ASSERT_TRUE(driver.init(param));
+  ASSERT_TRUE(driver.start());
+
+  // 75 packets a round
+  PacketSource source;
+  for (size_t i = 0; i < 85; i++)
+  {
+    driver.decodePacket(source.next());
+  }
+
+  std::shared_ptr<PointCloud> cloud;
+  ASSERT_TRUE(driver.waitForFrame(cloud, 1000));
+
+  DriverStats stats;
+  for (size_t i = 0; (i < 100) && driver.getStats(stats) && (stats.msop_pkts < 85); i++)
+  {
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+  driver.stop();
+
+  std::string text = exporter.render();
+  ASSERT_NE(text.find("# TYPE rs_driver_pkts_total counter\n"), std::string::npos);
+  ASSERT_NE(text.find("rs_driver_pkts_total{lidar=\"front\"} 85\n"), std::string::npos);
+  ASSERT_NE(text.find("rs_driver_msop_pkts_total{lidar=\"front\"} 85\n"), std::string::npos);
+  ASSERT_NE(text.find("rs_driver_frames_total{lidar=\"front\"} 1\n"), std::string::npos);
+  ASSERT_NE(text.find("# TYPE rs_driver_lost_pkts gauge\n"), std::string::npos);
+  ASSERT_NE(text.find("rs_driver_lost_pkts{lidar=\"front\"} 0\n"), std::string::npos);
+  ASSERT_NE(text.find("rs_driver_temperature_celsius{lidar=\"front\"} "), std::string::npos);
+
+  // without stats, since not initialized
+  ASSERT_EQ(text.find("rear"), std::string::npos);
+}
+
+TEST(TestMetricsExporter, renderValues)
+{
+  MetricsExporter::Source src;
+  src.name = "front";
+  src.get_stats = [](DriverStats& stats) 
+  { 
+    stats = DriverStats();
+    stats.points = 12345678901234567ull;
+    stats.decode_ns = 1500000000ull;
+    return true;
+  };
+  src.get_temperature = [](float&) { return false; };
+  src.get_record_stats = [](RecordStats&) { return false; };
+  src.get_latency_report = [](LatencyReport&) { return false; };
+
+  MetricsExporter exporter;
+  exporter.sources_.push_back(src);
+
+  // counters of all digits, and seconds of nanoseconds.
+  std::string text = exporter.render();
+  ASSERT_NE(text.find("rs_driver_points_total{lidar=\"front\"} 12345678901234567\n"), std::string::npos);
+  ASSERT_NE(text.find("rs_driver_decode_seconds_total{lidar=\"front\"} 1.5\n"), std::string::npos);
+}
+
+TEST(TestMetricsExporter, tcp)
+{
+  RSDriverParam param;
+  param.lidar_type = LidarType::RS16;
+  param.input_type = InputType::RAW_PACKET;
+  param.frame_queue_len = 1;
+
+  LidarDriver<PointCloud> driver;
+  ASSERT_TRUE(driver.init(param));
+
+  MetricsExporter exporter;
+  exporter.addDriver("front", driver);
+  ASSERT_TRUE(exporter.start());
+  ASSERT_GT(exporter.port(), 0);
+
+  std::string rsp = getTcp(exporter.port(), "/metrics");
+  ASSERT_EQ(rsp.find("HTTP/1.0 200 OK\r\n"), 0u);
+  ASSERT_NE(rsp.find("Content-Type: text/plain; version=0.0.4"), std::string::npos);
+  ASSERT_NE(rsp.find("rs_driver_pkts_total{lidar=\"front\"} 0\n"), std::string::npos);
+
+  rsp = getTcp(exporter.port(), "/other");
+  ASSERT_EQ(rsp.find("HTTP/1.0 404 Not Found\r\n"), 0u);
+
+  exporter.stop();
+  ASSERT_EQ(getTcp(exporter.port(), "/metrics"), "");
+}
+
+TEST(TestMetricsExporter, unixSocket)
+{
+  RSDriverParam param;
+  param.lidar_type = LidarType::RS16;
+  param.input_type = InputType::RAW_PACKET;
+  param.frame_queue_len = 1;
+
+  LidarDriver<PointCloud> driver;
+  ASSERT_TRUE(driver.init(param));
+
+  RSMetricsParam metrics_param;
+  metrics_param.unix_path = "/tmp/rs_driver_metrics_test.sock";
+
+  MetricsExporter exporter;
+  exporter.addDriver("front", driver);
+  ASSERT_TRUE(exporter.start(metrics_param));
+
+  std::string rsp = getUnix(metrics_param.unix_path);
+  ASSERT_NE(rsp.find("rs_driver_pkts_total{lidar=\"front\"} 0\n"), std::string::npos);
+
+  exporter.stop();
+  ASSERT_NE(access(metrics_param.unix_path.c_str(), F_OK), 0);
+}
+
+TEST(TestMetricsExporter, stalledClient)
+{
+  // a response larger than the socket buffers.
+  MetricsServer server;
+  ASSERT_TRUE(server.init(RSMetricsParam(), []() { return std::string(32 * 1024 * 1024, '#'); }));
+  ASSERT_TRUE(server.start());
+
+  int fd = socket(PF_INET, SOCK_STREAM, 0);
+  int rcvbuf = 4096;
+  setsockopt(fd, SOL_SOCKET, SO_RCVBUF, &rcvbuf, sizeof(rcvbuf));
+
+  struct sockaddr_in addr;
+  memset(&addr, 0, sizeof(addr));
+  addr.sin_family = AF_INET;
+  addr.sin_port = htons(server.port());
+  inet_pton(AF_INET, "127.0.0.1", &(addr.sin_addr));
+  ASSERT_EQ(connect(fd, (struct sockaddr*)&addr, sizeof(addr)), 0);
+
+  // request, but never read.
+  std::string req = "GET /metrics HTTP/1.0\r\n\r\n";
+  send(fd, req.data(), req.size(), 0);
+  std::this_thread::sleep_for(std::chrono::milliseconds(200));
+
+  // the server is not blocked by it.
+  auto begin = std::chrono::steady_clock::now();
+  server.stop();
+  ASSERT_LT(std::chrono::steady_clock::now() - begin, std::chrono::seconds(3));
+
+  close(fd);
+}
+
+TEST(TestMetricsExporter, slowClient)
+{
+  MetricsServer server;
+  ASSERT_TRUE(server.init(RSMetricsParam(), []() { return std::string("rs_driver_up 1\n"); }));
+  ASSERT_TRUE(server.start());
+
+  // a byte of the request now and then, never the whole request.
+  int fd = connectTcp(server.port());
+  ASSERT_GE(fd, 0);
+
+  auto begin = std::chrono::steady_clock::now();
+  bool closed = false;
+  for (size_t i = 0; (i < 50) && !closed; i++)
+  {
+    send(fd, "G", 1, MSG_NOSIGNAL);
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+    char c;
+    closed = (recv(fd, &c, 1, MSG_DONTWAIT) == 0);
+  }
+  close(fd);
+
+  // the server gives up on it, and goes on.
+  ASSERT_TRUE(closed);
+  ASSERT_LT(std::chrono::steady_clock::now() - begin, std::chrono::seconds(3));
+  ASSERT_NE(getTcp(server.port(), "/metrics").find("rs_driver_up 1"), std::string::npos);
+
+  // it's not blocked by such a client when stopping either.
+  fd = connectTcp(server.port());
+  ASSERT_GE(fd, 0);
+  send(fd, "G", 1, MSG_NOSIGNAL);
+  std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+  begin = std::chrono::steady_clock::now();
+  server.stop();
+  ASSERT_LT(std::chrono::steady_clock::now() - begin, std::chrono::milliseconds(500));
+
+  close(fd);
+}
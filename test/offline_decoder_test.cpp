@@ -0,0 +1,164 @@
+#include <gtest/gtest.h>
+
+#include <rs_driver/api/offline_decoder.hpp>
+#include <rs_driver/msg/point_cloud_msg.hpp>
+
+#include "packet_source.hpp"
+
+using namespace robosense::lidar;
+
+typedef PointXYZIRT PointT;
+typedef PointCloudT<PointT> PointCloud;
+
+static std::string writeRS16Log(size_t pkt_num)
+{
+  std::string path = "/tmp/rs_driver_offline_decoder_test.rslog";
+
+  PacketLogWriter writer;
+  writer.open(path, LOG_CODEC_NONE);
+
+  PacketSource source;
+  for (size_t i = 0; i < pkt_num; i++)
+  {
+    const std::vector<uint8_t>& msop = source.nextMsop(1600000000000000 + i * 1200);
+    writer.write(i * 1200, LOG_PKT_MSOP, 0, msop.data(), msop.size());
+  }
+
+  writer.close();
+  return path;
+}
+
+static std::vector<std::shared_ptr<PointCloud>> decodeAll(const std::string& path)
+{
+  RSDriverParam param;
+  param.lidar_type = LidarType::RS16;
+  param.input_type = InputType::LOG_FILE;
+  param.input_param.pcap_path = path;
+  param.decoder_param.wait_for_difop = false;
+
+  std::vector<std::shared_ptr<PointCloud>> frames;
+
+  OfflineDecoder<PointCloud> decoder;
+  EXPECT_TRUE(decoder.open(param));
+
+  std::shared_ptr<PointCloud> cloud;
+  while (decoder.nextFrame(cloud))
+  {
+    frames.push_back(cloud);
+    cloud.reset();
+  }
+
+  return frames;
+}
+
+TEST(TestOfflineDecoder, nextFrame)
+{
+  // 75 packets per round.
+  std::string path = writeRS16Log(250);
+
+  std::vector<std::shared_ptr<PointCloud>> frames = decodeAll(path);
+  ASSERT_EQ(frames.size(), 3u);
+
+  for (size_t i = 0; i < frames.size(); i++)
+  {
+    ASSERT_EQ(frames[i]->seq, i);
+    ASSERT_GT(frames[i]->points.size(), 0u);
+  }
+
+  // lidar clock
+  ASSERT_GT(frames[1]->timestamp, 1600000000.0);
+  ASSERT_LT(frames[1]->timestamp, 1600000001.0);
+
+  remove(path.c_str());
+}
+
+TEST(TestOfflineDecoder, reproducible)
+{
+  std::string path = writeRS16Log(250);
+
+  std::vector<std::shared_ptr<PointCloud>> frames1 = decodeAll(path);
+  std::vector<std::shared_ptr<PointCloud>> frames2 = decodeAll(path);
+
+  ASSERT_EQ(frames1.size(), frames2.size());
+  for (size_t i = 0; i < frames1.size(); i++)
+  {
+    ASSERT_EQ(frames1[i]->timestamp, frames2[i]->timestamp);
+    ASSERT_EQ(frames1[i]->points.size(), frames2[i]->points.size());
+    ASSERT_EQ(memcmp(frames1[i]->points.data(), frames2[i]->points.data(), 
+          frames1[i]->points.size() * sizeof(PointT)), 0);
+  }
+
+  remove(path.c_str());
+}
+
+TEST(TestOfflineDecoder, reuseCloud)
+{
+  std::string path = writeRS16Log(250);
+
+  RSDriverParam param;
+  param.lidar_type = LidarType::RS16;
+  param.input_type = InputType::LOG_FILE;
+  param.input_param.pcap_path = path;
+  param.decoder_param.wait_for_difop = false;
+
+  OfflineDecoder<PointCloud> decoder;
+  ASSERT_TRUE(decoder.open(param));
+
+  std::shared_ptr<PointCloud> cloud;
+  ASSERT_TRUE(decoder.nextFrame(cloud));
+  PointCloud* first = cloud.get();
+
+  // the first cloud is reused to decode the third frame.
+  ASSERT_TRUE(decoder.nextFrame(cloud));
+  ASSERT_TRUE(decoder.nextFrame(cloud));
+  ASSERT_EQ(cloud.get(), first);
+  ASSERT_EQ(cloud->seq, 2u);
+
+  ASSERT_FALSE(decoder.nextFrame(cloud));
+
+  remove(path.c_str());
+}
+
+TEST(TestOfflineDecoder, keepCloud)
+{
+  std::string path = writeRS16Log(250);
+
+  RSDriverParam param;
+  param.lidar_type = LidarType::RS16;
+  param.input_type = InputType::LOG_FILE;
+  param.input_param.pcap_path = path;
+  param.decoder_param.wait_for_difop = false;
+
+  OfflineDecoder<PointCloud> decoder;
+  ASSERT_TRUE(decoder.open(param));
+
+  // the caller keeps the frames. None of them is reused.
+  std::vector<std::shared_ptr<PointCloud>> kept;
+  std::shared_ptr<PointCloud> cloud;
+  while (decoder.nextFrame(cloud))
+  {
+    kept.push_back(cloud);
+  }
+
+  ASSERT_EQ(kept.size(), 3u);
+  for (size_t i = 0; i < kept.size(); i++)
+  {
+    ASSERT_EQ(kept[i]->seq, i);
+    ASSERT_GT(kept[i]->points.size(), 0u);
+  }
+  ASSERT_NE(kept[0].get(), kept[2].get());
+
+  remove(path.c_str());
+}
+
+TEST(TestOfflineDecoder, wrongInputType)
+{
+  RSDriverParam param;
+  param.input_type = InputType::ONLINE_LIDAR;
+
+  OfflineDecoder<PointCloud> decoder;
+  ASSERT_FALSE(decoder.open(param));
+
+  std::shared_ptr<PointCloud> cloud;
+  ASSERT_FALSE(decoder.nextFrame(cloud));
+}
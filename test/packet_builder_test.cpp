@@ -0,0 +1,100 @@
+
+#include <gtest/gtest.h>
+
+#include <rs_driver/driver/decoder/packet_builder.hpp>
+
+using namespace robosense::lidar;
+
+typedef PointCloudT<PointXYZIRT> PointCloud;
+
+static const LidarType ALL_TYPES[] = 
+{
+  LidarType::RS16, LidarType::RS32, LidarType::RSBP, LidarType::RSBPV4, 
+  LidarType::RSHELIOS, LidarType::RSHELIOS_16P, LidarType::RS128, LidarType::RS80, LidarType::RS48, 
+  LidarType::RSP128, LidarType::RSP80, LidarType::RSP48, 
+  LidarType::RSM1, LidarType::RSM2, LidarType::RSEOS, LidarType::RSM1_JUMBO
+};
+
+TEST(TestPacketBuilder, decode)
+{
+  for (auto type : ALL_TYPES)
+  {
+    PacketBuilder builder(type);
+    ASSERT_FALSE(builder.msops().empty()) << lidarTypeToStr(type);
+    ASSERT_GT(builder.pktInterval(), 0.0);
+
+    RSDecoderParam param;
+    param.wait_for_difop = true;
+    param.use_lidar_clock = true;
+    param.dense_points = false;
+
+    std::shared_ptr<Decoder<PointCloud>> decoder = DecoderFactory<PointCloud>::createDecoder(type, param);
+    decoder->point_cloud_ = std::make_shared<PointCloud>();
+
+    std::vector<double> frame_ts;
+    std::vector<size_t> frame_points;
+    Decoder<PointCloud>* d = decoder.get();
+    decoder->regCallback(
+        [](const Error&) {}, 
+        [&](uint16_t, double ts) 
+        { 
+          frame_ts.push_back(ts);
+          frame_points.push_back(d->point_cloud_->points.size());
+          d->point_cloud_->points.resize(0); 
+        });
+
+    // mechanical Lidars: no points before difop
+    std::vector<uint8_t> pkt = builder.msops()[0];
+    if (isMech(type))
+    {
+      decoder->processMsopPkt(pkt.data(), pkt.size());
+      ASSERT_TRUE(decoder->point_cloud_->points.empty()) << lidarTypeToStr(type);
+    }
+
+    decoder->processDifopPkt(builder.difop().data(), builder.difop().size());
+    ASSERT_TRUE(decoder->angles_ready_) << lidarTypeToStr(type);
+
+    // 2 frames, from 2020-09-13
+    const uint64_t base_us = 1600000000000000;
+    const size_t round = builder.msops().size();
+    for (size_t k = 0; k < round * 2 + 1; k++)
+    {
+      pkt = builder.msops()[k % round];
+      builder.stamp(pkt.data(), base_us + (uint64_t)(k * builder.pktInterval() * 1e6));
+      decoder->processMsopPkt(pkt.data(), pkt.size());
+    }
+
+    ASSERT_GE(frame_ts.size(), 2u) << lidarTypeToStr(type);
+    ASSERT_LE(frame_ts.size(), 3u) << lidarTypeToStr(type);
+    ASSERT_GT(frame_ts.back(), 1600000000.0) << lidarTypeToStr(type);
+    ASSERT_LT(frame_ts.back(), 1600000000.3) << lidarTypeToStr(type);
+    ASSERT_GT(frame_points.back(), builder.pointNum() * 9 / 10) << lidarTypeToStr(type);
+    ASSERT_LT(frame_points.back(), builder.pointNum() * 11 / 10) << lidarTypeToStr(type);
+  }
+}
+
+TEST(TestPacketBuilder, difopAngles)
+{
+  PacketBuilder builder(LidarType::RS128);
+
+  const RS128DifopPkt& difop = *(const RS128DifopPkt*)builder.difop().data();
+  ASSERT_EQ(ntohs(difop.rpm), 600);
+  ASSERT_EQ(difop.vert_angle_cali[0].sign, 1);
+  ASSERT_EQ(ntohs(difop.vert_angle_cali[0].value), 1500);
+  ASSERT_EQ(difop.vert_angle_cali[127].sign, 0);
+}
+
+TEST(TestPacketBuilder, memsSeq)
+{
+  PacketBuilder builder(LidarType::RSM1);
+  ASSERT_EQ(builder.msops().size(), 630u);
+
+  const RSM1MsopPkt& first = *(const RSM1MsopPkt*)builder.msops().front().data();
+  const RSM1MsopPkt& last = *(const RSM1MsopPkt*)builder.msops().back().data();
+  ASSERT_EQ(ntohs(first.header.pkt_seq), 1);
+  ASSERT_EQ(ntohs(last.header.pkt_seq), 630);
+
+  PacketBuilder jumbo(LidarType::RSM1_JUMBO);
+  ASSERT_EQ(jumbo.msops().size(), 10u);
+  ASSERT_EQ(jumbo.msops()[0].size(), sizeof(RSM1_Jumbo));
+}
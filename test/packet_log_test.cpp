@@ -0,0 +1,225 @@
+#include <gtest/gtest.h>
+
+#include <rs_driver/utility/packet_log.hpp>
+
+using namespace robosense::lidar;
+
+static void writeLog(const std::string& path, LogCodec codec, size_t pkt_num)
+{
+  PacketLogWriter writer(65536);
+  ASSERT_TRUE(writer.open(path, codec));
+
+  std::vector<uint8_t> pkt(1248);
+  for (size_t i = 0; i < pkt_num; i++)
+  {
+    memset (pkt.data(), (uint8_t)i, pkt.size());
+    uint8_t kind = (i % 100 == 0) ? LOG_PKT_DIFOP : LOG_PKT_MSOP;
+    ASSERT_TRUE(writer.write(1000 + i * 100, kind, 1, pkt.data(), pkt.size()));
+  }
+
+  writer.close();
+}
+
+static void readLog(const std::string& path, size_t pkt_num)
+{
+  PacketLogReader reader;
+  ASSERT_TRUE(reader.open(path));
+  ASSERT_GT(reader.index().size(), 1u);
+
+  LogPacket pkt;
+  size_t i = 0;
+  while (reader.next(pkt))
+  {
+    ASSERT_EQ(pkt.ts, 1000 + i * 100);
+    ASSERT_EQ(pkt.kind, (i % 100 == 0) ? LOG_PKT_DIFOP : LOG_PKT_MSOP);
+    ASSERT_EQ(pkt.source, 1);
+    ASSERT_EQ(pkt.size, 1248u);
+    ASSERT_EQ(pkt.data[0], (uint8_t)i);
+    ASSERT_EQ(pkt.data[1247], (uint8_t)i);
+    i++;
+  }
+  ASSERT_EQ(i, pkt_num);
+}
+
+TEST(TestPacketLog, writeRead)
+{
+  std::string path = "/tmp/rs_driver_packet_log_test.rslog";
+  writeLog(path, LOG_CODEC_NONE, 500);
+  readLog(path, 500);
+  remove(path.c_str());
+}
+
+#ifdef ENABLE_ZLIB
+TEST(TestPacketLog, writeReadZlib)
+{
+  std::string path = "/tmp/rs_driver_packet_log_zlib.rslog";
+  writeLog(path, LOG_CODEC_ZLIB, 500);
+  readLog(path, 500);
+
+  // the payload is highly compressible.
+  FILE* fp = fopen(path.c_str(), "rb");
+  ASSERT_TRUE(fp != NULL);
+  fseek(fp, 0, SEEK_END);
+  ASSERT_LT(ftell(fp), 500 * 1248 / 10);
+  fclose(fp);
+
+  remove(path.c_str());
+}
+#endif
+
+#ifdef ENABLE_ZSTD
+TEST(TestPacketLog, writeReadZstd)
+{
+  std::string path = "/tmp/rs_driver_packet_log_zstd.rslog";
+  writeLog(path, LOG_CODEC_ZSTD, 500);
+  readLog(path, 500);
+  remove(path.c_str());
+}
+#endif
+
+TEST(TestPacketLog, seek)
+{
+  std::string path = "/tmp/rs_driver_packet_log_seek.rslog";
+  writeLog(path, LOG_CODEC_NONE, 500);
+
+  PacketLogReader reader;
+  ASSERT_TRUE(reader.open(path));
+
+  LogPacket pkt;
+  ASSERT_TRUE(reader.seek(1000 + 321 * 100 - 50));
+  ASSERT_TRUE(reader.next(pkt));
+  ASSERT_EQ(pkt.ts, 1000u + 321 * 100);
+
+  ASSERT_TRUE(reader.seek(0));
+  ASSERT_TRUE(reader.next(pkt));
+  ASSERT_EQ(pkt.ts, 1000u);
+
+  ASSERT_FALSE(reader.seek(1000 + 500 * 100));
+  ASSERT_FALSE(reader.next(pkt));
+
+  reader.rewind();
+  ASSERT_TRUE(reader.next(pkt));
+  ASSERT_EQ(pkt.ts, 1000u);
+
+  remove(path.c_str());
+}
+
+TEST(TestPacketLog, readWithoutIndex)
+{
+  std::string path = "/tmp/rs_driver_packet_log_noindex.rslog";
+  writeLog(path, LOG_CODEC_NONE, 500);
+
+  // clear the index offset, and truncate the tail, as if the writer crashed.
+  FILE* fp = fopen(path.c_str(), "r+b");
+  ASSERT_TRUE(fp != NULL);
+  LogFileHeader hdr;
+  ASSERT_EQ(fread(&hdr, sizeof(hdr), 1, fp), 1u);
+  uint64_t index_offset = hdr.index_offset;
+  hdr.index_offset = 0;
+  hdr.chunk_num = 0;
+  fseek(fp, 0, SEEK_SET);
+  ASSERT_EQ(fwrite(&hdr, sizeof(hdr), 1, fp), 1u);
+  fclose(fp);
+  ASSERT_EQ(truncate(path.c_str(), index_offset - 100), 0);
+
+  PacketLogReader reader;
+  ASSERT_TRUE(reader.open(path));
+
+  LogPacket pkt;
+  size_t num = 0;
+  while (reader.next(pkt))
+  {
+    num++;
+  }
+
+  // the truncated chunk is lost.
+  ASSERT_GT(num, 0u);
+  ASSERT_LT(num, 500u);
+  ASSERT_EQ(num % reader.index()[0].pkt_num, 0u);
+
+  remove(path.c_str());
+}
+
+TEST(TestPacketLog, wrongChunkSize)
+{
+  std::string path = "/tmp/rs_driver_packet_log_wrong_size.rslog";
+  writeLog(path, LOG_CODEC_NONE, 500);
+
+  // raw_size of the first chunk is larger than its data.
+  FILE* fp = fopen(path.c_str(), "r+b");
+  ASSERT_TRUE(fp != NULL);
+  LogChunkHeader chunk_hdr;
+  fseek(fp, sizeof(LogFileHeader), SEEK_SET);
+  ASSERT_EQ(fread(&chunk_hdr, sizeof(chunk_hdr), 1, fp), 1u);
+  ASSERT_EQ(chunk_hdr.magic, LOG_CHUNK_MAGIC);
+  chunk_hdr.raw_size = chunk_hdr.comp_size * 2;
+  fseek(fp, sizeof(LogFileHeader), SEEK_SET);
+  ASSERT_EQ(fwrite(&chunk_hdr, sizeof(chunk_hdr), 1, fp), 1u);
+  fclose(fp);
+
+  PacketLogReader reader;
+  ASSERT_TRUE(reader.open(path));
+
+  LogPacket pkt;
+  ASSERT_FALSE(reader.next(pkt));
+
+  remove(path.c_str());
+}
+
+TEST(TestPacketLog, corruptChunkSize)
+{
+  std::string path = "/tmp/rs_driver_packet_log_corrupt_size.rslog";
+  writeLog(path, LOG_CODEC_NONE, 500);
+
+  // sizes of the first chunk are corrupt. Nothing is allocated for them.
+  FILE* fp = fopen(path.c_str(), "r+b");
+  ASSERT_TRUE(fp != NULL);
+  LogChunkHeader chunk_hdr;
+  fseek(fp, sizeof(LogFileHeader), SEEK_SET);
+  ASSERT_EQ(fread(&chunk_hdr, sizeof(chunk_hdr), 1, fp), 1u);
+  chunk_hdr.raw_size = chunk_hdr.comp_size = 0xFFFFFFF0;
+  fseek(fp, sizeof(LogFileHeader), SEEK_SET);
+  ASSERT_EQ(fwrite(&chunk_hdr, sizeof(chunk_hdr), 1, fp), 1u);
+  fclose(fp);
+
+  {
+    PacketLogReader reader;
+    ASSERT_TRUE(reader.open(path));
+
+    LogPacket pkt;
+    ASSERT_FALSE(reader.next(pkt));
+  }
+
+  // so is the chunk number of the index.
+  fp = fopen(path.c_str(), "r+b");
+  ASSERT_TRUE(fp != NULL);
+  LogFileHeader hdr;
+  ASSERT_EQ(fread(&hdr, sizeof(hdr), 1, fp), 1u);
+  hdr.chunk_num = 0xFFFFFFFFFFFF;
+  fseek(fp, 0, SEEK_SET);
+  ASSERT_EQ(fwrite(&hdr, sizeof(hdr), 1, fp), 1u);
+  fclose(fp);
+
+  {
+    PacketLogReader reader;
+    ASSERT_TRUE(reader.open(path));
+    ASSERT_EQ(reader.index().size(), 0u);
+  }
+
+  remove(path.c_str());
+}
+
+TEST(TestPacketLog, wrongFile)
+{
+  std::string path = "/tmp/rs_driver_packet_log_wrong.rslog";
+  FILE* fp = fopen(path.c_str(), "wb");
+  ASSERT_TRUE(fp != NULL);
+  fputs("not a log file, not a log file, not a log file", fp);
+  fclose(fp);
+
+  PacketLogReader reader;
+  ASSERT_FALSE(reader.open(path));
+  ASSERT_FALSE(reader.open("/tmp/rs_driver_packet_log_not_exist.rslog"));
+
+  remove(path.c_str());
+}
@@ -0,0 +1,61 @@
+
+#pragma once
+
+#include <rs_driver/driver/decoder/packet_builder.hpp>
+#include <rs_driver/msg/packet.hpp>
+
+namespace robosense
+{
+namespace lidar
+{
+
+//
+// The msop packets of PacketBuilder, round after round, as a Lidar sends them.
+//
+class PacketSource
+{
+public:
+
+  explicit PacketSource(LidarType type = LidarType::RS16)
+    : builder_(type), next_(0)
+  {
+  }
+
+  // packets of a round (mechanical Lidars) or a frame (MEMS Lidars).
+  size_t roundPkts() const
+  {
+    return builder_.msops().size();
+  }
+
+  // the next msop packet. If usec isn't 0, it is the timestamp of the packet.
+  const std::vector<uint8_t>& nextMsop(uint64_t usec = 0)
+  {
+    buf_ = builder_.msops()[next_];
+    next_ = (next_ + 1) % builder_.msops().size();
+
+    if (usec != 0)
+    {
+      builder_.stamp(buf_.data(), usec);
+    }
+
+    return buf_;
+  }
+
+  Packet next(uint64_t usec = 0)
+  {
+    const std::vector<uint8_t>& msop = nextMsop(usec);
+
+    Packet pkt(msop.size());
+    memcpy(pkt.buf_.data(), msop.data(), msop.size());
+    return pkt;
+  }
+
+private:
+
+  PacketBuilder builder_;
+  size_t next_;
+  std::vector<uint8_t> buf_;
+};
+
+}  // namespace lidar
+}  // namespace robosense
@@ -0,0 +1,295 @@
+
+#include <gtest/gtest.h>
+
+#include <rs_driver/driver/recorder/recorder.hpp>
+
+#include <dirent.h>
+#include <algorithm>
+
+using namespace robosense::lidar;
+
+static std::vector<std::string> listFiles(const std::string& dir)
+{
+  std::vector<std::string> files;
+
+  DIR* d = opendir(dir.c_str());
+  if (d == NULL)
+    return files;
+
+  struct dirent* ent;
+  while ((ent = readdir(d)) != NULL)
+  {
+    if (ent->d_name[0] != '.')
+      files.push_back(dir + "/" + ent->d_name);
+  }
+  closedir(d);
+
+  std::sort(files.begin(), files.end());
+  return files;
+}
+
+static size_t countPcapRecords(const std::string& path, size_t pkt_size)
+{
+  FILE* fp = fopen(path.c_str(), "rb");
+  if (fp == NULL)
+    return 0;
+
+  PcapFileHeader file_hdr;
+  EXPECT_EQ(fread(&file_hdr, sizeof(file_hdr), 1, fp), 1u);
+  EXPECT_EQ(file_hdr.magic, 0xa1b2c3d4);
+
+  size_t num = 0;
+  PcapRecordHeader rec_hdr;
+  while (fread(&rec_hdr, sizeof(rec_hdr), 1, fp) == 1)
+  {
+    EXPECT_EQ(rec_hdr.caplen, sizeof(UdpPktHeader) + pkt_size);
+
+    std::vector<uint8_t> buf(rec_hdr.caplen);
+    EXPECT_EQ(fread(buf.data(), buf.size(), 1, fp), 1u);
+
+    const UdpPktHeader* hdr = (const UdpPktHeader*)buf.data();
+    EXPECT_EQ(ntohs(hdr->udp.dest), 6699);
+    EXPECT_EQ(buf[sizeof(UdpPktHeader)], 0x55);
+    num++;
+  }
+
+  fclose(fp);
+  return num;
+}
+
+TEST(TestRecorder, record)
+{
+  std::string dir = "/tmp/rs_driver_recorder_test";
+  system(("rm -rf " + dir + " && mkdir -p " + dir).c_str());
+
+  RSRecordParam param;
+  param.record_path = dir + "/lidar";
+  param.buf_size = 0; // use minimum size
+  param.buf_num = 4;
+  param.file_size_max = 1;
+
+  RSInputParam input_param;
+
+  Recorder recorder(param, input_param);
+  recorder.regCallback([](const Error&) {});
+  ASSERT_TRUE(recorder.init());
+  ASSERT_TRUE(recorder.start());
+
+  std::vector<uint8_t> pkt(1248, 0x55);
+  for (int i = 0; i < 2000; i++)
+  {
+    recorder.record(pkt.data(), pkt.size(), false);
+    if (i % 100 == 0)
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+
+  recorder.stop();
+
+  RecordStats stats = recorder.getStats();
+  ASSERT_EQ(stats.packets + stats.dropped, 2000u);
+  ASSERT_GE(stats.files, 2u);
+
+  std::vector<std::string> files = listFiles(dir);
+  ASSERT_EQ(files.size(), stats.files);
+
+  size_t num = 0;
+  for (auto& f : files)
+  {
+    num += countPcapRecords(f, pkt.size());
+  }
+  ASSERT_EQ(num, stats.packets);
+
+  system(("rm -rf " + dir).c_str());
+}
+
+TEST(TestRecorder, reopenAfterError)
+{
+  std::string dir = "/tmp/rs_driver_recorder_reopen";
+  system(("rm -rf " + dir).c_str());
+
+  RSRecordParam param;
+  param.record_path = dir + "/lidar";
+  param.buf_size = 0; // use minimum size
+  param.buf_num = 4;
+
+  RSInputParam input_param;
+
+  Recorder recorder(param, input_param);
+  recorder.regCallback([](const Error&) {});
+  ASSERT_TRUE(recorder.init());
+  ASSERT_TRUE(recorder.start());
+
+  // the directory doesn't exist, so the file fails to open.
+  std::vector<uint8_t> pkt(1248, 0x55);
+  for (int i = 0; i < 300; i++)
+  {
+    recorder.record(pkt.data(), pkt.size(), false);
+  }
+  std::this_thread::sleep_for(std::chrono::milliseconds(200));
+
+  system(("mkdir -p " + dir).c_str());
+  for (int i = 0; i < 1000; i++)
+  {
+    recorder.record(pkt.data(), pkt.size(), false);
+    if (i % 100 == 0)
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  recorder.stop();
+
+  // the next file starts with the file header.
+  std::vector<std::string> files = listFiles(dir);
+  ASSERT_EQ(files.size(), 1u);
+  size_t num = countPcapRecords(files[0], pkt.size());
+  ASSERT_GT(num, 0u);
+  ASSERT_LT(num, recorder.getStats().packets);
+
+  // all buffers are back after stop().
+  for (int i = 0; i < 3; i++)
+  {
+    ASSERT_TRUE(recorder.start());
+    for (int j = 0; j < 300; j++)
+    {
+      recorder.record(pkt.data(), pkt.size(), false);
+    }
+    recorder.stop();
+  }
+
+  size_t free_num = 0;
+  while (recorder.free_queue_.pop() != NULL)
+  {
+    free_num++;
+  }
+  ASSERT_EQ(free_num, param.buf_num);
+
+  system(("rm -rf " + dir).c_str());
+}
+
+TEST(TestRecorder, dropIfFull)
+{
+  RSRecordParam param;
+  param.record_path = "/tmp/rs_driver_recorder_drop";
+  param.buf_size = 0; // use minimum size
+  param.buf_num = 2;
+
+  RSInputParam input_param;
+
+  Error err;
+  Recorder recorder(param, input_param);
+  recorder.regCallback([&err](const Error& e) { err = e; });
+  ASSERT_TRUE(recorder.init());
+
+  // not started, so no buffer is flushed.
+  std::vector<uint8_t> pkt(1248, 0x55);
+  for (int i = 0; i < 1000; i++)
+  {
+    recorder.record(pkt.data(), pkt.size(), false);
+  }
+
+  RecordStats stats = recorder.getStats();
+  ASSERT_GT(stats.dropped, 0u);
+  ASSERT_EQ(stats.packets + stats.dropped, 1000u);
+  ASSERT_EQ(err.error_code, ERRCODE_RECORDOVERFLOW);
+}
+
+TEST(TestRecorder, rotateWithoutBuffer)
+{
+  RSRecordParam param;
+  param.record_path = "/tmp/rs_driver_recorder_rotate";
+  param.record_format = RECORD_LOG;
+  param.buf_size = 0; // use minimum size
+  param.buf_num = 2;
+  param.file_duration_max = 1;
+
+  RSInputParam input_param;
+
+  Recorder recorder(param, input_param);
+  recorder.regCallback([](const Error&) {});
+  ASSERT_TRUE(recorder.init());
+
+  // not started, so all buffers are handed over and in flight, as if the disk stalls.
+  std::vector<uint8_t> pkt(1248, 0x55);
+  while (recorder.getStats().dropped == 0)
+  {
+    recorder.record(pkt.data(), pkt.size(), false);
+  }
+  ASSERT_TRUE(recorder.cur_ == NULL);
+
+  // time to rotate, without a buffer.
+  recorder.file_start_ts_ -= 2000000;
+  recorder.record(pkt.data(), pkt.size(), false);
+  ASSERT_EQ(recorder.getStats().dropped, 2u);
+
+  // the buffers are written. The file is closed with the next buffer.
+  Recorder::RecordBuffer* buf;
+  while ((buf = recorder.full_queue_.pop()) != NULL)
+  {
+    ASSERT_FALSE(buf->last);
+    recorder.free_queue_.push(buf);
+  }
+
+  recorder.record(pkt.data(), pkt.size(), false);
+  recorder.record(pkt.data(), pkt.size(), false);
+
+  buf = recorder.full_queue_.pop();
+  ASSERT_TRUE(buf != NULL);
+  ASSERT_TRUE(buf->last);
+  ASSERT_TRUE(recorder.cur_->first);
+
+  recorder.free_queue_.push(buf);
+}
+
+TEST(TestRecorder, recordLog)
+{
+  std::string dir = "/tmp/rs_driver_recorder_log";
+  system(("rm -rf " + dir + " && mkdir -p " + dir).c_str());
+
+  RSRecordParam param;
+  param.record_path = dir + "/lidar";
+  param.record_format = RECORD_LOG;
+  param.buf_size = 0; // use minimum size
+  param.buf_num = 4;
+
+  RSInputParam input_param;
+
+  Recorder recorder(param, input_param);
+  recorder.regCallback([](const Error&) {});
+  ASSERT_TRUE(recorder.init());
+  ASSERT_TRUE(recorder.start());
+
+  std::vector<uint8_t> pkt(1248, 0x55);
+  for (int i = 0; i < 1000; i++)
+  {
+    recorder.record(pkt.data(), pkt.size(), (i % 100) == 0);
+    if (i % 100 == 0)
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+
+  recorder.stop();
+
+  RecordStats stats = recorder.getStats();
+  ASSERT_EQ(stats.packets + stats.dropped, 1000u);
+  ASSERT_EQ(stats.files, 1u);
+
+  std::vector<std::string> files = listFiles(dir);
+  ASSERT_EQ(files.size(), 1u);
+  ASSERT_NE(files[0].find(".rslog"), std::string::npos);
+
+  PacketLogReader reader;
+  ASSERT_TRUE(reader.open(files[0]));
+  ASSERT_GT(reader.index().size(), 1u);
+
+  LogPacket log_pkt;
+  size_t num = 0, difop_num = 0;
+  while (reader.next(log_pkt))
+  {
+    ASSERT_EQ(log_pkt.size, pkt.size());
+    ASSERT_EQ(log_pkt.data[0], 0x55);
+    if (log_pkt.kind == LOG_PKT_DIFOP)
+      difop_num++;
+    num++;
+  }
+  ASSERT_EQ(num, stats.packets);
+  ASSERT_GT(difop_num, 0u);
+
+  system(("rm -rf " + dir).c_str());
+}
@@ -0,0 +1,139 @@
+#include <gtest/gtest.h>
+
+#include <rs_driver/driver/rolling_window.hpp>
+#include <rs_driver/msg/point_cloud_msg.hpp>
+
+#include <set>
+
+using namespace robosense::lidar;
+
+typedef PointXYZIRT PointT;
+typedef PointCloudT<PointT> PointCloud;
+
+static PointT makePoint(float x)
+{
+  PointT point;
+  memset (&point, 0, sizeof(point));
+  point.x = x;
+  return point;
+}
+
+//
+// write a packet, with blocks of (angle, points)
+//
+static void writePacket(RollingWindow<PointCloud>& window, 
+    const std::vector<std::pair<int32_t, std::vector<float>>>& blocks)
+{
+  PointCloud cloud;
+
+  window.beginPacket();
+  for (const auto& blk : blocks)
+  {
+    window.newBlock(blk.first, cloud.points.size());
+    for (float x : blk.second)
+    {
+      cloud.points.push_back(makePoint(x));
+    }
+  }
+
+  window.endPacket(cloud, 1.0);
+}
+
+TEST(TestRollingWindow, snapshot)
+{
+  // 4 columns
+  RollingWindow<PointCloud> window(90.0f);
+
+  std::shared_ptr<const PointCloud> snap;
+  ASSERT_FALSE(window.snapshot(snap));
+
+  writePacket(window, {{0, {1, 2}}, {9000, {3, 4}}, {18000, {5, 6}}, {27000, {7, 8}}});
+  ASSERT_FALSE(window.snapshot(snap));
+
+  window.setComplete();
+  ASSERT_TRUE(window.snapshot(snap));
+  ASSERT_EQ(snap->points.size(), 8u);
+  ASSERT_EQ(snap->width, 8u);
+  ASSERT_FALSE(snap->is_dense);
+  for (size_t i = 0; i < 8; i++)
+  {
+    ASSERT_EQ(snap->points[i].x, (float)(i + 1));
+  }
+
+  // overwrite the column in place. The held snapshot is not changed.
+  writePacket(window, {{9100, {10}}});
+  ASSERT_EQ(snap->points[2].x, 3.0f);
+
+  const PointCloud* prev = snap.get();
+  ASSERT_TRUE(window.snapshot(snap));
+  ASSERT_NE(snap.get(), prev);
+  ASSERT_EQ(snap->points[2].x, 10.0f);
+  ASSERT_TRUE(std::isnan(snap->points[3].x));
+  ASSERT_EQ(snap->points[4].x, 5.0f);
+  ASSERT_EQ(snap->seq, 1u);
+}
+
+TEST(TestRollingWindow, reuseBuffer)
+{
+  RollingWindow<PointCloud> window(90.0f);
+  writePacket(window, {{0, {1, 2}}, {9000, {3, 4}}});
+  window.setComplete();
+
+  std::set<const PointCloud*> clouds;
+  std::shared_ptr<const PointCloud> snap;
+  for (size_t i = 0; i < 10; i++)
+  {
+    writePacket(window, {{18000, {(float)i, (float)i}}, {27000, {(float)i, (float)i}}});
+    ASSERT_TRUE(window.snapshot(snap));
+    ASSERT_EQ(snap->points[4].x, (float)i);
+    ASSERT_EQ(snap->points[0].x, 1.0f);
+    clouds.insert(snap.get());
+  }
+
+  // the caller passes back its snapshot. The released buffers are reused.
+  ASSERT_LE(clouds.size(), 3u);
+
+  // the caller holds a snapshot. It is not written any more.
+  std::shared_ptr<const PointCloud> held = snap;
+  for (size_t i = 10; i < 20; i++)
+  {
+    writePacket(window, {{18000, {(float)i, (float)i}}, {27000, {(float)i, (float)i}}});
+    ASSERT_TRUE(window.snapshot(snap));
+    ASSERT_NE(snap.get(), held.get());
+    ASSERT_EQ(snap->points[4].x, (float)i);
+  }
+
+  ASSERT_EQ(held->points[4].x, 9.0f);
+  ASSERT_EQ(held->points[6].x, 9.0f);
+}
+
+TEST(TestRollingWindow, outliveWindow)
+{
+  std::shared_ptr<const PointCloud> snap;
+  {
+    RollingWindow<PointCloud> window(90.0f);
+    writePacket(window, {{0, {1, 2}}, {9000, {3, 4}}});
+    window.setComplete();
+    ASSERT_TRUE(window.snapshot(snap));
+  }
+
+  // the buffer is released after the window.
+  ASSERT_EQ(snap->points[2].x, 3.0f);
+}
+
+TEST(TestRollingWindow, sameColumn)
+{
+  RollingWindow<PointCloud> window(90.0f);
+
+  // dual return. Blocks of the same column are appended.
+  writePacket(window, {{100, {1, 2}}, {100, {3, 4}}, {9000, {5, 6}}, {9000, {7, 8}}});
+  window.setComplete();
+
+  std::shared_ptr<const PointCloud> snap;
+  ASSERT_TRUE(window.snapshot(snap));
+  ASSERT_EQ(window.rows_, 4u);
+  ASSERT_EQ(snap->points.size(), 16u);
+  ASSERT_EQ(snap->points[0].x, 1.0f);
+  ASSERT_EQ(snap->points[3].x, 4.0f);
+  ASSERT_EQ(snap->points[7].x, 8.0f);
+}
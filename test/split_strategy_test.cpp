@@ -50,6 +50,47 @@ TEST(TestSplitStrategyByAngle, newBlock_Zero)
   }
 }
 
+TEST(TestSplitStrategyByAngle, newBlock_Late)
+{
+  uint16_t block_az_diff = 20;
+  SplitStrategyByAngle sa(0, &block_az_diff);
+  ASSERT_FALSE(sa.newBlock(35960));
+  ASSERT_FALSE(sa.newBlock(35980));
+  ASSERT_TRUE(sa.newBlock(20));
+
+  // late blocks, before the split angle
+  ASSERT_FALSE(sa.newBlock(35940));
+  ASSERT_FALSE(sa.newBlock(0));
+  ASSERT_FALSE(sa.newBlock(40));
+
+  // half a round lost. The next round.
+  ASSERT_FALSE(sa.newBlock(18100));
+  ASSERT_FALSE(sa.newBlock(35980));
+  ASSERT_TRUE(sa.newBlock(0));
+}
+
+TEST(TestSplitStrategyByAngle, newBlock_LimitedFov)
+{
+  // FOV 0 ~ 90 degrees. Nothing in the blind section.
+  uint16_t block_az_diff = 20;
+  SplitStrategyByAngle sa(4500, &block_az_diff);
+
+  size_t splits = 0;
+  for (int round = 0; round < 3; round++)
+  {
+    for (int32_t angle = 0; angle < 9000; angle += 20)
+    {
+      if (sa.newBlock(angle))
+      {
+        ASSERT_EQ(angle, 4500);
+        splits++;
+      }
+    }
+  }
+
+  ASSERT_EQ(splits, 3u);
+}
+
 TEST(TestSplitStrategyByNum, newBlock)
 {
   uint16_t max_blks = 2;
@@ -135,3 +176,93 @@ TEST(TestSplitStrategyBySeq, newPacket_rewind)
   ASSERT_EQ(sn.safe_seq_min_, 0);
   ASSERT_EQ(sn.safe_seq_max_, 11);
 }
+
+TEST(TestSplitStrategyByTime, newBlock)
+{
+  SplitStrategyByTime st(0.1, 0.02);
+  ASSERT_FALSE(st.newBlock(0, 1600000000.05));
+  ASSERT_FALSE(st.newBlock(0, 1600000000.11));
+  ASSERT_TRUE(st.newBlock(0, 1600000000.121));
+  ASSERT_FALSE(st.newBlock(0, 1600000000.15));
+
+  // a little out of order
+  ASSERT_FALSE(st.newBlock(0, 1600000000.119));
+  ASSERT_FALSE(st.newBlock(0, 1600000000.2));
+  ASSERT_TRUE(st.newBlock(0, 1600000000.221));
+
+  // angle is ignored
+  ASSERT_FALSE(st.newBlock(0));
+}
+
+TEST(TestSplitStrategyByTime, newTs_jump)
+{
+  SplitStrategyByTime st(0.1, 0.0);
+  ASSERT_FALSE(st.newTs(1600000000.05));
+
+  // skip frames
+  ASSERT_TRUE(st.newTs(1600000000.55));
+  ASSERT_FALSE(st.newTs(1600000000.56));
+
+  // jump back
+  ASSERT_TRUE(st.newTs(1600000000.05));
+  ASSERT_FALSE(st.newTs(1600000000.06));
+  ASSERT_TRUE(st.newTs(1600000000.15));
+}
+
+TEST(TestSplitStrategyByTime, virtualNewBlock)
+{
+  SplitStrategyByTime st(0.1, 0.0);
+  SplitStrategy& s = st;
+  ASSERT_FALSE(s.newBlock(100, 1600000000.05));
+  ASSERT_TRUE(s.newBlock(200, 1600000000.15));
+
+  SplitStrategyByAngle sa(10);
+  SplitStrategy& a = sa;
+  ASSERT_FALSE(a.newBlock(5, 1600000000.05));
+  ASSERT_TRUE(a.newBlock(15, 1600000000.05));
+}
+
+TEST(TestSplitStrategyBySector, newBlock)
+{
+  SplitStrategyBySector ss(0, 3000);
+  ASSERT_FALSE(ss.newBlock(0));
+  ASSERT_FALSE(ss.newBlock(2980));
+  ASSERT_TRUE(ss.newBlock(3000));
+  ASSERT_FALSE(ss.newBlock(3020));
+  ASSERT_TRUE(ss.newBlock(6010));
+
+  // wrap around
+  ASSERT_FALSE(ss.newBlock(6020));
+  ASSERT_TRUE(ss.newBlock(35990));
+  ASSERT_TRUE(ss.newBlock(10));
+}
+
+TEST(TestSplitStrategyBySector, newBlock_start)
+{
+  SplitStrategyBySector ss(1000, 9000);
+  ASSERT_FALSE(ss.newBlock(500));
+  ASSERT_TRUE(ss.newBlock(1000));
+  ASSERT_FALSE(ss.newBlock(9990));
+  ASSERT_TRUE(ss.newBlock(10000));
+
+  // the first block after reset is never a split
+  ss.reset();
+  ASSERT_FALSE(ss.newBlock(20000));
+  ASSERT_FALSE(ss.newBlock(20010));
+}
+
+TEST(TestSplitStrategyByBlks, newBlock)
+{
+  SplitStrategyByBlks sb(2);
+  ASSERT_FALSE(sb.newBlock(0));
+  ASSERT_FALSE(sb.newBlock(0));
+  ASSERT_TRUE(sb.newBlock(0));
+  ASSERT_FALSE(sb.newBlock(0));
+  ASSERT_TRUE(sb.newBlock(0));
+
+  // count from the block after reset
+  sb.reset();
+  ASSERT_FALSE(sb.newBlock(0));
+  ASSERT_FALSE(sb.newBlock(0));
+  ASSERT_TRUE(sb.newBlock(0));
+}
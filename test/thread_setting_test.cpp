@@ -0,0 +1,170 @@
+#include <gtest/gtest.h>
+
+#include <rs_driver/driver/thread_setting.hpp>
+#include <rs_driver/utility/worker_pool.hpp>
+#include <rs_driver/api/lidar_driver.hpp>
+#include <rs_driver/msg/point_cloud_msg.hpp>
+
+#include <dirent.h>
+#include <fstream>
+
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <set>
+
+using namespace robosense::lidar;
+
+#ifdef __linux__
+
+TEST(TestThreadSetting, nameAndAffinity)
+{
+  std::atomic<bool> to_exit(false);
+  std::thread t([&to_exit]() {
+    while (!to_exit)
+    {
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+  });
+
+  RSThreadParam param;
+  param.cpu_list.push_back(0);
+  ASSERT_TRUE(setThreadParam(t, param, "rs_test"));
+
+  char name[16];
+  ASSERT_EQ(pthread_getname_np(t.native_handle(), name, sizeof(name)), 0);
+  ASSERT_STREQ(name, "rs_test");
+
+  cpu_set_t cpus;
+  CPU_ZERO(&cpus);
+  ASSERT_EQ(pthread_getaffinity_np(t.native_handle(), sizeof(cpus), &cpus), 0);
+  ASSERT_EQ(CPU_COUNT(&cpus), 1);
+  ASSERT_TRUE(CPU_ISSET(0, &cpus));
+
+  // a given name overrides the default one, and is truncated to 15 characters.
+  param.cpu_list.clear();
+  param.name = "a_very_long_thread_name";
+  ASSERT_TRUE(setThreadParam(t, param, "rs_test"));
+  ASSERT_EQ(pthread_getname_np(t.native_handle(), name, sizeof(name)), 0);
+  ASSERT_STREQ(name, "a_very_long_thr");
+
+  to_exit = true;
+  t.join();
+
+  // not running
+  ASSERT_FALSE(setThreadParam(t, param, "rs_test"));
+}
+
+TEST(TestThreadSetting, applyInThread)
+{
+  RSThreadParam param;
+  param.cpu_list.push_back(0);
+  param.name = "rs_test";
+
+  // placed before anything else runs in the thread.
+  std::string name;
+  int cpu_num = 0;
+  std::thread t([&]() {
+    applyThreadParam(indexThreadParam(param, 2), "rs_default");
+
+    char buf[16];
+    pthread_getname_np(pthread_self(), buf, sizeof(buf));
+    name = buf;
+
+    cpu_set_t cpus;
+    CPU_ZERO(&cpus);
+    pthread_getaffinity_np(pthread_self(), sizeof(cpus), &cpus);
+    cpu_num = CPU_COUNT(&cpus);
+  });
+  t.join();
+
+  ASSERT_EQ(name, "rs_test2");
+  ASSERT_EQ(cpu_num, 1);
+
+  // no name given, no suffix.
+  param.name.clear();
+  ASSERT_TRUE(indexThreadParam(param, 2).name.empty());
+}
+
+TEST(TestThreadSetting, workerPool)
+{
+  std::mutex mtx;
+  std::set<std::string> names;
+
+  WorkerPool pool;
+  ASSERT_TRUE(pool.start(2, [&mtx, &names](size_t idx) {
+    RSThreadParam param;
+    applyThreadParam(param, "rs_worker" + std::to_string(idx));
+
+    char name[16];
+    pthread_getname_np(pthread_self(), name, sizeof(name));
+    std::lock_guard<std::mutex> lg(mtx);
+    names.insert(name);
+  }));
+
+  // the threads place themselves before taking tasks.
+  std::atomic<int> done(0);
+  pool.submit([&done]() { done++; });
+  while (done == 0)
+  {
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  pool.stop();
+
+  ASSERT_EQ(names.size(), 2u);
+  ASSERT_EQ(names.count("rs_worker0"), 1u);
+  ASSERT_EQ(names.count("rs_worker1"), 1u);
+}
+
+static std::multiset<std::string> threadNames()
+{
+  std::multiset<std::string> names;
+
+  DIR* dir = opendir("/proc/self/task");
+  struct dirent* ent;
+  while ((dir != NULL) && ((ent = readdir(dir)) != NULL))
+  {
+    std::ifstream comm(std::string("/proc/self/task/") + ent->d_name + "/comm");
+    std::string name;
+    if (std::getline(comm, name))
+    {
+      names.insert(name);
+    }
+  }
+
+  if (dir != NULL)
+  {
+    closedir(dir);
+  }
+  return names;
+}
+
+TEST(TestThreadSetting, driverThreads)
+{
+  RSDriverParam param;
+  param.lidar_type = LidarType::RS16;
+  param.input_type = InputType::ONLINE_LIDAR;
+  param.input_param.msop_port = 27710;
+  param.input_param.difop_port = 27711;
+  param.input_param.socket_num = 2;
+  param.recv_thread_param.name = "rs_test_recv";
+  param.handle_thread_param.name = "rs_test_handle";
+
+  LidarDriver<PointCloudT<PointXYZI>> driver;
+  driver.regPointCloudCallback(
+      []() { return std::make_shared<PointCloudT<PointXYZI>>(); }, 
+      [](std::shared_ptr<PointCloudT<PointXYZI>>) {});
+  ASSERT_TRUE(driver.init(param));
+  ASSERT_TRUE(driver.start());
+  std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+  // each SO_REUSEPORT receiver has its own name.
+  std::multiset<std::string> names = threadNames();
+  ASSERT_EQ(names.count("rs_test_recv"), 1u);
+  ASSERT_EQ(names.count("rs_test_recv1"), 1u);
+  ASSERT_EQ(names.count("rs_test_handle"), 1u);
+
+  driver.stop();
+}
+
+#endif
@@ -0,0 +1,90 @@
+#include <gtest/gtest.h>
+
+#include <rs_driver/utility/trace.hpp>
+
+#include <fstream>
+#include <sstream>
+#include <thread>
+
+using namespace robosense::lidar;
+
+TEST(TestTracer, record)
+{
+  Tracer& tracer = Tracer::instance();
+
+  // not started
+  tracer.stop();
+  {
+    TraceScope scope("idle");
+  }
+
+  tracer.start(4);
+  ASSERT_TRUE(tracer.enabled());
+  ASSERT_EQ(tracer.eventNum(), 0u);
+
+  {
+    TraceScope scope("main");
+  }
+
+  std::thread t([]()
+  {
+    for (int i = 0; i < 6; i++)
+    {
+      TraceScope scope("worker");
+    }
+  });
+  t.join();
+
+  // 4 events per thread at most
+  ASSERT_EQ(tracer.eventNum(), 5u);
+  ASSERT_EQ(tracer.droppedNum(), 2u);
+
+  tracer.stop();
+  {
+    TraceScope scope("stopped");
+  }
+  ASSERT_EQ(tracer.eventNum(), 5u);
+
+  // restart clears the events
+  tracer.start();
+  ASSERT_EQ(tracer.eventNum(), 0u);
+  tracer.stop();
+}
+
+TEST(TestTracer, save)
+{
+  Tracer& tracer = Tracer::instance();
+  tracer.start();
+
+  {
+    TraceScope outer("outer");
+    TraceScope inner("inner");
+  }
+
+  tracer.stop();
+  ASSERT_TRUE(tracer.save("./trace_test.json"));
+
+  std::ifstream ifs("./trace_test.json");
+  std::stringstream ss;
+  ss << ifs.rdbuf();
+  std::string json = ss.str();
+
+  ASSERT_EQ(json.find("{\"displayTimeUnit\":\"ns\",\"traceEvents\":["), 0u);
+  ASSERT_NE(json.find("\"name\":\"thread_name\",\"ph\":\"M\""), std::string::npos);
+  ASSERT_NE(json.find("\"name\":\"inner\",\"ph\":\"X\""), std::string::npos);
+  ASSERT_NE(json.find("\"name\":\"outer\",\"ph\":\"X\""), std::string::npos);
+  ASSERT_EQ(json.substr(json.size() - 4), "\n]}\n");
+
+  // the outer event, stored after the inner one, begins first.
+  std::vector<double> tss;
+  for (size_t pos = json.find("\"ts\":"); pos != std::string::npos; pos = json.find("\"ts\":", pos + 1))
+  {
+    tss.push_back(std::stod(json.substr(pos + 5)));
+  }
+  ASSERT_EQ(tss.size(), 2u);
+  ASSERT_EQ(tss[1], 0.0);
+  ASSERT_GT(tss[0], tss[1]);
+  ASSERT_LT(tss[0], 1e6);
+
+  ASSERT_FALSE(tracer.save("/nonexist/trace_test.json"));
+}
@@ -0,0 +1,174 @@
+#include <gtest/gtest.h>
+
+#include <rs_driver/utility/worker_pool.hpp>
+
+#include <atomic>
+#include <mutex>
+#include <set>
+
+using namespace robosense::lidar;
+
+TEST(TestWorkerPool, submit)
+{
+  WorkerPool pool;
+  ASSERT_TRUE(pool.start(3));
+  ASSERT_EQ(pool.threadNum(), 3u);
+
+  std::atomic<int> count(0);
+  for (int i = 0; i < 1000; i++)
+  {
+    pool.submit([&count]() { count++; });
+  }
+
+  // pending tasks are done before stop() returns.
+  pool.stop();
+  ASSERT_EQ(count, 1000);
+  ASSERT_EQ(pool.threadNum(), 0u);
+}
+
+TEST(TestWorkerPool, submitBeforeStart)
+{
+  WorkerPool pool;
+
+  std::thread::id id;
+  pool.submit([&id]() { id = std::this_thread::get_id(); });
+
+  // run in the caller's thread.
+  ASSERT_EQ(id, std::this_thread::get_id());
+}
+
+TEST(TestWorkerPool, restart)
+{
+  WorkerPool pool;
+  ASSERT_TRUE(pool.start(0));
+  ASSERT_EQ(pool.threadNum(), 1u);
+  pool.stop();
+
+  ASSERT_TRUE(pool.start(2));
+
+  std::atomic<int> count(0);
+  pool.submit([&count]() { count++; });
+  pool.stop();
+  ASSERT_EQ(count, 1);
+}
+
+TEST(TestWorkerPool, steal)
+{
+  WorkerPool pool;
+  ASSERT_TRUE(pool.start(4));
+
+  std::mutex mtx;
+  std::set<std::thread::id> ids;
+  std::atomic<int> count(0);
+
+  // tasks submitted by a thread of the pool go to its own queue. The other threads steal them.
+  pool.submit([&]() 
+      {
+        for (int i = 0; i < 100; i++)
+        {
+          pool.submit([&]() 
+              {
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+                std::lock_guard<std::mutex> lg(mtx);
+                ids.insert(std::this_thread::get_id());
+                count++;
+              });
+        }
+      });
+
+  for (int i = 0; (i < 500) && (count < 100); i++)
+  {
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+
+  pool.stop();
+  ASSERT_EQ(count, 100);
+  ASSERT_GT(ids.size(), 1u);
+  ASSERT_GT(pool.stealNum(), 0u);
+}
+
+TEST(TestWorkerPool, orderPerQueue)
+{
+  WorkerPool pool;
+  ASSERT_TRUE(pool.start(1));
+
+  // a single thread runs the tasks of its queue in order.
+  std::vector<int> order;
+  for (int i = 0; i < 100; i++)
+  {
+    pool.submit([&order, i]() { order.push_back(i); });
+  }
+
+  pool.stop();
+  ASSERT_EQ(order.size(), 100u);
+  for (int i = 0; i < 100; i++)
+  {
+    ASSERT_EQ(order[i], i);
+  }
+}
+
+TEST(TestWorkerPool, concurrentSubmit)
+{
+  WorkerPool pool;
+  ASSERT_TRUE(pool.start(3));
+
+  // producers push to the queues in parallel, and wait for their own tasks one by one. 
+  // A lost wakeup leaves a task waiting.
+  std::atomic<int> count(0);
+  std::atomic<int> timeouts(0);
+  std::vector<std::thread> producers;
+  for (int p = 0; p < 4; p++)
+  {
+    producers.emplace_back([&pool, &count, &timeouts]()
+    {
+      for (int i = 0; i < 2000; i++)
+      {
+        std::atomic<bool> done(false);
+        pool.submit([&count, &done]() { count++; done = true; });
+
+        auto begin = std::chrono::steady_clock::now();
+        while (!done)
+        {
+          if (std::chrono::steady_clock::now() - begin > std::chrono::seconds(1))
+          {
+            timeouts++;
+            break;
+          }
+          std::this_thread::yield();
+        }
+      }
+    });
+  }
+
+  for (auto& t : producers)
+  {
+    t.join();
+  }
+
+  pool.stop();
+  ASSERT_EQ(timeouts, 0);
+  ASSERT_EQ(count, 8000);
+}
+
+TEST(TestWorkerPool, submitWhileStopping)
+{
+  // every task submitted is done, either by the pool or by the caller.
+  for (int round = 0; round < 20; round++)
+  {
+    WorkerPool pool;
+    ASSERT_TRUE(pool.start(2));
+
+    std::atomic<int> count(0);
+    std::thread producer([&pool, &count]()
+    {
+      for (int i = 0; i < 1000; i++)
+      {
+        pool.submit([&count]() { count++; });
+      }
+    });
+
+    pool.stop();
+    producer.join();
+    ASSERT_EQ(count, 1000);
+  }
+}
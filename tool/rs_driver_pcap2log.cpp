@@ -0,0 +1,201 @@
+/*********************************************************************************************************************
+Copyright (c) 2020 RoboSense
+All rights reserved
+
+By downloading, copying, installing or using the software you agree to this license. If you do not agree to this
+license, do not download, install, copy or use the software.
+
+License Agreement
+For RoboSense LiDAR SDK Library
+(3-clause BSD License)
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that the
+following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following
+disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following
+disclaimer in the documentation and/or other materials provided with the distribution.
+
+3. Neither the names of the RoboSense, nor Suteng Innovation Technology, nor the names of other contributors may be used
+to endorse or promote products derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*********************************************************************************************************************/
+
+
+#include <rs_driver/api/lidar_driver.hpp>
+#include <rs_driver/driver/input/input_pcap.hpp>
+#include <rs_driver/utility/packet_log.hpp>
+
+using namespace robosense::lidar;
+
+bool checkKeywordExist(int argc, const char* const* argv, const char* str)
+{
+  for (int i = 1; i < argc; i++)
+  {
+    if (strcmp(argv[i], str) == 0)
+    {
+      return true;
+    }
+  }
+  return false;
+}
+
+bool parseArgument(int argc, const char* const* argv, const char* str, std::string& val)
+{
+  int index = -1;
+
+  for (int i = 1; i < argc; i++)
+  {
+    if (strcmp(argv[i], str) == 0)
+    {
+      index = i + 1;
+    }
+  }
+
+  if (index > 0 && index < argc)
+  {
+    val = argv[index];
+    return true;
+  }
+
+  return false;
+}
+
+void printHelpMenu()
+{
+  RS_MSG << "Arguments: " << RS_REND;
+  RS_MSG << "  -pcap   = The path of the pcap file (.pcap, .pcap.gz, .pcap.zst)" << RS_REND;
+  RS_MSG << "  -log    = The path of the log file to write" << RS_REND;
+  RS_MSG << "  -msop   = LiDAR msop port number,the default value is 6699" << RS_REND;
+  RS_MSG << "  -difop  = LiDAR difop port number,the default value is 7788" << RS_REND;
+  RS_MSG << "  -codec  = Compression of the log file (none, zlib, zstd), the default value is zstd" << RS_REND;
+  RS_MSG << "  -vlan   = The pcap file contains VLAN layer" << RS_REND;
+}
+
+int main(int argc, char* argv[])
+{
+  RS_TITLE << "------------------------------------------------------" << RS_REND;
+  RS_TITLE << "            RS_Driver PCAP to Log Version: v" << getDriverVersion() << RS_REND;
+  RS_TITLE << "------------------------------------------------------" << RS_REND;
+
+  if (argc < 2 || checkKeywordExist(argc, argv, "-h") || checkKeywordExist(argc, argv, "--help"))
+  {
+    printHelpMenu();
+    return 0;
+  }
+
+  std::string pcap_path, log_path, result_str;
+  uint16_t msop_port = 6699;
+  uint16_t difop_port = 7788;
+  LogCodec codec = LOG_CODEC_ZSTD;
+  bool use_vlan = checkKeywordExist(argc, argv, "-vlan");
+
+  parseArgument(argc, argv, "-pcap", pcap_path);
+  parseArgument(argc, argv, "-log", log_path);
+  if (pcap_path.empty() || log_path.empty())
+  {
+    printHelpMenu();
+    return -1;
+  }
+
+  if (parseArgument(argc, argv, "-msop", result_str))
+  {
+    msop_port = std::stoi(result_str);
+  }
+
+  if (parseArgument(argc, argv, "-difop", result_str))
+  {
+    difop_port = std::stoi(result_str);
+  }
+
+  if (parseArgument(argc, argv, "-codec", result_str))
+  {
+    if (result_str == "none")
+      codec = LOG_CODEC_NONE;
+    else if (result_str == "zlib")
+      codec = LOG_CODEC_ZLIB;
+  }
+
+  char errbuf[PCAP_ERRBUF_SIZE];
+  PcapUnzip unzip;
+  pcap_t* pcap = openPcapFile(pcap_path, unzip, errbuf);
+  if (pcap == NULL)
+  {
+    RS_ERROR << "Fail to open pcap file: " << pcap_path << RS_REND;
+    return -1;
+  }
+
+  std::stringstream msop_stream, difop_stream;
+  if (use_vlan)
+  {
+    msop_stream << "vlan && ";
+    difop_stream << "vlan && ";
+  }
+  msop_stream << "udp dst port " << msop_port;
+  difop_stream << "udp dst port " << difop_port;
+
+  bpf_program msop_filter, difop_filter;
+  pcap_compile(pcap, &msop_filter, msop_stream.str().c_str(), 1, 0xFFFFFFFF);
+  pcap_compile(pcap, &difop_filter, difop_stream.str().c_str(), 1, 0xFFFFFFFF);
+
+  PacketLogWriter writer;
+  if (!writer.open(log_path, codec))
+  {
+    pcap_close(pcap);
+    return -1;
+  }
+
+  size_t offset = ETH_HDR_LEN + (use_vlan ? VLAN_HDR_LEN : 0);
+  uint64_t pcap_bytes = 0;
+  uint64_t msop_num = 0, difop_num = 0;
+
+  struct pcap_pkthdr* header;
+  const u_char* pkt_data;
+  while (pcap_next_ex(pcap, &header, &pkt_data) >= 0)
+  {
+    pcap_bytes += sizeof(pcap_pkthdr) + header->caplen;
+
+    uint8_t kind;
+    if (pcap_offline_filter(&msop_filter, header, pkt_data) != 0)
+    {
+      kind = LOG_PKT_MSOP;
+      msop_num++;
+    }
+    else if (pcap_offline_filter(&difop_filter, header, pkt_data) != 0)
+    {
+      kind = LOG_PKT_DIFOP;
+      difop_num++;
+    }
+    else
+    {
+      continue;
+    }
+
+    if (header->caplen <= offset)
+    {
+      continue;
+    }
+
+    uint64_t ts = (uint64_t)header->ts.tv_sec * 1000000 + header->ts.tv_usec;
+    if (!writer.write(ts, kind, 0, pkt_data + offset, header->caplen - offset))
+    {
+      break;
+    }
+  }
+
+  pcap_close(pcap);
+  writer.close();
+
+  RS_MSG << "MSOP packets: " << msop_num << ", DIFOP packets: " << difop_num << RS_REND;
+  RS_MSG << "PCAP bytes: " << pcap_bytes << ", Log bytes: " << writer.bytes() << RS_REND;
+  return 0;
+}
@@ -0,0 +1,350 @@
+/*********************************************************************************************************************
+Copyright (c) 2020 RoboSense
+All rights reserved
+
+By downloading, copying, installing or using the software you agree to this license. If you do not agree to this
+license, do not download, install, copy or use the software.
+
+License Agreement
+For RoboSense LiDAR SDK Library
+(3-clause BSD License)
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that the
+following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following
+disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following
+disclaimer in the documentation and/or other materials provided with the distribution.
+
+3. Neither the names of the RoboSense, nor Suteng Innovation Technology, nor the names of other contributors may be used
+to endorse or promote products derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*********************************************************************************************************************/
+
+
+#include <rs_driver/api/lidar_driver.hpp>
+#include <rs_driver/driver/decoder/packet_builder.hpp>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <signal.h>
+
+#include <chrono>
+#include <random>
+#include <thread>
+
+using namespace robosense::lidar;
+
+static volatile sig_atomic_t to_exit = 0;
+
+static void sigHandler(int)
+{
+  to_exit = 1;
+}
+
+bool checkKeywordExist(int argc, const char* const* argv, const char* str)
+{
+  for (int i = 1; i < argc; i++)
+  {
+    if (strcmp(argv[i], str) == 0)
+    {
+      return true;
+    }
+  }
+  return false;
+}
+
+bool parseArgument(int argc, const char* const* argv, const char* str, std::string& val)
+{
+  int index = -1;
+
+  for (int i = 1; i < argc; i++)
+  {
+    if (strcmp(argv[i], str) == 0)
+    {
+      index = i + 1;
+    }
+  }
+
+  if (index > 0 && index < argc)
+  {
+    val = argv[index];
+    return true;
+  }
+
+  return false;
+}
+
+void printHelpMenu()
+{
+  RS_MSG << "Arguments: " << RS_REND;
+  RS_MSG << "  -type      = LiDAR type (RS16, RS32, RSBP, RSHELIOS, RS128, RSM1, RSM1_JUMBO ...), the default value is RS16" << RS_REND;
+  RS_MSG << "  -dest      = Destination address, the default value is 127.0.0.1" << RS_REND;
+  RS_MSG << "  -msop      = Destination msop port number, the default value is 6699" << RS_REND;
+  RS_MSG << "  -difop     = Destination difop port number, the default value is 7788" << RS_REND;
+  RS_MSG << "  -lidar_num = Number of simulated LiDARs. LiDAR i sends to msop + i and difop + i. the default value is 1" << RS_REND;
+  RS_MSG << "  -same_port = All LiDARs send to the same ports, from source address 127.0.0.2, 127.0.0.3, ..." << RS_REND;
+  RS_MSG << "  -speed     = Times of the real packet rate, the default value is 1" << RS_REND;
+  RS_MSG << "  -loss      = Ratio of msop packets to drop (0 ~ 1), the default value is 0" << RS_REND;
+  RS_MSG << "  -reorder   = Ratio of msop packets to swap with the next one (0 ~ 1), the default value is 0" << RS_REND;
+  RS_MSG << "  -seconds   = Seconds to run, the default value is 0 (until Ctrl-C)" << RS_REND;
+}
+
+static int createSocket(const std::string& src_ip)
+{
+  int fd = socket(AF_INET, SOCK_DGRAM, 0);
+  if (fd < 0)
+  {
+    RS_ERROR << "Fail to create socket: " << strerror(errno) << RS_REND;
+    return -1;
+  }
+
+  int send_buf = 4 * 1024 * 1024;
+  setsockopt(fd, SOL_SOCKET, SO_SNDBUF, &send_buf, sizeof(send_buf));
+
+  if (!src_ip.empty())
+  {
+    sockaddr_in src;
+    memset(&src, 0, sizeof(src));
+    src.sin_family = AF_INET;
+    src.sin_port = 0;
+    inet_pton(AF_INET, src_ip.c_str(), &src.sin_addr);
+
+    if (bind(fd, (sockaddr*)&src, sizeof(src)) < 0)
+    {
+      RS_ERROR << "Fail to bind source address " << src_ip << ": " << strerror(errno) << RS_REND;
+      close(fd);
+      return -1;
+    }
+  }
+
+  return fd;
+}
+
+struct SimLidar
+{
+  int fd;
+  sockaddr_in msop_addr;
+  sockaddr_in difop_addr;
+  std::vector<uint8_t> held;  // msop packet delayed for reordering
+};
+
+static sockaddr_in makeAddr(const std::string& ip, uint16_t port)
+{
+  sockaddr_in addr;
+  memset(&addr, 0, sizeof(addr));
+  addr.sin_family = AF_INET;
+  addr.sin_port = htons(port);
+  inet_pton(AF_INET, ip.c_str(), &addr.sin_addr);
+  return addr;
+}
+
+static bool sendPkt(int fd, const sockaddr_in& addr, const std::vector<uint8_t>& pkt)
+{
+  ssize_t ret = sendto(fd, pkt.data(), pkt.size(), 0, (const sockaddr*)&addr, sizeof(addr));
+  return (ret == (ssize_t)pkt.size());
+}
+
+int main(int argc, char* argv[])
+{
+  RS_TITLE << "------------------------------------------------------" << RS_REND;
+  RS_TITLE << "            RS_Driver Simulator Version: v" << getDriverVersion() << RS_REND;
+  RS_TITLE << "------------------------------------------------------" << RS_REND;
+
+  if (checkKeywordExist(argc, argv, "-h") || checkKeywordExist(argc, argv, "--help"))
+  {
+    printHelpMenu();
+    return 0;
+  }
+
+  std::string result_str;
+  LidarType type = LidarType::RS16;
+  std::string dest_ip = "127.0.0.1";
+  uint16_t msop_port = 6699;
+  uint16_t difop_port = 7788;
+  uint16_t lidar_num = 1;
+  bool same_port = checkKeywordExist(argc, argv, "-same_port");
+  double speed = 1.0;
+  double loss = 0.0;
+  double reorder = 0.0;
+  double seconds = 0.0;
+
+  if (parseArgument(argc, argv, "-type", result_str))
+  {
+    type = strToLidarType(result_str);
+  }
+
+  parseArgument(argc, argv, "-dest", dest_ip);
+
+  if (parseArgument(argc, argv, "-msop", result_str))
+  {
+    msop_port = std::stoi(result_str);
+  }
+
+  if (parseArgument(argc, argv, "-difop", result_str))
+  {
+    difop_port = std::stoi(result_str);
+  }
+
+  if (parseArgument(argc, argv, "-lidar_num", result_str))
+  {
+    lidar_num = std::max(std::stoi(result_str), 1);
+  }
+
+  if (parseArgument(argc, argv, "-speed", result_str))
+  {
+    speed = std::stod(result_str);
+  }
+
+  if (parseArgument(argc, argv, "-loss", result_str))
+  {
+    loss = std::stod(result_str);
+  }
+
+  if (parseArgument(argc, argv, "-reorder", result_str))
+  {
+    reorder = std::stod(result_str);
+  }
+
+  if (parseArgument(argc, argv, "-seconds", result_str))
+  {
+    seconds = std::stod(result_str);
+  }
+
+  if (speed <= 0)
+  {
+    RS_ERROR << "Invalid speed: " << speed << RS_REND;
+    return -1;
+  }
+
+  PacketBuilder builder(type);
+  if (builder.msops().empty())
+  {
+    RS_ERROR << "Unsupported LiDAR type: " << lidarTypeToStr(type) << RS_REND;
+    return -1;
+  }
+
+  std::vector<SimLidar> lidars(lidar_num);
+  for (uint16_t i = 0; i < lidar_num; i++)
+  {
+    std::string src_ip = same_port ? ("127.0.0." + std::to_string(2 + i)) : "";
+    uint16_t offset = same_port ? 0 : i;
+
+    lidars[i].fd = createSocket(src_ip);
+    if (lidars[i].fd < 0)
+    {
+      return -1;
+    }
+    lidars[i].msop_addr = makeAddr(dest_ip, msop_port + offset);
+    lidars[i].difop_addr = makeAddr(dest_ip, difop_port + offset);
+  }
+
+  signal(SIGINT, sigHandler);
+  signal(SIGTERM, sigHandler);
+
+  const double interval = builder.pktInterval() / speed;
+  const size_t round = builder.msops().size();
+
+  RS_INFOL << "LiDAR type: " << lidarTypeToStr(type) << ", LiDARs: " << lidar_num 
+    << ", msop packets per frame: " << round 
+    << ", msop packets per second: " << (1.0 / interval) << RS_REND;
+
+  std::mt19937 rand_gen(0);
+  std::uniform_real_distribution<double> dist(0.0, 1.0);
+
+  uint64_t msop_num = 0, lost_num = 0, reorder_num = 0, difop_num = 0, fail_num = 0;
+
+  // the timestamp in the packets goes at the real rate of the LiDAR.
+  const uint64_t start_us = std::chrono::duration_cast<std::chrono::microseconds>(
+      std::chrono::system_clock::now().time_since_epoch()).count();
+  const auto start = std::chrono::steady_clock::now();
+  double next_difop = 0;
+
+  for (uint64_t k = 0; !to_exit; k++)
+  {
+    double elapsed = k * interval;
+    if ((seconds > 0) && (elapsed >= seconds))
+    {
+      break;
+    }
+
+    std::this_thread::sleep_until(start + std::chrono::duration<double>(elapsed));
+
+    if (elapsed >= next_difop)
+    {
+      for (auto& lidar : lidars)
+      {
+        if (sendPkt(lidar.fd, lidar.difop_addr, builder.difop()))
+          difop_num++;
+        else
+          fail_num++;
+      }
+
+      next_difop += 1.0 / speed;
+    }
+
+    std::vector<uint8_t> pkt = builder.msops()[k % round];
+    builder.stamp(pkt.data(), start_us + (uint64_t)(k * builder.pktInterval() * 1e6));
+
+    for (auto& lidar : lidars)
+    {
+      if (dist(rand_gen) < loss)
+      {
+        lost_num++;
+        continue;
+      }
+
+      if (lidar.held.empty() && (dist(rand_gen) < reorder))
+      {
+        lidar.held = pkt;
+        reorder_num++;
+        continue;
+      }
+
+      if (sendPkt(lidar.fd, lidar.msop_addr, pkt))
+        msop_num++;
+      else
+        fail_num++;
+
+      if (!lidar.held.empty())
+      {
+        if (sendPkt(lidar.fd, lidar.msop_addr, lidar.held))
+          msop_num++;
+        else
+          fail_num++;
+
+        lidar.held.clear();
+      }
+    }
+  }
+
+  double duration = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+  for (auto& lidar : lidars)
+  {
+    if (!lidar.held.empty())
+    {
+      if (sendPkt(lidar.fd, lidar.msop_addr, lidar.held))
+        msop_num++;
+      else
+        fail_num++;
+    }
+
+    close(lidar.fd);
+  }
+
+  RS_MSG << "Seconds: " << duration << ", MSOP packets: " << msop_num << ", DIFOP packets: " << difop_num << RS_REND;
+  RS_MSG << "Dropped: " << lost_num << ", Reordered: " << reorder_num << ", Send failures: " << fail_num << RS_REND;
+  return 0;
+}